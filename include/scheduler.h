@@ -7,10 +7,21 @@
 #define __SCHEDULER_H__
 
 #include <stddef.h>     /*  size_t           */
+#include <time.h>       /*  time_t           */
 #include "uid.h"        /*  ilrd_uid_ty      */ /*  public  */
 
 typedef struct scheduler scheduler_ty;
 
+/*  the time source of a scheduler, "now" returns the current time in seconds
+    and "sleep" waits "seconds" of that time, it returns 0 if all of them
+    passed, not 0 if the wait was cut short                                   */
+typedef struct sched_clock
+{
+    time_t (*now)(void *param);
+    int (*sleep)(void *param, time_t seconds);
+    void *param;
+}sched_clock_ty;
+
 /*  write a function with this signature to state an operation to be executed 
     the function should return 0 if it should be repeated, 1 if it should
     be stopped                                                                */
@@ -46,6 +57,15 @@ ilrd_uid_ty SchedulerAddTask(scheduler_ty *scheduler, size_t interval,
                             oper_func_ty operation, void *param,
                             clean_func_ty clean_func);
 
+/*******************************************************************************
+ * Same as SchedulerAddTask(), but the operation runs for the first time
+ * "interval" from now instead of at once
+ * Time Complexity: ~O(n) (determined by the used system call complexity) 
+*******************************************************************************/
+ilrd_uid_ty SchedulerAddTaskLater(scheduler_ty *scheduler, size_t interval, 
+                            oper_func_ty operation, void *param,
+                            clean_func_ty clean_func);
+
 /*******************************************************************************
  * Removes operation specified by "uid"
  * note: undefined behaviour if "scheduler" is empty or NULL 
@@ -57,13 +77,37 @@ int SchedulerRemoveTask(scheduler_ty *scheduler, ilrd_uid_ty uid);
 
 /*******************************************************************************
  * Starts performing the operations in the scheduler
+ * a wait cut short, by a signal or by the sleep of the clock, is taken up
+ * again for what is left of it - an operation never runs before its time
  * Returns: 0 in success, otherwise 1
  * Time Complexity: O(1)
 *******************************************************************************/
 int SchedulerRun(scheduler_ty *scheduler);
 
+/*******************************************************************************
+ * While "scheduler" waits for its next operation it also watches "fd" and
+ * calls "on_wake" with "param" as soon as "fd" becomes readable, then waits
+ * again for what is left of the interval
+ * "fd" -1 restores the plain sleep
+ * note: undefined behaviour if "scheduler" is NULL
+ * Time Complexity: O(1)
+*******************************************************************************/
+void SchedulerSetWakeFd(scheduler_ty *scheduler, int fd,
+                        void (*on_wake)(void *param), void *param);
+
+/*******************************************************************************
+ * Replaces the time source of "scheduler" by "clock", which is copied
+ * NULL restores the wall clock, time() and sleep() or the wake fd
+ * a set clock takes over the waits, the wake fd is not watched
+ * note: undefined behaviour if "scheduler" is NULL or if tasks were added
+ * Time Complexity: O(1)
+*******************************************************************************/
+void SchedulerSetClock(scheduler_ty *scheduler, const sched_clock_ty *clock);
+
 /*******************************************************************************
  * Stops performing the operations in the scheduler
+ * async-signal-safe: from a handler that cut the wait of SchedulerRun() short
+ * it returns right away, without waiting for the next operation
  * Time Complexity: O(1)
 *******************************************************************************/
 void SchedulerStop(scheduler_ty *scheduler);
@@ -52,12 +52,20 @@ time_t TaskGetTimeToRun(const task_ty *task);
 *******************************************************************************/
 ilrd_uid_ty TaskGetUID(const task_ty *task);
 
+/*******************************************************************************
+ * Sets "task"'s "time_to_run" to "time_to_run"
+ * note: undefined behaviour if "task" is NULL
+ * Time Complexity: O(1)
+*******************************************************************************/
+void TaskSetTimeToRun(task_ty *task, time_t time_to_run);
+
 /*******************************************************************************
  * Updates "task"'s "time_to_run", according to its "interval"
+ * runs that are already due at "now" are skipped, the task keeps its phase
  * note: undefined behaviour if "task" is NULL
  * Time Complexity: O(1)
 *******************************************************************************/
-void TaskUpdateTimeToRun(task_ty *task);
+void TaskUpdateTimeToRun(task_ty *task, time_t now);
 
 /*******************************************************************************
  * Returns 1 if "task"'s uid matches "uid", 0 otherwise
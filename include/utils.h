@@ -11,16 +11,21 @@
 #define DEBUG_ONLY(x)
 #endif
 
+/* a module may route the failure messages elsewhere by defining REPORT_BAD */
+#ifndef REPORT_BAD
+#define REPORT_BAD(MSG) fputs(MSG, stderr)
+#endif
+
 #define RETURN_IF_BAD(IS_GOOD, MSG, RETVAL) if (!IS_GOOD) \
                                             { \
-                                                fputs(MSG, stderr); \
+                                                REPORT_BAD(MSG); \
                                                 return(RETVAL); \
                                             }
 
 #define RETURN_IF_BAD_CLEAN(IS_GOOD, MSG, RETVAL, CLEANUP) if (!IS_GOOD) \
                                                     { \
                                                         CLEANUP; \
-                                                        fputs(MSG, stderr); \
+                                                        REPORT_BAD(MSG); \
                                                         return(RETVAL); \
                                                     }
 
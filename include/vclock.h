@@ -0,0 +1,52 @@
+/*******************************************************************************
+ * Project:     Watchdog - virtual clock
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * a deterministic time source for the scheduler: a sleep moves the time
+ * forward at once, so hours of a schedule run in a few milliseconds
+*******************************************************************************/
+#ifndef __VCLOCK_H__
+#define __VCLOCK_H__
+
+#include <time.h>       /*  time_t          */
+#include "scheduler.h"  /*  sched_clock_ty  */
+
+/*  called by a sleep before the time moves from "from" to "to", the place to
+    play what happens meanwhile                                               */
+typedef void (*vclock_advance_ty)(void *param, time_t from, time_t to);
+
+typedef struct vclock
+{
+    time_t now;
+    vclock_advance_ty on_advance;
+    void *param;
+}vclock_ty;
+
+/*******************************************************************************
+ * Sets "vclock" to "start", "on_advance" may be NULL
+ * Time Complexity: O(1)
+*******************************************************************************/
+void VClockInit(vclock_ty *vclock, time_t start, vclock_advance_ty on_advance,
+                void *param);
+
+/*******************************************************************************
+ * Fills "clock" so that a scheduler runs on "vclock", see SchedulerSetClock()
+ * "vclock" must outlive the scheduler
+ * Time Complexity: O(1)
+*******************************************************************************/
+void VClockAttach(vclock_ty *vclock, sched_clock_ty *clock);
+
+/*******************************************************************************
+ * Returns the time of "vclock"
+ * Time Complexity: O(1)
+*******************************************************************************/
+time_t VClockNow(const vclock_ty *vclock);
+
+/*******************************************************************************
+ * Moves "vclock" "seconds" forward, "on_advance" is called first
+ * Time Complexity: O(1), plus "on_advance"
+*******************************************************************************/
+void VClockAdvance(vclock_ty *vclock, time_t seconds);
+
+#endif  /*  __VCLOCK_H__  */
@@ -7,10 +7,13 @@
 #define __WATCHDOG_H__
 
 #include <stddef.h>
+#include <time.h>
 
 
 /*******************************************************************************
  * note: SIGUSR1 and SIGUSR2 are used for the operation of the watchdog!      *
+ *       MakeMeImmortal() leaves them blocked in the calling thread, and so   *
+ *       in the threads it creates later, the rest of its mask is untouched   *
 *******************************************************************************/
 
 /*******************************************************************************
@@ -29,11 +32,528 @@
 *******************************************************************************/
 int MakeMeImmortal(int argc, char *argv[], size_t interval, size_t max_misses);
 
+/*******************************************************************************
+ * returned once the watchdog did not stop within the time it was given
+*******************************************************************************/
+enum {WD_TIMED_OUT = 7};
+
 /*******************************************************************************
  * notifies the watchdog to not resuscitate the calling program
+ * the watchdog thread and its process only are signaled, both stop right
+ * away instead of on their next tick
 
  * returns 0 for success, not 0 otherwise
 *******************************************************************************/
 int DoNotResuscitate(void);
 
+/*******************************************************************************
+ * DoNotResuscitate() that returns within "timeout_ms" (0 - no limit)
+
+ * returns 0 once the watchdog stopped, WD_TIMED_OUT if it did not in time -
+ * it is told again by the next call - not 0 on other failures
+*******************************************************************************/
+int DoNotResuscitateTimed(size_t timeout_ms);
+
+/*******************************************************************************
+ * a watchdog of the calling program, one program may run several of them,
+ * each with a thread, a watchdog process and a timing of its own
+*******************************************************************************/
+typedef struct wd_handle wd_handle_ty;
+
+/*******************************************************************************
+ * "argc", "argv", "interval", "max_misses" - as for MakeMeImmortal()
+ * "name" - NULL for the main watchdog, which revives the program, the way
+ *          MakeMeImmortal() sets it
+ *          any other name for an additional watchdog, e.g. a fast one for an
+ *          I/O loop and a slow one for a batch pipeline: once it misses
+ *          "max_misses" sign of life, it stops the program as set by
+ *          WDSetStopPolicy() and leaves the revival to the main watchdog
+ * note: "name" may not contain '/' and is limited to 31 characters, it
+ *       names the stats page of the watchdog "<pair name>.<name>"
+*******************************************************************************/
+typedef struct wd_config
+{
+    int argc;
+    char **argv;
+    size_t interval;
+    size_t max_misses;
+    const char *name;
+}wd_config_ty;
+
+/*******************************************************************************
+ * sets a watchdog for the calling program as described by "config", the
+ * policies set so far apply to it
+ * the progress, memory and latency checks, the kept descriptors and the
+ * restart state belong to the main watchdog only
+
+ * returns the watchdog, or NULL on failure or if the program already has a
+ * main watchdog and "name" is NULL
+*******************************************************************************/
+wd_handle_ty *WDCreate(const wd_config_ty *config);
+
+/*******************************************************************************
+ * stops "handle" and its watchdog process within "timeout_ms" (0 - no
+ * limit) and frees it
+ * a watchdog process still there once the thread stopped gets SIGKILL when
+ * the time is up (the "term_ms" of WDSetStopPolicy() without a limit)
+ * for the main watchdog it is DoNotResuscitate(), the additional watchdogs
+ * keep running
+
+ * returns 0 for success, WD_TIMED_OUT if the watchdog thread did not stop
+ * in time - "handle" is not freed then, and may be destroyed again -
+ * not 0 on other failures
+*******************************************************************************/
+int WDDestroy(wd_handle_ty *handle, size_t timeout_ms);
+
+/*******************************************************************************
+ * restart policy applied by both sides of the watchdog before reviving the
+ * other side (all times in seconds):
+ * "base_delay"   - backoff before the 2nd restart, doubled for every further
+ *                  restart until it reaches "max_delay"
+ * "jitter_pct"   - random +- percentage applied to every delay (0 - 100)
+ * "max_restarts" - restarts allowed within "window" before the circuit breaker
+ *                  opens and restarts stop until the window elapses
+ *                  (0 disables the breaker)
+ * "healthy_time" - a peer that stays alive that long resets the counters
+*******************************************************************************/
+typedef struct wd_restart_policy
+{
+    size_t base_delay;
+    size_t max_delay;
+    size_t jitter_pct;
+    size_t max_restarts;
+    size_t window;
+    size_t healthy_time;
+}wd_restart_policy_ty;
+
+/*******************************************************************************
+ * restart bookkeeping of the watchdog running in the calling process
+*******************************************************************************/
+typedef struct wd_restart_state
+{
+    size_t total_restarts;
+    size_t restarts_in_window;
+    size_t consecutive;
+    size_t breaker_trips;
+    int breaker_open;
+    time_t window_start;
+    time_t last_restart;
+    time_t next_allowed;
+}wd_restart_state_ty;
+
+/*******************************************************************************
+ * sets the restart policy of the watchdog
+ * must be called before MakeMeImmortal(), the policy is inherited by the
+ * watchdog process as well
+
+ * returns 0 for success, not 0 otherwise
+*******************************************************************************/
+int WDSetRestartPolicy(const wd_restart_policy_ty *policy);
+
+/*******************************************************************************
+ * progress checks applied by the watchdog on top of the heartbeats, from the
+ * CPU and I/O counters the kernel keeps for the calling program
+ * (all times in seconds, 0 disables a check):
+ * "stall_time" - neither CPU time nor I/O advanced that long, e.g. the
+ *                program waits forever on a lost lock
+ * "spin_time"  - a thread burned at least "spin_pct" percent of a core that
+ *                long without doing any I/O, e.g. a livelock
+ * a program failing a check is killed and restarted, as if it missed
+ * "max_misses" heartbeats
+ * note: the checks are disabled by default, an idle program is not making
+ *       progress either
+*******************************************************************************/
+typedef struct wd_progress_policy
+{
+    size_t stall_time;
+    size_t spin_time;
+    size_t spin_pct;
+}wd_progress_policy_ty;
+
+/*******************************************************************************
+ * sets the progress checks of the watchdog
+ * must be called before MakeMeImmortal(), the checks run in the watchdog
+ * process
+
+ * returns 0 for success, not 0 otherwise
+*******************************************************************************/
+int WDSetProgressPolicy(const wd_progress_policy_ty *policy);
+
+/*******************************************************************************
+ * how the watchdog receives heartbeats and the stop request:
+ * WD_SIGNAL_HANDLERS - asynchronous SIGUSR1 / SIGUSR2 handlers (default)
+ * WD_SIGNAL_FD       - the signals stay blocked and are read from a signalfd
+ *                      by the scheduler loop, in batches, between its tasks
+ * in both modes the signals are sent to the watchdog thread of the peer only
+*******************************************************************************/
+typedef enum wd_signal_mode
+{
+    WD_SIGNAL_HANDLERS = 0,
+    WD_SIGNAL_FD = 1
+}wd_signal_mode_ty;
+
+/*******************************************************************************
+ * sets the signal mode of the watchdog
+ * must be called before MakeMeImmortal(), the mode is inherited by the
+ * watchdog process as well
+
+ * returns 0 for success, not 0 otherwise
+*******************************************************************************/
+int WDSetSignalMode(wd_signal_mode_ty mode);
+
+/*******************************************************************************
+ * how the watchdog process waits between its tasks:
+ * WD_LOOP_AUTO - in an io_uring when the kernel supports one (default): the
+ *                timeout, the reads of the signalfd, the polls of the
+ *                control channel and of the exit of the app go to the
+ *                kernel together, one system call per wait, and the exit of
+ *                the app counts as all of its beats missed at once
+ *                the poll loop otherwise
+ * WD_LOOP_POLL - the poll loop of the scheduler, a system call per action
+ * the watchdog thread of the app always runs the poll loop
+*******************************************************************************/
+typedef enum wd_event_loop
+{
+    WD_LOOP_AUTO = 0,
+    WD_LOOP_POLL = 1
+}wd_event_loop_ty;
+
+/*******************************************************************************
+ * sets the event loop of the watchdog process
+ * must be called before MakeMeImmortal(), it is inherited by the watchdog
+ * process
+
+ * returns 0 for success, not 0 otherwise
+*******************************************************************************/
+int WDSetEventLoop(wd_event_loop_ty loop);
+
+/*******************************************************************************
+ * memory checks applied by the watchdog, to restart a leaking program on its
+ * own schedule instead of at the hands of the OOM killer:
+ * "limit_mb"   - usage at which the program is restarted (0 - the cgroup
+ *                limit only)
+ * "horizon"    - restart as soon as the growth trend reaches the limit
+ *                within that many seconds
+ * "window"     - seconds of samples the trend is fitted on
+ * "use_pss"    - measure PSS (shared pages split between their users)
+ *                instead of RSS, costlier to sample
+ * "use_cgroup" - measure the memory.current of the program's cgroup, the
+ *                limit is the lower of "limit_mb" and its memory.max
+ * the program is stopped as set by WDSetStopPolicy() and revived
+ * note: the checks are disabled by default
+*******************************************************************************/
+typedef struct wd_memory_policy
+{
+    size_t limit_mb;
+    size_t horizon;
+    size_t window;
+    int use_pss;
+    int use_cgroup;
+}wd_memory_policy_ty;
+
+/*******************************************************************************
+ * sets the memory checks of the watchdog
+ * must be called before MakeMeImmortal(), the checks run in the watchdog
+ * process
+
+ * returns 0 for success, not 0 otherwise
+*******************************************************************************/
+int WDSetMemoryPolicy(const wd_memory_policy_ty *policy);
+
+/*******************************************************************************
+ * latency check applied by the watchdog to the requests the program reports
+ * with WDRecordLatency(), so a program that still heartbeats but serves far
+ * too slowly is restarted as well:
+ * "slo_ns"     - the "percentile" of the latencies over the last "window"
+ *                seconds may not exceed it (0 disables the check)
+ * "percentile" - 1 - 99
+ * "min_count"  - windows with fewer requests are not judged
+ * every interval in violation counts as a missed heartbeat, "max_misses" in
+ * a row restart the program like the memory checks do
+*******************************************************************************/
+typedef struct wd_latency_policy
+{
+    unsigned long slo_ns;
+    size_t percentile;
+    size_t window;
+    size_t min_count;
+}wd_latency_policy_ty;
+
+/*******************************************************************************
+ * sets the latency check of the watchdog
+ * must be called before MakeMeImmortal(), the check runs in the watchdog
+ * process
+
+ * returns 0 for success, not 0 otherwise
+*******************************************************************************/
+int WDSetLatencyPolicy(const wd_latency_policy_ty *policy);
+
+/*******************************************************************************
+ * records a request served in "ns" nanoseconds, for the latency check
+ * lock free, a few ns, every thread records into a histogram of its own
+ * note: a no-op unless a latency check was set before MakeMeImmortal(),
+ *       precision is 25%, 63 threads at a time get a histogram of their
+ *       own, the rest share one
+*******************************************************************************/
+void WDRecordLatency(unsigned long ns);
+
+/*******************************************************************************
+ * failure detection by suspicion instead of a fixed count of misses (phi
+ * accrual): both sides learn the distribution of the time between the beats
+ * of the peer and declare it dead once
+ * phi = -log10(P(a beat comes later than the silence so far)) reaches
+ * "threshold", e.g. 8 for one false suspicion in 10^8 checks, so a quiet
+ * host detects within about an interval and a loaded one waits out its
+ * usual delays:
+ * "threshold"  - 0 disables the detector
+ * "window"     - times between beats remembered, 2 - 1000
+ * "min_std_ms" - floor of the deviation, so a peer that was punctual so far
+ *                is not suspected for a beat a little late
+ * "pause_ms"   - a pause accepted on top of the mean, e.g. for a GC
+ * note: "max_misses" still bounds the silence, set it for the worst load
+ *       the host sees, the detector declares earlier while beats are
+ *       punctual
+*******************************************************************************/
+typedef struct wd_phi_policy
+{
+    double threshold;
+    size_t window;
+    size_t min_std_ms;
+    size_t pause_ms;
+}wd_phi_policy_ty;
+
+/*******************************************************************************
+ * sets the phi accrual detector of the watchdog
+ * must be called before MakeMeImmortal(), both sides of the pair use it
+
+ * returns 0 for success, not 0 otherwise
+*******************************************************************************/
+int WDSetPhiPolicy(const wd_phi_policy_ty *policy);
+
+/*******************************************************************************
+ * adaptive heartbeat rate: the pair starts beating every "interval" of
+ * MakeMeImmortal(), and after every "stable_beats" regular checks of the
+ * peer it doubles the time between the beats, up to "max_interval"
+ * a missed beat, or a memory trend or a latency SLO of the app in trouble,
+ * brings it back to "interval" at once
+ * every beat carries the interval it was sent at, the peer is declared dead
+ * after "max_misses" of those, so the deadline follows the rate
+ * "max_interval" - the slowest rate in seconds, up to 255, 0 disables it
+ * "stable_beats" - regular checks before each step to a slower rate
+ * note: a side that sees trouble beats faster at once, the other follows
+ *       on its next check, within the slow interval
+*******************************************************************************/
+typedef struct wd_rate_policy
+{
+    size_t max_interval;
+    size_t stable_beats;
+}wd_rate_policy_ty;
+
+/*******************************************************************************
+ * sets the adaptive heartbeat rate of the watchdog
+ * must be called before MakeMeImmortal(), both sides of the pair use it
+
+ * returns 0 for success, not 0 otherwise
+*******************************************************************************/
+int WDSetRatePolicy(const wd_rate_policy_ty *policy);
+
+/*******************************************************************************
+ * how the watchdog stops an instance that is still there before it revives
+ * the program, so two instances never run at once:
+ * "drain_ms"   - the handler set by WDSetDrainHandler() is called, and the
+ *                instance has that long to finish its work and exit
+ *                (0 skips the drain)
+ * "term_ms"    - then SIGTERM, and that long to exit before SIGKILL
+ * the default is no drain and 2 seconds after SIGTERM
+ * note: the watchdog blocks for the whole sequence, up to "drain_ms" +
+ *       "term_ms" + 1 second
+*******************************************************************************/
+typedef struct wd_stop_policy
+{
+    size_t drain_ms;
+    size_t term_ms;
+}wd_stop_policy_ty;
+
+/*******************************************************************************
+ * sets the stop sequence of the watchdog
+ * must be called before MakeMeImmortal(), the watchdog process stops the
+ * program and the program stops the watchdog process (without the drain)
+
+ * returns 0 for success, not 0 otherwise
+*******************************************************************************/
+int WDSetStopPolicy(const wd_stop_policy_ty *policy);
+
+/*******************************************************************************
+ * sets the function called when the watchdog wants the program to drain,
+ * e.g. to stop accepting and exit once the requests in flight are served
+ * "on_drain" runs in the watchdog thread and gets "param" and the time
+ * left [ms], it should return quickly
+ * note: the notification is picked up within a second
+*******************************************************************************/
+void WDSetDrainHandler(void (*on_drain)(void *param, size_t ms_left),
+                       void *param);
+
+/*******************************************************************************
+ * which members of a supervision group the failure of one restarts, as in
+ * Erlang/OTP:
+ * WD_ONE_FOR_ONE  - the failed member only
+ * WD_ONE_FOR_ALL  - every member of the group
+ * WD_REST_FOR_ONE - the failed member and the members of a higher rank
+*******************************************************************************/
+typedef enum wd_group_strategy
+{
+    WD_ONE_FOR_ONE = 0,
+    WD_ONE_FOR_ALL = 1,
+    WD_REST_FOR_ONE = 2
+}wd_group_strategy_ty;
+
+/*******************************************************************************
+ * membership of the program in a group of programs that depend on each
+ * other, e.g. a proxy, its cache and its log shipper, each of them made
+ * immortal on its own:
+ * "name"         - the group, the same for all its members - a group named
+ *                  "<group>.<subgroup>" is a member of "<group>" (up to 4
+ *                  levels)
+ * "strategy"     - which members of the group a failure restarts
+ * "rank"         - the dependency order: the members of a restart are
+ *                  stopped at once and started once the members of a lower
+ *                  rank beat again, the members of a rank in parallel
+ *                  (ranks are compared in the groups above as well)
+ * "max_restarts" - restarts of the group within "window" seconds before the
+ *                  next failure is passed on to the group above, which
+ *                  restarts the whole group; the topmost group postpones it
+ *                  until the window elapsed (0 - no limit)
+ * the members of a group set its strategy and limits, a group with
+ * subgroups only restarts one for one with the default limits
+ * note: the restart policy of every member still applies to its restarts
+*******************************************************************************/
+typedef struct wd_group_policy
+{
+    const char *name;
+    wd_group_strategy_ty strategy;
+    size_t rank;
+    size_t max_restarts;
+    size_t window;
+}wd_group_policy_ty;
+
+/*******************************************************************************
+ * makes the program a member of a supervision group
+ * must be called before MakeMeImmortal(), the group is joined by the
+ * watchdog process, DoNotResuscitate() leaves it
+
+ * returns 0 for success, not 0 otherwise
+ * note: "name" may not contain '/' or ',' and is limited to 63 characters,
+ *       a group has at most 32 members, its subgroups included
+*******************************************************************************/
+int WDSetGroupPolicy(const wd_group_policy_ty *policy);
+
+/*******************************************************************************
+ * copies the current restart state of the watchdog into "state"
+
+ * returns 0 for success, not 0 if the watchdog is not running
+*******************************************************************************/
+int WDGetRestartState(wd_restart_state_ty *state);
+
+/*******************************************************************************
+ * returns a shared memory region of "size" bytes named "name", that outlives
+ * the calling process, so an instance revived by the watchdog can resume from
+ * the state its predecessor left behind
+
+ * the region is page aligned and mapped at the same address in every
+ * instance whenever that address is free, so pointers into the region stay
+ * valid - see WDPersistentEpoch() to tell a warm region from a cold one
+
+ * the region is created zeroed if it doesn't exist yet, or if it was created
+ * with a different "size" - a process that still maps the old one keeps it
+
+ * returns NULL on failure, also once the process holds 16 regions
+ * note: "name" may not contain '/' and is limited to 63 characters
+*******************************************************************************/
+void *WDAllocPersistent(const char *name, size_t size);
+
+/*******************************************************************************
+ * returns the number of instances that attached to "region" before the
+ * calling one - 0 means the region was just created and holds no state
+*******************************************************************************/
+unsigned long WDPersistentEpoch(const void *region);
+
+/*******************************************************************************
+ * unmaps "region" and removes it, so the next instance starts cold
+ * DoNotResuscitate() removes the regions as well, but keeps them mapped
+
+ * returns 0 for success, not 0 otherwise
+*******************************************************************************/
+int WDFreePersistent(void *region);
+
+/*******************************************************************************
+ * hands "fd" (e.g. a listening socket) over to the watchdog under "name"
+ * the watchdog holds a duplicate and passes it to every instance it revives,
+ * so a restart doesn't close the socket nor lose its accept backlog
+ * registering a "name" again replaces the previous descriptor
+
+ * returns 0 for success, not 0 otherwise
+ * note: "name" may not contain '=' or ';' and is limited to 31 characters,
+ *       at most 16 descriptors are kept
+*******************************************************************************/
+int WDKeepFd(int fd, const char *name);
+
+/*******************************************************************************
+ * returns the descriptor kept under "name" by the previous instance, or -1 if
+ * the calling process was not revived with such a descriptor
+*******************************************************************************/
+int WDGetKeptFd(const char *name);
+
+/*******************************************************************************
+ * a node of a cluster of programs on several hosts that watch each other
+ * over UDP, by gossiping their heartbeats:
+ * "node_id"     - unique in the cluster
+ * "bind"        - "ip:port" the node listens on ("0.0.0.0:<port>" for any
+ *                 address, port 0 for any port)
+ * "seeds"       - "ip:port,ip:port" of nodes to join the cluster through,
+ *                 NULL for the first node
+ * "interval_ms" - time between the gossip rounds of the node
+ * "fanout"      - members sent a digest every round
+ * "fail_ms"     - a member whose heartbeat did not advance that long failed,
+ *                 should cover a few times the rounds a heartbeat takes to
+ *                 spread (see gossip_bench.out)
+ * "on_failed"   - called with "param", the id and the "ip:port" of a member
+ *                 that failed, NULL for none
+ * "hook"        - program run with the id and the "ip:port" of a member
+ *                 that failed, e.g. a script that restarts it over ssh,
+ *                 NULL for none
+*******************************************************************************/
+typedef struct wd_gossip_config
+{
+    unsigned int node_id;
+    const char *bind;
+    const char *seeds;
+    size_t interval_ms;
+    size_t fanout;
+    size_t fail_ms;
+    void (*on_failed)(void *param, unsigned int node_id, const char *addr);
+    void *param;
+    const char *hook;
+}wd_gossip_config_ty;
+
+typedef struct wd_gossip wd_gossip_ty;
+
+/*******************************************************************************
+ * starts a gossip node as set by "config" in a thread of its own, with
+ * every signal blocked, "on_failed" runs in that thread
+ * independent of MakeMeImmortal(): a node that runs in an immortal program
+ * is revived with it and joins the cluster again
+
+ * returns the node, or NULL on failure
+ * note: a digest carries 32 members at most, a node knows 1024 at most
+*******************************************************************************/
+wd_gossip_ty *WDGossipStart(const wd_gossip_config_ty *config);
+
+/*******************************************************************************
+ * stops the thread of "gossip" and frees it, the other members see the node
+ * fail
+
+ * returns 0 for success, not 0 otherwise
+*******************************************************************************/
+int WDGossipStop(wd_gossip_ty *gossip);
+
 #endif  /*  __WATCHDOG_H__  */
@@ -0,0 +1,59 @@
+/*******************************************************************************
+ * Project:     Watchdog - control channel between the app and wd_app
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#ifndef __WD_CHANNEL_H__
+#define __WD_CHANNEL_H__
+
+/*  environment variable holding the channel end inherited by a spawned peer  */
+#define CHANNEL_ENV "WD_CTL_FD"
+
+enum {CHANNEL_NAME_SIZE = 32};
+
+typedef enum channel_msg_type
+{
+    CHANNEL_KEEP_FD = 1,
+    CHANNEL_WD_TID = 2,
+    CHANNEL_DRAIN = 3
+}channel_msg_type_ty;
+
+typedef struct channel_msg
+{
+    channel_msg_type_ty type;
+    char name[CHANNEL_NAME_SIZE];
+    long arg;
+}channel_msg_ty;
+
+/*******************************************************************************
+ * Creates a connected pair of channel ends, both close-on-exec
+ * "fds[0]" is kept by the caller, "fds[1]" is meant for the spawned peer
+ * returns 0 on success, not 0 otherwise
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+int ChannelCreate(int fds[2]);
+
+/*******************************************************************************
+ * Returns the channel end inherited through CHANNEL_ENV, -1 if there is none
+ * or it is not an open descriptor, and removes CHANNEL_ENV
+ * note: changes the environment, the caller serializes it
+ * Time Complexity: O(1)
+*******************************************************************************/
+int ChannelInherited(void);
+
+/*******************************************************************************
+ * Sends "msg" over "channel", with "fd" attached when it is not -1
+ * returns 0 on success, not 0 otherwise
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+int ChannelSend(int channel, const channel_msg_ty *msg, int fd);
+
+/*******************************************************************************
+ * Receives one pending message from "channel" into "msg" without blocking
+ * an attached descriptor is stored in "fd" (close-on-exec), -1 otherwise
+ * returns 0 if a message was received, not 0 if none is pending
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+int ChannelRecv(int channel, channel_msg_ty *msg, int *fd);
+
+#endif  /*  __WD_CHANNEL_H__  */
@@ -0,0 +1,110 @@
+/*******************************************************************************
+ * Project:     Watchdog - cross-host heartbeats
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * a node of a gossip cluster over UDP: every round it beats its own
+ * heartbeat and sends a digest of the members it knows to "fanout" random
+ * members, which keep the higher heartbeat of every member they get
+ * a digest carries at most GOSSIP_MAX_DIGEST members, taken in turns from
+ * the table, so a node sends the same messages and bytes per second in a
+ * cluster of any size
+ * a member whose heartbeat did not advance for "fail_ms" failed, it is
+ * forgotten after twice that, so a late digest can not revive it
+ * a heartbeat starts from the wall clock [us], so a restarted node is newer
+ * than its old instance
+*******************************************************************************/
+#ifndef __WD_GOSSIP_H__
+#define __WD_GOSSIP_H__
+
+#include <stddef.h>     /*  size_t                      */
+#include "watchdog.h"   /*  wd_gossip_config_ty         */
+
+enum {GOSSIP_MAX_NODES = 1024, GOSSIP_MAX_DIGEST = 32, GOSSIP_MAX_SEEDS = 16,
+      GOSSIP_ADDR_SIZE = 22, GOSSIP_HOOK_SIZE = 256};
+
+typedef struct gossip_stats
+{
+    unsigned long messages_sent;
+    unsigned long messages_received;
+    unsigned long bytes_sent;
+    unsigned long bytes_received;
+    unsigned long dropped;      /* malformed messages, members over the limit */
+    unsigned long failures;
+}gossip_stats_ty;
+
+/*******************************************************************************
+ * Creates a node as set by "config" and binds its socket, non blocking
+ * returns the node, NULL on failure or if "config" is invalid
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+wd_gossip_ty *GossipCreate(const wd_gossip_config_ty *config);
+
+/*******************************************************************************
+ * Closes the socket of "node" and frees it
+ * Time Complexity: O(1)
+*******************************************************************************/
+void GossipDestroy(wd_gossip_ty *node);
+
+/*******************************************************************************
+ * Returns the socket of "node", readable once a digest arrived
+ * Time Complexity: O(1)
+*******************************************************************************/
+int GossipFd(const wd_gossip_ty *node);
+
+/*******************************************************************************
+ * Writes the address the node is bound to ("ip:port") into "addr", e.g. to
+ * seed other nodes with a node bound to port 0
+ * Time Complexity: O(1)
+*******************************************************************************/
+void GossipAddr(const wd_gossip_ty *node, char addr[GOSSIP_ADDR_SIZE]);
+
+/*******************************************************************************
+ * Runs a round: beats and sends a digest to "fanout" members, or to a seed
+ * while it knows none
+ * returns the number of messages sent
+ * Time Complexity: O(members)
+*******************************************************************************/
+size_t GossipRound(wd_gossip_ty *node);
+
+/*******************************************************************************
+ * Merges every digest waiting on the socket, received at "now_ms"
+ * (CLOCK_MONOTONIC)
+ * returns the number of digests merged
+ * Time Complexity: O(digests * GOSSIP_MAX_DIGEST * log(members))
+*******************************************************************************/
+size_t GossipReceive(wd_gossip_ty *node, unsigned long now_ms);
+
+/*******************************************************************************
+ * Finds the members failed by "now_ms": calls "on_failed" and runs "hook"
+ * once for each of them, and forgets the members failed long ago
+ * returns the number of members that failed
+ * Time Complexity: O(members)
+*******************************************************************************/
+size_t GossipCheck(wd_gossip_ty *node, unsigned long now_ms);
+
+/*******************************************************************************
+ * Returns the number of members "node" knows alive, itself excluded
+ * Time Complexity: O(members)
+*******************************************************************************/
+size_t GossipAlive(const wd_gossip_ty *node);
+
+/*******************************************************************************
+ * Returns not 0 if "node" knows member "node_id" alive
+ * Time Complexity: O(log(members))
+*******************************************************************************/
+int GossipIsAlive(const wd_gossip_ty *node, unsigned int node_id);
+
+/*******************************************************************************
+ * Copies the counters of "node" into "stats"
+ * Time Complexity: O(1)
+*******************************************************************************/
+void GossipGetStats(const wd_gossip_ty *node, gossip_stats_ty *stats);
+
+/*******************************************************************************
+ * Returns the time of CLOCK_MONOTONIC [ms]
+ * Time Complexity: O(1)
+*******************************************************************************/
+unsigned long GossipNow(void);
+
+#endif  /*  __WD_GOSSIP_H__  */
@@ -0,0 +1,113 @@
+/*******************************************************************************
+ * Project:     Watchdog - supervision groups
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * the wd_app of every member of a group shares a page per group it belongs
+ * to: its own group and every group above it ("stack.logs" is a group of
+ * "stack"), so a failure of one member restarts the members the strategy
+ * of the group names, in one coordinated step:
+ * - every member named stops its app at once
+ * - then starts it once the named members of a lower rank beat again
+ * a group that restarted too often passes the failure on to the group above
+*******************************************************************************/
+#ifndef __WD_GROUP_H__
+#define __WD_GROUP_H__
+
+#include <stddef.h>     /*  size_t                      */
+#include <time.h>       /*  time_t                      */
+#include <sys/types.h>  /*  pid_t                       */
+#include "watchdog.h"   /*  wd_group_policy_ty          */
+
+/*  environment variable used to hand the policy over to "wd_app"             */
+#define GROUP_POLICY_ENV "WD_GROUP_POLICY"
+
+/*  /dev/shm name of a page is GROUP_PREFIX followed by the group's name      */
+#define GROUP_PREFIX "/wd_group."
+
+enum {GROUP_NAME_SIZE = 64, GROUP_MEMBER_SIZE = 160, GROUP_MAX_DEPTH = 4,
+      GROUP_MAX_MEMBERS = 32};
+
+/*  what the wd_app of a member does next                                     */
+typedef enum group_action
+{
+    GROUP_IDLE = 0,     /* no restart of the member in progress             */
+    GROUP_STOP = 1,     /* stop the app, then GroupDone()                   */
+    GROUP_WAIT = 2,     /* stopped, a member of a lower rank is not up yet  */
+    GROUP_START = 3,    /* start the app, then GroupDone()                  */
+    GROUP_STARTED = 4   /* started, until the new app beats                 */
+}group_action_ty;
+
+typedef struct group group_ty;
+
+/*******************************************************************************
+ * Serializes "policy" into GROUP_POLICY_ENV
+ * returns 0 on success, not 0 if the name is invalid
+ * Time Complexity: O(1)
+*******************************************************************************/
+int GroupPolicyExport(const wd_group_policy_ty *policy);
+
+/*******************************************************************************
+ * Fills "policy" from GROUP_POLICY_ENV, its name is copied into "name"
+ * returns 0 on success, not 0 if the variable is missing or malformed
+ * Time Complexity: O(1)
+*******************************************************************************/
+int GroupPolicyImport(wd_group_policy_ty *policy, char name[GROUP_NAME_SIZE]);
+
+/*******************************************************************************
+ * Joins "member" (a pair name, unique in the tree) to the group of "policy"
+ * and to every group above it, as the member watched by "wd_pid"
+ * a member that joins again, e.g. from a revived wd_app, keeps its place
+ * returns the membership, NULL on failure or if a group is full
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+group_ty *GroupJoin(const wd_group_policy_ty *policy, const char *member,
+                    pid_t wd_pid);
+
+/*******************************************************************************
+ * Removes the member from every group and frees "group"
+ * the page of a group left empty is removed
+ * Time Complexity: O(GROUP_MAX_DEPTH * GROUP_MAX_MEMBERS)
+*******************************************************************************/
+void GroupLeave(group_ty *group);
+
+/*******************************************************************************
+ * Reports that the app of the member failed at "now": the group restarts
+ * the members its strategy names, a group that reached "max_restarts"
+ * within "window" passes the failure on to the group above, which restarts
+ * the whole group that failed
+ * returns the depth of the group that restarts (0 - the member's own),
+ * -1 if the topmost group reached its limit too, the restart is postponed
+ * Time Complexity: O(GROUP_MAX_DEPTH * GROUP_MAX_MEMBERS)
+*******************************************************************************/
+int GroupFailed(group_ty *group, time_t now);
+
+/*******************************************************************************
+ * Returns the next step of the member, "last_beat_us" is the time
+ * (CLOCK_MONOTONIC) of the last beat of its app: a started member is up
+ * once its app beat after GroupDone()
+ * Time Complexity: O(GROUP_MAX_DEPTH * GROUP_MAX_MEMBERS)
+*******************************************************************************/
+group_action_ty GroupNext(group_ty *group, unsigned long last_beat_us);
+
+/*******************************************************************************
+ * Reports that the member did "action" (GROUP_STOP or GROUP_START) at
+ * "now_us" (CLOCK_MONOTONIC)
+ * Time Complexity: O(1)
+*******************************************************************************/
+void GroupDone(group_ty *group, group_action_ty action, unsigned long now_us);
+
+/*******************************************************************************
+ * Returns the name of the group that decided the last restart GroupNext()
+ * returned
+ * Time Complexity: O(1)
+*******************************************************************************/
+const char *GroupActiveName(const group_ty *group);
+
+/*******************************************************************************
+ * Removes the page of group "name"
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+void GroupUnlink(const char *name);
+
+#endif  /*  __WD_GROUP_H__  */
@@ -4,6 +4,36 @@
 #include <stddef.h>
 #include "scheduler.h"
 #include "semaphore.h"
+#include "watchdog.h"
+#include "wd_progress.h"
+#include "wd_memory.h"
+#include "wd_latency.h"
+#include "wd_stop.h"
+#include "wd_stats.h"
+#include "wd_group.h"
+#include "wd_restart.h"
+#include "wd_phi.h"
+#include "wd_rate.h"
+#include "wd_spawn.h"
+#include "wd_registry.h"
+
+/*  name of the app / wd_app pair, inherited by both sides                   */
+#define PAIR_NAME_ENV "WD_NAME"
+
+/*  wd_signal_mode_ty of the pair, inherited by both sides                    */
+#define SIGNAL_MODE_ENV "WD_SIGNAL_MODE"
+
+/*  wd_event_loop_ty of the watchdog process                                  */
+#define EVENT_LOOP_ENV "WD_EVENT_LOOP"
+
+/*  signal mask the app was started with, so wd_app revives it with the same  */
+#define SIGMASK_ENV "WD_APP_SIGMASK"
+
+/*  name of an additional watchdog, set for the wd_app it spawns only         */
+#define HANDLE_NAME_ENV "WD_HANDLE"
+
+/*  pipe a new wd_app writes to once it is armed, set for its spawn only      */
+#define READY_FD_ENV "WD_READY_FD"
 
 enum {INVALID_PID = -1, FALSEE = 0, TRUEE = 1};
 
@@ -11,26 +41,92 @@ enum {SUCCESS = 0, FAILED = 1};
 
 enum {NUM_OF_ADDED_ARGS = 3};
 
+enum {NAME_MAX_SIZE = 128, HANDLE_NAME_SIZE = 32};
+
 enum {MMI_FAIL = 2, BLOCKSIGNALS_FAIL = 3, SEM_DESTROY_FAIL= 4, SEM_WAIT_FAIL = 5,
         CREATE_NEW_THREAD_FAIL = 6};
 
 typedef enum p_type {APP = 0, WD = 1} p_type_ty;
 
-typedef struct wd_params
+/*  the outside world of a watchdog, replaced by a simulation: "clock" runs
+    the scheduler and dates the restart decisions, "spawn" stands for
+    SpawnRun() and "kill" for every signal to the peer, "beat" for the
+    beats with their value if set, "kill" with SIGUSR1 otherwise            */
+typedef struct wd_ops
+{
+    sched_clock_ty clock;
+    int (*spawn)(void *param, pid_t *pid, char *argv[]);
+    int (*kill)(void *param, pid_t pid, int sig);
+    int (*beat)(void *param, pid_t pid, unsigned long value);
+    void *param;
+}wd_ops_ty;
+
+/*  the state of one watchdog, wd_handle_ty of the public API                 */
+typedef struct wd_handle
 {
     size_t interval;
     size_t max_misses;
     int argc;
     char **argv;
+    spawn_ty *spawn;
     pid_t other_pid;
     p_type_ty p_type;
     scheduler_ty *scheduler;
     sem_t have_connection;
+    int ctl_fd;
+    pid_t self_tid;
+    pid_t peer_tid;
+    wd_restart_policy_ty restart_policy;
+    restart_state_ty restart;
+    wd_progress_policy_ty progress_policy;
+    progress_ty progress;
+    stats_page_ty *stats_page;
+    stats_side_ty *stats;
+    registry_ty *registry;
+    long reg_slot;
+    unsigned long last_sign_us;
+    wd_signal_mode_ty signal_mode;
+    wd_event_loop_ty event_loop;
+    int sig_fd;
+    int ready_fd;
+    int is_connecting;
+    wd_memory_policy_ty memory_policy;
+    memory_ty memory;
+    pid_t memory_failed_pid;
+    size_t memory_failures;
+    size_t memory_skips;
+    int planned_restart;
+    int skip_miss;
+    wd_latency_policy_ty latency_policy;
+    latency_ty latency;
+    size_t slo_misses;
+    wd_stop_policy_ty stop_policy;
+    group_ty *group;
+    int peer_stopped;
+    wd_phi_policy_ty phi_policy;
+    phi_ty phi;
+    size_t phi_interval;
+    wd_rate_policy_ty rate_policy;
+    rate_ty rate;
+    size_t beat_interval;
+    ilrd_uid_ty beat_uid;
+    int is_main;
+    char handle[HANDLE_NAME_SIZE];
+    char name[NAME_MAX_SIZE + HANDLE_NAME_SIZE];
+    volatile size_t signal_cnt;
+    volatile int stop_flag;
+    volatile unsigned long last_beat_us;
+    sem_t dnr_return;
+    const wd_ops_ty *ops;
 }wd_params_ty;
 
 int WDFunc(wd_params_ty *params, int should_post);
 
-wd_params_ty *CreateStruct(int argc, char *argv[], size_t interval, size_t max_misses, pid_t other_pid);
+/*  a heartbeat of the peer, what a simulation delivers instead of SIGUSR1,
+    "value" as RatePack() made it                                           */
+void WDReceiveBeat(wd_params_ty *params, unsigned long value);
+
+wd_params_ty *CreateStruct(int argc, char *argv[], size_t interval, size_t max_misses, pid_t other_pid, const char *handle);
 
 int MakeMeImmortal(int argc, char *argv[], size_t interval, size_t max_misses);
 
@@ -0,0 +1,56 @@
+/*******************************************************************************
+ * Project:     Watchdog - descriptors kept across restarts
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#ifndef __WD_KEEPFD_H__
+#define __WD_KEEPFD_H__
+
+#include <stddef.h>     /*  size_t      */
+
+#include "wd_spawn.h"
+
+/*  "name=fd;name=fd" list of the descriptors handed to a revived app         */
+#define KEEPFD_ENV "WD_KEPT_FDS"
+
+/*  descriptors the table holds at most                                       */
+enum {KEEPFD_MAX = 16};
+
+/*******************************************************************************
+ * Stores "fd" under "name", replacing (and closing) a previous one
+ * the table takes ownership of "fd"
+ * returns 0 on success, not 0 if "name" is invalid or the table is full
+ * Time Complexity: O(n)
+*******************************************************************************/
+int KeepFdStore(const char *name, int fd);
+
+/*******************************************************************************
+ * Sends every stored descriptor over "channel" - used to hand the table to a
+ * newly spawned wd_app
+ * returns 0 on success, not 0 otherwise
+ * Time Complexity: O(n)
+*******************************************************************************/
+int KeepFdSendAll(int channel);
+
+/*******************************************************************************
+ * Publishes the table in KEEPFD_ENV of the next spawns of "spawn"
+ * returns 0 on success, not 0 otherwise
+ * Time Complexity: O(n)
+*******************************************************************************/
+int KeepFdExport(spawn_ty *spawn);
+
+/*******************************************************************************
+ * Lists every stored descriptor in "fds", which has room for KEEPFD_MAX, for
+ * the spawned process to inherit them under their current numbers
+ * returns the number of descriptors listed
+ * Time Complexity: O(n)
+*******************************************************************************/
+size_t KeepFdInherit(int *fds);
+
+/*******************************************************************************
+ * Adopts the descriptors inherited through KEEPFD_ENV into the table
+ * Time Complexity: O(n)
+*******************************************************************************/
+void KeepFdImport(void);
+
+#endif  /*  __WD_KEEPFD_H__  */
@@ -0,0 +1,129 @@
+/*******************************************************************************
+ * Project:     Watchdog - request latency SLO
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#ifndef __WD_LATENCY_H__
+#define __WD_LATENCY_H__
+
+#include <stddef.h>     /*  size_t                  */
+#include <sys/types.h>  /*  pid_t                   */
+#include "watchdog.h"   /*  wd_latency_policy_ty    */
+
+/*  environment variable used to hand the policy over to "wd_app"             */
+#define LATENCY_POLICY_ENV "WD_LATENCY_POLICY"
+
+/*  /dev/shm name of a page is LATENCY_PREFIX, the pair's name and the pid    */
+#define LATENCY_PREFIX "/wd_lat."
+
+/*  0 - 3 ns exact, then 4 buckets per power of 2 up to 2^41 ns (~37 min),
+    longer latencies share the last one                                       */
+enum {LATENCY_VERSION = 2, LATENCY_SLOTS = 64, LATENCY_BUCKETS = 160,
+      LATENCY_WINDOW = 64};
+
+/*******************************************************************************
+ * the histogram of one recording thread at a time, nobody else writes it
+ * a thread that exits frees its slot, counts and all: the next thread that
+ * claims it goes on counting, so the histograms never go back
+ * the last slot is shared by the threads that found no free one
+*******************************************************************************/
+typedef struct latency_slot
+{
+    unsigned long owner;
+    unsigned long pad[7];
+    unsigned long hist[LATENCY_BUCKETS];
+}latency_slot_ty;
+
+typedef struct latency_page
+{
+    unsigned long magic;
+    unsigned long version;
+    unsigned long pad[6];
+    latency_slot_ty slots[LATENCY_SLOTS];
+}latency_page_ty;
+
+/*  the watchdog side: cumulative snapshots of the last "window" evaluations  */
+typedef struct latency
+{
+    pid_t pid;
+    latency_page_ty *page;
+    size_t first;
+    size_t cnt;
+    unsigned long last_pct_ns;
+    unsigned long last_count;
+    unsigned long snaps[LATENCY_WINDOW][LATENCY_BUCKETS];
+}latency_ty;
+
+/*******************************************************************************
+ * Serializes "policy" into LATENCY_POLICY_ENV
+ * returns 0 on success, not 0 otherwise
+ * Time Complexity: O(1)
+*******************************************************************************/
+int LatencyPolicyExport(const wd_latency_policy_ty *policy);
+
+/*******************************************************************************
+ * Fills "policy" from LATENCY_POLICY_ENV, or disables the check if the
+ * variable is missing or malformed
+ * Time Complexity: O(1)
+*******************************************************************************/
+void LatencyPolicyImport(wd_latency_policy_ty *policy);
+
+/*******************************************************************************
+ * Creates the page of the pair "name" for the calling process, a page left
+ * by a previous process with the same pid is cleared
+ * WDRecordLatency() records into it from then on
+ * returns 0 on success, not 0 otherwise
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+int LatencyCreate(const char *name);
+
+/*******************************************************************************
+ * Removes the page of the pair "name" created by process "pid"
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+void LatencyUnlink(const char *name, pid_t pid);
+
+/*******************************************************************************
+ * Initializes "latency" as detached
+ * Time Complexity: O(1)
+*******************************************************************************/
+void LatencyInit(latency_ty *latency);
+
+/*******************************************************************************
+ * Maps the page of the pair "name" created by "pid" and forgets the window
+ * returns 0 on success, not 0 if the page doesn't exist (yet)
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+int LatencyAttach(latency_ty *latency, const char *name, pid_t pid);
+
+/*******************************************************************************
+ * Unmaps the page mapped by LatencyAttach()
+ * Time Complexity: O(1)
+*******************************************************************************/
+void LatencyDetach(latency_ty *latency);
+
+/*******************************************************************************
+ * Returns the bucket of the histograms that counts a latency of "ns"
+ * Time Complexity: O(1)
+*******************************************************************************/
+size_t LatencyBucket(unsigned long ns);
+
+/*******************************************************************************
+ * Returns the largest latency in ns that "bucket" counts
+ * note: the last bucket counts the longer latencies as well
+ * Time Complexity: O(1)
+*******************************************************************************/
+unsigned long LatencyBucketUpperBound(size_t bucket);
+
+/*******************************************************************************
+ * Takes a snapshot of the page and computes the "percentile" of the requests
+ * recorded over the last "window_len" snapshots (LATENCY_WINDOW at most)
+ * returns 1 if the percentile is above "slo_ns" and at least "min_count"
+ * requests were recorded, 0 otherwise
+ * note: "last_pct_ns" is the upper bound of the bucket holding the percentile
+ * Time Complexity: O(LATENCY_SLOTS * LATENCY_BUCKETS)
+*******************************************************************************/
+int LatencyEvaluate(latency_ty *latency, const wd_latency_policy_ty *policy,
+                    size_t window_len);
+
+#endif  /*  __WD_LATENCY_H__  */
@@ -0,0 +1,103 @@
+/*******************************************************************************
+ * Project:     Watchdog - binary event log
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#ifndef __WD_LOG_H__
+#define __WD_LOG_H__
+
+#include <stddef.h>     /*  size_t  */
+
+/*  /dev/shm name of the ring is LOG_PREFIX followed by the pair's name       */
+#define LOG_PREFIX "/wd_log."
+
+enum {LOG_VERSION = 1, LOG_RECORDS = 1024, LOG_TEXT_SIZE = 24};
+
+typedef enum log_event
+{
+    LOG_ERROR = 1,          /* text: message, arg0: errno                     */
+    LOG_BEAT_SENT,          /* arg0: peer pid, arg1: scheduler lag [us]       */
+    LOG_BEAT_FAILED,        /* arg0: peer pid, arg1: errno                    */
+    LOG_CONNECTED,          /* arg0: peer pid                                 */
+    LOG_WD_EXISTS,          /* arg0: watchdog pid found, arg1: its generation */
+    LOG_REVIVED,            /* arg0: new peer pid, arg1: restarts so far      */
+    LOG_RESTART_POSTPONED,  /* arg0: peer pid, arg1: next allowed [epoch s]   */
+    LOG_NO_PROGRESS,        /* arg0: peer pid, arg1: progress_verdict_ty      */
+    LOG_WD_APP_STARTED,     /* arg0: pid, arg1: app pid                       */
+    LOG_SCHEDULER_STOPPED,  /* arg0: pid                                      */
+    LOG_MEMORY_RESTART,     /* arg0: peer pid, arg1: usage [KB]               */
+    LOG_SLO_RESTART,        /* arg0: peer pid, arg1: latency percentile [ns]  */
+    LOG_PEER_STOPPED,       /* text: last phase, arg0: peer pid, arg1: [us]   */
+    LOG_DRAIN_REQUESTED,    /* arg0: pid, arg1: time to exit [ms]             */
+    LOG_GROUP_RESTART,      /* text: group, arg0: peer pid, arg1: its depth   */
+    LOG_SUSPECTED,          /* arg0: peer pid, arg1: phi [1/1000]             */
+    LOG_RATE_CHANGED,       /* arg0: peer pid, arg1: beat interval [s]        */
+    LOG_APP_ADOPTED,        /* arg0: app pid, arg1: the app it replaced       */
+    LOG_EVENTS_CNT
+}log_event_ty;
+
+/*******************************************************************************
+ * one 64 byte record, "seq" is 0 while it is written and its index + 1 once
+ * it is complete
+*******************************************************************************/
+typedef struct log_record
+{
+    unsigned long seq;
+    unsigned long time_ns;      /* CLOCK_MONOTONIC                            */
+    unsigned int event;
+    unsigned int pid;
+    long arg0;
+    long arg1;
+    char text[LOG_TEXT_SIZE];
+}log_record_ty;
+
+/*******************************************************************************
+ * the ring shared by both sides of a pair, writers claim records with an
+ * atomic increment of "head" and overwrite the oldest ones
+*******************************************************************************/
+typedef struct log_ring
+{
+    unsigned long magic;
+    unsigned long version;
+    long realtime_offset_ns;    /* CLOCK_REALTIME - CLOCK_MONOTONIC at creation */
+    unsigned long head;
+    log_record_ty records[LOG_RECORDS];
+}log_ring_ty;
+
+/*******************************************************************************
+ * Maps the ring of the pair "name" for this process, creating it if needed
+ * later calls keep the ring that is already mapped
+ * returns 0 on success, not 0 otherwise
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+int LogOpen(const char *name);
+
+/*******************************************************************************
+ * Removes the ring of the pair "name", the mapping of this process stays
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+void LogUnlink(const char *name);
+
+/*******************************************************************************
+ * Appends an event to the ring, dropped if no ring is mapped
+ * "text" may be NULL, it is truncated to LOG_TEXT_SIZE - 1 characters
+ * async-signal-safe, lock free, never blocks
+ * Time Complexity: O(1)
+*******************************************************************************/
+void LogEvent(log_event_ty event, long arg0, long arg1, const char *text);
+
+/*******************************************************************************
+ * Logs LOG_ERROR with "msg" and the current errno
+ * without a ring the message goes to stderr, so early failures are not lost
+ * Time Complexity: O(1)
+*******************************************************************************/
+void LogError(const char *msg);
+
+/*******************************************************************************
+ * Copies the record of "ring" at "index" into "copy" if it is complete
+ * returns 0 on success, not 0 if it is being written or was never written
+ * Time Complexity: O(1)
+*******************************************************************************/
+int LogReadRecord(const log_ring_ty *ring, unsigned long index, log_record_ty *copy);
+
+#endif  /*  __WD_LOG_H__  */
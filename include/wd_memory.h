@@ -0,0 +1,86 @@
+/*******************************************************************************
+ * Project:     Watchdog - memory growth checks
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#ifndef __WD_MEMORY_H__
+#define __WD_MEMORY_H__
+
+#include <time.h>       /*  time_t                  */
+#include <sys/types.h>  /*  pid_t                   */
+#include "watchdog.h"   /*  wd_memory_policy_ty     */
+
+/*  environment variable used to hand the policy over to "wd_app"             */
+#define MEMORY_POLICY_ENV "WD_MEMORY_POLICY"
+
+enum {MEMORY_SAMPLES = 64, MEMORY_MIN_SAMPLES = 5, MEMORY_BUF_SIZE = 4096};
+
+typedef enum memory_verdict
+{
+    MEMORY_OK = 0,
+    MEMORY_OVER_LIMIT = 1,
+    MEMORY_TREND = 2
+}memory_verdict_ty;
+
+/*  all descriptors are opened by MemoryAttach(), sampling only pread()s      */
+typedef struct memory
+{
+    pid_t pid;
+    int fd;                 /* statm, smaps_rollup or the cgroup's memory.current */
+    unsigned long limit;
+    size_t first;
+    size_t cnt;
+    time_t times[MEMORY_SAMPLES];
+    unsigned long bytes[MEMORY_SAMPLES];
+    unsigned long last_bytes;
+    long eta;               /* seconds until the limit is reached, -1 if never */
+    char buf[MEMORY_BUF_SIZE];
+}memory_ty;
+
+/*******************************************************************************
+ * Serializes "policy" into MEMORY_POLICY_ENV
+ * returns 0 on success, not 0 otherwise
+ * Time Complexity: O(1)
+*******************************************************************************/
+int MemoryPolicyExport(const wd_memory_policy_ty *policy);
+
+/*******************************************************************************
+ * Fills "policy" from MEMORY_POLICY_ENV, or disables the checks if the
+ * variable is missing or malformed
+ * Time Complexity: O(1)
+*******************************************************************************/
+void MemoryPolicyImport(wd_memory_policy_ty *policy);
+
+/*******************************************************************************
+ * Initializes "memory" as detached
+ * Time Complexity: O(1)
+*******************************************************************************/
+void MemoryInit(memory_ty *memory);
+
+/*******************************************************************************
+ * Opens the counter of "pid" selected by "policy" and forgets the samples
+ * with "use_cgroup" the limit is the lower of "limit_mb" and memory.max
+ * returns 0 on success, not 0 otherwise
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+int MemoryAttach(memory_ty *memory, pid_t pid, const wd_memory_policy_ty *policy);
+
+/*******************************************************************************
+ * Closes the descriptor opened by MemoryAttach()
+ * Time Complexity: O(1)
+*******************************************************************************/
+void MemoryDetach(memory_ty *memory);
+
+/*******************************************************************************
+ * Samples the usage at time "now" and checks it against "policy":
+ * MEMORY_OVER_LIMIT - the usage reached the limit
+ * MEMORY_TREND      - the least squares line through the samples of the last
+ *                     "window" seconds reaches the limit within "horizon"
+ * note: does not allocate, the trend needs MEMORY_MIN_SAMPLES samples and
+ *       uses the MEMORY_SAMPLES most recent ones at most
+ * Time Complexity: O(MEMORY_SAMPLES)
+*******************************************************************************/
+memory_verdict_ty MemorySample(memory_ty *memory,
+                               const wd_memory_policy_ty *policy, time_t now);
+
+#endif  /*  __WD_MEMORY_H__  */
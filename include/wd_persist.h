@@ -0,0 +1,32 @@
+/*******************************************************************************
+ * Project:     Watchdog - persistent state regions
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#ifndef __WD_PERSIST_H__
+#define __WD_PERSIST_H__
+
+#include <stddef.h>     /*  size_t  */
+
+/*  bumped whenever "persist_header_ty" changes, older regions are recreated  */
+enum {PERSIST_VERSION = 1};
+
+/*  lives in the first page of every region, the caller's data follows it     */
+typedef struct persist_header
+{
+    unsigned long magic;
+    unsigned long version;
+    unsigned long epoch;
+    size_t size;
+    void *base;
+}persist_header_ty;
+
+/*******************************************************************************
+ * Unlinks every region allocated by the calling process, so it won't survive
+ * the process anymore - the mappings themselves stay valid until exit
+ * called by DoNotResuscitate()
+ * Time Complexity: O(n)
+*******************************************************************************/
+void PersistUnlinkAll(void);
+
+#endif  /*  __WD_PERSIST_H__  */
@@ -0,0 +1,95 @@
+/*******************************************************************************
+ * Project:     Watchdog - phi accrual failure detector
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * the watchdog learns the mean and the deviation of the time between the
+ * beats of its peer over the last "window" of them, and suspects it by
+ * phi = -log10(P(a beat comes later than the silence so far)), assuming the
+ * times are normally distributed
+ * the beats are queued by the handler, the check drains the queue, so the
+ * estimator is never updated by a handler that interrupted a check
+*******************************************************************************/
+#ifndef __WD_PHI_H__
+#define __WD_PHI_H__
+
+#include <stddef.h>     /*  size_t              */
+#include "watchdog.h"   /*  wd_phi_policy_ty    */
+
+/*  environment variable used to hand the policy over to "wd_app"             */
+#define PHI_POLICY_ENV "WD_PHI_POLICY"
+
+enum {PHI_MAX_WINDOW = 1000, PHI_QUEUE = 16};
+
+typedef struct phi
+{
+    /* written by the beats, a handler may interrupt the check */
+    unsigned long arrivals[PHI_QUEUE];
+    size_t head;
+    size_t tail;
+    unsigned long latest_us;
+
+    /* a ring of the last "window" times between beats, of the check only */
+    unsigned long last_us;
+    double intervals[PHI_MAX_WINDOW];
+    size_t first;
+    size_t cnt;
+    size_t window;
+    double sum;
+    double sum_sq;
+    double min_std_us;
+    double pause_us;
+}phi_ty;
+
+/*******************************************************************************
+ * Serializes "policy" into PHI_POLICY_ENV
+ * returns 0 on success, not 0 if "policy" is invalid
+ * Time Complexity: O(1)
+*******************************************************************************/
+int PhiPolicyExport(const wd_phi_policy_ty *policy);
+
+/*******************************************************************************
+ * Fills "policy" from PHI_POLICY_ENV, or disables the detector if the
+ * variable is missing or malformed
+ * Time Complexity: O(1)
+*******************************************************************************/
+void PhiPolicyImport(wd_phi_policy_ty *policy);
+
+/*******************************************************************************
+ * Initializes "phi" as set by "policy" for beats every "interval_us": the
+ * history starts with two times a quarter of the interval apart, the
+ * silence starts at "now_us"
+ * Time Complexity: O(1)
+*******************************************************************************/
+void PhiInit(phi_ty *phi, const wd_phi_policy_ty *policy,
+             unsigned long interval_us, unsigned long now_us);
+
+/*******************************************************************************
+ * Starts the silence of a new peer at "now_us", the history is kept and the
+ * beats still queued are dropped
+ * Time Complexity: O(1)
+*******************************************************************************/
+void PhiRestart(phi_ty *phi, unsigned long now_us);
+
+/*******************************************************************************
+ * Adds the queued beats to the history, then forgets it for the one of
+ * beats every "interval_us", as PhiInit() starts it
+ * Time Complexity: O(1) per beat queued
+*******************************************************************************/
+void PhiRescale(phi_ty *phi, unsigned long interval_us);
+
+/*******************************************************************************
+ * Queues a beat that arrived at "now_us", async-signal-safe
+ * a beat that finds the queue full still ends the silence
+ * Time Complexity: O(1)
+*******************************************************************************/
+void PhiBeat(phi_ty *phi, unsigned long now_us);
+
+/*******************************************************************************
+ * Adds the queued beats to the history and returns phi of the silence from
+ * the last beat until "now_us"
+ * Time Complexity: O(1) per beat queued
+*******************************************************************************/
+double PhiValue(phi_ty *phi, unsigned long now_us);
+
+#endif  /*  __WD_PHI_H__  */
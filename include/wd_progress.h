@@ -0,0 +1,111 @@
+/*******************************************************************************
+ * Project:     Watchdog - progress based liveness
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#ifndef __WD_PROGRESS_H__
+#define __WD_PROGRESS_H__
+
+#include <time.h>       /*  time_t                  */
+#include <sys/types.h>  /*  pid_t                   */
+#include "watchdog.h"   /*  wd_progress_policy_ty   */
+
+/*  environment variable used to hand the policy over to "wd_app"             */
+#define PROGRESS_POLICY_ENV "WD_PROGRESS_POLICY"
+
+enum {PROGRESS_MAX_THREADS = 64, PROGRESS_BUF_SIZE = 1024,
+      PROGRESS_RESCAN = 60};
+
+typedef enum progress_verdict
+{
+    PROGRESS_OK = 0,
+    PROGRESS_STALLED = 1,
+    PROGRESS_SPINNING = 2
+}progress_verdict_ty;
+
+typedef struct progress_thread
+{
+    int fd;
+    pid_t tid;
+    unsigned long run_ns;
+    unsigned long run_ns_at_io;
+}progress_thread_ty;
+
+/*  all descriptors are opened by ProgressAttach(), sampling only pread()s,
+    the thread set is rescanned through "task_fd", the open task directory    */
+typedef struct progress
+{
+    pid_t pid;
+    pid_t skip_tid;
+    int task_fd;
+    int stat_fd;
+    int io_fd;
+    int skip_io_fd;
+    size_t threads_cnt;
+    size_t samples;
+    unsigned long cpu_ticks;
+    unsigned long io_chars;
+    time_t last_progress;
+    time_t last_io;
+    progress_thread_ty threads[PROGRESS_MAX_THREADS];
+    char buf[PROGRESS_BUF_SIZE];
+}progress_ty;
+
+/*******************************************************************************
+ * Serializes "policy" into PROGRESS_POLICY_ENV
+ * returns 0 on success, not 0 otherwise
+ * Time Complexity: O(1)
+*******************************************************************************/
+int ProgressPolicyExport(const wd_progress_policy_ty *policy);
+
+/*******************************************************************************
+ * Fills "policy" from PROGRESS_POLICY_ENV, or disables both checks if the
+ * variable is missing or malformed
+ * Time Complexity: O(1)
+*******************************************************************************/
+void ProgressPolicyImport(wd_progress_policy_ty *policy);
+
+/*******************************************************************************
+ * Initializes "progress" as detached
+ * Time Complexity: O(1)
+*******************************************************************************/
+void ProgressInit(progress_ty *progress);
+
+/*******************************************************************************
+ * Opens the /proc counters of "pid", its task directory and the counters of
+ * its threads, except "skip_tid"
+ * (the watchdog thread of the app, which always makes progress) - 0 if none
+ * returns 0 on success, not 0 otherwise
+ * Time Complexity: O(threads)
+*******************************************************************************/
+int ProgressAttach(progress_ty *progress, pid_t pid, pid_t skip_tid, time_t now);
+
+/*******************************************************************************
+ * Closes every descriptor opened by ProgressAttach()
+ * Time Complexity: O(threads)
+*******************************************************************************/
+void ProgressDetach(progress_ty *progress);
+
+/*******************************************************************************
+ * Samples the counters at time "now" and checks them against "policy":
+ * PROGRESS_STALLED  - neither CPU time nor I/O advanced for "stall_time"
+ * PROGRESS_SPINNING - a thread burned "spin_pct" of the time since the last
+ *                     I/O, for at least "spin_time", without any I/O
+ * note: does not allocate nor open anything but the counters of new threads,
+ *       the thread set is refreshed every PROGRESS_RESCAN samples only
+ * Time Complexity: O(threads)
+*******************************************************************************/
+progress_verdict_ty ProgressSample(progress_ty *progress,
+                                   const wd_progress_policy_ty *policy,
+                                   time_t now);
+
+/*******************************************************************************
+ * Reads the file of "fd" from offset 0 into "buf" of "size" bytes and
+ * terminates it - no lseek and no path walk, so /proc counters kept open
+ * are read again as they are now
+ * returns 0 on success, not 0 if "fd" is -1, empty or the read failed
+ * Time Complexity: O(size)
+*******************************************************************************/
+int ProgressReadFile(int fd, char *buf, size_t size);
+
+#endif  /*  __WD_PROGRESS_H__  */
@@ -0,0 +1,102 @@
+/*******************************************************************************
+ * Project:     Watchdog - adaptive heartbeat rate
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * every beat carries, above its send time, the interval its sender beats at
+ * and the interval the sender wishes the pair to beat at
+ * a side wishes a slower rate after "stable_beats" regular checks of its
+ * peer and the fastest one as soon as a check is not regular, the pair runs
+ * at the faster of the two wishes
+ * a faster rate is taken at once, a slower one only after a beat announced
+ * it, so the deadline of the peer, which follows the interval of the last
+ * beat, never falls behind
+*******************************************************************************/
+#ifndef __WD_RATE_H__
+#define __WD_RATE_H__
+
+#include <stddef.h>     /*  size_t              */
+#include "watchdog.h"   /*  wd_rate_policy_ty   */
+
+/*  environment variable used to hand the policy over to "wd_app"             */
+#define RATE_POLICY_ENV "WD_RATE_POLICY"
+
+/*  the send time takes the low 48 bits of a beat, 8 years of microseconds    */
+#define RATE_TIME_MASK 0xffffffffffffUL
+
+enum {RATE_MAX_INTERVAL = 255};
+
+typedef struct rate
+{
+    /* written by the beats of the peer */
+    size_t peer_interval;
+    size_t peer_wish;
+
+    /* of the scheduler of the watchdog only */
+    size_t base;
+    size_t max;
+    size_t stable_beats;
+    size_t stable;
+    size_t wish;
+    size_t current;
+    size_t announced;
+    int told;
+}rate_ty;
+
+/*******************************************************************************
+ * Serializes "policy" into RATE_POLICY_ENV
+ * returns 0 on success, not 0 if "policy" is invalid
+ * Time Complexity: O(1)
+*******************************************************************************/
+int RatePolicyExport(const wd_rate_policy_ty *policy);
+
+/*******************************************************************************
+ * Fills "policy" from RATE_POLICY_ENV, or disables the adaptive rate if the
+ * variable is missing or malformed
+ * Time Complexity: O(1)
+*******************************************************************************/
+void RatePolicyImport(wd_rate_policy_ty *policy);
+
+/*******************************************************************************
+ * Initializes "rate" as set by "policy" for a pair that beats every
+ * "interval" seconds at the fastest: it starts there, and expects the peer
+ * as slow as the policy allows until its first beat
+ * Time Complexity: O(1)
+*******************************************************************************/
+void RateInit(rate_ty *rate, const wd_rate_policy_ty *policy, size_t interval);
+
+/*******************************************************************************
+ * A new peer: back to the fastest rate, the peer is not known yet
+ * Time Complexity: O(1)
+*******************************************************************************/
+void RateRestart(rate_ty *rate);
+
+/*******************************************************************************
+ * Takes the verdict of a check of the peer and returns the interval to beat
+ * and check at from now on
+ * Time Complexity: O(1)
+*******************************************************************************/
+size_t RateUpdate(rate_ty *rate, int is_regular);
+
+/*******************************************************************************
+ * Returns the value of a beat sent at "now_us", and notes that the peer is
+ * told of the announced interval
+ * Time Complexity: O(1)
+*******************************************************************************/
+unsigned long RatePack(rate_ty *rate, unsigned long now_us);
+
+/*******************************************************************************
+ * Takes the intervals of the peer out of the value of its beat, and returns
+ * its send time, async-signal-safe
+ * a beat that carries no interval stands for the fastest rate
+ * Time Complexity: O(1)
+*******************************************************************************/
+unsigned long RateUnpack(rate_ty *rate, unsigned long value);
+
+/*******************************************************************************
+ * Returns the interval the peer beats at, by its last beat
+ * Time Complexity: O(1)
+*******************************************************************************/
+size_t RatePeerInterval(const rate_ty *rate);
+
+#endif  /*  __WD_RATE_H__  */
@@ -0,0 +1,141 @@
+/*******************************************************************************
+ * Project:     Watchdog - shared memory registry of the pairs
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * one record per pair name, in a table mapped from /dev/shm by every app,
+ * every wd_app and any tool: who the app and its watchdog are, how many
+ * wd_apps the pair had and when each side beat last
+ * a record is found by the hash of its name, probing the next ones, and is
+ * read without a lock - writers take its sequence lock
+ * a record with no live process is free for another name
+*******************************************************************************/
+#ifndef __WD_REGISTRY_H__
+#define __WD_REGISTRY_H__
+
+#include <stddef.h>     /*  size_t  */
+#include <sys/types.h>  /*  pid_t   */
+
+/*  /dev/shm name of the registry of the pairs                                */
+#define REGISTRY_SHM "/wd_registry"
+
+enum {REGISTRY_VERSION = 2, REGISTRY_RECORDS = 256, REGISTRY_NAME_SIZE = 160};
+
+/*  beat_ns[] of a record: the app side and the wd_app side                   */
+typedef enum registry_side {REGISTRY_APP_SIDE = 0, REGISTRY_WD_SIDE = 1} registry_side_ty;
+
+/*******************************************************************************
+ * "seq" is a sequence lock: 0 for a record never used, odd while a writer
+ * updates it, readers retry until they copy it with the same even value
+ * "app_tid" is the watchdog thread of the app, which takes the beats
+ * "app_start" and "wd_start" are the start times of the processes, as
+ * RegistryStartTime() tells them: a pid recycled by another process has a
+ * start time of its own
+ * "generation" grows with every wd_app that took the record
+ * "beat_ns" are CLOCK_MONOTONIC, stored atomically outside of the lock, on
+ * every tick of the side - whether or not its peer took the beat
+*******************************************************************************/
+typedef struct registry_record
+{
+    unsigned long seq;
+    unsigned long hash;
+    char name[REGISTRY_NAME_SIZE];
+    unsigned long app_pid;
+    unsigned long app_tid;
+    unsigned long app_start;
+    unsigned long wd_pid;
+    unsigned long wd_start;
+    unsigned long generation;
+    unsigned long beat_ns[2];
+}registry_record_ty;
+
+typedef struct registry
+{
+    unsigned long magic;
+    unsigned long version;
+    registry_record_ty records[REGISTRY_RECORDS];
+}registry_ty;
+
+/*******************************************************************************
+ * Maps the registry "shm_name", REGISTRY_SHM for the one of the pairs,
+ * creating it if "create" is not 0
+ * returns NULL on failure
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+registry_ty *RegistryOpen(const char *shm_name, int create);
+
+/*******************************************************************************
+ * Unmaps "registry"
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+void RegistryClose(registry_ty *registry);
+
+/*******************************************************************************
+ * Removes the registry "shm_name"
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+void RegistryUnlink(const char *shm_name);
+
+/*******************************************************************************
+ * Returns the slot of the record of "name", -1 if there is none
+ * lock free, never blocks a writer
+ * Time Complexity: O(1) on average, O(REGISTRY_RECORDS) at worst
+*******************************************************************************/
+long RegistryFind(const registry_ty *registry, const char *name);
+
+/*******************************************************************************
+ * Returns the slot of the record of "name", taking a free one if there is
+ * none, with the caller as the process of "side"
+ * returns -1 if the registry is full
+ * Time Complexity: O(1) on average, O(REGISTRY_RECORDS) at worst
+*******************************************************************************/
+long RegistryAttach(registry_ty *registry, const char *name,
+                    registry_side_ty side);
+
+/*******************************************************************************
+ * Copies a consistent snapshot of the record in "slot" into "copy"
+ * returns 0 on success, not 0 if a writer held it all along
+ * Time Complexity: O(1) (retries while a writer is at it)
+*******************************************************************************/
+int RegistryRead(const registry_ty *registry, size_t slot,
+                 registry_record_ty *copy);
+
+/*******************************************************************************
+ * Brackets an update of the record in "slot", returned by the first
+ * a writer that died in between holds the lock until the next one breaks it
+ * Time Complexity: O(1) (waits while another writer is at it)
+*******************************************************************************/
+registry_record_ty *RegistryWriteBegin(registry_ty *registry, size_t slot);
+void RegistryWriteEnd(registry_record_ty *record);
+
+/*******************************************************************************
+ * Stamps the beat of "side" in the record in "slot"
+ * async-signal-safe, lock free
+ * Time Complexity: O(1)
+*******************************************************************************/
+void RegistryBeat(registry_ty *registry, size_t slot, registry_side_ty side);
+
+/*******************************************************************************
+ * Returns the time since "side" of "record" last beat in nanoseconds, the
+ * largest unsigned long if it never did
+ * Time Complexity: O(1)
+*******************************************************************************/
+unsigned long RegistryBeatAge(const registry_record_ty *record,
+                              registry_side_ty side);
+
+/*******************************************************************************
+ * Returns the start time of "pid" since boot in clock ticks, from /proc,
+ * 0 if it is gone or a zombie
+ * allocates nothing
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+unsigned long RegistryStartTime(pid_t pid);
+
+/*******************************************************************************
+ * Returns not 0 if "pid" runs and is the process that started at "start",
+ * any process of that pid if "start" is 0
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+int RegistryIsAlive(pid_t pid, unsigned long start);
+
+#endif  /*  __WD_REGISTRY_H__  */
@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * Project:     Watchdog - restart policy
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#ifndef __WD_RESTART_H__
+#define __WD_RESTART_H__
+
+#include <time.h>       /*  time_t                                      */
+#include "watchdog.h"   /*  wd_restart_policy_ty, wd_restart_state_ty   */
+
+/*  environment variable used to hand the policy over to "wd_app"             */
+#define RESTART_POLICY_ENV "WD_RESTART_POLICY"
+
+/*  the bookkeeping WDGetRestartState() reports, and the state of the jitter  */
+typedef struct restart_state
+{
+    wd_restart_state_ty counters;
+    unsigned int seed;
+}restart_state_ty;
+
+/*******************************************************************************
+ * Fills "policy" with the default restart policy
+ * Time Complexity: O(1)
+*******************************************************************************/
+void RestartPolicyDefault(wd_restart_policy_ty *policy);
+
+/*******************************************************************************
+ * Serializes "policy" into the RESTART_POLICY_ENV environment variable, so
+ * every process spawned afterwards inherits it
+ * returns 0 on success, not 0 otherwise
+ * Time Complexity: O(1)
+*******************************************************************************/
+int RestartPolicyExport(const wd_restart_policy_ty *policy);
+
+/*******************************************************************************
+ * Fills "policy" from the RESTART_POLICY_ENV environment variable, or with the
+ * default policy if the variable is missing or malformed
+ * Time Complexity: O(1)
+*******************************************************************************/
+void RestartPolicyImport(wd_restart_policy_ty *policy);
+
+/*******************************************************************************
+ * Resets "state" to "no restarts so far"
+ * Time Complexity: O(1)
+*******************************************************************************/
+void RestartStateInit(restart_state_ty *state);
+
+/*******************************************************************************
+ * Returns 1 if "policy" allows a restart at time "now", 0 if the restart has to
+ * be postponed - either because the backoff delay has not elapsed yet or
+ * because the circuit breaker is open
+ * note: may close a breaker whose window has elapsed (half-open state)
+ * Time Complexity: O(1)
+*******************************************************************************/
+int RestartIsAllowed(const wd_restart_policy_ty *policy,
+                     restart_state_ty *state, time_t now);
+
+/*******************************************************************************
+ * Records a restart performed at time "now" and computes the earliest time of
+ * the next one: exponential backoff with jitter, capped at "max_delay"
+ * Opens the circuit breaker once "max_restarts" are reached inside "window"
+ * Time Complexity: O(1)
+*******************************************************************************/
+void RestartRecord(const wd_restart_policy_ty *policy,
+                   restart_state_ty *state, time_t now);
+
+/*******************************************************************************
+ * Reports that the peer is alive at time "now"
+ * once it stayed healthy for "healthy_time" since the last restart, the
+ * backoff and the circuit breaker are reset
+ * Time Complexity: O(1)
+*******************************************************************************/
+void RestartReportHealthy(const wd_restart_policy_ty *policy,
+                          restart_state_ty *state, time_t now);
+
+#endif  /*  __WD_RESTART_H__  */
@@ -0,0 +1,103 @@
+/*******************************************************************************
+ * Project:     Watchdog - table of heartbeat slots
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * liveness of many threads or clients of one program: each beats its own
+ * slot and one scan finds every slot silent for longer than its timeout
+ * the table is a structure of arrays, so the scan is a vectorized pass over
+ * two arrays of 64 bit values - AVX2 or SSE2 when the CPU has them
+*******************************************************************************/
+#ifndef __WD_SLOTS_H__
+#define __WD_SLOTS_H__
+
+#include <stddef.h>     /*  size_t  */
+
+/*  slots are scanned in groups of SLOTS_ALIGN, one bitmap word per group     */
+enum {SLOTS_ALIGN = 64};
+
+typedef enum slots_kernel
+{
+    SLOTS_SCALAR = 0,
+    SLOTS_SSE2 = 1,
+    SLOTS_AVX2 = 2,
+    SLOTS_BEST = 3
+}slots_kernel_ty;
+
+typedef struct wd_slots wd_slots_ty;
+
+/*******************************************************************************
+ * Creates a table of at least "capacity" slots, all of them disarmed
+ * the scan runs the best kernel the CPU supports
+ * returns the table on success, NULL otherwise
+ * Time Complexity: O(capacity)
+*******************************************************************************/
+wd_slots_ty *SlotsCreate(size_t capacity);
+
+/*******************************************************************************
+ * Frees "slots"
+ * Time Complexity: O(1)
+*******************************************************************************/
+void SlotsDestroy(wd_slots_ty *slots);
+
+/*******************************************************************************
+ * Returns the number of slots of "slots", "capacity" rounded up to
+ * SLOTS_ALIGN
+ * Time Complexity: O(1)
+*******************************************************************************/
+size_t SlotsCapacity(const wd_slots_ty *slots);
+
+/*******************************************************************************
+ * Arms slot "index": it expires once it is silent for more than "timeout_ns"
+ * counts as a beat
+ * note: undefined behaviour if "index" is out of the table
+ * Time Complexity: O(1)
+*******************************************************************************/
+void SlotsArm(wd_slots_ty *slots, size_t index, unsigned long timeout_ns);
+
+/*******************************************************************************
+ * Disarms slot "index", it never expires
+ * note: undefined behaviour if "index" is out of the table
+ * Time Complexity: O(1)
+*******************************************************************************/
+void SlotsDisarm(wd_slots_ty *slots, size_t index);
+
+/*******************************************************************************
+ * A beat of slot "index", one clock read and one store
+ * async-signal-safe, lock free, every slot may beat from its own thread
+ * note: undefined behaviour if "index" is out of the table
+ * Time Complexity: O(1)
+*******************************************************************************/
+void SlotsBeat(wd_slots_ty *slots, size_t index);
+
+/*******************************************************************************
+ * Finds the slots silent for more than their timeout at "now_ns"
+ * (CLOCK_MONOTONIC), bit i of "bitmap" is set for expired slot i
+ * "bitmap" holds SlotsCapacity() / SLOTS_ALIGN words, all of them written
+ * returns the number of expired slots
+ * Time Complexity: O(capacity), one pass
+*******************************************************************************/
+size_t SlotsScan(const wd_slots_ty *slots, unsigned long now_ns,
+                 unsigned long *bitmap);
+
+/*******************************************************************************
+ * Selects the kernel of SlotsScan(), SLOTS_BEST for the best one the CPU
+ * supports - all of them find the same slots
+ * returns 0 on success, not 0 if the CPU lacks it (the kernel is kept)
+ * Time Complexity: O(1)
+*******************************************************************************/
+int SlotsSetKernel(wd_slots_ty *slots, slots_kernel_ty kernel);
+
+/*******************************************************************************
+ * Returns the name of the kernel SlotsScan() of "slots" runs
+ * Time Complexity: O(1)
+*******************************************************************************/
+const char *SlotsKernelName(const wd_slots_ty *slots);
+
+/*******************************************************************************
+ * Returns the current CLOCK_MONOTONIC time, the clock of the slots
+ * Time Complexity: O(1)
+*******************************************************************************/
+unsigned long SlotsNow(void);
+
+#endif  /*  __WD_SLOTS_H__  */
@@ -0,0 +1,75 @@
+/*******************************************************************************
+ * Project:     Watchdog - allocation free spawn
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * everything a spawn of the peer needs is built once, up front, in an arena
+ * of its own that is mapped, faulted in and locked: the argument vector,
+ * the environment with room for the variables set per spawn, the path of
+ * the binary, a descriptor of it and the stack of the child
+ * a spawn then allocates nothing, so it works as well on an exhausted heap:
+ * the child is a clone that shares the memory of the caller until it execs,
+ * like vfork, on the stack of the arena
+ * a spawn_ty is of one thread at a time
+*******************************************************************************/
+#ifndef __WD_SPAWN_H__
+#define __WD_SPAWN_H__
+
+#include <stddef.h>     /*  size_t              */
+#include <signal.h>     /*  sigset_t            */
+#include <sys/types.h>  /*  pid_t               */
+
+/*  a variable set per spawn takes up to SPAWN_VAR_SIZE - 1 characters of
+    "name=value", up to SPAWN_MAX_VARS of them                                */
+enum {SPAWN_VAR_SIZE = 1024, SPAWN_MAX_VARS = 8};
+
+typedef struct spawn spawn_ty;
+
+/*******************************************************************************
+ * Builds the arena for spawns of "prefix" followed by "argv", both NULL
+ * terminated, "prefix" may be NULL, with a copy of "envp" as environment
+ * the binary, the first argument, is looked up in PATH now if its name has
+ * no '/', and opened: a spawn execs it by its path, and by the descriptor if
+ * the path is gone, e.g. after a chdir() or a deploy that removed it
+ * returns the arena, NULL on failure
+ * Time Complexity: O(size of the vectors) + the used system call complexity
+*******************************************************************************/
+spawn_ty *SpawnCreate(char *const prefix[], char *const argv[],
+                      char *const envp[]);
+
+/*******************************************************************************
+ * Frees "spawn"
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+void SpawnDestroy(spawn_ty *spawn);
+
+/*******************************************************************************
+ * Returns the argument vector of the spawns, in the arena
+ * Time Complexity: O(1)
+*******************************************************************************/
+char **SpawnArgv(spawn_ty *spawn);
+
+/*******************************************************************************
+ * Sets "name" to "value" in the environment of the next spawns, in place
+ * returns 0 on success, not 0 if it is too long or out of room
+ * Time Complexity: O(size of the environment)
+*******************************************************************************/
+int SpawnSetEnv(spawn_ty *spawn, const char *name, const char *value);
+
+/*******************************************************************************
+ * Sets the signal mask the spawned processes start with, NULL for the mask
+ * of the thread that spawns them
+ * Time Complexity: O(1)
+*******************************************************************************/
+void SpawnSetMask(spawn_ty *spawn, const sigset_t *mask);
+
+/*******************************************************************************
+ * Spawns a process, which inherits the "cnt" descriptors "fds" besides
+ * those that are not close-on-exec, and stores its pid in "pid"
+ * the handlers of the caller are reset in the child before it execs
+ * returns 0 on success, not 0 if the clone or the exec failed (errno is set)
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+int SpawnRun(spawn_ty *spawn, const int *fds, size_t cnt, pid_t *pid);
+
+#endif  /*  __WD_SPAWN_H__  */
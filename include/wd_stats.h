@@ -0,0 +1,109 @@
+/*******************************************************************************
+ * Project:     Watchdog - shared memory statistics page
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#ifndef __WD_STATS_H__
+#define __WD_STATS_H__
+
+#include <stddef.h>     /*  size_t  */
+
+/*  /dev/shm name of the page is STATS_PREFIX followed by the pair's name     */
+#define STATS_PREFIX "/wd_stats."
+
+enum {STATS_VERSION = 5, STATS_MISS_BUCKETS = 16, STATS_LATENCY_BUCKETS = 32,
+      STATS_STOP_PHASES = 3};
+
+/*  the watchdog thread of the app owns side 0, wd_app owns side 1            */
+typedef enum stats_side_id {STATS_APP_SIDE = 0, STATS_WD_SIDE = 1} stats_side_id_ty;
+
+/*******************************************************************************
+ * one side of the pair, written by its owner only
+ * "seq" is a sequence lock: odd while the owner updates the side, readers
+ * retry until they copy it with the same even value on both ends
+ * the heartbeat counters and the latency histogram are bumped atomically by
+ * the signal handler, outside of the sequence lock
+*******************************************************************************/
+typedef struct stats_side
+{
+    unsigned long seq;
+    unsigned long pid;
+    unsigned long peer_pid;
+    unsigned long restarts;
+    unsigned long breaker_trips;
+    long last_exit_status;
+    unsigned long detect_us_last;
+    unsigned long detect_us_max;
+    unsigned long sched_lag_us_last;
+    unsigned long sched_lag_us_max;
+    unsigned long miss_hist[STATS_MISS_BUCKETS];
+    unsigned long beats_sent;
+    unsigned long beats_received;
+    unsigned long latency_us_sum;
+    unsigned long latency_hist[STATS_LATENCY_BUCKETS];
+    unsigned long memory_bytes;
+    long memory_eta;
+    unsigned long planned_restarts;
+    unsigned long request_latency_ns;
+    unsigned long request_count;
+    unsigned long slo_violations;
+    unsigned long stop_phase_us[STATS_STOP_PHASES]; /* of the last stop      */
+    unsigned long stops_ended[STATS_STOP_PHASES];   /* by the phase it ended  */
+    unsigned long beat_interval;                    /* [s], of the rate       */
+}stats_side_ty;
+
+typedef struct stats_page
+{
+    unsigned long magic;
+    unsigned long version;
+    stats_side_ty side[2];
+}stats_page_ty;
+
+/*******************************************************************************
+ * Maps the page of the pair "name", creating it if "create" is not 0
+ * returns NULL on failure
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+stats_page_ty *StatsOpen(const char *name, int create);
+
+/*******************************************************************************
+ * Unmaps "page"
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+void StatsClose(stats_page_ty *page);
+
+/*******************************************************************************
+ * Removes the page of the pair "name"
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+void StatsUnlink(const char *name);
+
+/*******************************************************************************
+ * Brackets an update of "side" by its owner
+ * note: the owner must not nest them, e.g. from a signal handler
+ * Time Complexity: O(1)
+*******************************************************************************/
+void StatsWriteBegin(stats_side_ty *side);
+void StatsWriteEnd(stats_side_ty *side);
+
+/*******************************************************************************
+ * Records a heartbeat delivered "latency_us" after it was sent
+ * async-signal-safe, lock free
+ * Time Complexity: O(1)
+*******************************************************************************/
+void StatsRecordBeat(stats_side_ty *side, unsigned long latency_us);
+
+/*******************************************************************************
+ * Copies a consistent snapshot of "side" into "copy", never blocks the owner
+ * Time Complexity: O(1) (retries while the owner is writing)
+*******************************************************************************/
+void StatsRead(const stats_side_ty *side, stats_side_ty *copy);
+
+/*******************************************************************************
+ * Returns the upper bound [us] of the latency bucket holding the "pct"
+ * percentile of "side", 0 if no heartbeat was recorded
+ * Time Complexity: O(STATS_LATENCY_BUCKETS)
+*******************************************************************************/
+unsigned long StatsLatencyPercentile(const stats_side_ty *side, size_t pct);
+
+#endif  /*  __WD_STATS_H__  */
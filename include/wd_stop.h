@@ -0,0 +1,73 @@
+/*******************************************************************************
+ * Project:     Watchdog - bounded stop sequence of an old instance
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#ifndef __WD_STOP_H__
+#define __WD_STOP_H__
+
+#include <stddef.h>     /*  size_t                  */
+#include <sys/types.h>  /*  pid_t                   */
+#include "watchdog.h"   /*  wd_stop_policy_ty       */
+
+/*  environment variable used to hand the policy over to "wd_app"             */
+#define STOP_POLICY_ENV "WD_STOP_POLICY"
+
+/*  used when no policy was set, and how long SIGKILL may take                */
+enum {STOP_DEFAULT_TERM_MS = 2000, STOP_KILL_WAIT_MS = 1000};
+
+typedef enum stop_phase
+{
+    STOP_DRAIN = 0,
+    STOP_TERM = 1,
+    STOP_KILL = 2,
+    STOP_PHASES = 3
+}stop_phase_ty;
+
+/*  "phases" entered, the process exited in the last one (0 - it already had) */
+typedef struct stop_report
+{
+    size_t phases;
+    unsigned long phase_us[STOP_PHASES];
+}stop_report_ty;
+
+/*******************************************************************************
+ * Serializes "policy" into STOP_POLICY_ENV
+ * returns 0 on success, not 0 otherwise
+ * Time Complexity: O(1)
+*******************************************************************************/
+int StopPolicyExport(const wd_stop_policy_ty *policy);
+
+/*******************************************************************************
+ * Fills "policy" from STOP_POLICY_ENV, or with the defaults (no drain,
+ * STOP_DEFAULT_TERM_MS) if the variable is missing or malformed
+ * Time Complexity: O(1)
+*******************************************************************************/
+void StopPolicyImport(wd_stop_policy_ty *policy);
+
+/*******************************************************************************
+ * Stops process "pid": sends a drain notification over "channel" (skipped if
+ * it is -1 or "drain_ms" is 0) and waits up to "drain_ms" for the process to
+ * exit, then SIGTERM and up to "term_ms", then SIGKILL and up to
+ * STOP_KILL_WAIT_MS
+ * the signals are sent and the exit is observed through a pidfd, so "pid"
+ * may be any process and can not be confused with a new one that reuses it
+ * "report" tells how long each phase took
+ * returns 0 once the process is gone, not 0 if it survived every phase
+ * note: a child is not reaped, the caller still has to waitpid() it
+ * Time Complexity: determined by the used system call complexity, blocks up
+ *                  to "drain_ms" + "term_ms" + STOP_KILL_WAIT_MS
+*******************************************************************************/
+int StopProcess(pid_t pid, const wd_stop_policy_ty *policy, int channel,
+                stop_report_ty *report);
+
+/*******************************************************************************
+ * Waits up to "timeout_ms" for process "pid" to exit, then sends it SIGKILL
+ * and waits up to STOP_KILL_WAIT_MS, both through the same pidfd
+ * returns 0 once it is gone, not 0 if it is still there
+ * note: a child is not reaped
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+int StopWaitOrKill(pid_t pid, size_t timeout_ms);
+
+#endif  /*  __WD_STOP_H__  */
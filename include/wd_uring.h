@@ -0,0 +1,79 @@
+/*******************************************************************************
+ * Project:     Watchdog - io_uring event loop backend
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * a small io_uring of its own, set up through the raw system calls: the
+ * operations queued between two waits go to the kernel with the wait, and
+ * the wait comes back with every completion that is ready, so a wait that
+ * reads, polls and times out at once is a single io_uring_enter()
+ * a ring is of one thread, the one that queues and waits
+*******************************************************************************/
+#ifndef __WD_URING_H__
+#define __WD_URING_H__
+
+#include <stddef.h>     /*  size_t  */
+
+typedef struct uring uring_ty;
+
+/*  called for every completion, "tag" as queued with the operation and "res"
+    its result, -errno if it failed                                           */
+typedef void (*uring_done_ty)(void *param, unsigned long tag, int res);
+
+/*******************************************************************************
+ * Sets up a ring for up to "entries" operations in flight
+ * returns the ring, NULL if the kernel has no io_uring, has it disabled or
+ * lacks the timed wait of 5.11
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+uring_ty *UringCreate(unsigned int entries);
+
+/*******************************************************************************
+ * Frees "ring", the operations still in flight are cancelled
+ * Time Complexity: determined by the used system call complexity
+*******************************************************************************/
+void UringDestroy(uring_ty *ring);
+
+/*******************************************************************************
+ * Queues a read of up to "len" bytes of "fd" into "buf", which has to stay
+ * valid until the read completes, with the number of bytes read as result
+ * returns 0 on success, not 0 if the ring is full
+ * Time Complexity: O(1)
+*******************************************************************************/
+int UringQueueRead(uring_ty *ring, int fd, void *buf, size_t len,
+                   unsigned long tag);
+
+/*******************************************************************************
+ * Queues a one shot poll of "fd" for input, with the poll events as result
+ * returns 0 on success, not 0 if the ring is full
+ * Time Complexity: O(1)
+*******************************************************************************/
+int UringQueuePoll(uring_ty *ring, int fd, unsigned long tag);
+
+/*******************************************************************************
+ * Queues the cancellation of the operation queued with "target" as its tag,
+ * which then completes with -ECANCELED - the cancellation completes as well,
+ * with "tag" and 0, or -ENOENT if the operation had completed already
+ * returns 0 on success, not 0 if the ring is full
+ * Time Complexity: O(1)
+*******************************************************************************/
+int UringQueueCancel(uring_ty *ring, unsigned long target, unsigned long tag);
+
+/*******************************************************************************
+ * Submits the queued operations and waits up to "timeout_ms" (forever if it
+ * is negative) for a completion, in one system call, then calls "on_done"
+ * with "param" for every completion there is
+ * returns the number of completions, 0 if the time passed without one, -1
+ * if a signal cut the wait short or on error (errno is set)
+ * Time Complexity: O(completions) + the used system call complexity
+*******************************************************************************/
+int UringWait(uring_ty *ring, long timeout_ms, uring_done_ty on_done,
+              void *param);
+
+/*******************************************************************************
+ * Returns the number of system calls "ring" made since it was set up
+ * Time Complexity: O(1)
+*******************************************************************************/
+size_t UringSyscalls(const uring_ty *ring);
+
+#endif  /*  __WD_URING_H__  */
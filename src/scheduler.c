@@ -4,6 +4,7 @@
 #include <assert.h> /* assert       */
 #include <stddef.h> /* size_t       */
 #include <unistd.h> /* sleep       */
+#include <poll.h> /* poll           */
 
 #include "scheduler.h"
 #include "p_queue.h"
@@ -12,7 +13,11 @@
 struct scheduler
 {
     p_queue_ty *p_queue;
-    int stop;
+    volatile int stop;
+    int wake_fd;
+    void (*on_wake)(void *param);
+    void *wake_param;
+    sched_clock_ty clock;
 };
 
 static int CmpExecutionTime(void *task1, void *task2)
@@ -25,6 +30,16 @@ static int match(void *task, void *uid)
     return UIDIsSame(TaskGetUID((task_ty *)task), *((ilrd_uid_ty *)uid));
 }
 
+static time_t Now(const scheduler_ty *scheduler)
+{
+    if (NULL != scheduler->clock.now)
+    {
+        return scheduler->clock.now(scheduler->clock.param);
+    }
+
+    return time(NULL);
+}
+
 scheduler_ty *SchedulerCreate(void)
 {
     scheduler_ty *scheduler = (scheduler_ty *)malloc(sizeof(scheduler_ty));
@@ -41,6 +56,12 @@ scheduler_ty *SchedulerCreate(void)
     }
 
     scheduler->stop = 0;
+    scheduler->wake_fd = -1;
+    scheduler->on_wake = NULL;
+    scheduler->wake_param = NULL;
+    scheduler->clock.now = NULL;
+    scheduler->clock.sleep = NULL;
+    scheduler->clock.param = NULL;
 
     return scheduler;
 }
@@ -53,9 +74,9 @@ void SchedulerDestroy(scheduler_ty *scheduler)
     free(scheduler);
 }
 
-ilrd_uid_ty SchedulerAddTask(scheduler_ty *scheduler, size_t interval, 
-                            oper_func_ty operation, void *param,
-                            clean_func_ty clean_func)
+static ilrd_uid_ty AddTask(scheduler_ty *scheduler, size_t interval,
+                           time_t delay, oper_func_ty operation, void *param,
+                           clean_func_ty clean_func)
 {
     task_ty *new_task = NULL;
 
@@ -67,6 +88,8 @@ ilrd_uid_ty SchedulerAddTask(scheduler_ty *scheduler, size_t interval,
         return UIDBadID;
     }
 
+    TaskSetTimeToRun(new_task, Now(scheduler) + delay);
+
     if (0 != PQueueEnqueue(scheduler->p_queue, new_task))
     {
         TaskDestroy(new_task);
@@ -76,6 +99,21 @@ ilrd_uid_ty SchedulerAddTask(scheduler_ty *scheduler, size_t interval,
     return TaskGetUID(new_task);
 }
 
+ilrd_uid_ty SchedulerAddTask(scheduler_ty *scheduler, size_t interval, 
+                            oper_func_ty operation, void *param,
+                            clean_func_ty clean_func)
+{
+    return AddTask(scheduler, interval, 0, operation, param, clean_func);
+}
+
+ilrd_uid_ty SchedulerAddTaskLater(scheduler_ty *scheduler, size_t interval, 
+                            oper_func_ty operation, void *param,
+                            clean_func_ty clean_func)
+{
+    return AddTask(scheduler, interval, (time_t)interval, operation, param,
+                                                                clean_func);
+}
+
 int SchedulerRemoveTask(scheduler_ty *scheduler, ilrd_uid_ty uid)
 {
     task_ty *curr_task = NULL;
@@ -94,6 +132,35 @@ int SchedulerRemoveTask(scheduler_ty *scheduler, ilrd_uid_ty uid)
 }
 
 
+/* returns 0 if the whole "sleep_time" passed, 1 if it was cut short */
+static int SchedulerWait(scheduler_ty *scheduler, time_t sleep_time)
+{
+    struct pollfd pfd;
+    int ready = 0;
+
+    if (NULL != scheduler->clock.sleep)
+    {
+        return (0 != scheduler->clock.sleep(scheduler->clock.param, sleep_time));
+    }
+
+    if (-1 == scheduler->wake_fd)
+    {
+        return (0 != sleep(sleep_time));
+    }
+
+    pfd.fd = scheduler->wake_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    ready = poll(&pfd, 1, (int)sleep_time * 1000);
+    if (0 < ready)
+    {
+        scheduler->on_wake(scheduler->wake_param);
+    }
+
+    return (0 != ready);
+}
+
 int SchedulerRun(scheduler_ty *scheduler)
 {
     task_ty *curr_task = NULL;
@@ -105,10 +172,14 @@ int SchedulerRun(scheduler_ty *scheduler)
     while (!scheduler->stop && !SchedulerIsEmpty(scheduler))
     {
         curr_task = (task_ty *)PQueuePeek(scheduler->p_queue);
-        sleep_time = TaskGetTimeToRun(curr_task) - time(NULL);
+        sleep_time = TaskGetTimeToRun(curr_task) - Now(scheduler);
         if (sleep_time > 0)
         {
-            sleep(sleep_time);
+            /* a signal may cut the sleep short - never run a task early */
+            if (0 != SchedulerWait(scheduler, sleep_time))
+            {
+                continue;
+            }
         }
         
         PQueueDequeue(scheduler->p_queue);
@@ -121,7 +192,7 @@ int SchedulerRun(scheduler_ty *scheduler)
         }
         else
         {
-            TaskUpdateTimeToRun(curr_task);
+            TaskUpdateTimeToRun(curr_task, Now(scheduler));
             PQueueEnqueue(scheduler->p_queue, curr_task);
         }
     }
@@ -150,7 +221,7 @@ int SchedulerRun2(scheduler_ty *scheduler)
         
         time_to_run = TaskGetTimeToRun(task);
         
-        while(time_to_run > time(NULL)); 
+        while(time_to_run > Now(scheduler)); 
         
         if (TaskRun(task) == break_task)
         {
@@ -158,7 +229,7 @@ int SchedulerRun2(scheduler_ty *scheduler)
         }
         else
         {
-            TaskUpdateTimeToRun(task);
+            TaskUpdateTimeToRun(task, Now(scheduler));
                         
             if (1 == PQueueEnqueue(scheduler->p_queue ,(void *)task))
             {
@@ -173,6 +244,33 @@ int SchedulerRun2(scheduler_ty *scheduler)
 }
 
 
+void SchedulerSetWakeFd(scheduler_ty *scheduler, int fd,
+                        void (*on_wake)(void *param), void *param)
+{
+    assert(NULL != scheduler);
+    assert(-1 == fd || NULL != on_wake);
+
+    scheduler->wake_fd = fd;
+    scheduler->on_wake = on_wake;
+    scheduler->wake_param = param;
+}
+
+void SchedulerSetClock(scheduler_ty *scheduler, const sched_clock_ty *clock)
+{
+    assert(NULL != scheduler);
+    assert(NULL == clock || (NULL != clock->now && NULL != clock->sleep));
+
+    if (NULL == clock)
+    {
+        scheduler->clock.now = NULL;
+        scheduler->clock.sleep = NULL;
+        scheduler->clock.param = NULL;
+        return;
+    }
+
+    scheduler->clock = *clock;
+}
+
 void SchedulerStop(scheduler_ty *scheduler)
 {
     assert(NULL != scheduler);
@@ -1,5 +1,6 @@
 #include <stdlib.h> /* malloc, free */
 #include <assert.h> /* assert       */
+#include <time.h>   /* time         */
 
 #include "task.h" 
 
@@ -72,11 +73,25 @@ ilrd_uid_ty TaskGetUID(const task_ty *task)
     return task->uid;
 }
 
-void TaskUpdateTimeToRun(task_ty *task)
+void TaskSetTimeToRun(task_ty *task, time_t time_to_run)
+{
+    assert (NULL != task);
+
+    task->time_to_run = time_to_run;
+}
+
+void TaskUpdateTimeToRun(task_ty *task, time_t now)
 {
     assert (NULL != task);
 
     task->time_to_run = task->time_to_run + task->interval;
+
+    /* runs missed while the scheduler was held up are skipped, not replayed */
+    if (task->time_to_run < now)
+    {
+        task->time_to_run += (time_t)(((size_t)(now - task->time_to_run) +
+                             task->interval - 1) / task->interval * task->interval);
+    }
 }
 
 int TaskIsMatchUID(const task_ty *task, ilrd_uid_ty uid)
@@ -0,0 +1,62 @@
+/*******************************************************************************
+ * Project:     Watchdog - virtual clock
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#include <assert.h>     /* assert   */
+#include <stddef.h>     /* NULL     */
+
+#include "vclock.h"
+
+static time_t Now(void *param)
+{
+    return VClockNow((const vclock_ty *)param);
+}
+
+/* nothing cuts a virtual sleep short */
+static int Sleep(void *param, time_t seconds)
+{
+    VClockAdvance((vclock_ty *)param, seconds);
+
+    return 0;
+}
+
+void VClockInit(vclock_ty *vclock, time_t start, vclock_advance_ty on_advance,
+                void *param)
+{
+    assert(NULL != vclock);
+
+    vclock->now = start;
+    vclock->on_advance = on_advance;
+    vclock->param = param;
+}
+
+void VClockAttach(vclock_ty *vclock, sched_clock_ty *clock)
+{
+    assert(NULL != vclock);
+    assert(NULL != clock);
+
+    clock->now = Now;
+    clock->sleep = Sleep;
+    clock->param = vclock;
+}
+
+time_t VClockNow(const vclock_ty *vclock)
+{
+    assert(NULL != vclock);
+
+    return vclock->now;
+}
+
+void VClockAdvance(vclock_ty *vclock, time_t seconds)
+{
+    assert(NULL != vclock);
+    assert(0 <= seconds);
+
+    if (NULL != vclock->on_advance)
+    {
+        vclock->on_advance(vclock->param, vclock->now, vclock->now + seconds);
+    }
+
+    vclock->now += seconds;
+}
@@ -3,103 +3,365 @@
  * Author:      AvivJilin
  * Version:     1.0 - 11/03/2023
 *******************************************************************************/
-#define _POSIX_C_SOURCE 200112L  /* sigset_t, CLOCK_REALTIME, SIG_UNBLOCK */
+#define _GNU_SOURCE  /* sigset_t, CLOCK_REALTIME, SIG_UNBLOCK, F_DUPFD_CLOEXEC */
 
-#include <stdio.h> /* fprintf */
+#include <stdio.h> /* sprintf */
+#include <errno.h> /* errno */
 #include <unistd.h> /* getpid */
-#include <stdlib.h> /*   malloc, free, setenv, unsetenv, atoi    */
+#include <stdlib.h> /*   malloc, free, setenv, atoi    */
 #include <pthread.h> /* pthread */
 #include <assert.h>  /* assert */
 #include <signal.h>  /* SIGUSR1, SIGUSR2, sigaction */
 #include <string.h> /* strcpy, memcpy */
 #include <sys/wait.h> /* waitpid */
+#include <fcntl.h> /* fcntl */
+#include <sys/syscall.h> /* SYS_gettid, SYS_tgkill, SYS_rt_tgsigqueueinfo */
+#include <sys/signalfd.h> /* signalfd */
+#include <poll.h> /* poll */
+#include <time.h> /* time */
+#include <sched.h> /* sched_yield */
 
 #include "watchdog.h"
 #include "wd_internal.h"
 #include "scheduler.h"
+#include "wd_restart.h"
+#include "wd_persist.h"
+#include "wd_channel.h"
+#include "wd_keepfd.h"
+#include "wd_progress.h"
+#include "wd_stats.h"
+#include "wd_log.h"
+#include "wd_stop.h"
+#include "wd_group.h"
+#include "wd_uring.h"
+#include "wd_spawn.h"
+#include "wd_registry.h"
+
+/* stdio may block on a full pipe and is not async-signal-safe */
+#define REPORT_BAD(MSG) LogError(MSG)
 #include "utils.h"
 
 #define FILE_NAME "./wd_app"
-#define BUFFER_SIZE 10
 
-static volatile size_t g_signal_cnt = 0;
-static volatile int g_stop_flag = 0;
-static sem_t g_dnr_return;
+extern char **environ;
+#define BUFFER_SIZE 24
+
+enum {SIGNALS_BATCH = 16, READY_TIMEOUT_MS = 1000, STOP_RESEND_MS = 50};
+
+/* a memory counter that cannot be opened skips 1, 2, 4 ... 64 ticks */
+enum {MEMORY_MAX_SHIFT = 6};
+
+/* what a completion of the loop of wd_app is about, the polls of the
+   channel and of the peer carry the peer they were armed for above it     */
+enum {LOOP_ENTRIES = 8, LOOP_SIGNALS = 1, LOOP_CONTROL = 2, LOOP_PEER = 3,
+      LOOP_CANCEL = 4, LOOP_KIND_BITS = 8};
+
+/* wd_app waits in an io_uring: the beats and the stop request read from
+   the signalfd, the control channel and the exit of the peer complete
+   into it, along with the timeout of the wait
+   "is_peer_polled" and "is_ctl_polled" are set while a poll is in flight
+   and once it is no longer wanted, a poll the ring had no room for is
+   queued with the next wait                                               */
+typedef struct wd_loop
+{
+    wd_params_ty *params;
+    uring_ty *ring;
+    struct signalfd_siginfo infos[SIGNALS_BATCH];
+    int is_reading;
+    int is_peer_polled;
+    int is_ctl_polled;
+    pid_t peer;
+    int ctl_fd;
+    int pidfd;
+    unsigned long arm;
+}wd_loop_ty;
+
+/* the watchdog run by the calling thread, for the signal handlers - every
+   watchdog thread gets the signals of its own peer only                    */
+static __thread wd_params_ty *t_handle = NULL;
+
+/* main watchdog of the calling process, guarded for the public getters */
+static wd_params_ty *g_wd_params = NULL;
+static pthread_mutex_t g_params_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* the environment is shared by the watchdogs, each copies it for its spawns */
+static pthread_mutex_t g_env_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* set by WDSetDrainHandler(), called by the watchdog thread */
+static void (*g_drain_fn)(void *param, size_t ms_left) = NULL;
+static void *g_drain_param = NULL;
 
 /* Signal handlers */
-static void HandlerSIGUSR1(int sig_num);
+static void HandlerSIGUSR1(int sig_num, siginfo_t *info, void *context);
 static void HandlerSIGUSR2(int sig_num);
+static void OnBeat(wd_params_ty *params, int is_queued, unsigned long value);
+static void OnSignals(wd_params_ty *params,
+                      const struct signalfd_siginfo *infos, size_t cnt);
+static void ReadSignals(void *params);
+static int SetupSignalFd(wd_params_ty *params, int is_blocking);
+static void LoopStart(wd_loop_ty *loop, wd_params_ty *params);
+static void LoopEnd(wd_loop_ty *loop);
+static time_t LoopNow(void *loop);
+static int LoopSleep(void *loop, time_t seconds);
+static void LoopWatchPeer(wd_loop_ty *loop);
+static void LoopPoll(wd_loop_ty *loop);
+static void OnLoopDone(void *loop, unsigned long tag, int res);
+static int SendBeat(wd_params_ty *params, unsigned long value);
 
 static void *WDRoutine(void *params);
 int CreateNewThread(wd_params_ty *wd_params);
-static int BlockSignals(void);
+static int BlockSignals(sigset_t *caller_mask);
+static int RestoreSignals(sigset_t *caller_mask);
+static void ExportSignalMask(void);
+static int ImportSignalMask(sigset_t *mask);
+static int SemWaitNoIntr(sem_t *sem);
+static int WaitStopped(wd_params_ty *params, pid_t self_tid, pid_t other_pid,
+                                                    unsigned long deadline);
+static void SendStop(pid_t self_tid, pid_t other_pid);
 static int InstallSignalHandlers(void);
-static char *AllocNumber(size_t num);
 static int Revive(wd_params_ty *params);
-static char **CreateNewVector(int argc, char *argv[], size_t interval, size_t max_misses);
+static pid_t StopOldPeer(wd_params_ty *params, int *exit_status);
+static int SpawnSimulated(wd_params_ty *params);
+static time_t ClockNow(const wd_params_ty *params);
+static int CreateSpawn(wd_params_ty *params, char *const prefix[], char *argv[]);
+static int SetSpawnNum(spawn_ty *spawn, const char *var_name, int var);
 static int IsConnected(void *wd);
+static int WaitReady(wd_params_ty *params);
+static void CloseFd(int fd);
 static int IsWatchDogExist(wd_params_ty *wd);
+static int ReceiveControl(void *params);
+static int CheckProgress(void *params);
+static int CheckMemory(void *params);
+static void PlanRestart(wd_params_ty *params);
+static int CheckLatency(void *params);
+static void JoinGroup(wd_params_ty *params);
+static void FailGroup(wd_params_ty *params);
+static int StepGroup(wd_params_ty *params);
+static int CheckGroup(void *params);
+static void SetChannel(wd_params_ty *params, int ctl_fd);
+static void SendThreadId(wd_params_ty *params);
 static pid_t GetEnvNum(const char *var_name);
-static int DestroyAll(wd_params_ty *wd_params, scheduler_ty *scheduler, char *argv[]);
+static int DestroyAll(wd_params_ty *wd_params, char *argv[]);
+static void AbortCreate(wd_params_ty *wd_params);
+static void ExportPairName(const char *argv0);
+static int IsValidHandleName(const char *handle);
+static void OpenStats(wd_params_ty *params);
+static void OpenRegistry(wd_params_ty *params);
+static void CloseRegistry(wd_params_ty *params);
+static void PublishPeer(wd_params_ty *params);
+static int AdoptApp(wd_params_ty *params);
+static int IsWdAppFresh(const wd_params_ty *params,
+                        const registry_record_ty *record);
+static unsigned long NowUsec(void);
+static unsigned long BeatNowUsec(const wd_params_ty *params);
+static int IsSuspected(wd_params_ty *params);
+static size_t DeadAfter(const wd_params_ty *params);
+static int IsUnderPressure(const wd_params_ty *params);
+static int AdaptRate(wd_params_ty *params, size_t signal_cnt);
+static int SetRate(wd_params_ty *params, size_t interval);
 
 /* Signal handlers */
-static void HandlerSIGUSR1(int sig_num)
+static void HandlerSIGUSR1(int sig_num, siginfo_t *info, void *context)
 {
     assert(sig_num == SIGUSR1);
+    (void)context;
     
-    /* atomic operation g_signal_cnt = 0; */
-    __atomic_store_n(&g_signal_cnt, 0, __ATOMIC_SEQ_CST);
-
+    /* only our peer may feed us, as OnSignals() has it */
+    if (NULL != t_handle && t_handle->other_pid == info->si_pid)
+    {
+        OnBeat(t_handle, SI_QUEUE == info->si_code,
+                            (unsigned long)(size_t)info->si_value.sival_ptr);
+    }
 }
 
 static void HandlerSIGUSR2(int sig_num)
 {
     assert(sig_num == SIGUSR2);
     
-    /* atomic operation g_stop_flag = 1; */
-    __atomic_store_n(&g_stop_flag, TRUEE, __ATOMIC_SEQ_CST);
+    if (NULL != t_handle)
+    {
+        /* atomic operation stop_flag = 1; */
+        __atomic_store_n(&t_handle->stop_flag, TRUEE, __ATOMIC_SEQ_CST);
+        
+        /* the wait we cut short ends the scheduler, not its next tick */
+        if (NULL != t_handle->scheduler)
+        {
+            SchedulerStop(t_handle->scheduler);
+        }
+    }
+}
+
+/* a heartbeat arrived, from a handler or from the signalfd */
+static void OnBeat(wd_params_ty *params, int is_queued, unsigned long value)
+{
+    unsigned long now = NowUsec();
+    unsigned long sent = RateUnpack(&params->rate, value);
+    stats_side_ty *stats = params->stats;
+    
+    /* atomic operation signal_cnt = 0; */
+    __atomic_store_n(&params->signal_cnt, 0, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&params->last_beat_us, now, __ATOMIC_RELAXED);
+    PhiBeat(&params->phi, BeatNowUsec(params));
+    
+    /* SignOfLife() stamps every beat with its send time */
+    now &= RATE_TIME_MASK;
+    if (NULL != stats && is_queued)
+    {
+        StatsRecordBeat(stats, (now > sent) ? now - sent : 0);
+    }
+}
+
+void WDReceiveBeat(wd_params_ty *params, unsigned long value)
+{
+    assert(NULL != params);
+    
+    OnBeat(params, FALSEE, value);
+}
+
+/* signals read from the signalfd, directly or through the loop */
+static void OnSignals(wd_params_ty *params,
+                      const struct signalfd_siginfo *infos, size_t cnt)
+{
+    size_t i = 0;
+    
+    for (i = 0; i < cnt; ++i)
+    {
+        /* only our peer may feed us, only the pair may stop us */
+        if (SIGUSR1 == infos[i].ssi_signo &&
+            params->other_pid == (pid_t)infos[i].ssi_pid)
+        {
+            OnBeat(params, SI_QUEUE == infos[i].ssi_code,
+                                        (unsigned long)infos[i].ssi_ptr);
+        }
+        else if (SIGUSR2 == infos[i].ssi_signo &&
+                 (params->other_pid == (pid_t)infos[i].ssi_pid ||
+                  getpid() == (pid_t)infos[i].ssi_pid))
+        {
+            __atomic_store_n(&params->stop_flag, TRUEE, __ATOMIC_SEQ_CST);
+            SchedulerStop(params->scheduler);
+        }
+    }
+}
+
+/* drains the signalfd, called by the scheduler loop of the watchdog */
+static void ReadSignals(void *params)
+{
+    wd_params_ty *wd_params = (wd_params_ty *)params;
+    struct signalfd_siginfo infos[SIGNALS_BATCH];
+    ssize_t len = 0;
+    
+    while (0 < (len = read(wd_params->sig_fd, infos, sizeof(infos))))
+    {
+        OnSignals(wd_params, infos, (size_t)len / sizeof(infos[0]));
+    }
 }
 
 
 int MakeMeImmortal(int argc, char *argv[], size_t interval, size_t max_misses)
+{
+    wd_config_ty config;
+    
+    config.argc = argc;
+    config.argv = argv;
+    config.interval = interval;
+    config.max_misses = max_misses;
+    config.name = NULL;
+    
+    return (NULL == WDCreate(&config)) ? MMI_FAIL : SUCCESS;
+}
+
+wd_handle_ty *WDCreate(const wd_config_ty *config)
 {
     wd_params_ty *wd_params = NULL;
+    char *prefix[NUM_OF_ADDED_ARGS + 1];
+    char interval_str[BUFFER_SIZE];
+    char misses_str[BUFFER_SIZE];
+    int is_main = FALSEE;
     int status = 0;
-    sem_t have_connection;
     
-    /* Create semaphore */
-    status = sem_init(&have_connection, 0, 0); 
-    RETURN_IF_BAD(!status, "sem_init", MMI_FAIL);
+    assert(NULL != config);
     
-    status = BlockSignals(); 
-    RETURN_IF_BAD_CLEAN(!status, "BlockSignals \n", MMI_FAIL,
-                                                sem_destroy(&have_connection));
-
-    wd_params = CreateStruct(argc, argv, interval, max_misses, 0);
-    RETURN_IF_BAD_CLEAN((NULL != wd_params), "CreateStruct \n", MMI_FAIL,
-                                                sem_destroy(&have_connection));
+    is_main = (NULL == config->name);
+    RETURN_IF_BAD((is_main || IsValidHandleName(config->name)),
+                                        "WDCreate: invalid name\n", NULL);
+    
+    pthread_mutex_lock(&g_env_lock);
+    if (is_main)
+    {
+        /* wd_app revives us with the mask we were started with */
+        ExportSignalMask();
+        
+        /* descriptors handed over by the watchdog that revived us */
+        KeepFdImport();
+    }
+    
+    ExportPairName(config->argv[0]);
+    if (NULL != getenv(PAIR_NAME_ENV))
+    {
+        LogOpen(getenv(PAIR_NAME_ENV));
+    }
+    
+    wd_params = CreateStruct(config->argc, config->argv, config->interval,
+                                    config->max_misses, 0, config->name);
+    pthread_mutex_unlock(&g_env_lock);
+    RETURN_IF_BAD((NULL != wd_params), "CreateStruct \n", NULL);
+    
+    /* two main creates may race, only the first one claims the slot */
+    pthread_mutex_lock(&g_params_lock);
+    status = (is_main && NULL != g_wd_params);
+    if (is_main && !status)
+    {
+        g_wd_params = wd_params;
+    }
+    pthread_mutex_unlock(&g_params_lock);
+    RETURN_IF_BAD_CLEAN(!status, "WDCreate: main watchdog exists\n", NULL,
+                                        DestroyAll(wd_params, NULL));
+    
+    status = sem_init(&wd_params->have_connection, 0, 0);
+    RETURN_IF_BAD_CLEAN(!status, "sem_init", NULL,
+                                        DestroyAll(wd_params, NULL));
     
-    wd_params->have_connection = have_connection;
     wd_params->p_type = WD;
-
-    wd_params->argv = CreateNewVector(argc, argv, interval, max_misses);
-    RETURN_IF_BAD_CLEAN((NULL != wd_params->argv), "CreateNewVector \n", MMI_FAIL,
-                                                DestroyAll(wd_params, NULL, NULL));
+    
+    /* WDRecordLatency() has somewhere to record from now on */
+    if (is_main && 0 != wd_params->latency_policy.slo_ns &&
+        NULL != getenv(PAIR_NAME_ENV) &&
+        0 != LatencyCreate(getenv(PAIR_NAME_ENV)))
+    {
+        LogError("LatencyCreate");
+    }
+    
+    /* wd_app is spawned as: ./wd_app <interval> <max_misses> <app argv> */
+    sprintf(interval_str, "%lu", (unsigned long)config->interval);
+    sprintf(misses_str, "%lu", (unsigned long)config->max_misses);
+    prefix[0] = FILE_NAME;
+    prefix[1] = interval_str;
+    prefix[2] = misses_str;
+    prefix[3] = NULL;
+    
+    pthread_mutex_lock(&g_env_lock);
+    status = CreateSpawn(wd_params, prefix, config->argv);
+    pthread_mutex_unlock(&g_env_lock);
+    RETURN_IF_BAD_CLEAN(!status, "CreateSpawn \n", NULL,
+                                        DestroyAll(wd_params, NULL));
     /* Create watchdog thread */
     status = CreateNewThread(wd_params);
-    RETURN_IF_BAD_CLEAN(!status, "CREATE_NEW_THREAD_FAIL", CREATE_NEW_THREAD_FAIL, DestroyAll(wd_params, NULL, wd_params->argv));
+    RETURN_IF_BAD_CLEAN(!status, "CREATE_NEW_THREAD_FAIL", NULL,
+                            DestroyAll(wd_params, wd_params->argv));
+    
+    status = SemWaitNoIntr(&(wd_params->have_connection));
+    RETURN_IF_BAD_CLEAN(!status, "sem_wait", NULL, AbortCreate(wd_params));
     
-    status = sem_wait(&(wd_params->have_connection));
-    RETURN_IF_BAD_CLEAN(!status, "sem_wait", SEM_WAIT_FAIL, DestroyAll(wd_params, NULL, wd_params->argv));
-
     /* destroy semaphore */
-    status = sem_destroy(&have_connection);
-    RETURN_IF_BAD_CLEAN(!status, "sem_destroy", SEM_DESTROY_FAIL, DestroyAll(wd_params, NULL, wd_params->argv));
-
-    return status; 
+    status = sem_destroy(&wd_params->have_connection);
+    RETURN_IF_BAD_CLEAN(!status, "sem_destroy", NULL,
+                                                    AbortCreate(wd_params));
+    
+    return wd_params;
 }
 
-static int BlockSignals(void)
+/* the watchdog thread is born with every signal blocked */
+static int BlockSignals(sigset_t *caller_mask)
 {
     int status = SUCCESS;
     sigset_t mask;
@@ -108,63 +370,153 @@ static int BlockSignals(void)
     RETURN_IF_BAD(!status, "sigfillset failed", BLOCKSIGNALS_FAIL);
     
     
-    status = sigprocmask(SIG_BLOCK, &mask, NULL);
+    status = pthread_sigmask(SIG_BLOCK, &mask, caller_mask);
+    RETURN_IF_BAD(!status, "pthread_sigmask", BLOCKSIGNALS_FAIL);
+    
+    return status;
+}
+
+/* the caller gets its mask back, without the signals of the watchdog, so a
+   stray SIGUSR1 / SIGUSR2 never interrupts one of its threads            */
+static int RestoreSignals(sigset_t *caller_mask)
+{
+    int status = SUCCESS;
+    
+    status = sigaddset(caller_mask, SIGUSR1);
+    status |= sigaddset(caller_mask, SIGUSR2);
+    RETURN_IF_BAD(!status, "sigaddset failed", BLOCKSIGNALS_FAIL);
+    
+    status = pthread_sigmask(SIG_SETMASK, caller_mask, NULL);
     RETURN_IF_BAD(!status, "pthread_sigmask", BLOCKSIGNALS_FAIL);
     
     return status;
 }
 
-wd_params_ty *CreateStruct(int argc, char *argv[], size_t interval, size_t max_misses, pid_t other_pid)
+wd_params_ty *CreateStruct(int argc, char *argv[], size_t interval, size_t max_misses, pid_t other_pid, const char *handle)
 {
+    const char *pair_name = getenv(PAIR_NAME_ENV);
     wd_params_ty *wd_params = (wd_params_ty *)malloc(sizeof(wd_params_ty));
     RETURN_IF_BAD((NULL != wd_params), "CreateParams", NULL);
     
+    RETURN_IF_BAD_CLEAN((0 == sem_init(&wd_params->dnr_return, 0, 0)),
+                                        "sem_init", NULL, free(wd_params));
+    
     wd_params->argc = argc;
     wd_params->argv = argv;
+    wd_params->spawn = NULL;
     wd_params->interval = interval;
     wd_params->max_misses = max_misses;
     wd_params->other_pid = other_pid;
     wd_params->scheduler = NULL;
+    wd_params->ctl_fd = -1;
+    wd_params->self_tid = 0;
+    wd_params->peer_tid = 0;
+    wd_params->stats_page = NULL;
+    wd_params->stats = NULL;
+    wd_params->registry = NULL;
+    wd_params->reg_slot = -1;
+    wd_params->last_sign_us = 0;
+    wd_params->signal_mode = (WD_SIGNAL_FD == GetEnvNum(SIGNAL_MODE_ENV)) ?
+                                            WD_SIGNAL_FD : WD_SIGNAL_HANDLERS;
+    wd_params->event_loop = (WD_LOOP_POLL == GetEnvNum(EVENT_LOOP_ENV)) ?
+                                            WD_LOOP_POLL : WD_LOOP_AUTO;
+    wd_params->sig_fd = -1;
+    wd_params->ready_fd = -1;
+    wd_params->is_connecting = FALSEE;
+    wd_params->ops = NULL;
+    
+    RestartPolicyImport(&wd_params->restart_policy);
+    RestartStateInit(&wd_params->restart);
+    ProgressPolicyImport(&wd_params->progress_policy);
+    ProgressInit(&wd_params->progress);
+    MemoryPolicyImport(&wd_params->memory_policy);
+    MemoryInit(&wd_params->memory);
+    wd_params->memory_failed_pid = 0;
+    wd_params->memory_failures = 0;
+    wd_params->memory_skips = 0;
+    wd_params->planned_restart = FALSEE;
+    wd_params->skip_miss = FALSEE;
+    LatencyPolicyImport(&wd_params->latency_policy);
+    LatencyInit(&wd_params->latency);
+    wd_params->slo_misses = 0;
+    StopPolicyImport(&wd_params->stop_policy);
+    wd_params->group = NULL;
+    wd_params->peer_stopped = FALSEE;
+    PhiPolicyImport(&wd_params->phi_policy);
+    wd_params->phi_interval = interval;
+    RatePolicyImport(&wd_params->rate_policy);
+    wd_params->beat_interval = interval;
+    wd_params->beat_uid = UIDBadID;
+    
+    /* the stats page of an additional watchdog is named after it */
+    wd_params->is_main = (NULL == handle);
+    wd_params->handle[0] = '\0';
+    wd_params->name[0] = '\0';
+    if (NULL != handle)
+    {
+        sprintf(wd_params->handle, "%.*s", HANDLE_NAME_SIZE - 1, handle);
+    }
+    if (NULL != pair_name)
+    {
+        sprintf(wd_params->name, "%.*s%s%s", NAME_MAX_SIZE - 1, pair_name,
+                    (NULL == handle) ? "" : ".", wd_params->handle);
+    }
+    
+    wd_params->signal_cnt = 0;
+    wd_params->stop_flag = FALSEE;
+    wd_params->last_beat_us = 0;
     
     return wd_params;
     
 }
 
-static int DestroyAll(wd_params_ty *wd_params, scheduler_ty *scheduler, char *argv[])
+static int DestroyAll(wd_params_ty *wd_params, char *argv[])
 {
-    int i = 0;
-    
-    if (NULL != scheduler)
+    pthread_mutex_lock(&g_params_lock);
+    if (g_wd_params == wd_params)
     {
-        SchedulerDestroy(scheduler);
+        g_wd_params = NULL;
     }
+    pthread_mutex_unlock(&g_params_lock);
     
     if(NULL != argv)
     {
-        for (i = 0; i < wd_params->argc + NUM_OF_ADDED_ARGS - 1; ++i)
-        {
-            free(wd_params->argv[i]);
-            wd_params->argv[i] = NULL;
-        }
-        
-        free(wd_params->argv);
+        /* the vector lives in the arena of the spawns */
+        SpawnDestroy(wd_params->spawn);
+        wd_params->spawn = NULL;
         wd_params->argv = NULL;
     }
     
-    if((NULL != wd_params) && (NULL != argv))
-    {
-        free(wd_params);
-        wd_params = NULL;
-    }
+    SetChannel(wd_params, -1);
+    CloseFd(wd_params->ready_fd);
+    ProgressDetach(&wd_params->progress);
+    MemoryDetach(&wd_params->memory);
+    LatencyDetach(&wd_params->latency);
+    sem_destroy(&wd_params->dnr_return);
+    
+    free(wd_params);
+    wd_params = NULL;
 
     return SUCCESS;
 }
 
+/* the watchdog thread of a create that failed late runs already and may
+   have spawned wd_app, both are stopped as WDDestroy() would stop them   */
+static void AbortCreate(wd_params_ty *wd_params)
+{
+    while (0 == __atomic_load_n(&wd_params->self_tid, __ATOMIC_ACQUIRE))
+    {
+        sched_yield();
+    }
+    
+    WDDestroy(wd_params, 0);
+}
 
 int CreateNewThread(wd_params_ty *wd_params)
 {
     pthread_t wd_thread;
     pthread_attr_t attr;
+    sigset_t caller_mask;
     int status = 0;
     
     assert(NULL != wd_params);
@@ -176,7 +528,12 @@ int CreateNewThread(wd_params_ty *wd_params)
     RETURN_IF_BAD_CLEAN(!status, "pthread_attr_setdetachstate\n", FAILED,
                                                 pthread_attr_destroy(&attr));
     
+    status = BlockSignals(&caller_mask);
+    RETURN_IF_BAD_CLEAN(!status, "BlockSignals \n", FAILED,
+                                                pthread_attr_destroy(&attr));
+    
     status = pthread_create(&wd_thread, &attr, WDRoutine, (void*)wd_params);
+    RestoreSignals(&caller_mask);
     RETURN_IF_BAD_CLEAN(!status, "pthread_create\n", FAILED,
                                                 pthread_attr_destroy(&attr));
     
@@ -186,372 +543,2127 @@ int CreateNewThread(wd_params_ty *wd_params)
     return SUCCESS;
 }
 
-static char **CreateNewVector(int argc, char *argv[], size_t interval, size_t max_misses)
+int DoNotResuscitate(void)
+{
+    return DoNotResuscitateTimed(0);
+}
+
+int DoNotResuscitateTimed(size_t timeout_ms)
 {
-    char **new_vector = NULL;
-    char *file_name = FILE_NAME;
+    wd_params_ty *wd_params = NULL;
     
-    new_vector = (char **)malloc(sizeof(char *) * (argc + NUM_OF_ADDED_ARGS + 1));
-    RETURN_IF_BAD((NULL != new_vector), "malloc failed", NULL);
+    pthread_mutex_lock(&g_params_lock);
+    wd_params = g_wd_params;
+    pthread_mutex_unlock(&g_params_lock);
     
-    new_vector[0] = (char *)malloc(sizeof(char ) * (strlen(file_name) + 1));
-    RETURN_IF_BAD_CLEAN((NULL != new_vector), "malloc failed", NULL, free(new_vector));
+    RETURN_IF_BAD((NULL != wd_params), "DoNotResuscitate: no watchdog\n", FAILED);
     
-    strcpy(new_vector[0], file_name);
+    return WDDestroy(wd_params, timeout_ms);
+}
+
+int WDDestroy(wd_handle_ty *handle, size_t timeout_ms)
+{
+    int status = SUCCESS;
+    pid_t self_tid = 0;
+    pid_t other_pid = 0;
+    unsigned long deadline = 0;
+    unsigned long now = NowUsec();
     
-    new_vector[1] = AllocNumber(interval);
-    RETURN_IF_BAD((NULL != new_vector[1]), "malloc failed", NULL);
+    assert(NULL != handle);
     
-    new_vector[2] = AllocNumber(max_misses);
-    RETURN_IF_BAD((NULL != new_vector[2]), "malloc failed", NULL);
+    deadline = (0 == timeout_ms) ? 0 : now + timeout_ms * 1000;
     
-    memcpy(new_vector + NUM_OF_ADDED_ARGS, argv, sizeof(char *) * (argc + 1));
+    pthread_mutex_lock(&g_params_lock);
+    self_tid = handle->self_tid;
+    other_pid = handle->other_pid;
+    pthread_mutex_unlock(&g_params_lock);
     
-    return new_vector;
-}
-
-static char *AllocNumber(size_t num)
-{
-    char *ptr = NULL;
-    char value[BUFFER_SIZE];
-    size_t len = 0;
+    RETURN_IF_BAD((0 != self_tid), "WDDestroy: not running\n", FAILED);
+    
+    /* a handle that timed out still runs, its state stays */
+    status = WaitStopped(handle, self_tid, other_pid, deadline);
+    RETURN_IF_BAD(!status, "WDDestroy: timed out", WD_TIMED_OUT);
+    
+    /* nobody will be revived, so no state has to survive either */
+    if (handle->is_main)
+    {
+        PersistUnlinkAll();
+        
+        if (NULL != getenv(PAIR_NAME_ENV))
+        {
+            LogUnlink(getenv(PAIR_NAME_ENV));
+            LatencyUnlink(getenv(PAIR_NAME_ENV), getpid());
+        }
+    }
+    
+    if ('\0' != handle->name[0])
+    {
+        StatsUnlink(handle->name);
+    }
     
-    len = sprintf(value, "%ld", num);
+    /* wd_app stopped its scheduler as well, it is on its way out */
+    if (0 != other_pid)
+    {
+        now = NowUsec();
+        timeout_ms = (0 == deadline) ? handle->stop_policy.term_ms :
+                        (deadline > now) ? (deadline - now) / 1000 : 0;
+        
+        StopWaitOrKill(other_pid, timeout_ms);
+        
+        /* the first wd_app is our child */
+        waitpid(other_pid, NULL, WNOHANG);
+    }
     
-    value[len] = '\0';
+    DestroyAll(handle, handle->argv);
     
-    ptr = (char *)malloc(sizeof(char *) * (len + 1));
-    RETURN_IF_BAD((NULL != ptr), "malloc failed", NULL);
+    /* return status */
+    return status;
+}
+
+/* signals the watchdog thread and wd_app until the thread stopped - a stop
+   that lands right before a handler mode scheduler sleeps is sent again   */
+static int WaitStopped(wd_params_ty *params, pid_t self_tid, pid_t other_pid,
+                                                    unsigned long deadline)
+{
+    struct timespec ts;
+    unsigned long now = 0;
+    unsigned long wait_us = 0;
+    int status = 0;
     
-    strcpy(ptr, value);
+    for (;;)
+    {
+        SendStop(self_tid, other_pid);
+        
+        now = NowUsec();
+        if (0 != deadline && now >= deadline)
+        {
+            return FAILED;
+        }
+        
+        wait_us = STOP_RESEND_MS * 1000;
+        if (0 != deadline && deadline - now < wait_us)
+        {
+            wait_us = deadline - now;
+        }
+        
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += (long)(wait_us * 1000);
+        ts.tv_sec += ts.tv_nsec / 1000000000;
+        ts.tv_nsec %= 1000000000;
+        
+        do
+        {
+            status = sem_timedwait(&params->dnr_return, &ts);
+        }
+        while (0 != status && EINTR == errno);
+        
+        if (0 == status)
+        {
+            return SUCCESS;
+        }
+    }
+}
+
+/* our watchdog thread and wd_app only, not the whole process group */
+static void SendStop(pid_t self_tid, pid_t other_pid)
+{
+    if (0 != other_pid)
+    {
+        kill(other_pid, SIGUSR2);
+    }
     
-    return ptr;
+    syscall(SYS_tgkill, (int)getpid(), (int)self_tid, SIGUSR2);
 }
 
-int DoNotResuscitate(void)
+int WDSetRestartPolicy(const wd_restart_policy_ty *policy)
 {
-    int status = SUCCESS;
+    assert(NULL != policy);
     
-    status = kill(0, SIGUSR2);
-    RETURN_IF_BAD(!status, "kill SIGUSR2  failed", FAILED);
+    return RestartPolicyExport(policy);
+}
+
+int WDSetSignalMode(wd_signal_mode_ty mode)
+{
+    SetEnvNum(SIGNAL_MODE_ENV, (int)mode);
     
-    status = sem_wait(&(g_dnr_return));
-    RETURN_IF_BAD(!status, "sem_wait", FAILED);
+    return SUCCESS;
+}
+
+int WDSetEventLoop(wd_event_loop_ty loop)
+{
+    SetEnvNum(EVENT_LOOP_ENV, (int)loop);
     
-    status = sem_destroy(&(g_dnr_return)); /* check return value */
-    RETURN_IF_BAD(!status, "sem_wait", FAILED);
+    return SUCCESS;
+}
+
+int WDSetStopPolicy(const wd_stop_policy_ty *policy)
+{
+    assert(NULL != policy);
     
-    /* return status */
-    return status;
+    return StopPolicyExport(policy);
 }
 
-static int UnBlock()
+int WDSetGroupPolicy(const wd_group_policy_ty *policy)
 {
-    sigset_t mask;
-    int status = SUCCESS;
+    assert(NULL != policy);
     
-    /* update mask to unblock SIGUSR1 & SIGUSR2 */
-    status = sigemptyset(&mask);
-    RETURN_IF_BAD(!status, "sigemptyset failed\n", FAILED);
+    return GroupPolicyExport(policy);
+}
+
+void WDSetDrainHandler(void (*on_drain)(void *param, size_t ms_left),
+                       void *param)
+{
+    pthread_mutex_lock(&g_params_lock);
+    g_drain_fn = on_drain;
+    g_drain_param = param;
+    pthread_mutex_unlock(&g_params_lock);
+}
+
+int WDSetLatencyPolicy(const wd_latency_policy_ty *policy)
+{
+    assert(NULL != policy);
     
-    status = sigaddset(&mask, SIGUSR1);
-    RETURN_IF_BAD(!status, "sigaddset failed\n", FAILED);
+    return LatencyPolicyExport(policy);
+}
 
-    status = sigaddset(&mask, SIGUSR2);
-    RETURN_IF_BAD(!status, "sigaddset failed\n", FAILED);
+int WDSetMemoryPolicy(const wd_memory_policy_ty *policy)
+{
+    assert(NULL != policy);
     
-    status = sigprocmask(SIG_UNBLOCK, &mask, NULL);
-    RETURN_IF_BAD(!status, "sigprocmask failed\n", FAILED);
+    return MemoryPolicyExport(policy);
+}
 
-    return status;
+int WDSetProgressPolicy(const wd_progress_policy_ty *policy)
+{
+    assert(NULL != policy);
+    
+    return ProgressPolicyExport(policy);
 }
 
-static void *WDRoutine(void *params)
+int WDSetPhiPolicy(const wd_phi_policy_ty *policy)
 {
-    int status = 0; /*TODO ASSERT */
-    wd_params_ty *wd_params = (wd_params_ty *)params;
+    assert(NULL != policy);
+    
+    return PhiPolicyExport(policy);
+}
 
-    status = UnBlock();
-    RETURN_IF_BAD(!status, "UnBlock failed\n", NULL);
+int WDSetRatePolicy(const wd_rate_policy_ty *policy)
+{
+    assert(NULL != policy);
+    
+    return RatePolicyExport(policy);
+}
 
-     /* use WDFunc(params); */
-    WDFunc(wd_params, 1);
+int WDGetRestartState(wd_restart_state_ty *state)
+{
+    int status = FAILED;
     
-    DestroyAll(wd_params, NULL, wd_params->argv);
+    assert(NULL != state);
     
-    return NULL;
+    pthread_mutex_lock(&g_params_lock);
+    if (NULL != g_wd_params)
+    {
+        *state = g_wd_params->restart.counters;
+        status = SUCCESS;
+    }
+    pthread_mutex_unlock(&g_params_lock);
     
+    return status;
 }
 
-static int SignOfLife(void *params)
+int WDKeepFd(int fd, const char *name)
 {
-    int status = SUCCESS; 
-    wd_params_ty *wd_params = (wd_params_ty *)params;
+    channel_msg_ty msg;
+    int kept_fd = -1;
+    int status = SUCCESS;
     
-    /* ++g_signal_cnt */
-    __atomic_fetch_add(&g_signal_cnt, 1, 0);
+    assert(NULL != name);
     
-    /* send SIGUSR1 to  wd App  */
-    status = kill(wd_params->other_pid, SIGUSR1);
+    kept_fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    RETURN_IF_BAD((-1 != kept_fd), "WDKeepFd dup failed\n", FAILED);
     
-    fprintf(stderr,"send to:%d \n", wd_params->other_pid);
+    status = KeepFdStore(name, kept_fd);
+    RETURN_IF_BAD_CLEAN(!status, "WDKeepFd invalid name or table full\n",
+                                                    FAILED, close(kept_fd));
+    
+    /* a running wd_app gets it right away, a future one when it is spawned */
+    memset(&msg, 0, sizeof(msg));
+    msg.type = CHANNEL_KEEP_FD;
+    strcpy(msg.name, name);
+    
+    pthread_mutex_lock(&g_params_lock);
+    if (NULL != g_wd_params && -1 != g_wd_params->ctl_fd)
+    {
+        status = ChannelSend(g_wd_params->ctl_fd, &msg, kept_fd);
+    }
+    pthread_mutex_unlock(&g_params_lock);
     
-    RETURN_IF_BAD(!status, "kill failed\n", 0);
-
     return status;
 }
 
-static int CheckSignOfLife(void *params)
+static void SetChannel(wd_params_ty *params, int ctl_fd)
 {
-    wd_params_ty *wd_params = (wd_params_ty *)params;
-    int status = 0;
-    /* check if g_stop_flag == 1 */
-    if (TRUEE == g_stop_flag)
+    pthread_mutex_lock(&g_params_lock);
+    if (-1 != params->ctl_fd)
     {
-        /* SchedulerStop(params->scheduler) */
-        SchedulerStop(wd_params->scheduler);
+        close(params->ctl_fd);
     }
-    else if(0 == (wd_params->other_pid))
+    params->ctl_fd = ctl_fd;
+    pthread_mutex_unlock(&g_params_lock);
+}
+
+static int ReceiveControl(void *params)
+{
+    wd_params_ty *wd_params = (wd_params_ty *)params;
+    void (*on_drain)(void *param, size_t ms_left) = NULL;
+    void *drain_param = NULL;
+    channel_msg_ty msg;
+    int fd = -1;
+    
+    while (-1 != wd_params->ctl_fd &&
+                            0 == ChannelRecv(wd_params->ctl_fd, &msg, &fd))
     {
-        
-        status = IsWatchDogExist(wd_params);
-            
-        if(status)
+        switch (msg.type)
         {
-            fputs("Already Have WD App\n\n", stderr);
-               
-            sem_post(&(wd_params->have_connection));
+            case CHANNEL_KEEP_FD:
+                msg.name[CHANNEL_NAME_SIZE - 1] = '\0';
+                if (-1 != fd && 0 != KeepFdStore(msg.name, fd))
+                {
+                    close(fd);
+                }
+                fd = -1;
+                break;
+            
+            case CHANNEL_WD_TID:
+                wd_params->peer_tid = (pid_t)msg.arg;
+                break;
+            
+            case CHANNEL_DRAIN:
+                pthread_mutex_lock(&g_params_lock);
+                on_drain = g_drain_fn;
+                drain_param = g_drain_param;
+                pthread_mutex_unlock(&g_params_lock);
                 
-            return SUCCESS;
+                LogEvent(LOG_DRAIN_REQUESTED, getpid(), msg.arg, NULL);
+                if (NULL != on_drain)
+                {
+                    on_drain(drain_param, (size_t)msg.arg);
+                }
+                break;
         }
-        Revive(wd_params);
         
-        return SUCCESS;
-    }
-
-    /* if g_signal_cnt > params->max_misses */
-    else if(g_signal_cnt >= wd_params->max_misses)
-    {
-
-        /* Revive(params) */
-        Revive(wd_params);
+        if (-1 != fd)
+        {
+            close(fd);
+        }
     }
     
     return SUCCESS;
 }
 
-static void CleanFunc(ilrd_uid_ty uid, void *params)
+/* the watchdog thread of the app, so wd_app can leave it out of progress */
+static void SendThreadId(wd_params_ty *params)
 {
-    (void)uid;
-    (void)params;
+    channel_msg_ty msg;
+    
+    memset(&msg, 0, sizeof(msg));
+    msg.type = CHANNEL_WD_TID;
+    msg.arg = params->self_tid;
+    
+    if (-1 != params->ctl_fd)
+    {
+        ChannelSend(params->ctl_fd, &msg, -1);
+    }
 }
 
-
-int WDFunc(wd_params_ty *params, int should_post)
+static int CheckProgress(void *params)
 {
-    ilrd_uid_ty uid; 
-    int status = 0;
+    wd_params_ty *wd_params = (wd_params_ty *)params;
+    progress_verdict_ty verdict = PROGRESS_OK;
+    time_t now = ClockNow(wd_params);
     
-    /* Install signal handler for SIGUSR1 */
-    status = InstallSignalHandlers();
-    RETURN_IF_BAD(!status, "SchedulerAddTask ", FAILED);
+    if (0 == wd_params->other_pid || wd_params->planned_restart ||
+        wd_params->peer_stopped)
+    {
+        return SUCCESS;
+    }
     
-    status = sem_init(&g_dnr_return, 0, 0);
-    RETURN_IF_BAD(!status, "SchedulerAddTask ", FAILED);
+    /* a revived app, or its watchdog thread just introduced itself */
+    if (wd_params->progress.pid != wd_params->other_pid ||
+        wd_params->progress.skip_tid != wd_params->peer_tid)
+    {
+        ProgressAttach(&wd_params->progress, wd_params->other_pid,
+                                                wd_params->peer_tid, now);
+        return SUCCESS;
+    }
+    
+    verdict = ProgressSample(&wd_params->progress,
+                                        &wd_params->progress_policy, now);
+    if (PROGRESS_OK != verdict)
+    {
+        LogEvent(LOG_NO_PROGRESS, wd_params->other_pid, verdict, NULL);
+        
+        /* alive but useless - stopped and revived like a leaking one */
+        PlanRestart(wd_params);
+    }
+    
+    return SUCCESS;
+}
+
+static int CheckMemory(void *params)
+{
+    wd_params_ty *wd_params = (wd_params_ty *)params;
+    memory_verdict_ty verdict = MEMORY_OK;
+    
+    if (0 == wd_params->other_pid || wd_params->planned_restart ||
+        wd_params->peer_stopped)
+    {
+        return SUCCESS;
+    }
+    
+    /* a revived app starts a new trend, a dead one is left to the beats */
+    if (wd_params->memory.pid != wd_params->other_pid)
+    {
+        /* the backoff is of the peer that failed, not of its successor */
+        if (wd_params->memory_failed_pid != wd_params->other_pid)
+        {
+            wd_params->memory_failed_pid = wd_params->other_pid;
+            wd_params->memory_failures = 0;
+            wd_params->memory_skips = 0;
+        }
+        
+        if (0 < wd_params->memory_skips)
+        {
+            --wd_params->memory_skips;
+        }
+        else if (0 == MemoryAttach(&wd_params->memory, wd_params->other_pid,
+                                                &wd_params->memory_policy))
+        {
+            wd_params->memory_failures = 0;
+        }
+        else
+        {
+            /* logged after 1, 2, 4 ... failures, rarer and rarer */
+            ++wd_params->memory_failures;
+            if (0 == (wd_params->memory_failures &
+                      (wd_params->memory_failures - 1)))
+            {
+                LogError("MemoryAttach");
+            }
+            wd_params->memory_skips = (size_t)1 <<
+                        ((MEMORY_MAX_SHIFT < wd_params->memory_failures - 1) ?
+                        MEMORY_MAX_SHIFT : wd_params->memory_failures - 1);
+        }
+        return SUCCESS;
+    }
+    
+    verdict = MemorySample(&wd_params->memory, &wd_params->memory_policy,
+                                                        ClockNow(wd_params));
+    
+    if (NULL != wd_params->stats)
+    {
+        StatsWriteBegin(wd_params->stats);
+        wd_params->stats->memory_bytes = wd_params->memory.last_bytes;
+        wd_params->stats->memory_eta = wd_params->memory.eta;
+        StatsWriteEnd(wd_params->stats);
+    }
+    
+    if (MEMORY_OK != verdict)
+    {
+        LogEvent(LOG_MEMORY_RESTART, wd_params->other_pid,
+                        (long)(wd_params->memory.last_bytes / 1024), NULL);
+        PlanRestart(wd_params);
+    }
+    
+    return SUCCESS;
+}
+
+static int CheckLatency(void *params)
+{
+    wd_params_ty *wd_params = (wd_params_ty *)params;
+    const char *name = getenv(PAIR_NAME_ENV);
+    int violated = FALSEE;
+    
+    if (0 == wd_params->other_pid || wd_params->planned_restart ||
+        wd_params->peer_stopped || NULL == name)
+    {
+        return SUCCESS;
+    }
+    
+    /* a revived app records into a page of its own, the old one is gone */
+    if (wd_params->latency.pid != wd_params->other_pid)
+    {
+        if (0 != wd_params->latency.pid)
+        {
+            LatencyUnlink(name, wd_params->latency.pid);
+        }
+        LatencyDetach(&wd_params->latency);
+        wd_params->latency.pid = wd_params->other_pid;
+        wd_params->slo_misses = 0;
+    }
+    
+    /* the app creates its page in MakeMeImmortal(), it may not be there yet */
+    if (NULL == wd_params->latency.page &&
+        0 != LatencyAttach(&wd_params->latency, name, wd_params->other_pid))
+    {
+        wd_params->latency.pid = wd_params->other_pid;
+        return SUCCESS;
+    }
+    
+    violated = LatencyEvaluate(&wd_params->latency, &wd_params->latency_policy,
+                        wd_params->latency_policy.window / wd_params->interval);
+    
+    wd_params->slo_misses = violated ? wd_params->slo_misses + 1 : 0;
+    
+    if (NULL != wd_params->stats)
+    {
+        StatsWriteBegin(wd_params->stats);
+        wd_params->stats->request_latency_ns = wd_params->latency.last_pct_ns;
+        wd_params->stats->request_count = wd_params->latency.last_count;
+        wd_params->stats->slo_violations += (violated ? 1 : 0);
+        StatsWriteEnd(wd_params->stats);
+    }
+    
+    /* alive but too slow for too long - as good as missing the beats */
+    if (wd_params->slo_misses >= wd_params->max_misses)
+    {
+        LogEvent(LOG_SLO_RESTART, wd_params->other_pid,
+                                (long)wd_params->latency.last_pct_ns, NULL);
+        wd_params->slo_misses = 0;
+        PlanRestart(wd_params);
+    }
+    
+    return SUCCESS;
+}
+
+/* wd_app of a member joins its group and the groups above it */
+static void JoinGroup(wd_params_ty *params)
+{
+    wd_group_policy_ty policy;
+    char name[GROUP_NAME_SIZE];
+    
+    if (APP != params->p_type || '\0' == params->name[0] ||
+        0 != GroupPolicyImport(&policy, name))
+    {
+        return;
+    }
+    
+    params->group = GroupJoin(&policy, params->name, getpid());
+    if (NULL == params->group)
+    {
+        LogError("GroupJoin");
+    }
+}
+
+/* the app failed, the group names the members that restart along with it */
+static void FailGroup(wd_params_ty *params)
+{
+    int depth = GroupFailed(params->group, ClockNow(params));
+    
+    if (0 > depth)
+    {
+        /* every group up to the top reached its limit, CheckSignOfLife
+           retries on its next tick                                         */
+        LogEvent(LOG_RESTART_POSTPONED, params->other_pid, 0, "group");
+        return;
+    }
+    
+    LogEvent(LOG_GROUP_RESTART, params->other_pid, depth,
+                                            GroupActiveName(params->group));
+    params->planned_restart = FALSEE;
+    
+    StepGroup(params);
+}
+
+/* stops the app as soon as a restart of the group names it, starts it once
+   the members it depends on are up, returns TRUEE while it is down        */
+static int StepGroup(wd_params_ty *params)
+{
+    group_action_ty action = GroupNext(params->group, params->last_beat_us);
+    pid_t old_pid = params->other_pid;
+    int exit_status = 0;
+    
+    if (GROUP_STOP == action)
+    {
+        if (0 != old_pid && !params->peer_stopped)
+        {
+            StopOldPeer(params, &exit_status);
+            params->peer_stopped = TRUEE;
+        }
+        GroupDone(params->group, GROUP_STOP, NowUsec());
+        
+        action = GroupNext(params->group, params->last_beat_us);
+    }
+    
+    if (GROUP_START == action)
+    {
+        /* the restart policy of the member may postpone it */
+        Revive(params);
+        if (params->other_pid != old_pid)
+        {
+            GroupDone(params->group, GROUP_START, NowUsec());
+        }
+        
+        action = GroupNext(params->group, params->last_beat_us);
+    }
+    
+    return (GROUP_STOP == action || GROUP_WAIT == action ||
+                                                    GROUP_START == action);
+}
+
+static int CheckGroup(void *params)
+{
+    wd_params_ty *wd_params = (wd_params_ty *)params;
+    
+    if (0 != wd_params->other_pid && !wd_params->stop_flag)
+    {
+        StepGroup(wd_params);
+    }
+    
+    return SUCCESS;
+}
+
+/* CheckSignOfLife stops the peer and revives it on its next tick */
+static void PlanRestart(wd_params_ty *params)
+{
+    MemoryDetach(&params->memory);
+    params->planned_restart = TRUEE;
+    
+    if (NULL != params->stats)
+    {
+        StatsWriteBegin(params->stats);
+        ++params->stats->planned_restarts;
+        StatsWriteEnd(params->stats);
+    }
+}
+
+/* the watchdog thread takes SIGUSR1 & SIGUSR2 only, the rest is the app's */
+static int UnBlock(void)
+{
+    sigset_t mask;
+    int status = SUCCESS;
+    
+    status = sigfillset(&mask);
+    RETURN_IF_BAD(!status, "sigfillset failed\n", FAILED);
+    
+    status = sigdelset(&mask, SIGUSR1);
+    RETURN_IF_BAD(!status, "sigdelset failed\n", FAILED);
+
+    status = sigdelset(&mask, SIGUSR2);
+    RETURN_IF_BAD(!status, "sigdelset failed\n", FAILED);
+    
+    status = pthread_sigmask(SIG_SETMASK, &mask, NULL);
+    RETURN_IF_BAD(!status, "pthread_sigmask failed\n", FAILED);
+
+    return status;
+}
+
+static void *WDRoutine(void *params)
+{
+    int status = 0; /*TODO ASSERT */
+    wd_params_ty *wd_params = (wd_params_ty *)params;
+
+    /* a signalfd needs them blocked */
+    if (WD_SIGNAL_HANDLERS == wd_params->signal_mode)
+    {
+        status = UnBlock();
+        RETURN_IF_BAD(!status, "UnBlock failed\n", NULL);
+    }
+    
+    __atomic_store_n(&wd_params->self_tid, (pid_t)syscall(SYS_gettid),
+                                                        __ATOMIC_RELEASE);
+
+     /* use WDFunc(params); */
+    WDFunc(wd_params, 1);
+    
+    /* WDDestroy() frees the handle, it is not ours from here on */
+    sem_post(&wd_params->dnr_return);
+    
+    return NULL;
+    
+}
+
+static int SignOfLife(void *params)
+{
+    int status = SUCCESS; 
+    wd_params_ty *wd_params = (wd_params_ty *)params;
+    unsigned long now = NowUsec();
+    unsigned long lag = 0;
+    
+    /* a new peer gets a whole interval, also when this run is overdue
+       after a slow stop of the old one                                     */
+    if (wd_params->skip_miss)
+    {
+        wd_params->skip_miss = FALSEE;
+    }
+    else
+    {
+        /* ++signal_cnt */
+        __atomic_fetch_add(&wd_params->signal_cnt, 1, 0);
+    }
+    
+    /* the registry tells that we run, whether or not the peer takes it */
+    if (NULL != wd_params->registry)
+    {
+        RegistryBeat(wd_params->registry, (size_t)wd_params->reg_slot,
+                (WD == wd_params->p_type) ? REGISTRY_APP_SIDE : REGISTRY_WD_SIDE);
+    }
+    
+    /* no peer yet - pid 0 would signal the whole process group - or the
+       group stopped it, its pid may be recycled already                    */
+    if (0 == wd_params->other_pid || wd_params->peer_stopped)
+    {
+        return SUCCESS;
+    }
+    
+    /* wd_app beats the watchdog thread of the app only, wait until the app
+       introduced it                                                        */
+    if (APP == wd_params->p_type && 0 == wd_params->peer_tid)
+    {
+        ReceiveControl(wd_params);
+        if (0 == wd_params->peer_tid)
+        {
+            return SUCCESS;
+        }
+    }
+    
+    /* send SIGUSR1 to  wd App, stamped with the send time and the rate */
+    status = SendBeat(wd_params, RatePack(&wd_params->rate, now));
+    
+    /* how late the scheduler ran us compared to the previous beat */
+    if (0 != wd_params->last_sign_us)
+    {
+        lag = now - wd_params->last_sign_us;
+        lag = (lag > wd_params->beat_interval * 1000000) ?
+                                lag - wd_params->beat_interval * 1000000 : 0;
+    }
+    wd_params->last_sign_us = now;
+    
+    if (0 == status)
+    {
+        LogEvent(LOG_BEAT_SENT, wd_params->other_pid, (long)lag, NULL);
+    }
+    else
+    {
+        LogEvent(LOG_BEAT_FAILED, wd_params->other_pid, errno, NULL);
+    }
+    
+    if (NULL != wd_params->stats)
+    {
+        StatsWriteBegin(wd_params->stats);
+        ++wd_params->stats->beats_sent;
+        wd_params->stats->sched_lag_us_last = lag;
+        if (lag > wd_params->stats->sched_lag_us_max)
+        {
+            wd_params->stats->sched_lag_us_max = lag;
+        }
+        StatsWriteEnd(wd_params->stats);
+    }
+    
+    return SUCCESS;
+}
+
+static int CheckSignOfLife(void *params)
+{
+    wd_params_ty *wd_params = (wd_params_ty *)params;
+    size_t signal_cnt = wd_params->signal_cnt;
+    int status = 0;
+    int exit_status = 0;
+    int is_dead = FALSEE;
+    /* check if stop_flag == 1 */
+    if (TRUEE == wd_params->stop_flag)
+    {
+        /* SchedulerStop(params->scheduler) */
+        SchedulerStop(wd_params->scheduler);
+    }
+    else if(0 == (wd_params->other_pid))
+    {
+        
+        /* only the main watchdog of a revived app has one waiting for it */
+        status = wd_params->is_main && IsWatchDogExist(wd_params);
+            
+        /* IsConnected() releases the caller either way */
+        if(!status)
+        {
+            Revive(wd_params);
+        }
+        
+        return SUCCESS;
+    }
+    
+    /* an app of the pair started again took the place of the one we watch */
+    if (APP == wd_params->p_type && AdoptApp(wd_params))
+    {
+        return SUCCESS;
+    }
+    
+    /* the group restarts the app, its misses don't count meanwhile */
+    if (NULL != wd_params->group)
+    {
+        if (StepGroup(wd_params))
+        {
+            return SUCCESS;
+        }
+        
+        /* a step may have started a new app */
+        signal_cnt = wd_params->signal_cnt;
+    }
+    
+    if (NULL != wd_params->stats)
+    {
+        StatsWriteBegin(wd_params->stats);
+        ++wd_params->stats->miss_hist[(signal_cnt < STATS_MISS_BUCKETS) ?
+                                    signal_cnt : STATS_MISS_BUCKETS - 1];
+        StatsWriteEnd(wd_params->stats);
+    }
+
+    /* the detector may declare a silent peer dead before max_misses */
+    is_dead = (signal_cnt >= DeadAfter(wd_params)) || IsSuspected(wd_params);
+    
+    /* an additional watchdog leaves the revival to the main one */
+    if (is_dead && !wd_params->is_main && APP == wd_params->p_type)
+    {
+        StopOldPeer(wd_params, &exit_status);
+        SchedulerStop(wd_params->scheduler);
+    }
+    /* if signal_cnt > params->max_misses */
+    else if(is_dead || wd_params->planned_restart)
+    {
+        /* the strategy of the group decides who restarts along with it */
+        if (NULL != wd_params->group)
+        {
+            FailGroup(wd_params);
+        }
+        else
+        {
+            Revive(wd_params);
+        }
+    }
+    /* healthy means it beat lately, a dead peer not declared yet is not */
+    else if (signal_cnt <= 1)
+    {
+        pthread_mutex_lock(&g_params_lock);
+        RestartReportHealthy(&wd_params->restart_policy, &wd_params->restart,
+                                                        ClockNow(wd_params));
+        pthread_mutex_unlock(&g_params_lock);
+    }
+    
+    /* a check at the new rate took the place of this one */
+    return AdaptRate(wd_params, signal_cnt);
+}
+
+static void CleanFunc(ilrd_uid_ty uid, void *params)
+{
+    (void)uid;
+    (void)params;
+}
+
+/* a missed beat or an app in trouble brings the fast rate back - a beat
+   is missed after a tick of ours, or the ticks a slower peer takes         */
+static int AdaptRate(wd_params_ty *params, size_t signal_cnt)
+{
+    size_t ticks = (RatePeerInterval(&params->rate) + params->beat_interval -
+                                            1) / params->beat_interval;
+    size_t interval = RateUpdate(&params->rate,
+                            signal_cnt <= ticks && !IsUnderPressure(params));
+    
+    if (interval == params->beat_interval)
+    {
+        return SUCCESS;
+    }
+    
+    return (SUCCESS == SetRate(params, interval));
+}
+
+/* the beats and their check move to "interval" together, from an interval
+   from now on, the caller is the old check and ends itself once it
+   succeeded                                                                */
+static int SetRate(wd_params_ty *params, size_t interval)
+{
+    ilrd_uid_ty beat_uid;
+    ilrd_uid_ty check_uid;
+    size_t signal_cnt = 0;
+    
+    beat_uid = SchedulerAddTaskLater(params->scheduler, interval, SignOfLife,
+                                                (void *)params, CleanFunc);
+    RETURN_IF_BAD(!UIDIsSame(beat_uid, UIDBadID), "SchedulerAddTask", FAILED);
+    
+    check_uid = SchedulerAddTaskLater(params->scheduler, interval,
+                            CheckSignOfLife, (void *)params, CleanFunc);
+    RETURN_IF_BAD_CLEAN(!UIDIsSame(check_uid, UIDBadID), "SchedulerAddTask",
+                FAILED, SchedulerRemoveTask(params->scheduler, beat_uid));
+    
+    SchedulerRemoveTask(params->scheduler, params->beat_uid);
+    params->beat_uid = beat_uid;
+    
+    /* the misses so far count in ticks of the new rate, unless a beat just
+       ended them                                                           */
+    signal_cnt = __atomic_load_n(&params->signal_cnt, __ATOMIC_SEQ_CST);
+    __atomic_compare_exchange_n(&params->signal_cnt, &signal_cnt,
+                    signal_cnt * params->beat_interval / interval, FALSEE,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    params->beat_interval = interval;
+    params->last_sign_us = 0;
+    
+    LogEvent(LOG_RATE_CHANGED, params->other_pid, (long)interval, NULL);
+    
+    if (NULL != params->stats)
+    {
+        StatsWriteBegin(params->stats);
+        params->stats->beat_interval = interval;
+        StatsWriteEnd(params->stats);
+    }
+    
+    return SUCCESS;
+}
+
+
+int WDFunc(wd_params_ty *params, int should_post)
+{
+    ilrd_uid_ty uid; 
+    int status = 0;
+    wd_loop_ty loop;
+    
+    if (NULL != getenv(PAIR_NAME_ENV))
+    {
+        LogOpen(getenv(PAIR_NAME_ENV));
+    }
+    OpenStats(params);
+    if (NULL == params->ops)
+    {
+        OpenRegistry(params);
+    }
+    
+    /* the handlers run in this thread, they beat and stop this watchdog */
+    t_handle = params;
+    
+    /* Install signal handler for SIGUSR1 */
+    status = InstallSignalHandlers();
+    RETURN_IF_BAD(!status, "SchedulerAddTask ", FAILED);
+    
+    /* scheduler_ty *scheduler = SchedulerCreate(); */
+    params->scheduler = SchedulerCreate();
+    RETURN_IF_BAD((NULL != params->scheduler), "SchedulerCreate ", FAILED);
+    
+    /* a simulation runs on its own time, its beats come without signals */
+    loop.ring = NULL;
+    if (NULL != params->ops)
+    {
+        SchedulerSetClock(params->scheduler, &params->ops->clock);
+    }
+    else
+    {
+        /* the revives of the app are built while there is memory */
+        if (APP == params->p_type)
+        {
+            status = CreateSpawn(params, NULL, params->argv);
+            RETURN_IF_BAD(!status, "CreateSpawn ", FAILED);
+        }
+        
+        LoopStart(&loop, params);
+        
+        /* the loop reads the signalfd itself, it never has to drain it */
+        if (WD_SIGNAL_FD == params->signal_mode)
+        {
+            status = SetupSignalFd(params, NULL != loop.ring);
+            RETURN_IF_BAD(!status, "SetupSignalFd ", FAILED);
+        }
+    }
+    
+    /* the silence of the peer counts from now, on the scheduler's time */
+    PhiInit(&params->phi, &params->phi_policy, params->interval * 1000000,
+                                                    BeatNowUsec(params));
+    RateInit(&params->rate, &params->rate_policy, params->interval);
+    
+    
+    /* Add task to scheduler - SignOfLife */
+    uid = SchedulerAddTask(params->scheduler, params->interval, 
+                            SignOfLife, (void *)params,
+                            CleanFunc);
+    
+    status = UIDIsSame(uid, UIDBadID);
+    RETURN_IF_BAD(!status, "SchedulerAddTask ", FAILED);
+    params->beat_uid = uid;
+
+    /* Add task to scheduler - CheckSignOfLife */
+    uid = SchedulerAddTask(params->scheduler, params->interval, 
+                            CheckSignOfLife, (void *)params,
+                            CleanFunc);
+    status = UIDIsSame(uid, UIDBadID);
+    RETURN_IF_BAD(!status, "SchedulerAddTask ", FAILED);
+
+    
+    /* wd_app holds the descriptors the app wants to keep across restarts,
+       the app gets asked to drain - the loop polls the channel instead     */
+    if (NULL == loop.ring)
+    {
+        uid = SchedulerAddTask(params->scheduler, 1, ReceiveControl,
+         (void *)params, CleanFunc);
+        
+        status = UIDIsSame(uid, UIDBadID);
+        RETURN_IF_BAD(!status, "SchedulerAddTask", FAILED);
+    }
+    
+    if(!should_post && params->is_main)
+    {
+        /* a simulation stays out of the groups of real pairs */
+        if (NULL == params->ops)
+        {
+            JoinGroup(params);
+        }
+        
+        if (NULL != params->group)
+        {
+            uid = SchedulerAddTask(params->scheduler, 1, CheckGroup,
+                                                (void *)params, CleanFunc);
+            
+            status = UIDIsSame(uid, UIDBadID);
+            RETURN_IF_BAD(!status, "SchedulerAddTask", FAILED);
+        }
+        
+        if (0 != params->progress_policy.stall_time ||
+            0 != params->progress_policy.spin_time)
+        {
+            uid = SchedulerAddTask(params->scheduler, params->interval,
+                                    CheckProgress, (void *)params, CleanFunc);
+            
+            status = UIDIsSame(uid, UIDBadID);
+            RETURN_IF_BAD(!status, "SchedulerAddTask", FAILED);
+        }
+        
+        if (0 != params->latency_policy.slo_ns)
+        {
+            uid = SchedulerAddTask(params->scheduler, params->interval,
+                                    CheckLatency, (void *)params, CleanFunc);
+            
+            status = UIDIsSame(uid, UIDBadID);
+            RETURN_IF_BAD(!status, "SchedulerAddTask", FAILED);
+        }
+        
+        if (0 != params->memory_policy.limit_mb ||
+            params->memory_policy.use_cgroup)
+        {
+            uid = SchedulerAddTask(params->scheduler, params->interval,
+                                    CheckMemory, (void *)params, CleanFunc);
+            
+            status = UIDIsSame(uid, UIDBadID);
+            RETURN_IF_BAD(!status, "SchedulerAddTask", FAILED);
+        }
+    }
+
+    /* check if should_post */
+    if(should_post)
+    {
+        /* add task IsConnected(_mmi_return), short interval */
+        params->is_connecting = TRUEE;
+        uid = SchedulerAddTask(params->scheduler, 1, IsConnected,
+         (void *)params, CleanFunc);
+        
+        status = UIDIsSame(uid, UIDBadID);
+        RETURN_IF_BAD(!status, "SchedulerAddTask", FAILED);
+    }
+
+    /* armed - the app that spawned us stops waiting */
+    if (APP == params->p_type && -1 != params->ready_fd)
+    {
+        if (1 != write(params->ready_fd, "", 1))
+        {
+            LogError("ready pipe");
+        }
+        CloseFd(params->ready_fd);
+        params->ready_fd = -1;
+    }
+    
+    /* Run scheduler */
+    SchedulerRun(params->scheduler);
+    
+    LogEvent(LOG_SCHEDULER_STOPPED, getpid(), 0, NULL);
+    
+    LoopEnd(&loop);
+    
+    if (-1 != params->sig_fd)
+    {
+        SchedulerSetWakeFd(params->scheduler, -1, NULL, NULL);
+        close(params->sig_fd);
+        params->sig_fd = -1;
+    }
+    
+    t_handle = NULL;
+    
+    /* stopped for good, the group restarts without us */
+    if (NULL != params->group)
+    {
+        GroupLeave(params->group);
+        params->group = NULL;
+    }
+    
+    if (NULL != params->stats_page)
+    {
+        StatsClose(params->stats_page);
+        params->stats_page = NULL;
+        params->stats = NULL;
+    }
+    
+    CloseRegistry(params);
+    
+    SchedulerDestroy(params->scheduler);
+    
+    return SUCCESS;
+}
+
+static int IsConnected(void *wd)
+{
+    int status = 0;
+    
+    /* release the MMI (by sem_wait) */
+    if (((wd_params_ty *)wd)->other_pid != 0)
+    {
+        /* a wd_app we spawned says when it is armed, one we found already is */
+        status = (-1 != ((wd_params_ty *)wd)->ready_fd) ?
+                                    WaitReady((wd_params_ty *)wd) :
+                                    kill(((wd_params_ty *)wd)->other_pid, 0);
+        if (0 == status)
+        {
+            LogEvent(LOG_CONNECTED, ((wd_params_ty *)wd)->other_pid, 0, NULL);
+            ((wd_params_ty *)wd)->is_connecting = FALSEE;
+
+            if (0 != sem_post(&((wd_params_ty *)wd)->have_connection))
+            {
+                LogError("sem_post");
+            }
+            
+            return FAILED;
+        }
+    }
+    
+    return SUCCESS;
+}
+
+/* returns 0 once wd_app wrote to the ready pipe, not 0 if it did not yet or
+   died before it could - its pid is still taken then, kill() won't tell   */
+static int WaitReady(wd_params_ty *params)
+{
+    struct pollfd pfd;
+    char ready = 0;
+    int status = 0;
+    
+    pfd.fd = params->ready_fd;
+    pfd.events = POLLIN;
+    
+    do
+    {
+        status = poll(&pfd, 1, READY_TIMEOUT_MS);
+    }
+    while (-1 == status && EINTR == errno);
+    
+    if (1 != status || 1 != read(params->ready_fd, &ready, 1))
+    {
+        return FAILED;
+    }
+    
+    CloseFd(params->ready_fd);
+    params->ready_fd = -1;
+    
+    return SUCCESS;
+}
+
+static void CloseFd(int fd)
+{
+    if (-1 != fd)
+    {
+        close(fd);
+    }
+}
+
+static int Revive(wd_params_ty *params)
+{
+    pid_t other_pid = -1;
+    int status = 0;
+    int allowed = TRUEE;
+    int ctl_fds[2];
+    int ready_fds[2] = {-1, -1};
+    int exit_status = 0;
+    unsigned long detect_us = 0;
+    int fds[2 + KEEPFD_MAX];
+    size_t fds_cnt = 0;
+    pid_t reaped = 0;
+    time_t now = ClockNow(params);
+    
+    /* collect the zombie process */
+    if (params->other_pid != 0)
+    {
+        reaped = waitpid(params->other_pid, &exit_status, WNOHANG);
+        
+        /* the first launch is not a restart - backoff only real restarts */
+        pthread_mutex_lock(&g_params_lock);
+        allowed = RestartIsAllowed(&params->restart_policy, &params->restart, now);
+        if (allowed)
+        {
+            RestartRecord(&params->restart_policy, &params->restart, now);
+        }
+        pthread_mutex_unlock(&g_params_lock);
+        
+        if (!allowed)
+        {
+            /* postponed, CheckSignOfLife retries on its next tick */
+            LogEvent(LOG_RESTART_POSTPONED, params->other_pid,
+                                    (long)params->restart.counters.next_allowed, NULL);
+            return SUCCESS;
+        }
+        
+        /* hung, or asked to restart - never two instances at once */
+        if (params->other_pid != reaped && !params->peer_stopped)
+        {
+            reaped = StopOldPeer(params, &exit_status);
+        }
+        params->planned_restart = FALSEE;
+        
+        if (params->other_pid == reaped && NULL != params->stats)
+        {
+            StatsWriteBegin(params->stats);
+            params->stats->last_exit_status = exit_status;
+            StatsWriteEnd(params->stats);
+        }
+        
+        if (NULL != params->stats)
+        {
+            StatsWriteBegin(params->stats);
+            params->stats->restarts = params->restart.counters.total_restarts;
+            params->stats->breaker_trips = params->restart.counters.breaker_trips;
+            
+            /* a peer that never beat has no time to detect, only an uptime */
+            if (0 != params->last_beat_us)
+            {
+                detect_us = NowUsec() - params->last_beat_us;
+                params->stats->detect_us_last = detect_us;
+                if (detect_us > params->stats->detect_us_max)
+                {
+                    params->stats->detect_us_max = detect_us;
+                }
+            }
+            StatsWriteEnd(params->stats);
+        }
+    }    
+    
+    if (NULL != params->ops)
+    {
+        return SpawnSimulated(params);
+    }
+    
+    /* the thread id of a new app comes over the new channel */
+    if (APP == params->p_type)
+    {
+        params->peer_tid = 0;
+    }
+    
+    /* a fresh control channel for the new peer */
+    status = ChannelCreate(ctl_fds);
+    RETURN_IF_BAD(!status, "ChannelCreate", FAILED);
+    
+    /* a new wd_app writes to it once it is armed - for IsConnected() only,
+       the caller is released once                                          */
+    if (WD == params->p_type && params->is_connecting)
+    {
+        status = pipe2(ready_fds, O_CLOEXEC);
+        RETURN_IF_BAD_CLEAN(!status, "pipe2", FAILED,
+                                (close(ctl_fds[0]), close(ctl_fds[1])));
+    }
+    
+    /* nothing below allocates, the app may have run out of memory */
+    fds[fds_cnt++] = ctl_fds[1];
+    status = SetSpawnNum(params->spawn, CHANNEL_ENV, ctl_fds[1]);
+    if (-1 != ready_fds[1])
+    {
+        fds[fds_cnt++] = ready_fds[1];
+    }
+    
+    /* -1 overrides the pipe handed to an earlier wd_app */
+    if (WD == params->p_type)
+    {
+        status |= SetSpawnNum(params->spawn, READY_FD_ENV, ready_fds[1]);
+    }
+    
+    /* wd_app reviving the app: hand over the kept descriptors */
+    if (APP == params->p_type)
+    {
+        status |= KeepFdExport(params->spawn);
+        fds_cnt += KeepFdInherit(fds + fds_cnt);
+    }
+    
+    if (!status)
+    {
+        status = SpawnRun(params->spawn, fds, fds_cnt, &other_pid);
+    }
+    
+    close(ctl_fds[1]);
+    CloseFd(ready_fds[1]);
+    
+    RETURN_IF_BAD_CLEAN(!status, "SpawnRun", FAILED,
+                                (close(ctl_fds[0]), CloseFd(ready_fds[0])));
+    
+    SetChannel(params, ctl_fds[0]);
+    
+    /* IsConnected() waits for the new wd_app, not for an old one */
+    if (WD == params->p_type && params->is_connecting)
+    {
+        CloseFd(params->ready_fd);
+        params->ready_fd = ready_fds[0];
+    }
+    
+    if (WD == params->p_type)
+    {
+        /* a new wd_app knows nothing about us nor the kept descriptors */
+        SendThreadId(params);
+        if (params->is_main)
+        {
+            KeepFdSendAll(ctl_fds[0]);
+        }
+    }
+    
+    params->other_pid = other_pid;
+    params->peer_stopped = FALSEE;
+    params->skip_miss = TRUEE;
+    __atomic_store_n(&params->signal_cnt, 0, __ATOMIC_SEQ_CST);
+    PhiRestart(&params->phi, BeatNowUsec(params));
+    RateRestart(&params->rate);
+    
+    LogEvent(LOG_REVIVED, other_pid, (long)params->restart.counters.total_restarts, NULL);
+    
+    if (NULL != params->stats)
+    {
+        StatsWriteBegin(params->stats);
+        params->stats->peer_pid = (unsigned long)other_pid;
+        StatsWriteEnd(params->stats);
+    }
+    PublishPeer(params);
+    
+    status = waitpid(other_pid, NULL, 1);
+    RETURN_IF_BAD(!status, "waitpid Failed", FAILED);
+
+    /* return status; */
+    return SUCCESS;
+}
+
+/* the mocked spawn of a simulation, the new peer introduces itself at once */
+static int SpawnSimulated(wd_params_ty *params)
+{
+    pid_t other_pid = 0;
+    int status = 0;
+    
+    status = params->ops->spawn(params->ops->param, &other_pid, params->argv);
+    RETURN_IF_BAD(!status, "spawn", FAILED);
+    
+    params->other_pid = other_pid;
+    params->peer_tid = other_pid;
+    params->skip_miss = TRUEE;
+    __atomic_store_n(&params->signal_cnt, 0, __ATOMIC_SEQ_CST);
+    PhiRestart(&params->phi, BeatNowUsec(params));
+    RateRestart(&params->rate);
+    
+    LogEvent(LOG_REVIVED, other_pid, (long)params->restart.counters.total_restarts, NULL);
+    
+    return SUCCESS;
+}
+
+/* drains, terminates or kills the peer, returns its pid if it was reaped */
+static pid_t StopOldPeer(wd_params_ty *params, int *exit_status)
+{
+    static const char *phase_names[STOP_PHASES] = {"drain", "term", "kill"};
+    stop_report_ty report;
+    unsigned long took_us = 0;
+    size_t i = 0;
+    
+    /* a simulated peer goes at once */
+    if (NULL != params->ops)
+    {
+        params->ops->kill(params->ops->param, params->other_pid, SIGKILL);
+        return params->other_pid;
+    }
+    
+    /* only the app knows how to drain */
+    if (0 != StopProcess(params->other_pid, &params->stop_policy,
+                    (APP == params->p_type) ? params->ctl_fd : -1, &report))
+    {
+        LogError("peer survived SIGKILL");
+    }
+    
+    if (0 != report.phases)
+    {
+        for (i = 0; i < report.phases; ++i)
+        {
+            took_us += report.phase_us[i];
+        }
+        LogEvent(LOG_PEER_STOPPED, params->other_pid, (long)took_us,
+                                            phase_names[report.phases - 1]);
+        
+        if (NULL != params->stats)
+        {
+            StatsWriteBegin(params->stats);
+            for (i = 0; i < STOP_PHASES; ++i)
+            {
+                params->stats->stop_phase_us[i] = report.phase_us[i];
+            }
+            ++params->stats->stops_ended[report.phases - 1];
+            StatsWriteEnd(params->stats);
+        }
+    }
+    
+    /* the first app is our parent, not our child - nothing to reap */
+    return waitpid(params->other_pid, exit_status, WNOHANG);
+}
+
+/* a live wd_app of the pair in the registry: the one that revived us, or
+   one whose app is gone - a restarted app takes the place of that one
+   instead of spawning a second watchdog                                   */
+static int IsWatchDogExist(wd_params_ty *wd)
+{
+    registry_record_ty record;
+    pid_t wd_pid = 0;
+    int is_revived = FALSEE;
+    
+    assert(wd);
+    
+    if (NULL == wd->registry ||
+        0 != RegistryRead(wd->registry, (size_t)wd->reg_slot, &record))
+    {
+        return SUCCESS;
+    }
+    
+    /* the pid may be of another process by now, unless it still beats */
+    wd_pid = (pid_t)record.wd_pid;
+    if (!RegistryIsAlive(wd_pid, record.wd_start) || 0 == record.wd_start ||
+                                            !IsWdAppFresh(wd, &record))
+    {
+        return SUCCESS;
+    }
+    
+    /* another instance of the app that runs with it */
+    is_revived = (wd_pid == getppid());
+    if (!is_revived && getpid() != (pid_t)record.app_pid &&
+        RegistryIsAlive((pid_t)record.app_pid, record.app_start))
+    {
+        return SUCCESS;
+    }
+    
+    wd->other_pid = wd_pid;
+    
+    /* only a child inherits the channel, wd_app adopts any other app */
+    if (is_revived)
+    {
+        pthread_mutex_lock(&g_env_lock);
+        SetChannel(wd, ChannelInherited());
+        pthread_mutex_unlock(&g_env_lock);
+        SendThreadId(wd);
+    }
+    PublishPeer(wd);
+    
+    LogEvent(LOG_WD_EXISTS, wd_pid, (long)record.generation, NULL);
+    
+    return FAILED;
+}
+
+/* wd_app stamps every tick, at most the slowest rate apart - it is missed
+   after max_misses of those, like by its app                              */
+static int IsWdAppFresh(const wd_params_ty *params,
+                        const registry_record_ty *record)
+{
+    size_t interval = (params->rate_policy.max_interval > params->interval) ?
+                        params->rate_policy.max_interval : params->interval;
+    
+    return (RegistryBeatAge(record, REGISTRY_WD_SIDE) <=
+                    (unsigned long)(params->max_misses * interval) * 1000000000UL);
+}
+
+/* the app of the record took the place of the one we watch, which is gone:
+   it is our peer from now on - it has no channel to us, nor kept descriptors
+   for us to hand over, until we revive it ourselves                        */
+static int AdoptApp(wd_params_ty *params)
+{
+    registry_record_ty record;
+    pid_t app_pid = 0;
+    pid_t old_pid = params->other_pid;
+    
+    if (NULL == params->registry || !params->is_main ||
+        0 != RegistryRead(params->registry, (size_t)params->reg_slot, &record))
+    {
+        return FALSEE;
+    }
+    
+    app_pid = (pid_t)record.app_pid;
+    if (getpid() != (pid_t)record.wd_pid || old_pid == app_pid ||
+        0 == record.app_tid || RegistryIsAlive(old_pid, 0) ||
+        !RegistryIsAlive(app_pid, record.app_start))
+    {
+        return FALSEE;
+    }
+    
+    /* the app we revived is our child */
+    waitpid(old_pid, NULL, WNOHANG);
+    
+    SetChannel(params, -1);
+    params->other_pid = app_pid;
+    params->peer_tid = (pid_t)record.app_tid;
+    params->peer_stopped = FALSEE;
+    params->planned_restart = FALSEE;
+    params->skip_miss = TRUEE;
+    __atomic_store_n(&params->signal_cnt, 0, __ATOMIC_SEQ_CST);
+    PhiRestart(&params->phi, BeatNowUsec(params));
+    RateRestart(&params->rate);
+    
+    LogEvent(LOG_APP_ADOPTED, app_pid, old_pid, NULL);
+    
+    if (NULL != params->stats)
+    {
+        StatsWriteBegin(params->stats);
+        params->stats->peer_pid = (unsigned long)app_pid;
+        StatsWriteEnd(params->stats);
+    }
+    
+    /* the app counts our beats since it found us, not since we adopted it */
+    SendBeat(params, RatePack(&params->rate, NowUsec()));
+    
+    return TRUEE;
+}
+
+void SetEnvNum(const char *var_name, int var)
+{
+    int status = 0;
+    char pid_str[24];
+    size_t len = 0;
+    
+    assert(var_name);
+
+    len = sprintf(pid_str, "%d", var);
+    assert(len);
+    pid_str[len] = '\0';
+
+    status = setenv(var_name, pid_str, 1);
+    assert(-1 != status);
+}
+
+/* everything a revive needs, so that it allocates nothing - wd_spawn.h */
+static int CreateSpawn(wd_params_ty *params, char *const prefix[], char *argv[])
+{
+    sigset_t app_mask;
+    int status = 0;
+    
+    params->spawn = SpawnCreate(prefix, argv, environ);
+    RETURN_IF_BAD((NULL != params->spawn), "SpawnCreate", FAILED);
+    
+    /* the wd_app of an additional watchdog knows which one it is */
+    if (WD == params->p_type && !params->is_main)
+    {
+        status = SpawnSetEnv(params->spawn, HANDLE_NAME_ENV, params->handle);
+    }
+    
+    /* wd_app revives the app with the mask it started with, not its own -
+       the watchdog thread blocks all but the beats, wd_app starts with none
+       blocked and sets up its own                                          */
+    if (APP == params->p_type && 0 == ImportSignalMask(&app_mask))
+    {
+        SpawnSetMask(params->spawn, &app_mask);
+    }
+    else if (WD == params->p_type)
+    {
+        sigemptyset(&app_mask);
+        SpawnSetMask(params->spawn, &app_mask);
+    }
+    
+    RETURN_IF_BAD_CLEAN(!status, "SpawnSetEnv", FAILED,
+                            (SpawnDestroy(params->spawn), params->spawn = NULL));
+    params->argv = SpawnArgv(params->spawn);
+    
+    return SUCCESS;
+}
+
+static int SetSpawnNum(spawn_ty *spawn, const char *var_name, int var)
+{
+    char value[BUFFER_SIZE];
+    
+    sprintf(value, "%d", var);
+    
+    return SpawnSetEnv(spawn, var_name, value);
+}
+
+static pid_t GetEnvNum(const char *var_name)
+{
+    char *value = NULL;
+    
+    assert(var_name);
+    
+    value = getenv(var_name);
+    
+    if(NULL == value)
+    {
+        return SUCCESS;
+    }
+    
+    return atoi(value);
+}
+
+
+
+static int InstallSignalHandlers(void)
+{
+    struct sigaction sigusr1_act;
+    struct sigaction sigusr2_act;
+    int status = 0;
+
+    /* Install signal handler for SIGUSR1 */
+    sigusr1_act.sa_flags = SA_SIGINFO;
+    sigusr1_act.sa_sigaction = HandlerSIGUSR1;
+    
+    status = sigemptyset(&sigusr1_act.sa_mask);
+    RETURN_IF_BAD(!status, "sigemptyset", FAILED);
     
-    /* scheduler_ty *scheduler = SchedulerCreate(); */
-    params->scheduler = SchedulerCreate();
+    status = sigaction(SIGUSR1, &sigusr1_act, NULL);
+    RETURN_IF_BAD(!status, "sigaction", FAILED);
+
+    /* Install signal handler for SIGUSR2 */
+    sigusr2_act.sa_flags = 0;
+    sigusr2_act.sa_handler = HandlerSIGUSR2;
     
+    status = sigemptyset(&sigusr2_act.sa_mask);
+    RETURN_IF_BAD(!status, "sigemptyset", FAILED);
     
-    /* Add task to scheduler - SignOfLife */
-    uid = SchedulerAddTask(params->scheduler, params->interval, 
-                            SignOfLife, (void *)params,
-                            CleanFunc);
+    status = sigaction(SIGUSR2, &sigusr2_act, NULL);
+    RETURN_IF_BAD(!status, "sigaction", FAILED);
     
-    status = UIDIsSame(uid, UIDBadID);
-    RETURN_IF_BAD(!status, "SchedulerAddTask ", FAILED);
+    return SUCCESS;
 
-    /* Add task to scheduler - CheckSignOfLife */
-    uid = SchedulerAddTask(params->scheduler, params->interval, 
-                            CheckSignOfLife, (void *)params,
-                            CleanFunc);
-    status = UIDIsSame(uid, UIDBadID);
-    RETURN_IF_BAD(!status, "SchedulerAddTask ", FAILED);
+}
 
+/* names the pair once, the watchdog and every revived instance inherit it */
+static void ExportPairName(const char *argv0)
+{
+    char name[NAME_MAX_SIZE];
+    const char *base = strrchr(argv0, '/');
     
-    /* check if should_post */
-    if(should_post)
+    if (NULL != getenv(PAIR_NAME_ENV))
     {
-        /* add task IsConnected(_mmi_return), short interval */
-        uid = SchedulerAddTask(params->scheduler, 1, IsConnected,
-         (void *)params, CleanFunc);
-        
-        status = UIDIsSame(uid, UIDBadID);
-        RETURN_IF_BAD(!status, "SchedulerAddTask", FAILED);
+        return;
     }
+    
+    base = (NULL == base) ? argv0 : base + 1;
+    sprintf(name, "%.*s.%d", NAME_MAX_SIZE - 16, base, (int)getpid());
+    
+    setenv(PAIR_NAME_ENV, name, 1);
+}
 
-    /* Run scheduler */
-    SchedulerRun(params->scheduler);
+static int IsValidHandleName(const char *handle)
+{
+    return ('\0' != handle[0] && HANDLE_NAME_SIZE > strlen(handle) &&
+                                                NULL == strchr(handle, '/'));
+}
+
+static void OpenStats(wd_params_ty *params)
+{
+    if ('\0' == params->name[0])
+    {
+        return;
+    }
     
-    sem_post(&g_dnr_return);
+    params->stats_page = StatsOpen(params->name, TRUEE);
+    if (NULL == params->stats_page)
+    {
+        LogError("StatsOpen");
+        return;
+    }
     
-    DestroyAll(params, params->scheduler, NULL);
+    params->stats = &params->stats_page->side[(WD == params->p_type) ?
+                                            STATS_APP_SIDE : STATS_WD_SIDE];
     
-    return SUCCESS;
+    StatsWriteBegin(params->stats);
+    params->stats->pid = (unsigned long)getpid();
+    params->stats->peer_pid = (unsigned long)params->other_pid;
+    params->stats->beat_interval = params->beat_interval;
+    StatsWriteEnd(params->stats);
 }
 
-static int IsConnected(void *wd)
+static void OpenRegistry(wd_params_ty *params)
 {
-    int status = 0;
+    registry_record_ty *record = NULL;
+    pid_t wd_pid = 0;
     
-    /* release the MMI (by sem_wait) */
-    if (((wd_params_ty *)wd)->other_pid != 0)
+    if ('\0' == params->name[0])
     {
-        status = kill(((wd_params_ty *)wd)->other_pid, 0);
-        if (0 == status)
+        return;
+    }
+    
+    params->registry = RegistryOpen(REGISTRY_SHM, TRUEE);
+    if (NULL == params->registry)
+    {
+        LogError("RegistryOpen");
+        return;
+    }
+    
+    params->reg_slot = RegistryAttach(params->registry, params->name,
+                (WD == params->p_type) ? REGISTRY_APP_SIDE : REGISTRY_WD_SIDE);
+    if (-1 == params->reg_slot)
+    {
+        LogError("RegistryAttach");
+        RegistryClose(params->registry);
+        params->registry = NULL;
+        return;
+    }
+    
+    /* a new wd_app takes the record over, unless another one still runs */
+    if (APP == params->p_type)
+    {
+        record = RegistryWriteBegin(params->registry, (size_t)params->reg_slot);
+        wd_pid = (pid_t)record->wd_pid;
+        if (getpid() == wd_pid || !RegistryIsAlive(wd_pid, record->wd_start))
         {
-            fprintf(stderr,"IsConnected to: %d\n", ((wd_params_ty *)wd)->other_pid);
-
-            if (0 != sem_post(&((wd_params_ty *)wd)->have_connection))
+            record->wd_pid = (unsigned long)getpid();
+            record->wd_start = RegistryStartTime(getpid());
+            ++record->generation;
+            if ((pid_t)record->app_pid != params->other_pid)
             {
-                fprintf(stderr, "sem_post FAILED!\n");
+                record->app_pid = (unsigned long)params->other_pid;
+                record->app_start = RegistryStartTime(params->other_pid);
+                record->app_tid = 0;
             }
-            
-            return FAILED;
         }
+        RegistryWriteEnd(record);
     }
     
-    return SUCCESS;
+    /* fresh from the start, before the first tick */
+    RegistryBeat(params->registry, (size_t)params->reg_slot,
+                (WD == params->p_type) ? REGISTRY_APP_SIDE : REGISTRY_WD_SIDE);
 }
 
-
-static int Revive(wd_params_ty *params)
+/* stopped for good: the record no longer names us */
+static void CloseRegistry(wd_params_ty *params)
 {
-    pid_t other_pid = -1;
-    int status = 0;
+    registry_record_ty *record = NULL;
     
-    /* collect the zombie process */
-    if (params->other_pid != 0)
+    if (NULL == params->registry)
     {
-        waitpid(-1, NULL, WNOHANG);
-    }    
-    
-     /* do a fork */
-    other_pid = fork();
-    
-    RETURN_IF_BAD((other_pid >= 0), "fork", 1);
+        return;
+    }
     
-    if (0 == other_pid)
+    record = RegistryWriteBegin(params->registry, (size_t)params->reg_slot);
+    if (WD == params->p_type && getpid() == (pid_t)record->app_pid)
     {
-        /* child process: */
-        /*execvp wd_app.out */
-        status = execvp(params->argv[0], params->argv);
-        
-        RETURN_IF_BAD(!status, "execvp Failed", FAILED);
+        record->app_pid = 0;
+        record->app_tid = 0;
+        record->app_start = 0;
     }
-    else
+    else if (APP == params->p_type && getpid() == (pid_t)record->wd_pid)
     {
-        /* else */
-            /* parent process: */
-        params->other_pid = other_pid;
-        __atomic_store_n(&g_signal_cnt, 0, __ATOMIC_SEQ_CST);
-        status = waitpid(other_pid, NULL, 1);
-        RETURN_IF_BAD(!status, "waitpid Failed", FAILED);
+        record->wd_pid = 0;
+        record->wd_start = 0;
     }
-
-    /* return status; */
-    return SUCCESS;
+    RegistryWriteEnd(record);
+    
+    RegistryClose(params->registry);
+    params->registry = NULL;
+    params->reg_slot = -1;
 }
 
-static int IsWatchDogExist(wd_params_ty *wd)
+/* the app of the record and the thread that takes its beats, as the side
+   that started the other one knows them - never over a pair that runs    */
+static void PublishPeer(wd_params_ty *params)
 {
+    registry_record_ty *record = NULL;
     pid_t wd_pid = 0;
     
-    assert(wd);
+    if (NULL == params->registry)
+    {
+        return;
+    }
     
-    wd_pid = GetEnvNum("WD_PID");
+    record = RegistryWriteBegin(params->registry, (size_t)params->reg_slot);
+    wd_pid = (pid_t)record->wd_pid;
+    if (WD == params->p_type && (params->other_pid == wd_pid ||
+                        !RegistryIsAlive(wd_pid, record->wd_start)))
+    {
+        record->app_pid = (unsigned long)getpid();
+        record->app_start = RegistryStartTime(getpid());
+        record->app_tid = (unsigned long)params->self_tid;
+    }
+    else if (APP == params->p_type && getpid() == wd_pid &&
+                                (pid_t)record->app_pid != params->other_pid)
+    {
+        /* the app may have introduced itself already */
+        record->app_pid = (unsigned long)params->other_pid;
+        record->app_start = RegistryStartTime(params->other_pid);
+        record->app_tid = 0;
+    }
+    RegistryWriteEnd(record);
+}
+
+/* the mask of the calling thread, as the bitmap of signals 1 - 64 */
+static void ExportSignalMask(void)
+{
+    sigset_t mask;
+    char value[24];
+    unsigned long bits = 0;
+    int sig = 0;
     
-    if (0 == wd_pid)
+    if (0 != pthread_sigmask(SIG_BLOCK, NULL, &mask))
     {
-        return 0;
+        return;
     }
-    else
+    
+    for (sig = 1; sig <= 64; ++sig)
     {
-        if(wd_pid == getppid())
+        if (1 == sigismember(&mask, sig))
         {
-            wd->other_pid = wd_pid;
-            
-            fprintf(stderr, "IsWatchDogExist(), connect to wd_pid %d \n\n", wd_pid);
-            
-            return FAILED;
+            bits |= 1UL << (sig - 1);
         }
     }
+    
+    sprintf(value, "%lx", bits);
+    setenv(SIGMASK_ENV, value, 1);
+}
 
+static int ImportSignalMask(sigset_t *mask)
+{
+    const char *value = getenv(SIGMASK_ENV);
+    unsigned long bits = 0;
+    int sig = 0;
+    
+    if (NULL == value || 1 != sscanf(value, "%lx", &bits))
+    {
+        return FAILED;
+    }
+    
+    sigemptyset(mask);
+    for (sig = 1; sig <= 64; ++sig)
+    {
+        if (bits & (1UL << (sig - 1)))
+        {
+            sigaddset(mask, sig);
+        }
+    }
+    
     return SUCCESS;
 }
 
-void SetEnvNum(const char *var_name, int var)
+/* the caller's signals are no longer blocked while it waits */
+static int SemWaitNoIntr(sem_t *sem)
 {
     int status = 0;
-    char pid_str[24];
-    size_t len = 0;
     
-    assert(var_name);
+    do
+    {
+        status = sem_wait(sem);
+    }
+    while (0 != status && EINTR == errno);
+    
+    return status;
+}
 
-    len = sprintf(pid_str, "%d", var);
-    assert(len);
-    pid_str[len] = '\0';
+/* heartbeats and the stop request are read by the scheduler loop, a read
+   of the loop of wd_app may block, it waits in the kernel                 */
+static int SetupSignalFd(wd_params_ty *params, int is_blocking)
+{
+    sigset_t mask;
+    int status = SUCCESS;
+    
+    status = sigemptyset(&mask);
+    status |= sigaddset(&mask, SIGUSR1);
+    status |= sigaddset(&mask, SIGUSR2);
+    RETURN_IF_BAD(!status, "sigaddset failed\n", FAILED);
+    
+    status = pthread_sigmask(SIG_BLOCK, &mask, NULL);
+    RETURN_IF_BAD(!status, "pthread_sigmask failed\n", FAILED);
+    
+    params->sig_fd = signalfd(-1, &mask,
+                            (is_blocking ? 0 : SFD_NONBLOCK) | SFD_CLOEXEC);
+    RETURN_IF_BAD((-1 != params->sig_fd), "signalfd failed\n", FAILED);
+    
+    SchedulerSetWakeFd(params->scheduler, params->sig_fd, ReadSignals, params);
+    
+    return SUCCESS;
+}
 
-    status = setenv(var_name, pid_str, 1);
-    assert(-1 != status);
+/* wd_app waits in a ring if it may and the kernel has one, the scheduler
+   waits in poll() otherwise                                               */
+static void LoopStart(wd_loop_ty *loop, wd_params_ty *params)
+{
+    sched_clock_ty clock;
+    
+    loop->params = params;
+    loop->ring = NULL;
+    loop->is_reading = FALSEE;
+    loop->is_peer_polled = FALSEE;
+    loop->is_ctl_polled = FALSEE;
+    loop->peer = 0;
+    loop->ctl_fd = -1;
+    loop->pidfd = -1;
+    loop->arm = 0;
+    
+    if (APP != params->p_type || WD_LOOP_AUTO != params->event_loop)
+    {
+        return;
+    }
+    
+    loop->ring = UringCreate(LOOP_ENTRIES);
+    if (NULL == loop->ring)
+    {
+        return;
+    }
+    
+    clock.now = LoopNow;
+    clock.sleep = LoopSleep;
+    clock.param = loop;
+    SchedulerSetClock(params->scheduler, &clock);
 }
 
-static pid_t GetEnvNum(const char *var_name)
+static void LoopEnd(wd_loop_ty *loop)
 {
-    char *value = NULL;
+    if (NULL == loop->ring)
+    {
+        return;
+    }
     
-    assert(var_name);
+    SchedulerSetClock(loop->params->scheduler, NULL);
+    UringDestroy(loop->ring);
+    loop->ring = NULL;
+    CloseFd(loop->pidfd);
+    loop->pidfd = -1;
+}
+
+static time_t LoopNow(void *loop)
+{
+    (void)loop;
     
-    value = getenv(var_name);
+    return time(NULL);
+}
+
+/* the reads and polls that completed are queued again along with the wait,
+   any completion cuts it short                                            */
+static int LoopSleep(void *loop, time_t seconds)
+{
+    wd_loop_ty *wd_loop = (wd_loop_ty *)loop;
+    wd_params_ty *params = wd_loop->params;
     
-    if(NULL == value)
+    if (!wd_loop->is_reading && -1 != params->sig_fd &&
+        0 == UringQueueRead(wd_loop->ring, params->sig_fd, wd_loop->infos,
+                                    sizeof(wd_loop->infos), LOOP_SIGNALS))
     {
-        return SUCCESS;
+        wd_loop->is_reading = TRUEE;
     }
     
-    return atoi(value);
+    if (wd_loop->peer != params->other_pid || wd_loop->ctl_fd != params->ctl_fd)
+    {
+        LoopWatchPeer(wd_loop);
+    }
+    LoopPoll(wd_loop);
+    
+    return (0 != UringWait(wd_loop->ring, (long)seconds * 1000, OnLoopDone,
+                                                                    wd_loop));
 }
 
+/* a new peer: the polls of the old one are cancelled, they would hold its
+   pidfd and channel until they fire - a cancel the ring has no room for
+   leaves one to complete for nothing, its arm is not current             */
+static void LoopWatchPeer(wd_loop_ty *loop)
+{
+    wd_params_ty *params = loop->params;
+    
+    if (loop->is_peer_polled && -1 != loop->pidfd)
+    {
+        UringQueueCancel(loop->ring, (loop->arm << LOOP_KIND_BITS) | LOOP_PEER,
+                                                                LOOP_CANCEL);
+    }
+    if (loop->is_ctl_polled && -1 != loop->ctl_fd)
+    {
+        UringQueueCancel(loop->ring,
+                            (loop->arm << LOOP_KIND_BITS) | LOOP_CONTROL,
+                                                                LOOP_CANCEL);
+    }
+    
+    ++loop->arm;
+    loop->peer = params->other_pid;
+    loop->ctl_fd = params->ctl_fd;
+    loop->is_peer_polled = FALSEE;
+    loop->is_ctl_polled = FALSEE;
+    
+    CloseFd(loop->pidfd);
+    loop->pidfd = (0 == loop->peer) ? -1 :
+                            (int)syscall(SYS_pidfd_open, loop->peer, 0);
+}
 
+/* the polls of the peer that are not in flight, a full ring retries them
+   with the next wait rather than leave the peer unwatched                */
+static void LoopPoll(wd_loop_ty *loop)
+{
+    if (!loop->is_peer_polled && -1 != loop->pidfd)
+    {
+        loop->is_peer_polled = (0 == UringQueuePoll(loop->ring, loop->pidfd,
+                                (loop->arm << LOOP_KIND_BITS) | LOOP_PEER));
+    }
+    if (!loop->is_ctl_polled && -1 != loop->ctl_fd)
+    {
+        loop->is_ctl_polled = (0 == UringQueuePoll(loop->ring, loop->ctl_fd,
+                                (loop->arm << LOOP_KIND_BITS) | LOOP_CONTROL));
+    }
+}
 
-static int InstallSignalHandlers(void)
+static void OnLoopDone(void *loop, unsigned long tag, int res)
 {
-    struct sigaction sigusr1_act;
-    struct sigaction sigusr2_act;
-    int status = 0;
+    wd_loop_ty *wd_loop = (wd_loop_ty *)loop;
+    wd_params_ty *params = wd_loop->params;
+    int is_current = ((tag >> LOOP_KIND_BITS) == wd_loop->arm);
+    
+    switch (tag & ((1UL << LOOP_KIND_BITS) - 1))
+    {
+        case LOOP_SIGNALS:
+            wd_loop->is_reading = FALSEE;
+            if (0 < res)
+            {
+                OnSignals(params, wd_loop->infos,
+                                (size_t)res / sizeof(wd_loop->infos[0]));
+            }
+            else if (-EINTR != res)
+            {
+                errno = -res;
+                LogError("signalfd read");
+            }
+            break;
+        
+        /* a channel the app closed stays readable, it is polled no more */
+        case LOOP_CONTROL:
+            if (is_current)
+            {
+                ReceiveControl(params);
+                wd_loop->is_ctl_polled = !(0 < res &&
+                                            !(res & (POLLHUP | POLLERR)));
+            }
+            break;
+        
+        /* all of its beats are missed at once, the next check revives it */
+        case LOOP_PEER:
+            if (is_current && 0 < res && !params->peer_stopped &&
+                !params->stop_flag)
+            {
+                __atomic_store_n(&params->signal_cnt, DeadAfter(params),
+                                                            __ATOMIC_SEQ_CST);
+            }
+            break;
+    }
+}
 
-    /* Install signal handler for SIGUSR1 */
-    sigusr1_act.sa_flags = 0;
-    sigusr1_act.sa_handler = HandlerSIGUSR1;
+/* to the watchdog thread of the app, nobody else in the app is
+   interrupted - wd_app is single threaded, its pid will do, and it keeps
+   its ids, they cost a system call each                                  */
+static int SendBeat(wd_params_ty *params, unsigned long value)
+{
+    static pid_t self_pid = 0;
+    static uid_t self_uid = 0;
+    union sigval sig_value;
+    siginfo_t info;
     
-    status = sigemptyset(&sigusr1_act.sa_mask);
-    RETURN_IF_BAD(!status, "sigemptyset", FAILED);
+    sig_value.sival_ptr = (void *)(size_t)value;
     
-    status = sigaction(SIGUSR1, &sigusr1_act, NULL);
-    RETURN_IF_BAD(!status, "sigaction", FAILED);
+    if (NULL != params->ops)
+    {
+        return (NULL != params->ops->beat) ?
+                params->ops->beat(params->ops->param, params->other_pid, value) :
+                params->ops->kill(params->ops->param, params->other_pid, SIGUSR1);
+    }
+    
+    if (WD == params->p_type)
+    {
+        return sigqueue(params->other_pid, SIGUSR1, sig_value);
+    }
+    
+    if (0 == self_pid)
+    {
+        self_pid = getpid();
+        self_uid = getuid();
+    }
+    
+    memset(&info, 0, sizeof(info));
+    info.si_signo = SIGUSR1;
+    info.si_code = SI_QUEUE;
+    info.si_pid = self_pid;
+    info.si_uid = self_uid;
+    info.si_value = sig_value;
+    
+    return (int)syscall(SYS_rt_tgsigqueueinfo, (int)params->other_pid,
+                                    (int)params->peer_tid, SIGUSR1, &info);
+}
 
-    /* Install signal handler for SIGUSR2 */
-    sigusr2_act.sa_flags = 0;
-    sigusr2_act.sa_handler = HandlerSIGUSR2;
+/* the time of the restart decisions, simulated or the wall clock */
+static time_t ClockNow(const wd_params_ty *params)
+{
+    if (NULL != params->ops)
+    {
+        return params->ops->clock.now(params->ops->clock.param);
+    }
     
-    status = sigemptyset(&sigusr2_act.sa_mask);
-    RETURN_IF_BAD(!status, "sigemptyset", FAILED);
+    return time(NULL);
+}
+
+static unsigned long NowUsec(void)
+{
+    struct timespec ts;
     
-    status = sigaction(SIGUSR2, &sigusr2_act, NULL);
-    RETURN_IF_BAD(!status, "sigaction", FAILED);
+    clock_gettime(CLOCK_MONOTONIC, &ts);
     
-    return SUCCESS;
+    return (unsigned long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
 
+/* the time of the beats the detector learns from, simulated or monotonic */
+static unsigned long BeatNowUsec(const wd_params_ty *params)
+{
+    if (NULL != params->ops)
+    {
+        return (unsigned long)ClockNow(params) * 1000000;
+    }
+    
+    return NowUsec();
+}
+
+/* the silence of the peer is unlikely enough, by what it showed so far */
+static int IsSuspected(wd_params_ty *params)
+{
+    size_t peer_interval = RatePeerInterval(&params->rate);
+    double phi = 0;
+    
+    if (0 >= params->phi_policy.threshold)
+    {
+        return FALSEE;
+    }
+    
+    /* the times between the beats of another rate tell nothing */
+    if (peer_interval != params->phi_interval)
+    {
+        PhiRescale(&params->phi, peer_interval * 1000000);
+        params->phi_interval = peer_interval;
+    }
+    
+    phi = PhiValue(&params->phi, BeatNowUsec(params));
+    if (phi < params->phi_policy.threshold)
+    {
+        return FALSEE;
+    }
+    
+    LogEvent(LOG_SUSPECTED, params->other_pid,
+                        (phi < 1e6) ? (long)(phi * 1000) : 1000000000L, NULL);
+    
+    return TRUEE;
 }
 
+/* max_misses of the interval the peer beats at, in ticks of our own rate -
+   a tick of a slower rate than the peer's is never enough alone           */
+static size_t DeadAfter(const wd_params_ty *params)
+{
+    size_t ticks = (params->max_misses * RatePeerInterval(&params->rate) +
+                        params->beat_interval - 1) / params->beat_interval;
+    
+    return (ticks > params->max_misses) ? ticks : params->max_misses;
+}
 
+/* the checks of wd_app see the app heading for a planned restart */
+static int IsUnderPressure(const wd_params_ty *params)
+{
+    long eta = params->memory.eta;
+    
+    return (params->planned_restart || 0 != params->slo_misses ||
+            (0 <= eta && (size_t)eta <= 2 * params->memory_policy.horizon));
+}
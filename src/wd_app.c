@@ -5,7 +5,6 @@
 *******************************************************************************/
 #define _POSIX_C_SOURCE 200112L  /* sigset_t, CLOCK_REALTIME, SIG_UNBLOCK */
 
-#include <stdio.h>      /* printf, perror */
 #include <stdlib.h>     /* exit, atoi */
 #include <unistd.h>     /* sleep */
 #include <signal.h>     /* sig_atomic_t, sigaction, kill, SIGUSR1, SIGUSR2 */
@@ -19,27 +18,30 @@
 #include "watchdog.h"
 #include "scheduler.h"
 #include "wd_internal.h"
+#include "wd_channel.h"
+#include "wd_log.h"
 
 
-static volatile size_t g_signal_cnt = 0;
-static volatile int g_stop_flag = 0;
-
 int main (int argc, char *argv[])
 {
     /* set signals */
-    /* set enviorement variable as WD_PID */
     /* get the params from argv and use it in WDFunc and it should be not be posted  */
     size_t interval = 0, max_misses = 0;
     wd_params_ty *wd = NULL;
-    SetEnvNum("WD_PID",(int)getpid());
     
-    fprintf(stderr, "wd_app has been created %d & Thread is %d\n", getpid(), getppid());
+    if (NULL != getenv(PAIR_NAME_ENV))
+    {
+        LogOpen(getenv(PAIR_NAME_ENV));
+    }
+    LogEvent(LOG_WD_APP_STARTED, getpid(), getppid(), NULL);
     
     interval = atoi(argv[1]);
     max_misses = atoi(argv[2]);
     
     
-    wd = CreateStruct(argc, argv + 3, interval, max_misses, 0);
+    /* an additional watchdog of the app was named by it */
+    wd = CreateStruct(argc, argv + 3, interval, max_misses, 0,
+                                                getenv(HANDLE_NAME_ENV));
     
     if (NULL == wd)
     {
@@ -47,14 +49,18 @@ int main (int argc, char *argv[])
     }
     
     wd->other_pid = getppid();
+    wd->ctl_fd = ChannelInherited();
+    
+    /* tells the app we are armed, see WDFunc() */
+    if (NULL != getenv(READY_FD_ENV))
+    {
+        wd->ready_fd = atoi(getenv(READY_FD_ENV));
+        unsetenv(READY_FD_ENV);
+    }
     
     wd->p_type = APP;
     
     WDFunc(wd, 0);
     
-    unsetenv("WD_PID");
-    
-    puts ("finish wd_app");
-    
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,122 @@
+/*******************************************************************************
+ * Project:     Watchdog - control channel between the app and wd_app
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#define _GNU_SOURCE  /* SOCK_CLOEXEC, MSG_CMSG_CLOEXEC */
+
+#include <stdlib.h>     /* getenv, strtol */
+#include <string.h>     /* memset, memcpy */
+#include <limits.h>     /* INT_MAX      */
+#include <fcntl.h>      /* fcntl        */
+#include <assert.h>     /* assert       */
+#include <sys/socket.h> /* socketpair, sendmsg, recvmsg */
+
+#include "wd_channel.h"
+
+int ChannelCreate(int fds[2])
+{
+    assert(NULL != fds);
+
+    return (0 != socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds));
+}
+
+int ChannelInherited(void)
+{
+    const char *value = getenv(CHANNEL_ENV);
+    char *end = NULL;
+    long fd = -1;
+
+    if (NULL == value)
+    {
+        return -1;
+    }
+
+    fd = strtol(value, &end, 10);
+    if (end == value || '\0' != *end || 0 > fd || INT_MAX < fd ||
+        -1 == fcntl((int)fd, F_GETFD))
+    {
+        fd = -1;
+    }
+
+    /* ours alone, whatever we spawn gets a channel of its own */
+    unsetenv(CHANNEL_ENV);
+
+    return (int)fd;
+}
+
+int ChannelSend(int channel, const channel_msg_ty *msg, int fd)
+{
+    struct msghdr hdr;
+    struct iovec iov;
+    struct cmsghdr *cmsg = NULL;
+    union
+    {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    }control;
+
+    assert(NULL != msg);
+
+    memset(&hdr, 0, sizeof(hdr));
+    iov.iov_base = (void *)msg;
+    iov.iov_len = sizeof(*msg);
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+
+    if (-1 != fd)
+    {
+        memset(&control, 0, sizeof(control));
+        hdr.msg_control = control.buf;
+        hdr.msg_controllen = sizeof(control.buf);
+
+        cmsg = CMSG_FIRSTHDR(&hdr);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    }
+
+    return ((ssize_t)sizeof(*msg) != sendmsg(channel, &hdr, MSG_NOSIGNAL));
+}
+
+int ChannelRecv(int channel, channel_msg_ty *msg, int *fd)
+{
+    struct msghdr hdr;
+    struct iovec iov;
+    struct cmsghdr *cmsg = NULL;
+    union
+    {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    }control;
+
+    assert(NULL != msg);
+    assert(NULL != fd);
+
+    *fd = -1;
+
+    memset(&hdr, 0, sizeof(hdr));
+    iov.iov_base = msg;
+    iov.iov_len = sizeof(*msg);
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = control.buf;
+    hdr.msg_controllen = sizeof(control.buf);
+
+    if ((ssize_t)sizeof(*msg) != recvmsg(channel, &hdr,
+                                         MSG_DONTWAIT | MSG_CMSG_CLOEXEC))
+    {
+        return 1;
+    }
+
+    for (cmsg = CMSG_FIRSTHDR(&hdr); NULL != cmsg; cmsg = CMSG_NXTHDR(&hdr, cmsg))
+    {
+        if (SOL_SOCKET == cmsg->cmsg_level && SCM_RIGHTS == cmsg->cmsg_type)
+        {
+            memcpy(fd, CMSG_DATA(cmsg), sizeof(int));
+        }
+    }
+
+    return 0;
+}
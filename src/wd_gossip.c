@@ -0,0 +1,798 @@
+/*******************************************************************************
+ * Project:     Watchdog - cross-host heartbeats
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#define _POSIX_C_SOURCE 200112L  /* clock_gettime, rand_r, posix_spawnp */
+
+#include <stdlib.h>     /* malloc, free, strtoul, rand_r    */
+#include <string.h>     /* memcpy, memmove, strchr, strlen  */
+#include <stdio.h>      /* sprintf                          */
+#include <errno.h>      /* errno, EINTR                     */
+#include <assert.h>     /* assert                           */
+#include <unistd.h>     /* close, pipe, read, write         */
+#include <fcntl.h>      /* fcntl, O_NONBLOCK, FD_CLOEXEC    */
+#include <poll.h>       /* poll                             */
+#include <pthread.h>    /* pthread_create, pthread_join     */
+#include <signal.h>     /* sigfillset, pthread_sigmask      */
+#include <spawn.h>      /* posix_spawnp                     */
+#include <sys/wait.h>   /* waitpid                          */
+#include <sys/socket.h> /* socket, bind, sendto, recvfrom   */
+#include <netinet/in.h> /* sockaddr_in                      */
+#include <arpa/inet.h>  /* inet_pton, inet_ntop             */
+#include <time.h>       /* clock_gettime                    */
+
+#include "wd_gossip.h"
+
+extern char **environ;
+
+/* a digest: magic, version, count, sender id, then "count" entries of
+   id, heartbeat, ip and port, all in network byte order                    */
+enum {GOSSIP_MAGIC = 0x5747, GOSSIP_VERSION = 1, HEADER_SIZE = 8,
+      ENTRY_SIZE = 18, MESSAGE_SIZE = HEADER_SIZE +
+                                      GOSSIP_MAX_DIGEST * ENTRY_SIZE,
+      MAX_HOOKS = 8, ID_SIZE = 11};
+
+typedef enum member_state
+{
+    MEMBER_ALIVE = 0,
+    MEMBER_FAILED = 1
+}member_state_ty;
+
+typedef struct member
+{
+    unsigned int id;
+    unsigned long heartbeat;
+    unsigned long updated_ms;
+    struct sockaddr_in addr;
+    member_state_ty state;
+}member_ty;
+
+/* the members are sorted by id, the node itself is not one of them */
+struct wd_gossip
+{
+    unsigned int id;
+    unsigned long heartbeat;
+    struct sockaddr_in addr;
+    int fd;
+    size_t interval_ms;
+    size_t fanout;
+    size_t fail_ms;
+    void (*on_failed)(void *param, unsigned int node_id, const char *addr);
+    void *param;
+    char hook[GOSSIP_HOOK_SIZE];
+    struct sockaddr_in seeds[GOSSIP_MAX_SEEDS];
+    size_t n_seeds;
+    member_ty members[GOSSIP_MAX_NODES];
+    size_t n_members;
+    size_t cursor;
+    unsigned int rand_seed;
+    pid_t hooks[MAX_HOOKS];
+    gossip_stats_ty stats;
+    pthread_t thread;
+    int wake[2];
+};
+
+static void PutU16(unsigned char *buf, unsigned int value)
+{
+    buf[0] = (unsigned char)(value >> 8);
+    buf[1] = (unsigned char)value;
+}
+
+static void PutU32(unsigned char *buf, unsigned long value)
+{
+    PutU16(buf, (unsigned int)(value >> 16) & 0xFFFF);
+    PutU16(buf + 2, (unsigned int)value & 0xFFFF);
+}
+
+static void PutU64(unsigned char *buf, unsigned long value)
+{
+    PutU32(buf, (value >> 16) >> 16);
+    PutU32(buf + 4, value & 0xFFFFFFFFUL);
+}
+
+static unsigned int GetU16(const unsigned char *buf)
+{
+    return ((unsigned int)buf[0] << 8) | buf[1];
+}
+
+static unsigned long GetU32(const unsigned char *buf)
+{
+    return ((unsigned long)GetU16(buf) << 16) | GetU16(buf + 2);
+}
+
+static unsigned long GetU64(const unsigned char *buf)
+{
+    return ((GetU32(buf) << 16) << 16) | GetU32(buf + 4);
+}
+
+/* "ip:port" of "len" characters */
+static int ParseAddr(const char *text, size_t len, struct sockaddr_in *addr)
+{
+    char buf[GOSSIP_ADDR_SIZE];
+    char *colon = NULL;
+    char *end = NULL;
+    unsigned long port = 0;
+
+    if (len >= GOSSIP_ADDR_SIZE)
+    {
+        return 1;
+    }
+    memcpy(buf, text, len);
+    buf[len] = '\0';
+
+    colon = strchr(buf, ':');
+    if (NULL == colon || '\0' == colon[1])
+    {
+        return 1;
+    }
+    *colon = '\0';
+
+    port = strtoul(colon + 1, &end, 10);
+    if ('\0' != *end || 65535 < port)
+    {
+        return 1;
+    }
+
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_port = htons((unsigned short)port);
+
+    return (1 != inet_pton(AF_INET, buf, &addr->sin_addr));
+}
+
+static void FormatAddr(const struct sockaddr_in *addr,
+                       char text[GOSSIP_ADDR_SIZE])
+{
+    inet_ntop(AF_INET, &addr->sin_addr, text, GOSSIP_ADDR_SIZE);
+    sprintf(text + strlen(text), ":%u", (unsigned int)ntohs(addr->sin_port));
+}
+
+static int ParseSeeds(wd_gossip_ty *node, const char *seeds)
+{
+    const char *comma = NULL;
+
+    while (NULL != seeds && '\0' != *seeds)
+    {
+        if (GOSSIP_MAX_SEEDS == node->n_seeds)
+        {
+            return 1;
+        }
+
+        comma = strchr(seeds, ',');
+        comma = (NULL == comma) ? seeds + strlen(seeds) : comma;
+        if (0 != ParseAddr(seeds, (size_t)(comma - seeds),
+                                                &node->seeds[node->n_seeds]))
+        {
+            return 1;
+        }
+        ++node->n_seeds;
+
+        seeds = ('\0' == *comma) ? comma : comma + 1;
+    }
+
+    return 0;
+}
+
+static int SetFdFlags(int fd)
+{
+    return (-1 == fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) ||
+            -1 == fcntl(fd, F_SETFD, FD_CLOEXEC));
+}
+
+static int OpenSocket(wd_gossip_ty *node)
+{
+    socklen_t len = sizeof(node->addr);
+
+    node->fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (-1 == node->fd)
+    {
+        return 1;
+    }
+
+    if (0 != SetFdFlags(node->fd) ||
+        0 != bind(node->fd, (struct sockaddr *)&node->addr, len) ||
+        0 != getsockname(node->fd, (struct sockaddr *)&node->addr, &len))
+    {
+        close(node->fd);
+        node->fd = -1;
+        return 1;
+    }
+
+    return 0;
+}
+
+static unsigned long WallClockUs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return (unsigned long)ts.tv_sec * 1000000 +
+           (unsigned long)ts.tv_nsec / 1000;
+}
+
+wd_gossip_ty *GossipCreate(const wd_gossip_config_ty *config)
+{
+    wd_gossip_ty *node = NULL;
+
+    assert(NULL != config);
+
+    if (NULL == config->bind || 0 == config->interval_ms ||
+        0 == config->fanout || config->fail_ms <= config->interval_ms ||
+        (NULL != config->hook && GOSSIP_HOOK_SIZE <= strlen(config->hook)))
+    {
+        return NULL;
+    }
+
+    node = (wd_gossip_ty *)malloc(sizeof(wd_gossip_ty));
+    if (NULL == node)
+    {
+        return NULL;
+    }
+
+    node->id = config->node_id;
+    node->heartbeat = WallClockUs();
+    node->interval_ms = config->interval_ms;
+    node->fanout = config->fanout;
+    node->fail_ms = config->fail_ms;
+    node->on_failed = config->on_failed;
+    node->param = config->param;
+    strcpy(node->hook, (NULL == config->hook) ? "" : config->hook);
+    node->n_seeds = 0;
+    node->n_members = 0;
+    node->cursor = 0;
+    node->rand_seed = (unsigned int)(node->heartbeat ^ config->node_id);
+    memset(node->hooks, 0, sizeof(node->hooks));
+    memset(&node->stats, 0, sizeof(node->stats));
+
+    if (0 != ParseAddr(config->bind, strlen(config->bind), &node->addr) ||
+        0 != ParseSeeds(node, config->seeds) || 0 != OpenSocket(node))
+    {
+        free(node);
+        return NULL;
+    }
+
+    return node;
+}
+
+void GossipDestroy(wd_gossip_ty *node)
+{
+    if (NULL == node)
+    {
+        return;
+    }
+
+    close(node->fd);
+    free(node);
+}
+
+int GossipFd(const wd_gossip_ty *node)
+{
+    assert(NULL != node);
+
+    return node->fd;
+}
+
+void GossipAddr(const wd_gossip_ty *node, char addr[GOSSIP_ADDR_SIZE])
+{
+    assert(NULL != node);
+
+    FormatAddr(&node->addr, addr);
+}
+
+/* the index of member "id", or where it would be inserted */
+static size_t Find(const wd_gossip_ty *node, unsigned int id, int *is_found)
+{
+    size_t low = 0;
+    size_t high = node->n_members;
+    size_t mid = 0;
+
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        if (node->members[mid].id < id)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    *is_found = (low < node->n_members && node->members[low].id == id);
+
+    return low;
+}
+
+static void PutEntry(unsigned char *buf, unsigned int id,
+                     unsigned long heartbeat, const struct sockaddr_in *addr)
+{
+    PutU32(buf, id);
+    PutU64(buf + 4, heartbeat);
+    memcpy(buf + 12, &addr->sin_addr.s_addr, 4);
+    memcpy(buf + 16, &addr->sin_port, 2);
+}
+
+/* the node itself, then the next alive members from the cursor on */
+static size_t Pack(wd_gossip_ty *node, unsigned char *message)
+{
+    member_ty *member = NULL;
+    size_t count = 1;
+    size_t visited = 0;
+
+    PutU16(message, GOSSIP_MAGIC);
+    message[2] = GOSSIP_VERSION;
+    PutU32(message + 4, node->id);
+    PutEntry(message + HEADER_SIZE, node->id, node->heartbeat, &node->addr);
+
+    for (visited = 0; visited < node->n_members && count < GOSSIP_MAX_DIGEST;
+                                                                    ++visited)
+    {
+        member = &node->members[node->cursor];
+        node->cursor = (node->cursor + 1) % node->n_members;
+
+        if (MEMBER_ALIVE == member->state)
+        {
+            PutEntry(message + HEADER_SIZE + count * ENTRY_SIZE, member->id,
+                                            member->heartbeat, &member->addr);
+            ++count;
+        }
+    }
+    message[3] = (unsigned char)count;
+
+    return HEADER_SIZE + count * ENTRY_SIZE;
+}
+
+/* "fanout" distinct alive members with an address, a seed while none */
+static size_t PickPeers(wd_gossip_ty *node, const struct sockaddr_in **peers)
+{
+    size_t candidates[GOSSIP_MAX_NODES];
+    size_t n_candidates = 0;
+    size_t picked = 0;
+    size_t swap = 0;
+    size_t i = 0;
+
+    for (i = 0; i < node->n_members; ++i)
+    {
+        if (MEMBER_ALIVE == node->members[i].state &&
+            0 != node->members[i].addr.sin_addr.s_addr)
+        {
+            candidates[n_candidates++] = i;
+        }
+    }
+
+    if (0 == n_candidates)
+    {
+        if (0 == node->n_seeds)
+        {
+            return 0;
+        }
+        peers[0] = &node->seeds[(size_t)rand_r(&node->rand_seed) %
+                                                            node->n_seeds];
+        return 1;
+    }
+
+    for (picked = 0; picked < node->fanout && picked < n_candidates; ++picked)
+    {
+        i = picked + (size_t)rand_r(&node->rand_seed) %
+                                                (n_candidates - picked);
+        swap = candidates[i];
+        candidates[i] = candidates[picked];
+        candidates[picked] = swap;
+        peers[picked] = &node->members[swap].addr;
+    }
+
+    return picked;
+}
+
+size_t GossipRound(wd_gossip_ty *node)
+{
+    const struct sockaddr_in *peers[GOSSIP_MAX_NODES];
+    unsigned char message[MESSAGE_SIZE];
+    size_t n_peers = 0;
+    size_t size = 0;
+    size_t sent = 0;
+    size_t i = 0;
+
+    assert(NULL != node);
+
+    ++node->heartbeat;
+
+    n_peers = PickPeers(node, peers);
+    for (i = 0; i < n_peers; ++i)
+    {
+        /* every message takes the next members, a round spreads more */
+        size = Pack(node, message);
+        if ((ssize_t)size == sendto(node->fd, message, size, 0,
+                        (const struct sockaddr *)peers[i], sizeof(*peers[i])))
+        {
+            ++sent;
+            node->stats.bytes_sent += size;
+        }
+    }
+    node->stats.messages_sent += sent;
+
+    return sent;
+}
+
+static void Merge(wd_gossip_ty *node, const unsigned char *entry,
+                  const struct sockaddr_in *from, unsigned long now_ms)
+{
+    unsigned int id = (unsigned int)GetU32(entry);
+    unsigned long heartbeat = GetU64(entry + 4);
+    member_ty *member = NULL;
+    int is_found = 0;
+    size_t at = 0;
+
+    if (id == node->id)
+    {
+        return;
+    }
+
+    at = Find(node, id, &is_found);
+    member = &node->members[at];
+
+    if (!is_found)
+    {
+        if (GOSSIP_MAX_NODES == node->n_members)
+        {
+            ++node->stats.dropped;
+            return;
+        }
+        memmove(member + 1, member, (node->n_members - at) * sizeof(*member));
+        ++node->n_members;
+
+        member->id = id;
+        memset(&member->addr, 0, sizeof(member->addr));
+        member->addr.sin_family = AF_INET;
+    }
+    else if (heartbeat <= member->heartbeat)
+    {
+        return;
+    }
+
+    member->heartbeat = heartbeat;
+    member->updated_ms = now_ms;
+    member->state = MEMBER_ALIVE;
+
+    /* the sender is reached where it sent from, others as they say */
+    if (NULL != from)
+    {
+        member->addr = *from;
+    }
+    else if (0 != GetU32(entry + 12))
+    {
+        memcpy(&member->addr.sin_addr.s_addr, entry + 12, 4);
+        memcpy(&member->addr.sin_port, entry + 16, 2);
+    }
+}
+
+static int Unpack(wd_gossip_ty *node, const unsigned char *message,
+                  size_t size, const struct sockaddr_in *from,
+                  unsigned long now_ms)
+{
+    unsigned int sender = 0;
+    size_t count = 0;
+    size_t i = 0;
+
+    if (HEADER_SIZE > size || GOSSIP_MAGIC != GetU16(message) ||
+        GOSSIP_VERSION != message[2])
+    {
+        return 1;
+    }
+
+    count = message[3];
+    if (0 == count || GOSSIP_MAX_DIGEST < count ||
+        HEADER_SIZE + count * ENTRY_SIZE != size)
+    {
+        return 1;
+    }
+
+    sender = (unsigned int)GetU32(message + 4);
+    for (i = 0; i < count; ++i)
+    {
+        message += (0 == i) ? HEADER_SIZE : ENTRY_SIZE;
+        Merge(node, message, (GetU32(message) == sender) ? from : NULL,
+                                                                    now_ms);
+    }
+
+    return 0;
+}
+
+size_t GossipReceive(wd_gossip_ty *node, unsigned long now_ms)
+{
+    unsigned char message[MESSAGE_SIZE + 1];
+    struct sockaddr_in from;
+    socklen_t len = 0;
+    ssize_t size = 0;
+    size_t received = 0;
+
+    assert(NULL != node);
+
+    while (1)
+    {
+        len = sizeof(from);
+        size = recvfrom(node->fd, message, sizeof(message), 0,
+                                            (struct sockaddr *)&from, &len);
+        if (-1 == size)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            break;
+        }
+
+        node->stats.bytes_received += (unsigned long)size;
+        if (sizeof(from) != len ||
+            0 != Unpack(node, message, (size_t)size, &from, now_ms))
+        {
+            ++node->stats.dropped;
+            continue;
+        }
+        ++received;
+    }
+    node->stats.messages_received += received;
+
+    return received;
+}
+
+static void ReapHooks(wd_gossip_ty *node)
+{
+    size_t i = 0;
+
+    for (i = 0; i < MAX_HOOKS; ++i)
+    {
+        if (0 != node->hooks[i] &&
+            0 != waitpid(node->hooks[i], NULL, WNOHANG))
+        {
+            node->hooks[i] = 0;
+        }
+    }
+}
+
+static void RunHook(wd_gossip_ty *node, const char *id, const char *addr)
+{
+    posix_spawnattr_t attr;
+    sigset_t mask;
+    char *argv[4];
+    pid_t pid = 0;
+    size_t i = 0;
+
+    for (i = 0; i < MAX_HOOKS && 0 != node->hooks[i]; ++i)
+    {
+    }
+    if (MAX_HOOKS == i)
+    {
+        return;
+    }
+
+    argv[0] = node->hook;
+    argv[1] = (char *)id;
+    argv[2] = (char *)addr;
+    argv[3] = NULL;
+
+    /* the hook does not inherit the mask of the gossip thread */
+    sigemptyset(&mask);
+    if (0 != posix_spawnattr_init(&attr))
+    {
+        return;
+    }
+    if (0 == posix_spawnattr_setsigmask(&attr, &mask) &&
+        0 == posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK) &&
+        0 == posix_spawnp(&pid, node->hook, NULL, &attr, argv, environ))
+    {
+        node->hooks[i] = pid;
+    }
+    posix_spawnattr_destroy(&attr);
+}
+
+static void Report(wd_gossip_ty *node, const member_ty *member)
+{
+    char addr[GOSSIP_ADDR_SIZE];
+    char id[ID_SIZE];
+
+    FormatAddr(&member->addr, addr);
+    sprintf(id, "%u", member->id);
+
+    if (NULL != node->on_failed)
+    {
+        node->on_failed(node->param, member->id, addr);
+    }
+    if ('\0' != node->hook[0])
+    {
+        RunHook(node, id, addr);
+    }
+}
+
+size_t GossipCheck(wd_gossip_ty *node, unsigned long now_ms)
+{
+    member_ty *member = NULL;
+    unsigned long age = 0;
+    size_t failed = 0;
+    size_t i = 0;
+
+    assert(NULL != node);
+
+    ReapHooks(node);
+
+    for (i = 0; i < node->n_members; )
+    {
+        member = &node->members[i];
+        age = (now_ms > member->updated_ms) ? now_ms - member->updated_ms : 0;
+
+        if (MEMBER_FAILED == member->state && age > node->fail_ms * 2)
+        {
+            memmove(member, member + 1,
+                            (node->n_members - i - 1) * sizeof(*member));
+            --node->n_members;
+            node->cursor = (node->cursor >= node->n_members) ? 0 :
+                                                                node->cursor;
+            continue;
+        }
+
+        if (MEMBER_ALIVE == member->state && age > node->fail_ms)
+        {
+            member->state = MEMBER_FAILED;
+            ++failed;
+            Report(node, member);
+        }
+        ++i;
+    }
+    node->stats.failures += failed;
+
+    return failed;
+}
+
+size_t GossipAlive(const wd_gossip_ty *node)
+{
+    size_t alive = 0;
+    size_t i = 0;
+
+    assert(NULL != node);
+
+    for (i = 0; i < node->n_members; ++i)
+    {
+        alive += (MEMBER_ALIVE == node->members[i].state);
+    }
+
+    return alive;
+}
+
+int GossipIsAlive(const wd_gossip_ty *node, unsigned int node_id)
+{
+    int is_found = 0;
+    size_t at = 0;
+
+    assert(NULL != node);
+
+    at = Find(node, node_id, &is_found);
+
+    return (is_found && MEMBER_ALIVE == node->members[at].state);
+}
+
+void GossipGetStats(const wd_gossip_ty *node, gossip_stats_ty *stats)
+{
+    assert(NULL != node);
+    assert(NULL != stats);
+
+    *stats = node->stats;
+}
+
+unsigned long GossipNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (unsigned long)ts.tv_sec * 1000 +
+           (unsigned long)ts.tv_nsec / 1000000;
+}
+
+static void CloseWake(wd_gossip_ty *node)
+{
+    close(node->wake[0]);
+    close(node->wake[1]);
+}
+
+/* rounds on time and digests as they arrive, until a byte on the pipe */
+static void *GossipRoutine(void *arg)
+{
+    wd_gossip_ty *node = (wd_gossip_ty *)arg;
+    struct pollfd fds[2];
+    unsigned long next_ms = GossipNow();
+    unsigned long now_ms = 0;
+    char byte = 0;
+
+    fds[0].fd = node->fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = node->wake[0];
+    fds[1].events = POLLIN;
+
+    while (1 != read(node->wake[0], &byte, 1))
+    {
+        now_ms = GossipNow();
+        if (now_ms >= next_ms)
+        {
+            GossipRound(node);
+            GossipCheck(node, now_ms);
+
+            /* a late round does not make up for the ones it missed */
+            next_ms += node->interval_ms;
+            next_ms = (next_ms <= now_ms) ? now_ms + node->interval_ms :
+                                                                    next_ms;
+        }
+
+        if (0 < poll(fds, 2, (int)(next_ms - now_ms)) &&
+            0 != (fds[0].revents & POLLIN))
+        {
+            GossipReceive(node, GossipNow());
+        }
+    }
+
+    return NULL;
+}
+
+wd_gossip_ty *WDGossipStart(const wd_gossip_config_ty *config)
+{
+    wd_gossip_ty *node = NULL;
+    sigset_t caller_mask;
+    sigset_t mask;
+    int status = 0;
+
+    node = GossipCreate(config);
+    if (NULL == node)
+    {
+        return NULL;
+    }
+
+    if (0 != pipe(node->wake))
+    {
+        GossipDestroy(node);
+        return NULL;
+    }
+    if (0 != SetFdFlags(node->wake[0]) || 0 != SetFdFlags(node->wake[1]))
+    {
+        CloseWake(node);
+        GossipDestroy(node);
+        return NULL;
+    }
+
+    /* the thread inherits a mask with every signal blocked */
+    sigfillset(&mask);
+    pthread_sigmask(SIG_SETMASK, &mask, &caller_mask);
+    status = pthread_create(&node->thread, NULL, GossipRoutine, node);
+    pthread_sigmask(SIG_SETMASK, &caller_mask, NULL);
+
+    if (0 != status)
+    {
+        CloseWake(node);
+        GossipDestroy(node);
+        return NULL;
+    }
+
+    return node;
+}
+
+int WDGossipStop(wd_gossip_ty *gossip)
+{
+    int status = 0;
+
+    if (NULL == gossip)
+    {
+        return 1;
+    }
+
+    if (1 != write(gossip->wake[1], "", 1))
+    {
+        return 1;
+    }
+    status = pthread_join(gossip->thread, NULL);
+
+    CloseWake(gossip);
+    GossipDestroy(gossip);
+
+    return status;
+}
@@ -0,0 +1,637 @@
+/*******************************************************************************
+ * Project:     Watchdog - supervision groups
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#define _GNU_SOURCE  /* pthread_mutex_consistent, setenv */
+
+#include <stdio.h>      /* snprintf, sscanf */
+#include <stdlib.h>     /* setenv, getenv, calloc */
+#include <string.h>     /* strcmp, strncmp  */
+#include <errno.h>      /* errno            */
+#include <unistd.h>     /* ftruncate, close */
+#include <fcntl.h>      /* O_RDWR, O_CREAT  */
+#include <signal.h>     /* kill             */
+#include <pthread.h>    /* pthread_mutex_t  */
+#include <time.h>       /* nanosleep        */
+#include <assert.h>     /* assert           */
+#include <sys/mman.h>   /* shm_open, mmap   */
+#include <sys/stat.h>   /* fstat            */
+
+#include "wd_group.h"
+#include "wd_restart.h"
+
+#define GROUP_MAGIC 0x57444750UL     /* "WDGP" */
+#define GROUP_REMOVED 0x57444758UL   /* "WDGX", the last member left */
+
+enum {GROUP_VERSION = 1, SHM_NAME_SIZE = 128, POLICY_STR_SIZE = 160,
+      OPEN_RETRIES = 100, OPEN_RETRY_MS = 10};
+
+typedef enum group_phase
+{
+    PHASE_IDLE = 0,
+    PHASE_PENDING = 1,
+    PHASE_STOPPED = 2,
+    PHASE_STARTED = 3
+}group_phase_ty;
+
+/* a member of the group or of a group below it, "member" is "" if free */
+typedef struct group_slot
+{
+    char member[GROUP_MEMBER_SIZE];
+    char leaf[GROUP_NAME_SIZE];         /* the member's own group         */
+    unsigned long rank;
+    pid_t wd_pid;
+    int phase;
+    unsigned long generation;           /* of the restart it is part of   */
+    unsigned long started_us;
+}group_slot_ty;
+
+/* the restart state counts the restarts the group decided, the breaker
+   opens at "max_restarts" and the next failure goes to the group above     */
+typedef struct group_page
+{
+    unsigned long magic;
+    unsigned long version;
+    pthread_mutex_t lock;
+    int strategy;
+    int strategy_set;
+    wd_restart_policy_ty policy;
+    restart_state_ty restart;
+    unsigned long generation;
+    group_slot_ty slots[GROUP_MAX_MEMBERS];
+}group_page_ty;
+
+/* pages[0] is the member's own group, pages[depth - 1] the topmost one */
+struct group
+{
+    size_t depth;
+    size_t active;
+    group_page_ty *pages[GROUP_MAX_DEPTH];
+    group_slot_ty *slots[GROUP_MAX_DEPTH];
+    char names[GROUP_MAX_DEPTH][GROUP_NAME_SIZE];
+};
+
+static int IsValidName(const char *name);
+static group_page_ty *OpenPage(const char *name);
+static group_page_ty *MapPage(int fd, int created);
+static void InitPage(group_page_ty *page);
+static void Lock(group_page_ty *page);
+static void Unlock(group_page_ty *page);
+static void SetLimits(group_page_ty *page, size_t max_restarts, size_t window);
+static group_slot_ty *TakeSlot(group_page_ty *page, const char *member);
+static void MarkRestart(group_ty *group, size_t level);
+static int IsInGroup(const char *leaf, const char *name);
+static int IsBlocked(const group_page_ty *page, const group_slot_ty *slot);
+static int IsAlive(pid_t pid);
+static void SleepMs(long ms);
+
+int GroupPolicyExport(const wd_group_policy_ty *policy)
+{
+    char value[POLICY_STR_SIZE];
+
+    assert(NULL != policy);
+
+    if (NULL == policy->name || !IsValidName(policy->name) ||
+        WD_REST_FOR_ONE < policy->strategy)
+    {
+        return 1;
+    }
+
+    sprintf(value, "%s,%d,%lu,%lu,%lu", policy->name, (int)policy->strategy,
+            (unsigned long)policy->rank, (unsigned long)policy->max_restarts,
+            (unsigned long)policy->window);
+
+    return (0 != setenv(GROUP_POLICY_ENV, value, 1));
+}
+
+int GroupPolicyImport(wd_group_policy_ty *policy, char name[GROUP_NAME_SIZE])
+{
+    unsigned long fields[4];
+    int strategy = 0;
+    const char *value = getenv(GROUP_POLICY_ENV);
+
+    assert(NULL != policy);
+    assert(NULL != name);
+
+    if (NULL == value || 5 != sscanf(value, "%63[^,],%d,%lu,%lu,%lu", name,
+                                     &strategy, &fields[0], &fields[1],
+                                     &fields[2]) ||
+        !IsValidName(name) || 0 > strategy || WD_REST_FOR_ONE < strategy)
+    {
+        return 1;
+    }
+
+    policy->name = name;
+    policy->strategy = (wd_group_strategy_ty)strategy;
+    policy->rank = fields[0];
+    policy->max_restarts = fields[1];
+    policy->window = fields[2];
+
+    return 0;
+}
+
+group_ty *GroupJoin(const wd_group_policy_ty *policy, const char *member,
+                    pid_t wd_pid)
+{
+    group_ty *group = NULL;
+    char *dot = NULL;
+    size_t level = 0;
+
+    assert(NULL != policy);
+    assert(NULL != member);
+
+    if (NULL == policy->name || !IsValidName(policy->name) ||
+        '\0' == member[0] || GROUP_MEMBER_SIZE <= strlen(member))
+    {
+        return NULL;
+    }
+
+    group = (group_ty *)calloc(1, sizeof(group_ty));
+    if (NULL == group)
+    {
+        return NULL;
+    }
+
+    /* "a.b.c", then "a.b", then "a" */
+    strcpy(group->names[0], policy->name);
+    for (level = 1; NULL != (dot = strrchr(group->names[level - 1], '.'));
+                                                                    ++level)
+    {
+        strcpy(group->names[level], group->names[level - 1]);
+        group->names[level][dot - group->names[level - 1]] = '\0';
+    }
+
+    for (level = 0; level < GROUP_MAX_DEPTH && '\0' != group->names[level][0];
+                                                                    ++level)
+    {
+        group->pages[level] = OpenPage(group->names[level]);
+        if (NULL == group->pages[level])
+        {
+            GroupLeave(group);
+            return NULL;
+        }
+        group->depth = level + 1;
+
+        Lock(group->pages[level]);
+        group->slots[level] = TakeSlot(group->pages[level], member);
+        if (NULL != group->slots[level])
+        {
+            strcpy(group->slots[level]->leaf, policy->name);
+            group->slots[level]->rank = policy->rank;
+            group->slots[level]->wd_pid = wd_pid;
+        }
+
+        /* the members of a group set its strategy, not those below it */
+        if (0 == level)
+        {
+            group->pages[level]->strategy = (int)policy->strategy;
+            group->pages[level]->strategy_set = 1;
+            SetLimits(group->pages[level], policy->max_restarts,
+                                                            policy->window);
+        }
+        Unlock(group->pages[level]);
+
+        if (NULL == group->slots[level])
+        {
+            GroupLeave(group);
+            return NULL;
+        }
+    }
+
+    return group;
+}
+
+void GroupLeave(group_ty *group)
+{
+    group_page_ty *page = NULL;
+    size_t level = 0;
+    size_t used = 0;
+    size_t i = 0;
+
+    if (NULL == group)
+    {
+        return;
+    }
+
+    for (level = 0; level < group->depth; ++level)
+    {
+        page = group->pages[level];
+
+        Lock(page);
+        if (NULL != group->slots[level])
+        {
+            memset(group->slots[level], 0, sizeof(group_slot_ty));
+        }
+        for (i = 0, used = 0; i < GROUP_MAX_MEMBERS; ++i)
+        {
+            used += ('\0' != page->slots[i].member[0]);
+        }
+        /* a member joining now opens the page again */
+        if (0 == used)
+        {
+            __atomic_store_n(&page->magic, GROUP_REMOVED, __ATOMIC_RELEASE);
+            GroupUnlink(group->names[level]);
+        }
+        Unlock(page);
+
+        munmap(page, sizeof(group_page_ty));
+    }
+
+    free(group);
+}
+
+int GroupFailed(group_ty *group, time_t now)
+{
+    group_page_ty *page = NULL;
+    size_t level = 0;
+    size_t below = 0;
+    int allowed = 0;
+
+    assert(NULL != group);
+
+    for (level = 0; level < group->depth; ++level)
+    {
+        page = group->pages[level];
+
+        Lock(page);
+        allowed = RestartIsAllowed(&page->policy, &page->restart, now);
+        if (allowed)
+        {
+            RestartRecord(&page->policy, &page->restart, now);
+            MarkRestart(group, level);
+        }
+        Unlock(page);
+
+        if (allowed)
+        {
+            /* the groups below restart as a whole, they start afresh */
+            for (below = 0; below < level; ++below)
+            {
+                Lock(group->pages[below]);
+                RestartStateInit(&group->pages[below]->restart);
+                Unlock(group->pages[below]);
+            }
+            group->active = level;
+
+            return (int)level;
+        }
+    }
+
+    return -1;
+}
+
+group_action_ty GroupNext(group_ty *group, unsigned long last_beat_us)
+{
+    group_slot_ty *slot = NULL;
+    size_t counts[PHASE_STARTED + 1] = {0, 0, 0, 0};
+    size_t level = 0;
+    int blocked = 0;
+
+    assert(NULL != group);
+
+    for (level = 0; level < group->depth; ++level)
+    {
+        slot = group->slots[level];
+
+        Lock(group->pages[level]);
+        if (PHASE_STARTED == slot->phase && last_beat_us > slot->started_us)
+        {
+            slot->phase = PHASE_IDLE;
+        }
+        if (PHASE_STOPPED == slot->phase &&
+            IsBlocked(group->pages[level], slot))
+        {
+            blocked = 1;
+        }
+        if (PHASE_IDLE != slot->phase && 0 == counts[PHASE_PENDING] +
+                            counts[PHASE_STOPPED] + counts[PHASE_STARTED])
+        {
+            group->active = level;
+        }
+        ++counts[slot->phase];
+        Unlock(group->pages[level]);
+    }
+
+    if (0 != counts[PHASE_PENDING])
+    {
+        return GROUP_STOP;
+    }
+    if (0 != counts[PHASE_STOPPED])
+    {
+        return blocked ? GROUP_WAIT : GROUP_START;
+    }
+
+    return (0 != counts[PHASE_STARTED]) ? GROUP_STARTED : GROUP_IDLE;
+}
+
+void GroupDone(group_ty *group, group_action_ty action, unsigned long now_us)
+{
+    group_slot_ty *slot = NULL;
+    size_t level = 0;
+
+    assert(NULL != group);
+    assert(GROUP_STOP == action || GROUP_START == action);
+
+    for (level = 0; level < group->depth; ++level)
+    {
+        slot = group->slots[level];
+
+        Lock(group->pages[level]);
+        if (GROUP_STOP == action && PHASE_PENDING == slot->phase)
+        {
+            slot->phase = PHASE_STOPPED;
+        }
+        else if (GROUP_START == action && PHASE_STOPPED == slot->phase)
+        {
+            slot->phase = PHASE_STARTED;
+            slot->started_us = now_us;
+        }
+        Unlock(group->pages[level]);
+    }
+}
+
+const char *GroupActiveName(const group_ty *group)
+{
+    assert(NULL != group);
+
+    return group->names[group->active];
+}
+
+void GroupUnlink(const char *name)
+{
+    char shm_name[SHM_NAME_SIZE];
+
+    assert(NULL != name);
+
+    snprintf(shm_name, sizeof(shm_name), "%s%s", GROUP_PREFIX, name);
+    shm_unlink(shm_name);
+}
+
+/* up to GROUP_MAX_DEPTH levels of non empty names, no '/' nor ',' */
+static int IsValidName(const char *name)
+{
+    size_t levels = 1;
+    size_t len = strlen(name);
+    size_t i = 0;
+
+    if (0 == len || GROUP_NAME_SIZE <= len || '.' == name[0] ||
+        '.' == name[len - 1] || NULL != strstr(name, "..") ||
+        NULL != strpbrk(name, "/,"))
+    {
+        return 0;
+    }
+
+    for (i = 0; i < len; ++i)
+    {
+        levels += ('.' == name[i]);
+    }
+
+    return (GROUP_MAX_DEPTH >= levels);
+}
+
+/* the first member creates and initializes the page, the others wait for it */
+static group_page_ty *OpenPage(const char *name)
+{
+    char shm_name[SHM_NAME_SIZE];
+    group_page_ty *page = NULL;
+    size_t retry = 0;
+    int fd = -1;
+
+    snprintf(shm_name, sizeof(shm_name), "%s%s", GROUP_PREFIX, name);
+
+    for (retry = 0; retry < OPEN_RETRIES; ++retry)
+    {
+        fd = shm_open(shm_name, O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (-1 != fd)
+        {
+            return MapPage(fd, 1);
+        }
+
+        fd = shm_open(shm_name, O_RDWR, 0644);
+        if (-1 == fd)
+        {
+            if (ENOENT != errno)
+            {
+                return NULL;
+            }
+            continue;
+        }
+
+        page = MapPage(fd, 0);
+        if (NULL != page)
+        {
+            switch (__atomic_load_n(&page->magic, __ATOMIC_ACQUIRE))
+            {
+                case GROUP_MAGIC:
+                    if (GROUP_VERSION == page->version)
+                    {
+                        return page;
+                    }
+                    munmap(page, sizeof(group_page_ty));
+                    return NULL;
+
+                case GROUP_REMOVED:
+                    /* unlinked by the last member, not yet gone */
+                    break;
+            }
+            munmap(page, sizeof(group_page_ty));
+        }
+
+        SleepMs(OPEN_RETRY_MS);
+    }
+
+    return NULL;
+}
+
+/* returns NULL while the creator has not sized the page yet */
+static group_page_ty *MapPage(int fd, int created)
+{
+    group_page_ty *page = NULL;
+    struct stat st;
+
+    if ((created && 0 != ftruncate(fd, sizeof(group_page_ty))) ||
+        0 != fstat(fd, &st) || (size_t)st.st_size < sizeof(group_page_ty))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    page = (group_page_ty *)mmap(NULL, sizeof(group_page_ty),
+                                 PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == (void *)page)
+    {
+        return NULL;
+    }
+
+    if (created)
+    {
+        InitPage(page);
+    }
+
+    return page;
+}
+
+static void InitPage(group_page_ty *page)
+{
+    pthread_mutexattr_t attr;
+    wd_restart_policy_ty defaults;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&page->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    /* a group with subgroups only, until a member of its own sets it */
+    RestartPolicyDefault(&defaults);
+    page->strategy = WD_ONE_FOR_ONE;
+    SetLimits(page, defaults.max_restarts, defaults.window);
+    RestartStateInit(&page->restart);
+
+    page->version = GROUP_VERSION;
+    __atomic_store_n(&page->magic, GROUP_MAGIC, __ATOMIC_RELEASE);
+}
+
+/* a member that died holding the lock left the page as it was */
+static void Lock(group_page_ty *page)
+{
+    if (EOWNERDEAD == pthread_mutex_lock(&page->lock))
+    {
+        pthread_mutex_consistent(&page->lock);
+    }
+}
+
+static void Unlock(group_page_ty *page)
+{
+    pthread_mutex_unlock(&page->lock);
+}
+
+/* no backoff between the restarts of a group, a breaker only */
+static void SetLimits(group_page_ty *page, size_t max_restarts, size_t window)
+{
+    page->policy.base_delay = 0;
+    page->policy.max_delay = 0;
+    page->policy.jitter_pct = 0;
+    page->policy.max_restarts = max_restarts;
+    page->policy.window = window;
+    page->policy.healthy_time = window;
+}
+
+/* the member's slot, or a free one, or one of a member whose wd_app is gone */
+static group_slot_ty *TakeSlot(group_page_ty *page, const char *member)
+{
+    group_slot_ty *free_slot = NULL;
+    size_t i = 0;
+
+    for (i = 0; i < GROUP_MAX_MEMBERS; ++i)
+    {
+        if (0 == strcmp(page->slots[i].member, member))
+        {
+            return &page->slots[i];
+        }
+
+        if (NULL == free_slot && ('\0' == page->slots[i].member[0] ||
+                                  !IsAlive(page->slots[i].wd_pid)))
+        {
+            free_slot = &page->slots[i];
+        }
+    }
+
+    if (NULL != free_slot)
+    {
+        memset(free_slot, 0, sizeof(*free_slot));
+        strcpy(free_slot->member, member);
+    }
+
+    return free_slot;
+}
+
+/* the members of page "level" the strategy names for the failure of the
+   member (level 0) or of the whole group below (from level 1 on)           */
+static void MarkRestart(group_ty *group, size_t level)
+{
+    group_page_ty *page = group->pages[level];
+    group_slot_ty *slot = NULL;
+    unsigned long failed_rank = (unsigned long)-1;
+    int failed = 0;
+    size_t i = 0;
+
+    for (i = 0; i < GROUP_MAX_MEMBERS; ++i)
+    {
+        slot = &page->slots[i];
+        failed = (0 == level) ? (slot == group->slots[0]) :
+                    ('\0' != slot->member[0] &&
+                     IsInGroup(slot->leaf, group->names[level - 1]));
+        if (failed && slot->rank < failed_rank)
+        {
+            failed_rank = slot->rank;
+        }
+    }
+
+    ++page->generation;
+
+    for (i = 0; i < GROUP_MAX_MEMBERS; ++i)
+    {
+        slot = &page->slots[i];
+        if ('\0' == slot->member[0])
+        {
+            continue;
+        }
+
+        failed = (0 == level) ? (slot == group->slots[0]) :
+                    IsInGroup(slot->leaf, group->names[level - 1]);
+
+        if (failed || WD_ONE_FOR_ALL == page->strategy ||
+            (WD_REST_FOR_ONE == page->strategy && slot->rank > failed_rank))
+        {
+            slot->phase = PHASE_PENDING;
+            slot->generation = page->generation;
+        }
+    }
+}
+
+/* "name" itself or a group below it */
+static int IsInGroup(const char *leaf, const char *name)
+{
+    size_t len = strlen(name);
+
+    return (0 == strncmp(leaf, name, len) &&
+                                ('\0' == leaf[len] || '.' == leaf[len]));
+}
+
+/* a member of a lower rank restarted along with it is not up yet */
+static int IsBlocked(const group_page_ty *page, const group_slot_ty *slot)
+{
+    const group_slot_ty *other = NULL;
+    size_t i = 0;
+
+    for (i = 0; i < GROUP_MAX_MEMBERS; ++i)
+    {
+        other = &page->slots[i];
+        if ('\0' != other->member[0] && PHASE_IDLE != other->phase &&
+            other->generation == slot->generation &&
+            other->rank < slot->rank && IsAlive(other->wd_pid))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int IsAlive(pid_t pid)
+{
+    return (0 != pid && (0 == kill(pid, 0) || EPERM == errno));
+}
+
+static void SleepMs(long ms)
+{
+    struct timespec ts;
+
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (ms % 1000) * 1000000;
+
+    nanosleep(&ts, NULL);
+}
@@ -0,0 +1,186 @@
+/*******************************************************************************
+ * Project:     Watchdog - descriptors kept across restarts
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#define _GNU_SOURCE  /* F_DUPFD_CLOEXEC */
+
+#include <stdio.h>      /* sprintf          */
+#include <stdlib.h>     /* getenv, strtol   */
+#include <string.h>     /* strlen, strcpy, strcspn */
+#include <unistd.h>     /* close            */
+#include <fcntl.h>      /* fcntl            */
+#include <pthread.h>    /* pthread_mutex_t  */
+#include <assert.h>     /* assert           */
+
+#include "watchdog.h"
+#include "wd_channel.h"
+#include "wd_keepfd.h"
+
+enum {MAX_KEPT = KEEPFD_MAX, ENTRY_STR_SIZE = CHANNEL_NAME_SIZE + 16};
+
+typedef struct kept_fd
+{
+    char name[CHANNEL_NAME_SIZE];
+    int fd;
+}kept_fd_ty;
+
+static kept_fd_ty g_kept[MAX_KEPT];
+static size_t g_kept_cnt = 0;
+static pthread_mutex_t g_kept_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int IsValidName(const char *name);
+
+int KeepFdStore(const char *name, int fd)
+{
+    size_t i = 0;
+    int status = 0;
+
+    assert(NULL != name);
+
+    if (!IsValidName(name))
+    {
+        return 1;
+    }
+
+    pthread_mutex_lock(&g_kept_lock);
+    for (i = 0; i < g_kept_cnt && 0 != strcmp(g_kept[i].name, name); ++i)
+    {
+        /* empty */
+    }
+
+    if (i < g_kept_cnt)
+    {
+        close(g_kept[i].fd);
+        g_kept[i].fd = fd;
+    }
+    else if (MAX_KEPT > g_kept_cnt)
+    {
+        strcpy(g_kept[g_kept_cnt].name, name);
+        g_kept[g_kept_cnt].fd = fd;
+        ++g_kept_cnt;
+    }
+    else
+    {
+        status = 1;
+    }
+    pthread_mutex_unlock(&g_kept_lock);
+
+    return status;
+}
+
+int KeepFdSendAll(int channel)
+{
+    channel_msg_ty msg;
+    size_t i = 0;
+    int status = 0;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.type = CHANNEL_KEEP_FD;
+
+    pthread_mutex_lock(&g_kept_lock);
+    for (i = 0; i < g_kept_cnt; ++i)
+    {
+        strcpy(msg.name, g_kept[i].name);
+        status |= ChannelSend(channel, &msg, g_kept[i].fd);
+    }
+    pthread_mutex_unlock(&g_kept_lock);
+
+    return status;
+}
+
+int KeepFdExport(spawn_ty *spawn)
+{
+    char value[MAX_KEPT * ENTRY_STR_SIZE + 1];
+    size_t len = 0;
+    size_t i = 0;
+
+    assert(NULL != spawn);
+
+    value[0] = '\0';
+
+    pthread_mutex_lock(&g_kept_lock);
+    for (i = 0; i < g_kept_cnt; ++i)
+    {
+        len += sprintf(value + len, "%s=%d;", g_kept[i].name, g_kept[i].fd);
+    }
+    pthread_mutex_unlock(&g_kept_lock);
+
+    return SpawnSetEnv(spawn, KEEPFD_ENV, value);
+}
+
+size_t KeepFdInherit(int *fds)
+{
+    size_t i = 0;
+
+    assert(NULL != fds);
+
+    pthread_mutex_lock(&g_kept_lock);
+    for (i = 0; i < g_kept_cnt; ++i)
+    {
+        fds[i] = g_kept[i].fd;
+    }
+    pthread_mutex_unlock(&g_kept_lock);
+
+    return i;
+}
+
+void KeepFdImport(void)
+{
+    char name[CHANNEL_NAME_SIZE];
+    const char *entry = getenv(KEEPFD_ENV);
+    size_t name_len = 0;
+    int dup_fd = -1;
+
+    while (NULL != entry && '\0' != *entry)
+    {
+        name_len = strcspn(entry, "=");
+        if ('=' != entry[name_len] || CHANNEL_NAME_SIZE <= name_len)
+        {
+            return;
+        }
+
+        memcpy(name, entry, name_len);
+        name[name_len] = '\0';
+
+        dup_fd = fcntl((int)strtol(entry + name_len + 1, NULL, 10),
+                       F_DUPFD_CLOEXEC, 0);
+        if (-1 != dup_fd && 0 != KeepFdStore(name, dup_fd))
+        {
+            close(dup_fd);
+        }
+
+        entry = strchr(entry, ';');
+        entry = (NULL == entry) ? NULL : entry + 1;
+    }
+}
+
+int WDGetKeptFd(const char *name)
+{
+    const char *entry = getenv(KEEPFD_ENV);
+    size_t name_len = 0;
+
+    assert(NULL != name);
+
+    name_len = strlen(name);
+
+    while (NULL != entry && '\0' != *entry)
+    {
+        if (0 == strncmp(entry, name, name_len) && '=' == entry[name_len])
+        {
+            return (int)strtol(entry + name_len + 1, NULL, 10);
+        }
+
+        entry = strchr(entry, ';');
+        entry = (NULL == entry) ? NULL : entry + 1;
+    }
+
+    return -1;
+}
+
+static int IsValidName(const char *name)
+{
+    size_t len = strlen(name);
+
+    return (0 != len && CHANNEL_NAME_SIZE > len && len == strcspn(name, "=;"));
+}
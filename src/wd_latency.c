@@ -0,0 +1,377 @@
+/*******************************************************************************
+ * Project:     Watchdog - request latency SLO
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#define _GNU_SOURCE  /* setenv */
+
+#include <stdio.h>      /* sprintf, sscanf  */
+#include <stdlib.h>     /* setenv, getenv   */
+#include <string.h>     /* memset, memcpy   */
+#include <unistd.h>     /* ftruncate, close */
+#include <fcntl.h>      /* O_RDWR, O_CREAT  */
+#include <assert.h>     /* assert           */
+#include <pthread.h>    /* pthread_key_create */
+#include <sys/mman.h>   /* shm_open, mmap   */
+#include <sys/stat.h>   /* fstat            */
+
+#include "wd_latency.h"
+
+#define LATENCY_MAGIC 0x57444C54UL   /* "WDLT" */
+
+enum {POLICY_STR_SIZE = 96, POLICY_FIELDS = 4, SHM_NAME_SIZE = 256,
+      MAX_SHIFT = 41};
+
+static latency_page_ty *g_page = NULL;
+static unsigned long g_next_owner = 0;
+
+/* frees the slot of a thread that exits */
+static pthread_once_t g_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_slot_key;
+static int g_is_key = 0;
+
+/* the slot of the calling thread, claimed on its first record */
+static __thread latency_slot_ty *t_slot = NULL;
+
+static void ShmName(char *shm_name, const char *name, pid_t pid);
+static latency_slot_ty *ClaimSlot(latency_page_ty *page);
+static void CreateSlotKey(void);
+static void ReleaseSlot(void *slot);
+
+int LatencyPolicyExport(const wd_latency_policy_ty *policy)
+{
+    char value[POLICY_STR_SIZE];
+
+    assert(NULL != policy);
+
+    sprintf(value, "%lu,%lu,%lu,%lu", policy->slo_ns,
+            (unsigned long)policy->percentile, (unsigned long)policy->window,
+            (unsigned long)policy->min_count);
+
+    return (0 != setenv(LATENCY_POLICY_ENV, value, 1));
+}
+
+void LatencyPolicyImport(wd_latency_policy_ty *policy)
+{
+    unsigned long fields[POLICY_FIELDS] = {0, 0, 0, 0};
+    const char *value = getenv(LATENCY_POLICY_ENV);
+
+    assert(NULL != policy);
+
+    if (NULL == value || POLICY_FIELDS != sscanf(value, "%lu,%lu,%lu,%lu",
+                            &fields[0], &fields[1], &fields[2], &fields[3]) ||
+        0 == fields[1] || 100 <= fields[1])
+    {
+        fields[0] = fields[1] = fields[2] = fields[3] = 0;
+    }
+
+    policy->slo_ns = fields[0];
+    policy->percentile = fields[1];
+    policy->window = fields[2];
+    policy->min_count = fields[3];
+}
+
+int LatencyCreate(const char *name)
+{
+    char shm_name[SHM_NAME_SIZE];
+    latency_page_ty *page = NULL;
+    int fd = -1;
+
+    assert(NULL != name);
+
+    if (NULL != g_page)
+    {
+        return 0;
+    }
+
+    ShmName(shm_name, name, getpid());
+
+    fd = shm_open(shm_name, O_RDWR | O_CREAT, 0644);
+    if (-1 == fd)
+    {
+        return 1;
+    }
+
+    if (0 != ftruncate(fd, sizeof(latency_page_ty)))
+    {
+        close(fd);
+        return 1;
+    }
+
+    page = (latency_page_ty *)mmap(NULL, sizeof(latency_page_ty),
+                                   PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == (void *)page)
+    {
+        return 1;
+    }
+
+    memset(page, 0, sizeof(*page));
+    page->version = LATENCY_VERSION;
+    __atomic_store_n(&page->magic, LATENCY_MAGIC, __ATOMIC_RELEASE);
+
+    __atomic_store_n(&g_page, page, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+void LatencyUnlink(const char *name, pid_t pid)
+{
+    char shm_name[SHM_NAME_SIZE];
+
+    assert(NULL != name);
+
+    ShmName(shm_name, name, pid);
+    shm_unlink(shm_name);
+}
+
+void WDRecordLatency(unsigned long ns)
+{
+    latency_slot_ty *slot = t_slot;
+    latency_page_ty *page = NULL;
+    size_t bucket = LatencyBucket(ns);
+
+    if (NULL == slot)
+    {
+        page = __atomic_load_n(&g_page, __ATOMIC_ACQUIRE);
+        if (NULL == page)
+        {
+            return;
+        }
+        slot = t_slot = ClaimSlot(page);
+    }
+
+    /* the shared overflow slot needs an atomic add, an owned one does not */
+    if (&g_page->slots[LATENCY_SLOTS - 1] == slot)
+    {
+        __atomic_fetch_add(&slot->hist[bucket], 1, __ATOMIC_RELAXED);
+    }
+    else
+    {
+        __atomic_store_n(&slot->hist[bucket], slot->hist[bucket] + 1,
+                         __ATOMIC_RELAXED);
+    }
+}
+
+void LatencyInit(latency_ty *latency)
+{
+    assert(NULL != latency);
+
+    latency->pid = 0;
+    latency->page = NULL;
+    latency->first = 0;
+    latency->cnt = 0;
+    latency->last_pct_ns = 0;
+    latency->last_count = 0;
+}
+
+int LatencyAttach(latency_ty *latency, const char *name, pid_t pid)
+{
+    char shm_name[SHM_NAME_SIZE];
+    latency_page_ty *page = NULL;
+    struct stat st;
+    int fd = -1;
+
+    assert(NULL != latency);
+    assert(NULL != name);
+
+    LatencyDetach(latency);
+
+    ShmName(shm_name, name, pid);
+
+    fd = shm_open(shm_name, O_RDONLY, 0);
+    if (-1 == fd)
+    {
+        return 1;
+    }
+
+    if (0 != fstat(fd, &st) || (size_t)st.st_size < sizeof(latency_page_ty))
+    {
+        close(fd);
+        return 1;
+    }
+
+    page = (latency_page_ty *)mmap(NULL, sizeof(latency_page_ty), PROT_READ,
+                                   MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == (void *)page)
+    {
+        return 1;
+    }
+
+    if (LATENCY_MAGIC != __atomic_load_n(&page->magic, __ATOMIC_ACQUIRE) ||
+        LATENCY_VERSION != page->version)
+    {
+        munmap(page, sizeof(latency_page_ty));
+        return 1;
+    }
+
+    latency->pid = pid;
+    latency->page = page;
+
+    return 0;
+}
+
+void LatencyDetach(latency_ty *latency)
+{
+    assert(NULL != latency);
+
+    if (NULL != latency->page)
+    {
+        munmap(latency->page, sizeof(latency_page_ty));
+    }
+
+    LatencyInit(latency);
+}
+
+int LatencyEvaluate(latency_ty *latency, const wd_latency_policy_ty *policy,
+                    size_t window_len)
+{
+    unsigned long *now_snap = NULL;
+    const unsigned long *old_snap = NULL;
+    unsigned long window[LATENCY_BUCKETS];
+    unsigned long total = 0;
+    unsigned long seen = 0;
+    size_t last = 0;
+    size_t i = 0;
+    size_t j = 0;
+
+    assert(NULL != latency);
+    assert(NULL != policy);
+
+    if (NULL == latency->page)
+    {
+        return 0;
+    }
+
+    window_len = (0 == window_len) ? 1 : window_len;
+    window_len = (LATENCY_WINDOW - 1 < window_len) ? LATENCY_WINDOW - 1 : window_len;
+
+    /* drop the snapshots that left the window, keep one to diff against */
+    while (latency->cnt > window_len)
+    {
+        latency->first = (latency->first + 1) % LATENCY_WINDOW;
+        --latency->cnt;
+    }
+
+    last = (latency->first + latency->cnt) % LATENCY_WINDOW;
+    now_snap = latency->snaps[last];
+    memset(now_snap, 0, sizeof(latency->snaps[0]));
+
+    /* a free slot keeps the counts of the thread that left it */
+    for (i = 0; i < LATENCY_SLOTS; ++i)
+    {
+        for (j = 0; j < LATENCY_BUCKETS; ++j)
+        {
+            now_snap[j] += __atomic_load_n(&latency->page->slots[i].hist[j],
+                                           __ATOMIC_RELAXED);
+        }
+    }
+
+    old_snap = (0 == latency->cnt) ? NULL : latency->snaps[latency->first];
+    ++latency->cnt;
+
+    for (j = 0; j < LATENCY_BUCKETS; ++j)
+    {
+        window[j] = now_snap[j] - ((NULL == old_snap) ? 0 : old_snap[j]);
+        total += window[j];
+    }
+
+    latency->last_count = total;
+    latency->last_pct_ns = 0;
+
+    if (0 == total)
+    {
+        return 0;
+    }
+
+    for (j = 0; j < LATENCY_BUCKETS - 1; ++j)
+    {
+        seen += window[j];
+        if (seen * 100 >= total * policy->percentile)
+        {
+            break;
+        }
+    }
+
+    latency->last_pct_ns = LatencyBucketUpperBound(j);
+
+    return (total >= policy->min_count && latency->last_pct_ns > policy->slo_ns);
+}
+
+static void ShmName(char *shm_name, const char *name, pid_t pid)
+{
+    snprintf(shm_name, SHM_NAME_SIZE, "%s%s.%d", LATENCY_PREFIX, name, (int)pid);
+}
+
+/* 0 - 3 are exact, then 4 linear sub-buckets per power of 2 */
+size_t LatencyBucket(unsigned long ns)
+{
+    size_t msb = 0;
+
+    if (4 > ns)
+    {
+        return (size_t)ns;
+    }
+
+    msb = (size_t)(63 - __builtin_clzl(ns));
+    if (MAX_SHIFT <= msb)
+    {
+        return LATENCY_BUCKETS - 1;
+    }
+
+    return (msb - 1) * 4 + ((ns >> (msb - 2)) & 3);
+}
+
+unsigned long LatencyBucketUpperBound(size_t bucket)
+{
+    size_t msb = bucket / 4 + 1;
+    unsigned long sub = bucket % 4;
+
+    assert(LATENCY_BUCKETS > bucket);
+
+    if (4 > bucket)
+    {
+        return (unsigned long)bucket;
+    }
+
+    return ((4 + sub + 1) << (msb - 2)) - 1;
+}
+
+static latency_slot_ty *ClaimSlot(latency_page_ty *page)
+{
+    unsigned long owner = __atomic_add_fetch(&g_next_owner, 1, __ATOMIC_RELAXED);
+    unsigned long expected = 0;
+    size_t i = 0;
+
+    for (i = 0; i < LATENCY_SLOTS - 1; ++i)
+    {
+        expected = 0;
+        if (__atomic_compare_exchange_n(&page->slots[i].owner, &expected, owner,
+                                0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+        {
+            pthread_once(&g_key_once, CreateSlotKey);
+            if (g_is_key)
+            {
+                pthread_setspecific(g_slot_key, &page->slots[i]);
+            }
+            return &page->slots[i];
+        }
+    }
+
+    /* every slot is owned, share the last one */
+    __atomic_store_n(&page->slots[LATENCY_SLOTS - 1].owner, 1, __ATOMIC_RELEASE);
+
+    return &page->slots[LATENCY_SLOTS - 1];
+}
+
+static void CreateSlotKey(void)
+{
+    g_is_key = (0 == pthread_key_create(&g_slot_key, ReleaseSlot));
+}
+
+/* the counts stay, the next owner adds to them - the release publishes them */
+static void ReleaseSlot(void *slot)
+{
+    __atomic_store_n(&((latency_slot_ty *)slot)->owner, 0, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,207 @@
+/*******************************************************************************
+ * Project:     Watchdog - binary event log
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#define _GNU_SOURCE  /* CLOCK_MONOTONIC */
+
+#include <stdio.h>      /* snprintf             */
+#include <string.h>     /* memcpy, strlen       */
+#include <errno.h>      /* errno                */
+#include <unistd.h>     /* ftruncate, getpid    */
+#include <fcntl.h>      /* O_RDWR, O_CREAT      */
+#include <time.h>       /* clock_gettime        */
+#include <sched.h>      /* sched_yield          */
+#include <assert.h>     /* assert               */
+#include <sys/mman.h>   /* shm_open, mmap       */
+#include <sys/stat.h>   /* fstat                */
+
+#include "wd_log.h"
+
+#define LOG_MAGIC 0x57444C47UL       /* "WDLG" */
+
+/* the side that formats the ring yields to the other after FORMAT_TRIES */
+enum {SHM_NAME_SIZE = 256, NSEC_PER_SEC = 1000000000, FORMAT_TRIES = 1000};
+
+/* mapped once and for good, a handler may log at any time */
+static log_ring_ty *volatile g_ring = NULL;
+static unsigned int g_pid = 0;
+
+static long NowNsec(clockid_t clock);
+static void Format(log_ring_ty *ring);
+
+int LogOpen(const char *name)
+{
+    char shm_name[SHM_NAME_SIZE];
+    log_ring_ty *ring = NULL;
+    struct stat st;
+    size_t tries = 0;
+    int fd = -1;
+
+    assert(NULL != name);
+
+    if (NULL != g_ring)
+    {
+        return 0;
+    }
+
+    snprintf(shm_name, sizeof(shm_name), "%s%s", LOG_PREFIX, name);
+
+    fd = shm_open(shm_name, O_RDWR | O_CREAT, 0644);
+    if (-1 == fd)
+    {
+        return 1;
+    }
+
+    if (0 != fstat(fd, &st) || ((size_t)st.st_size < sizeof(log_ring_ty) &&
+                                0 != ftruncate(fd, sizeof(log_ring_ty))))
+    {
+        close(fd);
+        return 1;
+    }
+
+    ring = (log_ring_ty *)mmap(NULL, sizeof(log_ring_ty),
+                               PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == (void *)ring)
+    {
+        return 1;
+    }
+
+    /* the first side to come up formats the ring, the other one joins it */
+    if (0 == __atomic_load_n(&ring->magic, __ATOMIC_ACQUIRE))
+    {
+        unsigned long expected = 0;
+
+        if (__atomic_compare_exchange_n(&ring->magic, &expected, 1, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+        {
+            Format(ring);
+        }
+    }
+
+    /* the other side is formatting it - or died doing so, then we take over,
+       the format is the same whoever writes it                             */
+    while (1 == __atomic_load_n(&ring->magic, __ATOMIC_ACQUIRE))
+    {
+        if (FORMAT_TRIES <= ++tries)
+        {
+            Format(ring);
+            break;
+        }
+        sched_yield();
+    }
+
+    if (LOG_MAGIC != ring->magic || LOG_VERSION != ring->version)
+    {
+        munmap(ring, sizeof(log_ring_ty));
+        return 1;
+    }
+
+    g_pid = (unsigned int)getpid();
+    g_ring = ring;
+
+    return 0;
+}
+
+static void Format(log_ring_ty *ring)
+{
+    ring->version = LOG_VERSION;
+    ring->realtime_offset_ns = NowNsec(CLOCK_REALTIME) - NowNsec(CLOCK_MONOTONIC);
+    __atomic_store_n(&ring->magic, LOG_MAGIC, __ATOMIC_RELEASE);
+}
+
+void LogUnlink(const char *name)
+{
+    char shm_name[SHM_NAME_SIZE];
+
+    assert(NULL != name);
+
+    snprintf(shm_name, sizeof(shm_name), "%s%s", LOG_PREFIX, name);
+    shm_unlink(shm_name);
+}
+
+void LogEvent(log_event_ty event, long arg0, long arg1, const char *text)
+{
+    log_ring_ty *ring = g_ring;
+    log_record_ty *record = NULL;
+    unsigned long index = 0;
+    size_t i = 0;
+
+    if (NULL == ring)
+    {
+        return;
+    }
+
+    index = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED);
+    record = &ring->records[index % LOG_RECORDS];
+
+    __atomic_store_n(&record->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    record->time_ns = (unsigned long)NowNsec(CLOCK_MONOTONIC);
+    record->event = (unsigned int)event;
+    record->pid = g_pid;
+    record->arg0 = arg0;
+    record->arg1 = arg1;
+
+    for (i = 0; NULL != text && '\0' != text[i] && LOG_TEXT_SIZE - 1 > i; ++i)
+    {
+        record->text[i] = text[i];
+    }
+    record->text[i] = '\0';
+
+    __atomic_store_n(&record->seq, index + 1, __ATOMIC_RELEASE);
+}
+
+void LogError(const char *msg)
+{
+    int saved_errno = errno;
+
+    assert(NULL != msg);
+
+    if (NULL == g_ring)
+    {
+        if (0 > write(STDERR_FILENO, msg, strlen(msg)))
+        {
+            /* nowhere left to report it */
+        }
+    }
+    else
+    {
+        LogEvent(LOG_ERROR, saved_errno, 0, msg);
+    }
+
+    errno = saved_errno;
+}
+
+int LogReadRecord(const log_ring_ty *ring, unsigned long index, log_record_ty *copy)
+{
+    const log_record_ty *record = NULL;
+    unsigned long seq = 0;
+
+    assert(NULL != ring);
+    assert(NULL != copy);
+
+    record = &ring->records[index % LOG_RECORDS];
+
+    seq = __atomic_load_n(&record->seq, __ATOMIC_ACQUIRE);
+    if (index + 1 != seq)
+    {
+        return 1;
+    }
+
+    memcpy(copy, (const void *)record, sizeof(*copy));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    return (seq != __atomic_load_n(&record->seq, __ATOMIC_RELAXED));
+}
+
+static long NowNsec(clockid_t clock)
+{
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+
+    return (long)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
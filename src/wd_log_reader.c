@@ -0,0 +1,164 @@
+/*******************************************************************************
+ * Project:     Watchdog - event log reader
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * decodes the event ring of a watchdog pair, oldest event first
+ * usage: ./wd_log <pair name | path to a copy of the ring>
+ * note: reading never blocks the watchdog, torn records are skipped
+*******************************************************************************/
+#define _GNU_SOURCE  /* localtime_r */
+
+#include <stdio.h>      /* printf           */
+#include <string.h>     /* strchr, strerror */
+#include <unistd.h>     /* close            */
+#include <fcntl.h>      /* open             */
+#include <time.h>       /* localtime_r      */
+#include <sys/mman.h>   /* mmap             */
+#include <sys/stat.h>   /* fstat            */
+
+#include "wd_log.h"
+
+#define SHM_DIR "/dev/shm"
+
+enum {PATH_SIZE = 256, TIME_STR_SIZE = 32, NSEC_PER_SEC = 1000000000};
+
+typedef struct event_format
+{
+    const char *name;
+    const char *arg0;
+    const char *arg1;
+}event_format_ty;
+
+static const event_format_ty g_formats[LOG_EVENTS_CNT] =
+{
+    {"?", "arg0", "arg1"},
+    {"error", "errno", NULL},
+    {"beat_sent", "peer", "lag_us"},
+    {"beat_failed", "peer", "errno"},
+    {"connected", "peer", NULL},
+    {"wd_exists", "wd", "generation"},
+    {"revived", "peer", "restarts"},
+    {"restart_postponed", "peer", "until"},
+    {"no_progress", "peer", "verdict"},
+    {"wd_app_started", "pid", "app"},
+    {"scheduler_stopped", "pid", NULL},
+    {"memory_restart", "peer", "usage_kb"},
+    {"slo_restart", "peer", "latency_ns"},
+    {"peer_stopped", "peer", "took_us"},
+    {"drain_requested", "pid", "ms_left"},
+    {"group_restart", "peer", "depth"},
+    {"suspected", "peer", "phi_milli"},
+    {"rate_changed", "peer", "interval"},
+    {"app_adopted", "app", "old"}
+};
+
+static void PrintRecord(const log_ring_ty *ring, const log_record_ty *record)
+{
+    const event_format_ty *format = &g_formats[0];
+    char time_str[TIME_STR_SIZE];
+    long real_ns = (long)record->time_ns + ring->realtime_offset_ns;
+    time_t sec = (time_t)(real_ns / NSEC_PER_SEC);
+    struct tm tm;
+
+    if (LOG_EVENTS_CNT > record->event)
+    {
+        format = &g_formats[record->event];
+    }
+
+    localtime_r(&sec, &tm);
+    strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", &tm);
+
+    printf("%s.%06ld %6u %-18s", time_str, real_ns % NSEC_PER_SEC / 1000,
+           record->pid, format->name);
+
+    if (NULL != format->arg0)
+    {
+        printf(" %s=%ld", format->arg0, record->arg0);
+    }
+    if (NULL != format->arg1)
+    {
+        printf(" %s=%ld", format->arg1, record->arg1);
+    }
+    if ('\0' != record->text[0])
+    {
+        printf(" \"%.*s\"", LOG_TEXT_SIZE, record->text);
+    }
+    if (LOG_ERROR == record->event)
+    {
+        printf(" (%s)", strerror((int)record->arg0));
+    }
+
+    printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+    char path[PATH_SIZE];
+    const log_ring_ty *ring = NULL;
+    log_record_ty record;
+    unsigned long head = 0;
+    unsigned long index = 0;
+    struct stat st;
+    int fd = -1;
+
+    if (2 != argc)
+    {
+        fprintf(stderr, "usage: %s <pair name | ring file>\n", argv[0]);
+        return 1;
+    }
+
+    /* a pair name is looked up in /dev/shm, a path is an offline copy */
+    if (NULL == strchr(argv[1], '/'))
+    {
+        snprintf(path, sizeof(path), "%s%s%s", SHM_DIR, LOG_PREFIX, argv[1]);
+    }
+    else
+    {
+        snprintf(path, sizeof(path), "%s", argv[1]);
+    }
+
+    fd = open(path, O_RDONLY);
+    if (-1 == fd)
+    {
+        perror(path);
+        return 1;
+    }
+
+    if (0 != fstat(fd, &st) || (size_t)st.st_size < sizeof(log_ring_ty))
+    {
+        fprintf(stderr, "%s: not an event ring\n", path);
+        close(fd);
+        return 1;
+    }
+
+    ring = (const log_ring_ty *)mmap(NULL, sizeof(log_ring_ty), PROT_READ,
+                                     MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == (void *)ring)
+    {
+        perror("mmap");
+        return 1;
+    }
+
+    if (LOG_VERSION != ring->version)
+    {
+        fprintf(stderr, "%s: unknown ring version %lu\n", path, ring->version);
+        return 1;
+    }
+
+    head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    index = (head > LOG_RECORDS) ? head - LOG_RECORDS : 0;
+
+    for (; index < head; ++index)
+    {
+        if (0 == LogReadRecord(ring, index, &record))
+        {
+            PrintRecord(ring, &record);
+        }
+    }
+
+    munmap((void *)ring, sizeof(log_ring_ty));
+
+    return 0;
+}
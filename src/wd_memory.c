@@ -0,0 +1,299 @@
+/*******************************************************************************
+ * Project:     Watchdog - memory growth checks
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#define _GNU_SOURCE  /* O_CLOEXEC, setenv */
+
+#include <stdio.h>      /* sprintf, sscanf  */
+#include <stdlib.h>     /* setenv, getenv, strtoul */
+#include <string.h>     /* strstr, strchr   */
+#include <unistd.h>     /* close, sysconf   */
+#include <fcntl.h>      /* open             */
+#include <assert.h>     /* assert           */
+
+#include "wd_memory.h"
+#include "wd_progress.h"
+
+enum {POLICY_STR_SIZE = 96, POLICY_FIELDS = 5, PATH_SIZE = 512,
+      MB = 1024 * 1024, KB = 1024};
+
+static int ReadBytes(memory_ty *memory, const wd_memory_policy_ty *policy,
+                     unsigned long *bytes);
+static int OpenCgroupFile(memory_ty *memory, pid_t pid, const char *v2_file,
+                          const char *v1_file);
+
+int MemoryPolicyExport(const wd_memory_policy_ty *policy)
+{
+    char value[POLICY_STR_SIZE];
+
+    assert(NULL != policy);
+
+    sprintf(value, "%lu,%lu,%lu,%d,%d", (unsigned long)policy->limit_mb,
+            (unsigned long)policy->horizon, (unsigned long)policy->window,
+            policy->use_pss, policy->use_cgroup);
+
+    return (0 != setenv(MEMORY_POLICY_ENV, value, 1));
+}
+
+void MemoryPolicyImport(wd_memory_policy_ty *policy)
+{
+    unsigned long fields[3] = {0, 0, 0};
+    int flags[2] = {0, 0};
+    const char *value = getenv(MEMORY_POLICY_ENV);
+
+    assert(NULL != policy);
+
+    if (NULL == value || POLICY_FIELDS != sscanf(value, "%lu,%lu,%lu,%d,%d",
+                        &fields[0], &fields[1], &fields[2], &flags[0], &flags[1]))
+    {
+        fields[0] = fields[1] = fields[2] = 0;
+        flags[0] = flags[1] = 0;
+    }
+
+    policy->limit_mb = fields[0];
+    policy->horizon = fields[1];
+    policy->window = fields[2];
+    policy->use_pss = flags[0];
+    policy->use_cgroup = flags[1];
+}
+
+void MemoryInit(memory_ty *memory)
+{
+    assert(NULL != memory);
+
+    memory->pid = 0;
+    memory->fd = -1;
+    memory->limit = 0;
+    memory->first = 0;
+    memory->cnt = 0;
+    memory->last_bytes = 0;
+    memory->eta = -1;
+}
+
+int MemoryAttach(memory_ty *memory, pid_t pid, const wd_memory_policy_ty *policy)
+{
+    char path[PATH_SIZE];
+    int max_fd = -1;
+
+    assert(NULL != memory);
+    assert(NULL != policy);
+
+    MemoryDetach(memory);
+
+    memory->pid = pid;
+    memory->limit = (unsigned long)policy->limit_mb * MB;
+
+    if (policy->use_cgroup)
+    {
+        memory->fd = OpenCgroupFile(memory, pid, "memory.current",
+                                    "memory.usage_in_bytes");
+
+        /* "max" (v2) or a huge number (v1) when the cgroup has no limit */
+        max_fd = OpenCgroupFile(memory, pid, "memory.max",
+                                "memory.limit_in_bytes");
+        if (0 == ProgressReadFile(max_fd, memory->buf, MEMORY_BUF_SIZE) &&
+            '0' <= memory->buf[0] && '9' >= memory->buf[0])
+        {
+            unsigned long max = strtoul(memory->buf, NULL, 10);
+
+            if (0 == memory->limit || max < memory->limit)
+            {
+                memory->limit = max;
+            }
+        }
+        if (-1 != max_fd)
+        {
+            close(max_fd);
+        }
+    }
+    else
+    {
+        sprintf(path, "/proc/%d/%s", (int)pid,
+                policy->use_pss ? "smaps_rollup" : "statm");
+        memory->fd = open(path, O_RDONLY | O_CLOEXEC);
+    }
+
+    if (-1 == memory->fd || 0 == memory->limit)
+    {
+        MemoryDetach(memory);
+        return 1;
+    }
+
+    return 0;
+}
+
+void MemoryDetach(memory_ty *memory)
+{
+    assert(NULL != memory);
+
+    if (-1 != memory->fd)
+    {
+        close(memory->fd);
+    }
+
+    MemoryInit(memory);
+}
+
+memory_verdict_ty MemorySample(memory_ty *memory,
+                               const wd_memory_policy_ty *policy, time_t now)
+{
+    unsigned long bytes = 0;
+    double n = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+    double x = 0, y = 0, slope = 0, denom = 0;
+    size_t last = 0;
+    size_t i = 0;
+
+    assert(NULL != memory);
+    assert(NULL != policy);
+
+    if (-1 == memory->fd || 0 != ReadBytes(memory, policy, &bytes))
+    {
+        return MEMORY_OK;
+    }
+
+    /* append, dropping the oldest sample when full */
+    last = (memory->first + memory->cnt) % MEMORY_SAMPLES;
+    if (MEMORY_SAMPLES == memory->cnt)
+    {
+        memory->first = (memory->first + 1) % MEMORY_SAMPLES;
+        --memory->cnt;
+    }
+    memory->times[last] = now;
+    memory->bytes[last] = bytes;
+    ++memory->cnt;
+    memory->last_bytes = bytes;
+    memory->eta = -1;
+
+    /* and the ones that left the window */
+    while (0 != policy->window && 1 < memory->cnt &&
+           now - memory->times[memory->first] > (time_t)policy->window)
+    {
+        memory->first = (memory->first + 1) % MEMORY_SAMPLES;
+        --memory->cnt;
+    }
+
+    if (bytes >= memory->limit)
+    {
+        memory->eta = 0;
+        return MEMORY_OVER_LIMIT;
+    }
+
+    if (MEMORY_MIN_SAMPLES > memory->cnt)
+    {
+        return MEMORY_OK;
+    }
+
+    /* least squares, times relative to now and sizes in MB keep it exact */
+    for (i = 0; i < memory->cnt; ++i)
+    {
+        last = (memory->first + i) % MEMORY_SAMPLES;
+        x = (double)(memory->times[last] - now);
+        y = (double)memory->bytes[last] / MB;
+
+        n += 1;
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+
+    denom = n * sxx - sx * sx;
+    if (0 >= denom)
+    {
+        return MEMORY_OK;
+    }
+
+    slope = (n * sxy - sx * sy) / denom;
+    if (0 >= slope)
+    {
+        return MEMORY_OK;
+    }
+
+    memory->eta = (long)(((double)(memory->limit - bytes) / MB) / slope);
+
+    return (memory->eta <= (long)policy->horizon) ? MEMORY_TREND : MEMORY_OK;
+}
+
+static int ReadBytes(memory_ty *memory, const wd_memory_policy_ty *policy,
+                     unsigned long *bytes)
+{
+    unsigned long pages = 0;
+    const char *pss = NULL;
+
+    if (0 != ProgressReadFile(memory->fd, memory->buf, MEMORY_BUF_SIZE))
+    {
+        return 1;
+    }
+
+    if (policy->use_cgroup)
+    {
+        *bytes = strtoul(memory->buf, NULL, 10);
+    }
+    else if (policy->use_pss)
+    {
+        pss = strstr(memory->buf, "Pss:");
+        if (NULL == pss)
+        {
+            return 1;
+        }
+        *bytes = strtoul(pss + sizeof("Pss:") - 1, NULL, 10) * KB;
+    }
+    else
+    {
+        /* statm: size resident ... in pages */
+        if (1 != sscanf(memory->buf, "%*u %lu", &pages))
+        {
+            return 1;
+        }
+        *bytes = pages * (unsigned long)sysconf(_SC_PAGESIZE);
+    }
+
+    return 0;
+}
+
+/* cgroup v2 ("0::<path>") if mounted, the v1 memory controller otherwise */
+static int OpenCgroupFile(memory_ty *memory, pid_t pid, const char *v2_file,
+                          const char *v1_file)
+{
+    char path[PATH_SIZE];
+    char *line = NULL;
+    char *end = NULL;
+    int fd = -1;
+
+    sprintf(path, "/proc/%d/cgroup", (int)pid);
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (-1 == fd)
+    {
+        return -1;
+    }
+    if (0 != ProgressReadFile(fd, memory->buf, MEMORY_BUF_SIZE))
+    {
+        close(fd);
+        return -1;
+    }
+    close(fd);
+    fd = -1;
+
+    line = strstr(memory->buf, "0::");
+    if (NULL != line && (line == memory->buf || '\n' == line[-1]))
+    {
+        end = strchr(line, '\n');
+        snprintf(path, sizeof(path), "/sys/fs/cgroup%.*s/%s",
+                 (int)((NULL == end) ? strlen(line + 3) : (size_t)(end - line - 3)),
+                 line + 3, v2_file);
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+    }
+
+    line = strstr(memory->buf, ":memory:");
+    if (-1 == fd && NULL != line)
+    {
+        end = strchr(line, '\n');
+        snprintf(path, sizeof(path), "/sys/fs/cgroup/memory%.*s/%s",
+                 (int)((NULL == end) ? strlen(line + 8) : (size_t)(end - line - 8)),
+                 line + 8, v1_file);
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+    }
+
+    return fd;
+}
@@ -0,0 +1,259 @@
+/*******************************************************************************
+ * Project:     Watchdog - persistent state regions
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#define _GNU_SOURCE  /* MAP_FIXED_NOREPLACE */
+
+#include <stdio.h>      /* sprintf              */
+#include <string.h>     /* strlen, strchr, memset */
+#include <unistd.h>     /* ftruncate, close, sysconf */
+#include <fcntl.h>      /* O_RDWR, O_CREAT      */
+#include <pthread.h>    /* pthread_mutex_t      */
+#include <assert.h>     /* assert               */
+#include <sys/mman.h>   /* shm_open, mmap       */
+#include <sys/stat.h>   /* fstat                */
+
+#include "watchdog.h"
+#include "wd_persist.h"
+
+#define PERSIST_MAGIC 0x57445053UL     /* "WDPS" */
+#define PERSIST_PREFIX "/wd."
+
+/* regions are placed at a hint derived from their name, far from the heap,
+   the executable and the libraries, so a restarted instance finds the
+   same address free                                                          */
+#define PERSIST_HINT_BASE 0x600000000000UL
+#define PERSIST_HINT_SLOT 0x100000000UL
+
+enum {MAX_REGIONS = 16, MAX_NAME = 64, HINT_SLOTS = 4096};
+
+typedef struct region
+{
+    char name[sizeof(PERSIST_PREFIX) + MAX_NAME];
+    persist_header_ty *header;
+    size_t map_size;
+}region_ty;
+
+static region_ty g_regions[MAX_REGIONS];
+static size_t g_regions_cnt = 0;
+static pthread_mutex_t g_regions_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int OpenFresh(const char *shm_name, int fd, const struct stat *st,
+                     size_t map_size);
+static void *NameToHint(const char *name);
+static persist_header_ty *MapRegion(int fd, size_t map_size, void *hint);
+static persist_header_ty *HeaderOf(const void *region);
+static region_ty *FindRegion(const persist_header_ty *header);
+
+void *WDAllocPersistent(const char *name, size_t size)
+{
+    char shm_name[sizeof(PERSIST_PREFIX) + MAX_NAME];
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t map_size = 0;
+    persist_header_ty *header = NULL;
+    persist_header_ty old;
+    struct stat st;
+    int fd = -1;
+    int fresh = 0;
+
+    assert(NULL != name);
+    assert(0 != size);
+
+    if (MAX_NAME <= strlen(name) || NULL != strchr(name, '/'))
+    {
+        return NULL;
+    }
+
+    sprintf(shm_name, "%s%s", PERSIST_PREFIX, name);
+    map_size = page + (size + page - 1) / page * page;
+
+    /* a region we could not track would never be freed nor unlinked */
+    pthread_mutex_lock(&g_regions_lock);
+    if (MAX_REGIONS <= g_regions_cnt)
+    {
+        pthread_mutex_unlock(&g_regions_lock);
+        return NULL;
+    }
+
+    fd = shm_open(shm_name, O_RDWR | O_CREAT, 0600);
+    if (-1 == fd)
+    {
+        pthread_mutex_unlock(&g_regions_lock);
+        return NULL;
+    }
+
+    memset(&old, 0, sizeof(old));
+    if (0 != fstat(fd, &st) ||
+        ((size_t)st.st_size >= sizeof(old) &&
+         sizeof(old) != (size_t)pread(fd, &old, sizeof(old), 0)))
+    {
+        close(fd);
+        pthread_mutex_unlock(&g_regions_lock);
+        return NULL;
+    }
+
+    /* anything but an intact region of the same layout and size starts cold */
+    fresh = ((size_t)st.st_size != map_size || PERSIST_MAGIC != old.magic ||
+             PERSIST_VERSION != old.version || size != old.size);
+
+    if (fresh)
+    {
+        fd = OpenFresh(shm_name, fd, &st, map_size);
+    }
+
+    header = (-1 == fd) ? NULL :
+                MapRegion(fd, map_size, fresh ? NameToHint(name) : old.base);
+    if (-1 != fd)
+    {
+        close(fd);
+    }
+    if (NULL == header)
+    {
+        pthread_mutex_unlock(&g_regions_lock);
+        return NULL;
+    }
+
+    if (fresh)
+    {
+        header->version = PERSIST_VERSION;
+        header->epoch = 0;
+        header->size = size;
+        header->base = header;
+        __atomic_store_n(&header->magic, PERSIST_MAGIC, __ATOMIC_RELEASE);
+    }
+    else
+    {
+        __atomic_add_fetch(&header->epoch, 1, __ATOMIC_ACQ_REL);
+        header->base = header;
+    }
+
+    strcpy(g_regions[g_regions_cnt].name, shm_name);
+    g_regions[g_regions_cnt].header = header;
+    g_regions[g_regions_cnt].map_size = map_size;
+    ++g_regions_cnt;
+    pthread_mutex_unlock(&g_regions_lock);
+
+    return (char *)header + page;
+}
+
+unsigned long WDPersistentEpoch(const void *region)
+{
+    assert(NULL != region);
+
+    return __atomic_load_n(&HeaderOf(region)->epoch, __ATOMIC_ACQUIRE);
+}
+
+int WDFreePersistent(void *region)
+{
+    persist_header_ty *header = NULL;
+    region_ty *entry = NULL;
+    int status = 1;
+
+    assert(NULL != region);
+
+    header = HeaderOf(region);
+
+    pthread_mutex_lock(&g_regions_lock);
+    entry = FindRegion(header);
+    if (NULL != entry)
+    {
+        shm_unlink(entry->name);
+        status = munmap(header, entry->map_size);
+        *entry = g_regions[--g_regions_cnt];
+    }
+    pthread_mutex_unlock(&g_regions_lock);
+
+    return (0 != status);
+}
+
+void PersistUnlinkAll(void)
+{
+    size_t i = 0;
+
+    pthread_mutex_lock(&g_regions_lock);
+    for (i = 0; i < g_regions_cnt; ++i)
+    {
+        shm_unlink(g_regions[i].name);
+    }
+    pthread_mutex_unlock(&g_regions_lock);
+}
+
+/* an object of another size or layout may still be mapped by the instance
+   that left it, shrinking it would SIGBUS that one - it keeps the old object
+   and the name gets a new one. returns the fd to map, -1 on failure - "fd"
+   is closed unless it is the one returned                                  */
+static int OpenFresh(const char *shm_name, int fd, const struct stat *st,
+                     size_t map_size)
+{
+    if (0 != st->st_size)
+    {
+        close(fd);
+        shm_unlink(shm_name);
+        fd = shm_open(shm_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (-1 == fd)
+        {
+            return -1;
+        }
+    }
+
+    if (0 != ftruncate(fd, (off_t)map_size))
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static persist_header_ty *MapRegion(int fd, size_t map_size, void *hint)
+{
+    void *addr = mmap(hint, map_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+
+    if (MAP_FAILED == addr || addr != hint)
+    {
+        /* taken (or an old kernel ignored the flag), fall back to any address */
+        if (MAP_FAILED != addr)
+        {
+            munmap(addr, map_size);
+        }
+
+        addr = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+
+    return (MAP_FAILED == addr) ? NULL : (persist_header_ty *)addr;
+}
+
+/* FNV-1a of the name picks one of HINT_SLOTS 4GB slots above the hint base */
+static void *NameToHint(const char *name)
+{
+    unsigned long hash = 2166136261UL;
+
+    while ('\0' != *name)
+    {
+        hash = (hash ^ (unsigned char)*name++) * 16777619UL;
+    }
+
+    return (void *)(PERSIST_HINT_BASE + (hash % HINT_SLOTS) * PERSIST_HINT_SLOT);
+}
+
+static persist_header_ty *HeaderOf(const void *region)
+{
+    return (persist_header_ty *)((char *)region - sysconf(_SC_PAGESIZE));
+}
+
+static region_ty *FindRegion(const persist_header_ty *header)
+{
+    size_t i = 0;
+
+    for (i = 0; i < g_regions_cnt; ++i)
+    {
+        if (header == g_regions[i].header)
+        {
+            return &g_regions[i];
+        }
+    }
+
+    return NULL;
+}
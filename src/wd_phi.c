@@ -0,0 +1,193 @@
+/*******************************************************************************
+ * Project:     Watchdog - phi accrual failure detector
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#define _GNU_SOURCE  /* setenv */
+
+#include <stdio.h>      /* sprintf, sscanf  */
+#include <stdlib.h>     /* setenv, getenv   */
+#include <math.h>       /* exp, log10, sqrt */
+#include <assert.h>     /* assert           */
+
+#include "wd_phi.h"
+
+enum {POLICY_STR_SIZE = 96, POLICY_FIELDS = 4};
+
+/* a deviation of 0 would turn a beat right on time into 0 / 0 */
+#define MIN_STD_US 1.0
+
+int PhiPolicyExport(const wd_phi_policy_ty *policy)
+{
+    char value[POLICY_STR_SIZE];
+
+    assert(NULL != policy);
+
+    if (0 > policy->threshold || 1000 < policy->threshold ||
+        2 > policy->window || PHI_MAX_WINDOW < policy->window)
+    {
+        return 1;
+    }
+
+    sprintf(value, "%.3f,%lu,%lu,%lu", policy->threshold,
+            (unsigned long)policy->window, (unsigned long)policy->min_std_ms,
+            (unsigned long)policy->pause_ms);
+
+    return (0 != setenv(PHI_POLICY_ENV, value, 1));
+}
+
+void PhiPolicyImport(wd_phi_policy_ty *policy)
+{
+    unsigned long fields[POLICY_FIELDS - 1] = {0, 0, 0};
+    const char *value = getenv(PHI_POLICY_ENV);
+    double threshold = 0;
+
+    assert(NULL != policy);
+
+    if (NULL == value || POLICY_FIELDS != sscanf(value, "%lf,%lu,%lu,%lu",
+                            &threshold, &fields[0], &fields[1], &fields[2]) ||
+        0 > threshold || 2 > fields[0] || PHI_MAX_WINDOW < fields[0])
+    {
+        threshold = 0;
+        fields[0] = 2;
+        fields[1] = fields[2] = 0;
+    }
+
+    policy->threshold = threshold;
+    policy->window = fields[0];
+    policy->min_std_ms = fields[1];
+    policy->pause_ms = fields[2];
+}
+
+/* the oldest time leaves a full window, so the sums stay O(1) */
+static void AddInterval(phi_ty *phi, double interval)
+{
+    size_t at = (phi->first + phi->cnt) % phi->window;
+
+    if (phi->cnt == phi->window)
+    {
+        phi->sum -= phi->intervals[at];
+        phi->sum_sq -= phi->intervals[at] * phi->intervals[at];
+        phi->first = (phi->first + 1) % phi->window;
+    }
+    else
+    {
+        ++phi->cnt;
+    }
+
+    phi->intervals[at] = interval;
+    phi->sum += interval;
+    phi->sum_sq += interval * interval;
+}
+
+/* the beats queued by the handler go into the history */
+static void Drain(phi_ty *phi)
+{
+    size_t tail = __atomic_load_n(&phi->tail, __ATOMIC_ACQUIRE);
+    unsigned long arrival = 0;
+
+    for (; phi->head != tail; ++phi->head)
+    {
+        arrival = phi->arrivals[phi->head % PHI_QUEUE];
+        if (arrival > phi->last_us)
+        {
+            AddInterval(phi, (double)(arrival - phi->last_us));
+            phi->last_us = arrival;
+        }
+    }
+    __atomic_store_n(&phi->head, tail, __ATOMIC_RELEASE);
+}
+
+/* two times a quarter of the interval apart, until the peer shows how it
+   really beats                                                             */
+static void Seed(phi_ty *phi, unsigned long interval_us)
+{
+    phi->first = 0;
+    phi->cnt = 0;
+    phi->sum = 0;
+    phi->sum_sq = 0;
+
+    AddInterval(phi, interval_us * 0.75);
+    AddInterval(phi, interval_us * 1.25);
+}
+
+void PhiInit(phi_ty *phi, const wd_phi_policy_ty *policy,
+             unsigned long interval_us, unsigned long now_us)
+{
+    assert(NULL != phi);
+    assert(NULL != policy);
+
+    phi->head = 0;
+    phi->tail = 0;
+    phi->latest_us = now_us;
+    phi->last_us = now_us;
+    phi->window = (2 > policy->window) ? 2 : (PHI_MAX_WINDOW < policy->window) ?
+                                            PHI_MAX_WINDOW : policy->window;
+    phi->min_std_us = (double)policy->min_std_ms * 1000;
+    phi->pause_us = (double)policy->pause_ms * 1000;
+
+    Seed(phi, interval_us);
+}
+
+void PhiRestart(phi_ty *phi, unsigned long now_us)
+{
+    assert(NULL != phi);
+
+    __atomic_store_n(&phi->head, __atomic_load_n(&phi->tail, __ATOMIC_ACQUIRE),
+                                                            __ATOMIC_RELEASE);
+    __atomic_store_n(&phi->latest_us, now_us, __ATOMIC_RELAXED);
+    phi->last_us = now_us;
+}
+
+void PhiBeat(phi_ty *phi, unsigned long now_us)
+{
+    size_t tail = 0;
+
+    assert(NULL != phi);
+
+    tail = __atomic_load_n(&phi->tail, __ATOMIC_RELAXED);
+    if (tail - __atomic_load_n(&phi->head, __ATOMIC_ACQUIRE) < PHI_QUEUE)
+    {
+        phi->arrivals[tail % PHI_QUEUE] = now_us;
+        __atomic_store_n(&phi->tail, tail + 1, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&phi->latest_us, now_us, __ATOMIC_RELAXED);
+}
+
+void PhiRescale(phi_ty *phi, unsigned long interval_us)
+{
+    assert(NULL != phi);
+
+    Drain(phi);
+    Seed(phi, interval_us);
+}
+
+double PhiValue(phi_ty *phi, unsigned long now_us)
+{
+    unsigned long latest = 0;
+    double mean = 0;
+    double std = 0;
+    double y = 0;
+    double e = 0;
+
+    assert(NULL != phi);
+
+    Drain(phi);
+
+    /* a beat that found the queue full counts for the silence only */
+    latest = __atomic_load_n(&phi->latest_us, __ATOMIC_RELAXED);
+    latest = (latest > phi->last_us) ? latest : phi->last_us;
+
+    mean = phi->sum / phi->cnt;
+    std = phi->sum_sq / phi->cnt - mean * mean;
+    std = (0 < std) ? sqrt(std) : 0;
+    std = (std > phi->min_std_us) ? std : phi->min_std_us;
+    std = (std > MIN_STD_US) ? std : MIN_STD_US;
+    mean += phi->pause_us;
+
+    /* the logistic approximation of the normal distribution */
+    y = ((double)((now_us > latest) ? now_us - latest : 0) - mean) / std;
+    e = exp(-y * (1.5976 + 0.070566 * y * y));
+
+    return (0 < y) ? -log10(e / (1.0 + e)) : -log10(1.0 - 1.0 / (1.0 + e));
+}
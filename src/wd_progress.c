@@ -0,0 +1,417 @@
+/*******************************************************************************
+ * Project:     Watchdog - progress based liveness
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#define _GNU_SOURCE  /* O_CLOEXEC, setenv */
+
+#include <stdio.h>      /* sprintf, sscanf  */
+#include <stdlib.h>     /* setenv, getenv, strtoul */
+#include <string.h>     /* strrchr, strstr  */
+#include <unistd.h>     /* pread, close     */
+#include <fcntl.h>      /* open             */
+#include <dirent.h>     /* struct dirent64  */
+#include <assert.h>     /* assert           */
+#include <sys/syscall.h>/* SYS_getdents64   */
+
+#include "wd_progress.h"
+
+enum {POLICY_STR_SIZE = 64, POLICY_FIELDS = 3, PATH_SIZE = 64,
+      STAT_UTIME_FIELD = 11, NSEC_PER_SEC = 1000000000, DENTS_CNT = 8};
+
+static int OpenProc(pid_t pid, pid_t tid, const char *file);
+static int OpenTaskDir(pid_t pid);
+static int ReadCpuTicks(progress_ty *progress, unsigned long *ticks);
+static int ReadIoChars(progress_ty *progress, int fd, unsigned long *chars);
+static int ReadRunNs(progress_ty *progress, int fd, unsigned long *run_ns);
+static void RescanThreads(progress_ty *progress);
+
+int ProgressPolicyExport(const wd_progress_policy_ty *policy)
+{
+    char value[POLICY_STR_SIZE];
+
+    assert(NULL != policy);
+
+    sprintf(value, "%lu,%lu,%lu", (unsigned long)policy->stall_time,
+            (unsigned long)policy->spin_time, (unsigned long)policy->spin_pct);
+
+    return (0 != setenv(PROGRESS_POLICY_ENV, value, 1));
+}
+
+void ProgressPolicyImport(wd_progress_policy_ty *policy)
+{
+    unsigned long fields[POLICY_FIELDS] = {0, 0, 0};
+    const char *value = getenv(PROGRESS_POLICY_ENV);
+
+    assert(NULL != policy);
+
+    if (NULL == value || POLICY_FIELDS != sscanf(value, "%lu,%lu,%lu",
+                                         &fields[0], &fields[1], &fields[2]))
+    {
+        fields[0] = fields[1] = fields[2] = 0;
+    }
+
+    policy->stall_time = fields[0];
+    policy->spin_time = fields[1];
+    policy->spin_pct = fields[2];
+}
+
+void ProgressInit(progress_ty *progress)
+{
+    assert(NULL != progress);
+
+    progress->pid = 0;
+    progress->skip_tid = 0;
+    progress->task_fd = -1;
+    progress->stat_fd = -1;
+    progress->io_fd = -1;
+    progress->skip_io_fd = -1;
+    progress->threads_cnt = 0;
+    progress->samples = 0;
+}
+
+int ProgressAttach(progress_ty *progress, pid_t pid, pid_t skip_tid, time_t now)
+{
+    assert(NULL != progress);
+
+    ProgressDetach(progress);
+
+    progress->pid = pid;
+    progress->skip_tid = skip_tid;
+    progress->stat_fd = OpenProc(pid, 0, "stat");
+    progress->io_fd = OpenProc(pid, 0, "io");
+    progress->skip_io_fd = (0 == skip_tid) ? -1 : OpenProc(pid, skip_tid, "io");
+    progress->task_fd = OpenTaskDir(pid);
+
+    if (-1 == progress->stat_fd)
+    {
+        ProgressDetach(progress);
+        return 1;
+    }
+
+    RescanThreads(progress);
+
+    progress->cpu_ticks = 0;
+    progress->io_chars = 0;
+    ReadCpuTicks(progress, &progress->cpu_ticks);
+    ReadIoChars(progress, progress->io_fd, &progress->io_chars);
+    progress->last_progress = now;
+    progress->last_io = now;
+
+    return 0;
+}
+
+void ProgressDetach(progress_ty *progress)
+{
+    size_t i = 0;
+
+    assert(NULL != progress);
+
+    if (-1 != progress->task_fd)
+    {
+        close(progress->task_fd);
+    }
+    if (-1 != progress->stat_fd)
+    {
+        close(progress->stat_fd);
+    }
+    if (-1 != progress->io_fd)
+    {
+        close(progress->io_fd);
+    }
+    if (-1 != progress->skip_io_fd)
+    {
+        close(progress->skip_io_fd);
+    }
+    for (i = 0; i < progress->threads_cnt; ++i)
+    {
+        close(progress->threads[i].fd);
+    }
+
+    ProgressInit(progress);
+}
+
+progress_verdict_ty ProgressSample(progress_ty *progress,
+                                   const wd_progress_policy_ty *policy,
+                                   time_t now)
+{
+    unsigned long ticks = 0;
+    unsigned long chars = 0;
+    unsigned long skip_chars = 0;
+    unsigned long run_ns = 0;
+    unsigned long spin_ns = 0;
+    int cpu_advanced = 0;
+    size_t i = 0;
+
+    assert(NULL != progress);
+    assert(NULL != policy);
+
+    if (0 == progress->pid)
+    {
+        return PROGRESS_OK;
+    }
+
+    if (0 == ++progress->samples % PROGRESS_RESCAN)
+    {
+        RescanThreads(progress);
+    }
+
+    /* per-thread run time is precise to the ns and leaves our thread out,
+       the tick based process total is the fallback                         */
+    for (i = 0; i < progress->threads_cnt; ++i)
+    {
+        if (0 == ReadRunNs(progress, progress->threads[i].fd, &run_ns) &&
+            run_ns != progress->threads[i].run_ns)
+        {
+            progress->threads[i].run_ns = run_ns;
+            cpu_advanced = 1;
+        }
+    }
+
+    if (0 == ReadCpuTicks(progress, &ticks) && ticks != progress->cpu_ticks)
+    {
+        progress->cpu_ticks = ticks;
+        cpu_advanced |= (0 == progress->threads_cnt);
+    }
+
+    if (0 == ReadIoChars(progress, progress->io_fd, &chars))
+    {
+        if (0 == ReadIoChars(progress, progress->skip_io_fd, &skip_chars))
+        {
+            chars -= skip_chars;
+        }
+
+        if (chars != progress->io_chars)
+        {
+            progress->io_chars = chars;
+            progress->last_io = now;
+            progress->last_progress = now;
+
+            for (i = 0; i < progress->threads_cnt; ++i)
+            {
+                progress->threads[i].run_ns_at_io = progress->threads[i].run_ns;
+            }
+        }
+    }
+
+    if (cpu_advanced)
+    {
+        progress->last_progress = now;
+    }
+
+    if (0 != policy->stall_time &&
+        now - progress->last_progress >= (time_t)policy->stall_time)
+    {
+        return PROGRESS_STALLED;
+    }
+
+    if (0 != policy->spin_time &&
+        now - progress->last_io >= (time_t)policy->spin_time)
+    {
+        spin_ns = (unsigned long)(now - progress->last_io) *
+                  NSEC_PER_SEC / 100 * policy->spin_pct;
+
+        for (i = 0; i < progress->threads_cnt; ++i)
+        {
+            if (progress->threads[i].run_ns -
+                progress->threads[i].run_ns_at_io >= spin_ns)
+            {
+                return PROGRESS_SPINNING;
+            }
+        }
+    }
+
+    return PROGRESS_OK;
+}
+
+int ProgressReadFile(int fd, char *buf, size_t size)
+{
+    ssize_t len = 0;
+
+    assert(NULL != buf);
+
+    if (-1 == fd)
+    {
+        return 1;
+    }
+
+    len = pread(fd, buf, size - 1, 0);
+    if (0 >= len)
+    {
+        return 1;
+    }
+
+    buf[len] = '\0';
+
+    return 0;
+}
+
+static int OpenProc(pid_t pid, pid_t tid, const char *file)
+{
+    char path[PATH_SIZE];
+
+    if (0 == tid)
+    {
+        sprintf(path, "/proc/%d/%s", (int)pid, file);
+    }
+    else
+    {
+        sprintf(path, "/proc/%d/task/%d/%s", (int)pid, (int)tid, file);
+    }
+
+    return open(path, O_RDONLY | O_CLOEXEC);
+}
+
+static int OpenTaskDir(pid_t pid)
+{
+    char path[PATH_SIZE];
+
+    sprintf(path, "/proc/%d/task", (int)pid);
+
+    return open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+}
+
+static int ReadCpuTicks(progress_ty *progress, unsigned long *ticks)
+{
+    char *field = NULL;
+    unsigned long utime = 0;
+    unsigned long stime = 0;
+    size_t i = 0;
+
+    if (0 != ProgressReadFile(progress->stat_fd, progress->buf,
+                                                    PROGRESS_BUF_SIZE))
+    {
+        return 1;
+    }
+
+    /* the command name may hold spaces, count the fields after its ')' */
+    field = strrchr(progress->buf, ')');
+    if (NULL == field)
+    {
+        return 1;
+    }
+
+    for (i = 0; i <= STAT_UTIME_FIELD && NULL != field; ++i)
+    {
+        field = strchr(field + 1, ' ');
+    }
+
+    if (NULL == field || 2 != sscanf(field, "%lu %lu", &utime, &stime))
+    {
+        return 1;
+    }
+
+    *ticks = utime + stime;
+
+    return 0;
+}
+
+static int ReadIoChars(progress_ty *progress, int fd, unsigned long *chars)
+{
+    char *rchar = NULL;
+    char *wchar = NULL;
+
+    if (0 != ProgressReadFile(fd, progress->buf, PROGRESS_BUF_SIZE))
+    {
+        return 1;
+    }
+
+    rchar = strstr(progress->buf, "rchar:");
+    wchar = strstr(progress->buf, "wchar:");
+    if (NULL == rchar || NULL == wchar)
+    {
+        return 1;
+    }
+
+    *chars = strtoul(rchar + sizeof("rchar:"), NULL, 10) +
+             strtoul(wchar + sizeof("wchar:"), NULL, 10);
+
+    return 0;
+}
+
+static int ReadRunNs(progress_ty *progress, int fd, unsigned long *run_ns)
+{
+    if (0 != ProgressReadFile(fd, progress->buf, PROGRESS_BUF_SIZE))
+    {
+        return 1;
+    }
+
+    *run_ns = strtoul(progress->buf, NULL, 10);
+
+    return 0;
+}
+
+/* reopens the per-thread counters, keeping the history of known threads
+   the task directory stays open: rewound and read raw, no path walk and
+   no allocation                                                          */
+static void RescanThreads(progress_ty *progress)
+{
+    progress_thread_ty found[PROGRESS_MAX_THREADS];
+    struct dirent64 dents[DENTS_CNT];
+    const struct dirent64 *entry = NULL;
+    long len = 0;
+    long pos = 0;
+    size_t found_cnt = 0;
+    size_t i = 0;
+    pid_t tid = 0;
+
+    if (-1 == progress->task_fd || 0 != lseek(progress->task_fd, 0, SEEK_SET))
+    {
+        return;
+    }
+
+    while (PROGRESS_MAX_THREADS > found_cnt &&
+           0 < (len = syscall(SYS_getdents64, progress->task_fd, dents,
+                              sizeof(dents))))
+    {
+        for (pos = 0; pos < len && PROGRESS_MAX_THREADS > found_cnt;
+             pos += entry->d_reclen)
+        {
+            entry = (const struct dirent64 *)((const char *)dents + pos);
+            tid = (pid_t)atoi(entry->d_name);
+            if (0 == tid || tid == progress->skip_tid)
+            {
+                continue;
+            }
+
+            for (i = 0; i < progress->threads_cnt &&
+                        tid != progress->threads[i].tid; ++i)
+            {
+                /* empty */
+            }
+
+            if (i < progress->threads_cnt)
+            {
+                found[found_cnt] = progress->threads[i];
+                progress->threads[i].fd = -1;
+            }
+            else
+            {
+                found[found_cnt].tid = tid;
+                found[found_cnt].fd = OpenProc(progress->pid, tid, "schedstat");
+                found[found_cnt].run_ns = 0;
+                if (-1 == found[found_cnt].fd)
+                {
+                    continue;
+                }
+                ReadRunNs(progress, found[found_cnt].fd,
+                          &found[found_cnt].run_ns);
+                found[found_cnt].run_ns_at_io = found[found_cnt].run_ns;
+            }
+
+            ++found_cnt;
+        }
+    }
+
+    /* threads that are gone */
+    for (i = 0; i < progress->threads_cnt; ++i)
+    {
+        if (-1 != progress->threads[i].fd)
+        {
+            close(progress->threads[i].fd);
+        }
+    }
+
+    memcpy(progress->threads, found, found_cnt * sizeof(found[0]));
+    progress->threads_cnt = found_cnt;
+}
@@ -0,0 +1,165 @@
+/*******************************************************************************
+ * Project:     Watchdog - adaptive heartbeat rate
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#define _GNU_SOURCE  /* setenv */
+
+#include <stdio.h>      /* sprintf, sscanf  */
+#include <stdlib.h>     /* setenv, getenv   */
+#include <assert.h>     /* assert           */
+
+#include "wd_rate.h"
+
+enum {POLICY_STR_SIZE = 48, POLICY_FIELDS = 2};
+
+enum {INTERVAL_SHIFT = 56, WISH_SHIFT = 48, FIELD_MASK = 0xff};
+
+int RatePolicyExport(const wd_rate_policy_ty *policy)
+{
+    char value[POLICY_STR_SIZE];
+
+    assert(NULL != policy);
+
+    if (RATE_MAX_INTERVAL < policy->max_interval ||
+        (0 != policy->max_interval && 0 == policy->stable_beats))
+    {
+        return 1;
+    }
+
+    sprintf(value, "%lu,%lu", (unsigned long)policy->max_interval,
+                                        (unsigned long)policy->stable_beats);
+
+    return (0 != setenv(RATE_POLICY_ENV, value, 1));
+}
+
+void RatePolicyImport(wd_rate_policy_ty *policy)
+{
+    unsigned long fields[POLICY_FIELDS] = {0, 0};
+    const char *value = getenv(RATE_POLICY_ENV);
+
+    assert(NULL != policy);
+
+    if (NULL == value || POLICY_FIELDS != sscanf(value, "%lu,%lu",
+                                                    &fields[0], &fields[1]) ||
+        RATE_MAX_INTERVAL < fields[0] || 0 == fields[1])
+    {
+        fields[0] = 0;
+        fields[1] = 1;
+    }
+
+    policy->max_interval = fields[0];
+    policy->stable_beats = fields[1];
+}
+
+void RateInit(rate_ty *rate, const wd_rate_policy_ty *policy, size_t interval)
+{
+    assert(NULL != rate);
+    assert(NULL != policy);
+    assert(0 != interval);
+
+    rate->base = interval;
+    rate->max = (RATE_MAX_INTERVAL < interval ||
+                 policy->max_interval <= interval) ? interval :
+                                                    policy->max_interval;
+    rate->stable_beats = (0 == policy->stable_beats) ? 1 : policy->stable_beats;
+    rate->current = interval;
+
+    RateRestart(rate);
+}
+
+void RateRestart(rate_ty *rate)
+{
+    assert(NULL != rate);
+
+    rate->stable = 0;
+    rate->wish = rate->base;
+    rate->current = rate->base;
+    rate->announced = rate->base;
+    rate->told = 0;
+
+    __atomic_store_n(&rate->peer_wish, rate->base, __ATOMIC_RELAXED);
+    __atomic_store_n(&rate->peer_interval, rate->max, __ATOMIC_RELAXED);
+}
+
+size_t RateUpdate(rate_ty *rate, int is_regular)
+{
+    size_t target = 0;
+
+    assert(NULL != rate);
+
+    if (!is_regular)
+    {
+        rate->stable = 0;
+        rate->wish = rate->base;
+    }
+    else if (rate->wish < rate->max && ++rate->stable >= rate->stable_beats)
+    {
+        rate->stable = 0;
+        rate->wish = (rate->wish * 2 < rate->max) ? rate->wish * 2 : rate->max;
+    }
+
+    target = __atomic_load_n(&rate->peer_wish, __ATOMIC_RELAXED);
+    target = (target < rate->wish) ? target : rate->wish;
+    target = (target > rate->base) ? target : rate->base;
+
+    if (target <= rate->current)
+    {
+        rate->current = target;
+        rate->announced = target;
+
+        return rate->current;
+    }
+
+    /* the peer hears of a slower rate before it gets one */
+    if (rate->told && rate->announced > rate->current)
+    {
+        rate->current = (rate->announced < target) ? rate->announced : target;
+    }
+    if (target != rate->announced)
+    {
+        rate->announced = target;
+        rate->told = 0;
+    }
+
+    return rate->current;
+}
+
+unsigned long RatePack(rate_ty *rate, unsigned long now_us)
+{
+    unsigned long interval = 0;
+    unsigned long wish = 0;
+
+    assert(NULL != rate);
+
+    rate->told = 1;
+
+    /* a pair slower than the field holds is never adaptive */
+    interval = (RATE_MAX_INTERVAL < rate->announced) ? 0 : rate->announced;
+    wish = (RATE_MAX_INTERVAL < rate->wish) ? 0 : rate->wish;
+
+    return (interval << INTERVAL_SHIFT) | (wish << WISH_SHIFT) |
+                                                    (now_us & RATE_TIME_MASK);
+}
+
+unsigned long RateUnpack(rate_ty *rate, unsigned long value)
+{
+    size_t interval = (size_t)(value >> INTERVAL_SHIFT) & FIELD_MASK;
+    size_t wish = (size_t)(value >> WISH_SHIFT) & FIELD_MASK;
+
+    assert(NULL != rate);
+
+    __atomic_store_n(&rate->peer_interval, (0 == interval) ? rate->base :
+                                                    interval, __ATOMIC_RELAXED);
+    __atomic_store_n(&rate->peer_wish, (0 == wish) ? rate->base : wish,
+                                                            __ATOMIC_RELAXED);
+
+    return value & RATE_TIME_MASK;
+}
+
+size_t RatePeerInterval(const rate_ty *rate)
+{
+    assert(NULL != rate);
+
+    return __atomic_load_n(&rate->peer_interval, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,393 @@
+/*******************************************************************************
+ * Project:     Watchdog - shared memory registry of the pairs
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#define _GNU_SOURCE  /* O_CLOEXEC */
+
+#include <stdio.h>      /* sprintf          */
+#include <stdlib.h>     /* strtoul          */
+#include <limits.h>     /* ULONG_MAX        */
+#include <string.h>     /* strncmp, memcpy  */
+#include <unistd.h>     /* ftruncate, close */
+#include <fcntl.h>      /* O_RDWR, O_CREAT  */
+#include <assert.h>     /* assert           */
+#include <sched.h>      /* sched_yield      */
+#include <time.h>       /* clock_gettime    */
+#include <sys/mman.h>   /* shm_open, mmap   */
+#include <sys/stat.h>   /* fstat            */
+
+#include "wd_registry.h"
+
+#define REGISTRY_MAGIC 0x57445247UL     /* "WDRG" */
+
+/* a reader gives up after READ_TRIES, a writer breaks the lock of a dead
+   one after LOCK_TRIES - both yield in between, a writer holds it briefly */
+enum {READ_TRIES = 1000, LOCK_TRIES = 10000, STAT_SIZE = 512,
+      START_TIME_FIELD = 22};
+
+/* FNV-1a, never 0 */
+static unsigned long Hash(const char *name)
+{
+    unsigned long hash = 2166136261UL;
+
+    for (; '\0' != *name; ++name)
+    {
+        hash = (hash ^ (unsigned char)*name) * 16777619UL;
+    }
+
+    return (0 == hash) ? 1 : hash;
+}
+
+static unsigned long NowNs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (unsigned long)now.tv_sec * 1000000000UL + (unsigned long)now.tv_nsec;
+}
+
+/* a pair of two dead processes frees its record, no matter how it ended */
+static int IsFree(const registry_record_ty *record)
+{
+    return (!RegistryIsAlive((pid_t)record->app_pid, record->app_start) &&
+            !RegistryIsAlive((pid_t)record->wd_pid, record->wd_start));
+}
+
+unsigned long RegistryStartTime(pid_t pid)
+{
+    char path[32];
+    char stat[STAT_SIZE];
+    char *field = NULL;
+    ssize_t len = 0;
+    size_t i = 0;
+    int fd = -1;
+
+    if (0 >= pid)
+    {
+        return 0;
+    }
+
+    sprintf(path, "/proc/%d/stat", (int)pid);
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (-1 == fd)
+    {
+        return 0;
+    }
+    len = read(fd, stat, sizeof(stat) - 1);
+    close(fd);
+    stat[(0 < len) ? len : 0] = '\0';
+
+    /* the name may hold spaces and parentheses, the fields follow its end:
+       the state is field 3                                                */
+    field = strrchr(stat, ')');
+    if (NULL == field || ' ' != field[1] || 'Z' == field[2] || 'X' == field[2])
+    {
+        return 0;
+    }
+
+    for (i = 3, field += 2; i < START_TIME_FIELD && NULL != field; ++i)
+    {
+        field = strchr(field, ' ');
+        field = (NULL == field) ? NULL : field + 1;
+    }
+
+    return (NULL == field) ? 0 : strtoul(field, NULL, 10);
+}
+
+int RegistryIsAlive(pid_t pid, unsigned long start)
+{
+    unsigned long now_start = RegistryStartTime(pid);
+
+    return (0 != now_start && (0 == start || start == now_start));
+}
+
+registry_ty *RegistryOpen(const char *shm_name, int create)
+{
+    registry_ty *registry = NULL;
+    unsigned long magic = 0;
+    struct stat st;
+    int fd = -1;
+
+    assert(NULL != shm_name);
+
+    fd = shm_open(shm_name, create ? (O_RDWR | O_CREAT) : O_RDWR, 0644);
+    if (-1 == fd)
+    {
+        return NULL;
+    }
+
+    if (0 != fstat(fd, &st) || ((size_t)st.st_size < sizeof(registry_ty) &&
+        (!create || 0 != ftruncate(fd, sizeof(registry_ty)))))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    registry = (registry_ty *)mmap(NULL, sizeof(registry_ty),
+                                   PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == (void *)registry)
+    {
+        return NULL;
+    }
+
+    /* several processes open it at once: a fresh table, all zero, is taken
+       as it is - only an old layout is wiped, by the one that finds it */
+    magic = __atomic_load_n(&registry->magic, __ATOMIC_ACQUIRE);
+    if (REGISTRY_MAGIC != magic || REGISTRY_VERSION != registry->version)
+    {
+        if (!create)
+        {
+            RegistryClose(registry);
+            return NULL;
+        }
+
+        if (0 != magic)
+        {
+            memset(registry->records, 0, sizeof(registry->records));
+        }
+        registry->version = REGISTRY_VERSION;
+        __atomic_store_n(&registry->magic, REGISTRY_MAGIC, __ATOMIC_RELEASE);
+    }
+
+    return registry;
+}
+
+void RegistryClose(registry_ty *registry)
+{
+    assert(NULL != registry);
+
+    munmap(registry, sizeof(*registry));
+}
+
+void RegistryUnlink(const char *shm_name)
+{
+    assert(NULL != shm_name);
+
+    shm_unlink(shm_name);
+}
+
+int RegistryRead(const registry_ty *registry, size_t slot,
+                 registry_record_ty *copy)
+{
+    const registry_record_ty *record = NULL;
+    unsigned long seq = 0;
+    size_t tries = 0;
+
+    assert(NULL != registry);
+    assert(REGISTRY_RECORDS > slot);
+    assert(NULL != copy);
+
+    record = registry->records + slot;
+    for (tries = 0; tries < READ_TRIES; ++tries)
+    {
+        seq = __atomic_load_n(&record->seq, __ATOMIC_ACQUIRE);
+        memcpy(copy, (const void *)record, sizeof(*copy));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (!(seq & 1) && seq == __atomic_load_n(&record->seq, __ATOMIC_RELAXED))
+        {
+            copy->seq = seq;
+            return 0;
+        }
+        sched_yield();
+    }
+
+    return 1;
+}
+
+/* the record of "name" from the first probe on, or the first never used */
+static long Probe(const registry_ty *registry, const char *name,
+                  unsigned long hash, int *is_found)
+{
+    registry_record_ty copy;
+    size_t slot = 0;
+    size_t i = 0;
+
+    *is_found = 0;
+    for (i = 0; i < REGISTRY_RECORDS; ++i)
+    {
+        slot = (hash + i) % REGISTRY_RECORDS;
+        if (0 == __atomic_load_n(&registry->records[slot].seq, __ATOMIC_ACQUIRE))
+        {
+            return (long)slot;
+        }
+        if (0 == RegistryRead(registry, slot, &copy) && hash == copy.hash &&
+            0 == strncmp(name, copy.name, REGISTRY_NAME_SIZE))
+        {
+            *is_found = 1;
+            return (long)slot;
+        }
+    }
+
+    return -1;
+}
+
+long RegistryFind(const registry_ty *registry, const char *name)
+{
+    int is_found = 0;
+    long slot = -1;
+
+    assert(NULL != registry);
+    assert(NULL != name);
+
+    slot = Probe(registry, name, Hash(name), &is_found);
+
+    return is_found ? slot : -1;
+}
+
+registry_record_ty *RegistryWriteBegin(registry_ty *registry, size_t slot)
+{
+    registry_record_ty *record = NULL;
+    unsigned long seq = 0;
+    size_t tries = 0;
+
+    assert(NULL != registry);
+    assert(REGISTRY_RECORDS > slot);
+
+    record = registry->records + slot;
+    seq = __atomic_load_n(&record->seq, __ATOMIC_RELAXED);
+    for (;;)
+    {
+        /* held by a writer that is gone: taken over, it stays odd */
+        if ((seq & 1) && LOCK_TRIES <= tries)
+        {
+            if (__atomic_compare_exchange_n(&record->seq, &seq, seq + 2, 0,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            {
+                break;
+            }
+            tries = 0;
+            continue;
+        }
+
+        if (!(seq & 1) &&
+            __atomic_compare_exchange_n(&record->seq, &seq, seq + 1, 0,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            break;
+        }
+
+        ++tries;
+        sched_yield();
+        seq = __atomic_load_n(&record->seq, __ATOMIC_RELAXED);
+    }
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    return record;
+}
+
+void RegistryWriteEnd(registry_record_ty *record)
+{
+    assert(NULL != record);
+
+    __atomic_store_n(&record->seq, record->seq + 1, __ATOMIC_RELEASE);
+}
+
+/* a record never used, or of a pair that is gone, becomes the one of "name",
+   of the caller on "side" right away - so that no other name takes it     */
+static int Claim(registry_ty *registry, size_t slot, const char *name,
+                 unsigned long hash, registry_side_ty side)
+{
+    registry_record_ty *record = registry->records + slot;
+    unsigned long seq = 0;
+    int is_free = 0;
+
+    if (!__atomic_compare_exchange_n(&record->seq, &seq, 1, 0,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    {
+        record = RegistryWriteBegin(registry, slot);
+    }
+
+    is_free = (0 == record->hash || (IsFree(record) &&
+               0 != strncmp(name, record->name, REGISTRY_NAME_SIZE)));
+    if (is_free)
+    {
+        memset(record->name, 0, sizeof(record->name));
+        strncpy(record->name, name, REGISTRY_NAME_SIZE - 1);
+        record->app_pid = (REGISTRY_APP_SIDE == side) ? (unsigned long)getpid() : 0;
+        record->app_tid = 0;
+        record->app_start = (REGISTRY_APP_SIDE == side) ?
+                                        RegistryStartTime(getpid()) : 0;
+        record->wd_pid = (REGISTRY_WD_SIDE == side) ? (unsigned long)getpid() : 0;
+        record->wd_start = (REGISTRY_WD_SIDE == side) ?
+                                        RegistryStartTime(getpid()) : 0;
+        record->generation = 0;
+        record->beat_ns[REGISTRY_APP_SIDE] = 0;
+        record->beat_ns[REGISTRY_WD_SIDE] = 0;
+        __atomic_store_n(&record->hash, hash, __ATOMIC_RELAXED);
+    }
+
+    RegistryWriteEnd(record);
+
+    return is_free;
+}
+
+long RegistryAttach(registry_ty *registry, const char *name,
+                    registry_side_ty side)
+{
+    unsigned long hash = 0;
+    registry_record_ty copy;
+    int is_found = 0;
+    long slot = -1;
+    size_t i = 0;
+
+    assert(NULL != registry);
+    assert(NULL != name);
+
+    hash = Hash(name);
+    for (;;)
+    {
+        slot = Probe(registry, name, hash, &is_found);
+        if (is_found)
+        {
+            return slot;
+        }
+
+        /* the first free one on the way, else the never used one at its end */
+        for (i = 0; i < REGISTRY_RECORDS; ++i)
+        {
+            slot = (long)((hash + i) % REGISTRY_RECORDS);
+            if (0 != RegistryRead(registry, (size_t)slot, &copy) ||
+                0 == copy.seq || IsFree(&copy))
+            {
+                break;
+            }
+        }
+        if (REGISTRY_RECORDS == i)
+        {
+            return -1;
+        }
+
+        if (Claim(registry, (size_t)slot, name, hash, side))
+        {
+            return slot;
+        }
+        /* another process took it first, maybe for "name" */
+    }
+}
+
+void RegistryBeat(registry_ty *registry, size_t slot, registry_side_ty side)
+{
+    assert(NULL != registry);
+    assert(REGISTRY_RECORDS > slot);
+
+    __atomic_store_n(&registry->records[slot].beat_ns[side], NowNs(),
+                                                        __ATOMIC_RELAXED);
+}
+
+unsigned long RegistryBeatAge(const registry_record_ty *record,
+                              registry_side_ty side)
+{
+    unsigned long now = NowNs();
+
+    assert(NULL != record);
+
+    if (0 == record->beat_ns[side])
+    {
+        return ULONG_MAX;
+    }
+
+    return (now > record->beat_ns[side]) ? now - record->beat_ns[side] : 0;
+}
@@ -0,0 +1,186 @@
+/*******************************************************************************
+ * Project:     Watchdog - restart policy
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#define _POSIX_C_SOURCE 200112L  /* setenv, rand_r */
+
+#include <stdio.h>      /* sprintf, sscanf  */
+#include <stdlib.h>     /* setenv, getenv, rand_r */
+#include <string.h>     /* memset           */
+#include <unistd.h>     /* getpid           */
+#include <assert.h>     /* assert           */
+
+#include "wd_restart.h"
+
+enum {DEFAULT_BASE_DELAY = 1, DEFAULT_MAX_DELAY = 60, DEFAULT_JITTER_PCT = 20,
+      DEFAULT_MAX_RESTARTS = 5, DEFAULT_WINDOW = 60, DEFAULT_HEALTHY_TIME = 30};
+
+enum {POLICY_STR_SIZE = 128, POLICY_FIELDS = 6};
+
+static time_t BackoffDelay(const wd_restart_policy_ty *policy,
+                           restart_state_ty *state);
+
+void RestartPolicyDefault(wd_restart_policy_ty *policy)
+{
+    assert(NULL != policy);
+
+    policy->base_delay = DEFAULT_BASE_DELAY;
+    policy->max_delay = DEFAULT_MAX_DELAY;
+    policy->jitter_pct = DEFAULT_JITTER_PCT;
+    policy->max_restarts = DEFAULT_MAX_RESTARTS;
+    policy->window = DEFAULT_WINDOW;
+    policy->healthy_time = DEFAULT_HEALTHY_TIME;
+}
+
+int RestartPolicyExport(const wd_restart_policy_ty *policy)
+{
+    char value[POLICY_STR_SIZE];
+
+    assert(NULL != policy);
+
+    sprintf(value, "%lu,%lu,%lu,%lu,%lu,%lu",
+            (unsigned long)policy->base_delay,
+            (unsigned long)policy->max_delay,
+            (unsigned long)policy->jitter_pct,
+            (unsigned long)policy->max_restarts,
+            (unsigned long)policy->window,
+            (unsigned long)policy->healthy_time);
+
+    return (0 != setenv(RESTART_POLICY_ENV, value, 1));
+}
+
+void RestartPolicyImport(wd_restart_policy_ty *policy)
+{
+    unsigned long fields[POLICY_FIELDS];
+    const char *value = NULL;
+
+    assert(NULL != policy);
+
+    RestartPolicyDefault(policy);
+
+    value = getenv(RESTART_POLICY_ENV);
+    if (NULL == value)
+    {
+        return;
+    }
+
+    if (POLICY_FIELDS != sscanf(value, "%lu,%lu,%lu,%lu,%lu,%lu",
+                                &fields[0], &fields[1], &fields[2],
+                                &fields[3], &fields[4], &fields[5]))
+    {
+        return;
+    }
+
+    policy->base_delay = fields[0];
+    policy->max_delay = fields[1];
+    policy->jitter_pct = fields[2];
+    policy->max_restarts = fields[3];
+    policy->window = fields[4];
+    policy->healthy_time = fields[5];
+}
+
+void RestartStateInit(restart_state_ty *state)
+{
+    assert(NULL != state);
+
+    memset(state, 0, sizeof(*state));
+    state->seed = (unsigned int)getpid() ^ (unsigned int)time(NULL);
+}
+
+int RestartIsAllowed(const wd_restart_policy_ty *policy,
+                     restart_state_ty *state, time_t now)
+{
+    assert(NULL != policy);
+    assert(NULL != state);
+
+    if (state->counters.breaker_open)
+    {
+        if (now - state->counters.window_start < (time_t)policy->window)
+        {
+            return 0;
+        }
+
+        /* half-open: let one restart through and start a fresh window */
+        state->counters.breaker_open = 0;
+        state->counters.restarts_in_window = 0;
+        state->counters.window_start = now;
+    }
+
+    return (now >= state->counters.next_allowed);
+}
+
+void RestartRecord(const wd_restart_policy_ty *policy,
+                   restart_state_ty *state, time_t now)
+{
+    assert(NULL != policy);
+    assert(NULL != state);
+
+    if (0 == state->counters.restarts_in_window ||
+        now - state->counters.window_start >= (time_t)policy->window)
+    {
+        state->counters.window_start = now;
+        state->counters.restarts_in_window = 0;
+    }
+
+    ++state->counters.restarts_in_window;
+    ++state->counters.total_restarts;
+    state->counters.last_restart = now;
+    state->counters.next_allowed = now + BackoffDelay(policy, state);
+    ++state->counters.consecutive;
+
+    if (0 != policy->max_restarts &&
+        state->counters.restarts_in_window >= policy->max_restarts)
+    {
+        state->counters.breaker_open = 1;
+        ++state->counters.breaker_trips;
+    }
+}
+
+void RestartReportHealthy(const wd_restart_policy_ty *policy,
+                          restart_state_ty *state, time_t now)
+{
+    assert(NULL != policy);
+    assert(NULL != state);
+
+    if (0 == state->counters.consecutive ||
+        now - state->counters.last_restart < (time_t)policy->healthy_time)
+    {
+        return;
+    }
+
+    state->counters.consecutive = 0;
+    state->counters.restarts_in_window = 0;
+    state->counters.next_allowed = 0;
+    state->counters.breaker_open = 0;
+}
+
+/* delay before the restart following the current one:
+   base_delay * 2^consecutive, capped at max_delay, +-jitter_pct percent     */
+static time_t BackoffDelay(const wd_restart_policy_ty *policy,
+                           restart_state_ty *state)
+{
+    size_t delay = policy->base_delay;
+    size_t i = 0;
+    size_t jitter = 0;
+    size_t jitter_pct = policy->jitter_pct > 100 ? 100 : policy->jitter_pct;
+
+    for (i = 0; i < state->counters.consecutive && delay < policy->max_delay;
+         ++i)
+    {
+        delay *= 2;
+    }
+
+    if (delay > policy->max_delay)
+    {
+        delay = policy->max_delay;
+    }
+
+    if (0 != jitter_pct && 0 != delay)
+    {
+        jitter = (size_t)rand_r(&state->seed) % (2 * jitter_pct + 1);
+        delay = delay * (100 - jitter_pct + jitter) / 100;
+    }
+
+    return (time_t)delay;
+}
@@ -0,0 +1,296 @@
+/*******************************************************************************
+ * Project:     Watchdog - table of heartbeat slots
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#define _POSIX_C_SOURCE 200112L  /* posix_memalign, clock_gettime */
+
+#include <stdlib.h>     /* posix_memalign, free */
+#include <limits.h>     /* LONG_MAX             */
+#include <assert.h>     /* assert               */
+#include <time.h>       /* clock_gettime        */
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>  /* _mm256_*, _mm_*      */
+#define SLOTS_X86
+#endif
+
+#include "wd_slots.h"
+
+enum {VECTOR_ALIGN = 32, WORD_BITS = 64};
+
+typedef size_t (*scan_func_ty)(const long *last_seen, const long *timeout,
+                               size_t capacity, long now,
+                               unsigned long *bitmap);
+
+/* slot i is last_seen[i] and timeout[i], a disarmed one never times out */
+struct wd_slots
+{
+    long *last_seen;
+    long *timeout;
+    size_t capacity;
+    slots_kernel_ty kernel;
+    scan_func_ty scan;
+};
+
+static const char *g_kernel_names[SLOTS_BEST] = {"scalar", "sse2", "avx2"};
+
+/* silent for longer than the timeout: now - last_seen > timeout */
+static size_t ScanScalar(const long *last_seen, const long *timeout,
+                         size_t capacity, long now, unsigned long *bitmap)
+{
+    unsigned long word = 0;
+    size_t expired = 0;
+    size_t base = 0;
+    size_t i = 0;
+
+    for (base = 0; base < capacity; base += WORD_BITS)
+    {
+        word = 0;
+        for (i = 0; i < WORD_BITS; ++i)
+        {
+            word |= (unsigned long)(now - last_seen[base + i] >
+                                                timeout[base + i]) << i;
+        }
+        bitmap[base / WORD_BITS] = word;
+        expired += (size_t)__builtin_popcountl(word);
+    }
+
+    return expired;
+}
+
+#if defined(SLOTS_X86) && defined(__SSE2__)
+/* SSE2 has no 64 bit compare: the high halves signed, the low unsigned */
+static __m128i CmpGt64(__m128i a, __m128i b)
+{
+    const __m128i flip = _mm_set1_epi32((int)0x80000000);
+    __m128i hi_gt = _mm_cmpgt_epi32(a, b);
+    __m128i hi_eq = _mm_cmpeq_epi32(a, b);
+    __m128i lo_gt = _mm_cmpgt_epi32(_mm_xor_si128(a, flip),
+                                    _mm_xor_si128(b, flip));
+
+    /* the answer ends up in the high half, the sign bit movemask reads */
+    lo_gt = _mm_shuffle_epi32(lo_gt, _MM_SHUFFLE(2, 2, 0, 0));
+
+    return _mm_or_si128(hi_gt, _mm_and_si128(hi_eq, lo_gt));
+}
+
+static size_t ScanSSE2(const long *last_seen, const long *timeout,
+                       size_t capacity, long now, unsigned long *bitmap)
+{
+    const __m128i now_v = _mm_set1_epi64x(now);
+    __m128i age = _mm_setzero_si128();
+    __m128i limit = _mm_setzero_si128();
+    unsigned long word = 0;
+    size_t expired = 0;
+    size_t base = 0;
+    size_t i = 0;
+
+    for (base = 0; base < capacity; base += WORD_BITS)
+    {
+        word = 0;
+        for (i = 0; i < WORD_BITS; i += 2)
+        {
+            age = _mm_sub_epi64(now_v, _mm_load_si128(
+                                (const __m128i *)(last_seen + base + i)));
+            limit = _mm_load_si128((const __m128i *)(timeout + base + i));
+            word |= (unsigned long)_mm_movemask_pd(
+                        _mm_castsi128_pd(CmpGt64(age, limit))) << i;
+        }
+        bitmap[base / WORD_BITS] = word;
+        expired += (size_t)__builtin_popcountl(word);
+    }
+
+    return expired;
+}
+#endif
+
+#ifdef SLOTS_X86
+__attribute__((target("avx2")))
+static size_t ScanAVX2(const long *last_seen, const long *timeout,
+                       size_t capacity, long now, unsigned long *bitmap)
+{
+    const __m256i now_v = _mm256_set1_epi64x(now);
+    __m256i age = _mm256_setzero_si256();
+    __m256i limit = _mm256_setzero_si256();
+    unsigned long word = 0;
+    size_t expired = 0;
+    size_t base = 0;
+    size_t i = 0;
+
+    for (base = 0; base < capacity; base += WORD_BITS)
+    {
+        word = 0;
+        for (i = 0; i < WORD_BITS; i += 4)
+        {
+            age = _mm256_sub_epi64(now_v, _mm256_load_si256(
+                                (const __m256i *)(last_seen + base + i)));
+            limit = _mm256_load_si256((const __m256i *)(timeout + base + i));
+            word |= (unsigned long)_mm256_movemask_pd(_mm256_castsi256_pd(
+                                _mm256_cmpgt_epi64(age, limit))) << i;
+        }
+        bitmap[base / WORD_BITS] = word;
+        expired += (size_t)__builtin_popcountl(word);
+    }
+
+    return expired;
+}
+#endif
+
+wd_slots_ty *SlotsCreate(size_t capacity)
+{
+    wd_slots_ty *slots = NULL;
+    void *last_seen = NULL;
+    void *timeout = NULL;
+    size_t i = 0;
+
+    capacity = (capacity + SLOTS_ALIGN - 1) / SLOTS_ALIGN * SLOTS_ALIGN;
+    capacity = (0 == capacity) ? SLOTS_ALIGN : capacity;
+
+    slots = (wd_slots_ty *)malloc(sizeof(wd_slots_ty));
+    if (NULL == slots)
+    {
+        return NULL;
+    }
+
+    if (0 != posix_memalign(&last_seen, VECTOR_ALIGN, capacity * sizeof(long)))
+    {
+        free(slots);
+        return NULL;
+    }
+    if (0 != posix_memalign(&timeout, VECTOR_ALIGN, capacity * sizeof(long)))
+    {
+        free(last_seen);
+        free(slots);
+        return NULL;
+    }
+
+    slots->last_seen = (long *)last_seen;
+    slots->timeout = (long *)timeout;
+    slots->capacity = capacity;
+    slots->kernel = SLOTS_SCALAR;
+    slots->scan = ScanScalar;
+
+    for (i = 0; i < capacity; ++i)
+    {
+        slots->last_seen[i] = 0;
+        slots->timeout[i] = LONG_MAX;
+    }
+
+    SlotsSetKernel(slots, SLOTS_BEST);
+
+    return slots;
+}
+
+void SlotsDestroy(wd_slots_ty *slots)
+{
+    if (NULL == slots)
+    {
+        return;
+    }
+
+    free(slots->last_seen);
+    free(slots->timeout);
+    free(slots);
+}
+
+size_t SlotsCapacity(const wd_slots_ty *slots)
+{
+    assert(NULL != slots);
+
+    return slots->capacity;
+}
+
+void SlotsArm(wd_slots_ty *slots, size_t index, unsigned long timeout_ns)
+{
+    assert(NULL != slots);
+    assert(index < slots->capacity);
+
+    /* beat first, a scan in between must not see an old slot time out */
+    SlotsBeat(slots, index);
+    __atomic_store_n(&slots->timeout[index], (LONG_MAX < timeout_ns) ?
+                        LONG_MAX : (long)timeout_ns, __ATOMIC_RELEASE);
+}
+
+void SlotsDisarm(wd_slots_ty *slots, size_t index)
+{
+    assert(NULL != slots);
+    assert(index < slots->capacity);
+
+    __atomic_store_n(&slots->timeout[index], LONG_MAX, __ATOMIC_RELEASE);
+}
+
+void SlotsBeat(wd_slots_ty *slots, size_t index)
+{
+    assert(NULL != slots);
+    assert(index < slots->capacity);
+
+    __atomic_store_n(&slots->last_seen[index], (long)SlotsNow(),
+                                                        __ATOMIC_RELAXED);
+}
+
+size_t SlotsScan(const wd_slots_ty *slots, unsigned long now_ns,
+                 unsigned long *bitmap)
+{
+    assert(NULL != slots);
+    assert(NULL != bitmap);
+
+    return slots->scan(slots->last_seen, slots->timeout, slots->capacity,
+                                                    (long)now_ns, bitmap);
+}
+
+int SlotsSetKernel(wd_slots_ty *slots, slots_kernel_ty kernel)
+{
+    assert(NULL != slots);
+
+#ifdef SLOTS_X86
+    __builtin_cpu_init();
+    if (SLOTS_BEST == kernel)
+    {
+        kernel = __builtin_cpu_supports("avx2") ? SLOTS_AVX2 :
+                 __builtin_cpu_supports("sse2") ? SLOTS_SSE2 : SLOTS_SCALAR;
+    }
+
+    if (SLOTS_AVX2 == kernel && __builtin_cpu_supports("avx2"))
+    {
+        slots->kernel = SLOTS_AVX2;
+        slots->scan = ScanAVX2;
+        return 0;
+    }
+#ifdef __SSE2__
+    if (SLOTS_SSE2 == kernel && __builtin_cpu_supports("sse2"))
+    {
+        slots->kernel = SLOTS_SSE2;
+        slots->scan = ScanSSE2;
+        return 0;
+    }
+#endif
+#else
+    kernel = (SLOTS_BEST == kernel) ? SLOTS_SCALAR : kernel;
+#endif
+
+    if (SLOTS_SCALAR == kernel)
+    {
+        slots->kernel = SLOTS_SCALAR;
+        slots->scan = ScanScalar;
+        return 0;
+    }
+
+    return 1;
+}
+
+const char *SlotsKernelName(const wd_slots_ty *slots)
+{
+    assert(NULL != slots);
+
+    return g_kernel_names[slots->kernel];
+}
+
+unsigned long SlotsNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (unsigned long)ts.tv_sec * 1000000000 + (unsigned long)ts.tv_nsec;
+}
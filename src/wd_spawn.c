@@ -0,0 +1,372 @@
+/*******************************************************************************
+ * Project:     Watchdog - allocation free spawn
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#define _GNU_SOURCE  /* clone, CLONE_VFORK, O_PATH, syscall */
+
+#include <stdlib.h>         /* getenv, _exit            */
+#include <string.h>         /* strlen, memcpy, strchr   */
+#include <errno.h>          /* errno                    */
+#include <assert.h>         /* assert                   */
+#include <limits.h>         /* PATH_MAX                 */
+#include <sched.h>          /* clone                    */
+#include <signal.h>         /* sigaction, _NSIG         */
+#include <pthread.h>        /* pthread_sigmask          */
+#include <fcntl.h>          /* open, fcntl, O_PATH      */
+#include <unistd.h>         /* execve, access, close    */
+#include <sys/mman.h>       /* mmap, mlock              */
+#include <sys/wait.h>       /* waitpid                  */
+#include <sys/syscall.h>    /* SYS_execveat             */
+
+#include "wd_spawn.h"
+
+#ifndef AT_EMPTY_PATH
+#define AT_EMPTY_PATH 0x1000
+#endif
+
+enum {STACK_SIZE = 64 * 1024, ALIGN = 16};
+
+#define DEFAULT_PATH "/bin:/usr/bin"
+
+struct spawn
+{
+    size_t size;
+    char *stack;
+    char **argv;
+    char **envp;
+    size_t env_cnt;
+    char *vars;
+    size_t vars_cnt;
+    char *path;
+    int bin_fd;
+    int has_mask;
+    sigset_t mask;
+
+    /* of the spawn in progress, shared with the child until it execs */
+    sigset_t caller_mask;
+    const int *fds;
+    size_t fds_cnt;
+    volatile int child_errno;
+};
+
+static size_t Align(size_t size)
+{
+    return (size + ALIGN - 1) & ~(size_t)(ALIGN - 1);
+}
+
+static size_t VectorCount(char *const vector[])
+{
+    size_t cnt = 0;
+
+    while (NULL != vector && NULL != vector[cnt])
+    {
+        ++cnt;
+    }
+
+    return cnt;
+}
+
+static size_t VectorChars(char *const vector[])
+{
+    size_t chars = 0;
+    size_t i = 0;
+
+    for (i = 0; NULL != vector && NULL != vector[i]; ++i)
+    {
+        chars += strlen(vector[i]) + 1;
+    }
+
+    return chars;
+}
+
+/* copies the strings of "vector" to "chars", points "to" at them */
+static char *CopyVector(char **to, char *const vector[], char *chars)
+{
+    size_t len = 0;
+    size_t i = 0;
+
+    for (i = 0; NULL != vector && NULL != vector[i]; ++i)
+    {
+        len = strlen(vector[i]) + 1;
+        memcpy(chars, vector[i], len);
+        to[i] = chars;
+        chars += len;
+    }
+
+    return chars;
+}
+
+/* what posix_spawnp() looks up on every spawn, once: "path" has PATH_MAX */
+static void ResolvePath(const char *name, char *path)
+{
+    const char *dirs = getenv("PATH");
+    size_t name_len = strlen(name);
+    size_t dir_len = 0;
+
+    strncpy(path, name, PATH_MAX - 1);
+    path[PATH_MAX - 1] = '\0';
+    if (NULL != strchr(name, '/'))
+    {
+        return;
+    }
+
+    dirs = (NULL == dirs) ? DEFAULT_PATH : dirs;
+    while ('\0' != *dirs)
+    {
+        dir_len = strcspn(dirs, ":");
+        if (0 != dir_len && PATH_MAX > dir_len + name_len + 1)
+        {
+            memcpy(path, dirs, dir_len);
+            path[dir_len] = '/';
+            memcpy(path + dir_len + 1, name, name_len + 1);
+            if (0 == access(path, X_OK))
+            {
+                return;
+            }
+        }
+
+        dirs += dir_len + (':' == dirs[dir_len]);
+    }
+
+    /* not found - the spawn fails the way posix_spawnp() does */
+    strcpy(path, name);
+}
+
+spawn_ty *SpawnCreate(char *const prefix[], char *const argv[],
+                      char *const envp[])
+{
+    spawn_ty *spawn = NULL;
+    size_t args_cnt = VectorCount(prefix) + VectorCount(argv);
+    size_t env_cnt = VectorCount(envp);
+    size_t size = 0;
+    char *at = NULL;
+
+    assert(NULL != argv);
+
+    size = Align(sizeof(spawn_ty)) + STACK_SIZE +
+           Align(sizeof(char *) * (args_cnt + 1)) +
+           Align(sizeof(char *) * (env_cnt + SPAWN_MAX_VARS + 1)) +
+           SPAWN_MAX_VARS * SPAWN_VAR_SIZE + PATH_MAX +
+           VectorChars(prefix) + VectorChars(argv) + VectorChars(envp);
+
+    /* faulted in now, and kept in, a spawn never takes a page fault */
+    at = (char *)mmap(NULL, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (MAP_FAILED == at)
+    {
+        return NULL;
+    }
+    (void)mlock(at, size);
+
+    spawn = (spawn_ty *)at;
+    spawn->size = size;
+    at += Align(sizeof(spawn_ty));
+
+    spawn->stack = at;
+    at += STACK_SIZE;
+
+    spawn->argv = (char **)at;
+    at += Align(sizeof(char *) * (args_cnt + 1));
+
+    spawn->envp = (char **)at;
+    spawn->env_cnt = env_cnt;
+    at += Align(sizeof(char *) * (env_cnt + SPAWN_MAX_VARS + 1));
+
+    spawn->vars = at;
+    spawn->vars_cnt = 0;
+    at += SPAWN_MAX_VARS * SPAWN_VAR_SIZE;
+
+    spawn->path = at;
+    at += PATH_MAX;
+
+    at = CopyVector(spawn->argv, prefix, at);
+    at = CopyVector(spawn->argv + VectorCount(prefix), argv, at);
+    spawn->argv[args_cnt] = NULL;
+    CopyVector(spawn->envp, envp, at);
+    spawn->envp[env_cnt] = NULL;
+
+    if (0 == args_cnt)
+    {
+        SpawnDestroy(spawn);
+        return NULL;
+    }
+
+    ResolvePath(spawn->argv[0], spawn->path);
+    spawn->bin_fd = open(spawn->path, O_PATH | O_CLOEXEC);
+    spawn->has_mask = 0;
+    spawn->fds = NULL;
+    spawn->fds_cnt = 0;
+    spawn->child_errno = 0;
+
+    return spawn;
+}
+
+void SpawnDestroy(spawn_ty *spawn)
+{
+    if (NULL == spawn)
+    {
+        return;
+    }
+
+    if (-1 != spawn->bin_fd)
+    {
+        close(spawn->bin_fd);
+    }
+    munmap(spawn, spawn->size);
+}
+
+char **SpawnArgv(spawn_ty *spawn)
+{
+    assert(NULL != spawn);
+
+    return spawn->argv;
+}
+
+int SpawnSetEnv(spawn_ty *spawn, const char *name, const char *value)
+{
+    size_t name_len = 0;
+    size_t value_len = 0;
+    size_t i = 0;
+    char *var = NULL;
+
+    assert(NULL != spawn);
+    assert(NULL != name);
+    assert(NULL != value);
+
+    name_len = strlen(name);
+    value_len = strlen(value);
+    if (SPAWN_VAR_SIZE <= name_len + value_len + 1)
+    {
+        return 1;
+    }
+
+    for (i = 0; i < spawn->env_cnt; ++i)
+    {
+        if (0 == strncmp(spawn->envp[i], name, name_len) &&
+            '=' == spawn->envp[i][name_len])
+        {
+            break;
+        }
+    }
+
+    /* a variable inherited from the caller moves to a slot of its own */
+    var = (i < spawn->env_cnt) ? spawn->envp[i] : NULL;
+    if (NULL == var || var < spawn->vars ||
+        var >= spawn->vars + SPAWN_MAX_VARS * SPAWN_VAR_SIZE)
+    {
+        if (SPAWN_MAX_VARS == spawn->vars_cnt)
+        {
+            return 1;
+        }
+        var = spawn->vars + spawn->vars_cnt * SPAWN_VAR_SIZE;
+        ++spawn->vars_cnt;
+    }
+
+    memcpy(var, name, name_len);
+    var[name_len] = '=';
+    memcpy(var + name_len + 1, value, value_len + 1);
+
+    spawn->envp[i] = var;
+    if (i == spawn->env_cnt)
+    {
+        ++spawn->env_cnt;
+        spawn->envp[spawn->env_cnt] = NULL;
+    }
+
+    return 0;
+}
+
+void SpawnSetMask(spawn_ty *spawn, const sigset_t *mask)
+{
+    assert(NULL != spawn);
+
+    spawn->has_mask = (NULL != mask);
+    if (NULL != mask)
+    {
+        spawn->mask = *mask;
+    }
+}
+
+/* runs on the stack of the arena, in the memory of the caller */
+static int Child(void *arg)
+{
+    spawn_ty *spawn = (spawn_ty *)arg;
+    struct sigaction action;
+    size_t i = 0;
+    int sig = 0;
+
+    /* a handler of the caller would run in its memory, not in the binary */
+    for (sig = 1; sig < _NSIG; ++sig)
+    {
+        if (0 == sigaction(sig, NULL, &action) &&
+            SIG_IGN != action.sa_handler && SIG_DFL != action.sa_handler)
+        {
+            action.sa_handler = SIG_DFL;
+            action.sa_flags = 0;
+            sigaction(sig, &action, NULL);
+        }
+    }
+
+    for (i = 0; i < spawn->fds_cnt; ++i)
+    {
+        fcntl(spawn->fds[i], F_SETFD, 0);
+    }
+
+    pthread_sigmask(SIG_SETMASK, spawn->has_mask ? &spawn->mask :
+                                            &spawn->caller_mask, NULL);
+
+    execve(spawn->path, spawn->argv, spawn->envp);
+    if (-1 != spawn->bin_fd && ENOENT == errno)
+    {
+        syscall(SYS_execveat, spawn->bin_fd, "", spawn->argv, spawn->envp,
+                                                            AT_EMPTY_PATH);
+    }
+
+    /* the caller waits for the exec, it reads the error once we are gone */
+    spawn->child_errno = errno;
+    _exit(127);
+
+    return 0;
+}
+
+int SpawnRun(spawn_ty *spawn, const int *fds, size_t cnt, pid_t *pid)
+{
+    sigset_t all;
+    pid_t child = -1;
+    int error = 0;
+
+    assert(NULL != spawn);
+    assert(NULL != pid);
+    assert(0 == cnt || NULL != fds);
+
+    /* no handler of the caller may run in the child before it resets them */
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &spawn->caller_mask);
+
+    spawn->fds = fds;
+    spawn->fds_cnt = cnt;
+    spawn->child_errno = 0;
+
+    /* vfork-like: the caller sleeps until the child execs or exits */
+    child = clone(Child, spawn->stack + STACK_SIZE,
+                  CLONE_VM | CLONE_VFORK | SIGCHLD, spawn);
+    error = (-1 == child) ? errno : spawn->child_errno;
+
+    pthread_sigmask(SIG_SETMASK, &spawn->caller_mask, NULL);
+
+    if (0 != error)
+    {
+        if (-1 != child)
+        {
+            waitpid(child, NULL, 0);
+        }
+        errno = error;
+
+        return 1;
+    }
+
+    *pid = child;
+
+    return 0;
+}
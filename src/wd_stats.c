@@ -0,0 +1,170 @@
+/*******************************************************************************
+ * Project:     Watchdog - shared memory statistics page
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#define _GNU_SOURCE  /* O_CLOEXEC */
+
+#include <stdio.h>      /* snprintf         */
+#include <string.h>     /* memcpy           */
+#include <unistd.h>     /* ftruncate, close */
+#include <fcntl.h>      /* O_RDWR, O_CREAT  */
+#include <assert.h>     /* assert           */
+#include <sys/mman.h>   /* shm_open, mmap   */
+#include <sys/stat.h>   /* fstat            */
+
+#include "wd_stats.h"
+
+#define STATS_MAGIC 0x57445354UL     /* "WDST" */
+
+enum {SHM_NAME_SIZE = 256};
+
+stats_page_ty *StatsOpen(const char *name, int create)
+{
+    char shm_name[SHM_NAME_SIZE];
+    stats_page_ty *page = NULL;
+    struct stat st;
+    int fd = -1;
+    size_t i = 0;
+
+    assert(NULL != name);
+
+    snprintf(shm_name, sizeof(shm_name), "%s%s", STATS_PREFIX, name);
+
+    fd = shm_open(shm_name, create ? (O_RDWR | O_CREAT) : O_RDWR, 0644);
+    if (-1 == fd)
+    {
+        return NULL;
+    }
+
+    if (0 != fstat(fd, &st) || ((size_t)st.st_size < sizeof(stats_page_ty) &&
+        (!create || 0 != ftruncate(fd, sizeof(stats_page_ty)))))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    page = (stats_page_ty *)mmap(NULL, sizeof(stats_page_ty),
+                                 PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == (void *)page)
+    {
+        return NULL;
+    }
+
+    /* a fresh page is zeroed, an old layout is wiped */
+    if (STATS_MAGIC != page->magic || STATS_VERSION != page->version)
+    {
+        if (!create)
+        {
+            StatsClose(page);
+            return NULL;
+        }
+
+        memset(page, 0, sizeof(*page));
+        for (i = 0; i < 2; ++i)
+        {
+            page->side[i].last_exit_status = -1;
+            page->side[i].memory_eta = -1;
+        }
+        page->version = STATS_VERSION;
+        __atomic_store_n(&page->magic, STATS_MAGIC, __ATOMIC_RELEASE);
+    }
+
+    return page;
+}
+
+void StatsClose(stats_page_ty *page)
+{
+    assert(NULL != page);
+
+    munmap(page, sizeof(*page));
+}
+
+void StatsUnlink(const char *name)
+{
+    char shm_name[SHM_NAME_SIZE];
+
+    assert(NULL != name);
+
+    snprintf(shm_name, sizeof(shm_name), "%s%s", STATS_PREFIX, name);
+    shm_unlink(shm_name);
+}
+
+void StatsWriteBegin(stats_side_ty *side)
+{
+    assert(NULL != side);
+
+    __atomic_store_n(&side->seq, side->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void StatsWriteEnd(stats_side_ty *side)
+{
+    assert(NULL != side);
+
+    __atomic_store_n(&side->seq, side->seq + 1, __ATOMIC_RELEASE);
+}
+
+void StatsRecordBeat(stats_side_ty *side, unsigned long latency_us)
+{
+    size_t bucket = 0;
+
+    assert(NULL != side);
+
+    /* bucket k holds latencies below 2^k us */
+    while (bucket < STATS_LATENCY_BUCKETS - 1 && (1UL << bucket) <= latency_us)
+    {
+        ++bucket;
+    }
+
+    __atomic_fetch_add(&side->beats_received, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&side->latency_us_sum, latency_us, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&side->latency_hist[bucket], 1, __ATOMIC_RELAXED);
+}
+
+void StatsRead(const stats_side_ty *side, stats_side_ty *copy)
+{
+    unsigned long seq = 0;
+
+    assert(NULL != side);
+    assert(NULL != copy);
+
+    do
+    {
+        seq = __atomic_load_n(&side->seq, __ATOMIC_ACQUIRE);
+        memcpy(copy, (const void *)side, sizeof(*copy));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    }
+    while ((seq & 1) || seq != __atomic_load_n(&side->seq, __ATOMIC_RELAXED));
+}
+
+unsigned long StatsLatencyPercentile(const stats_side_ty *side, size_t pct)
+{
+    unsigned long total = 0;
+    unsigned long seen = 0;
+    size_t i = 0;
+
+    assert(NULL != side);
+
+    for (i = 0; i < STATS_LATENCY_BUCKETS; ++i)
+    {
+        total += side->latency_hist[i];
+    }
+
+    if (0 == total)
+    {
+        return 0;
+    }
+
+    for (i = 0; i < STATS_LATENCY_BUCKETS - 1; ++i)
+    {
+        seen += side->latency_hist[i];
+        if (seen * 100 >= total * pct)
+        {
+            break;
+        }
+    }
+
+    return 1UL << i;
+}
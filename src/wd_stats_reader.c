@@ -0,0 +1,320 @@
+/*******************************************************************************
+ * Project:     Watchdog - stats page reader
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * dumps the stats pages of watchdog pairs in Prometheus text format, along
+ * with their records in the registry
+ * usage: ./wd_stats [pair name]    (every pair in /dev/shm if none is given)
+ * note: reading never blocks the watchdog, the page and the records are
+ *       sequence locked
+*******************************************************************************/
+#include <stdio.h>      /* printf           */
+#include <stddef.h>     /* offsetof         */
+#include <string.h>     /* strncmp, strlen  */
+#include <dirent.h>     /* opendir, readdir */
+#include <limits.h>     /* ULONG_MAX        */
+
+#include "wd_stats.h"
+#include "wd_registry.h"
+
+#define SHM_DIR "/dev/shm"
+
+enum {MAX_PAIRS = 256, PAIR_NAME_SIZE = 256};
+
+typedef struct snapshot
+{
+    char name[PAIR_NAME_SIZE];
+    size_t side_id;
+    stats_side_ty side;
+}snapshot_ty;
+
+typedef enum value_kind {ULONG_VALUE, LONG_VALUE, USEC_VALUE, NSEC_VALUE} value_kind_ty;
+
+/* one scalar metric family, "offset" locates its field in stats_side_ty */
+typedef struct scalar_metric
+{
+    const char *metric;
+    const char *type;
+    const char *help;
+    const char *extra_label;
+    size_t offset;
+    value_kind_ty kind;
+}scalar_metric_ty;
+
+#define FIELD(f) offsetof(stats_side_ty, f)
+
+static const scalar_metric_ty g_scalars[] =
+{
+    {"wd_pid", "gauge", "Pid of the side.", "", FIELD(pid), ULONG_VALUE},
+    {"wd_peer_pid", "gauge", "Pid of the supervised peer.", "", FIELD(peer_pid), ULONG_VALUE},
+    {"wd_restarts_total", "counter", "Restarts of the peer.", "", FIELD(restarts), ULONG_VALUE},
+    {"wd_breaker_trips_total", "counter", "Times the restart circuit breaker opened.", "", FIELD(breaker_trips), ULONG_VALUE},
+    {"wd_last_exit_status", "gauge", "Raw wait status of the last reaped peer, -1 if none.", "", FIELD(last_exit_status), LONG_VALUE},
+    {"wd_detect_seconds", "gauge", "Time from the last heartbeat to the restart decision.", ",stat=\"last\"", FIELD(detect_us_last), USEC_VALUE},
+    {NULL, NULL, NULL, ",stat=\"max\"", FIELD(detect_us_max), USEC_VALUE},
+    {"wd_sched_lag_seconds", "gauge", "Delay of the heartbeat task behind its schedule.", ",stat=\"last\"", FIELD(sched_lag_us_last), USEC_VALUE},
+    {NULL, NULL, NULL, ",stat=\"max\"", FIELD(sched_lag_us_max), USEC_VALUE},
+    {"wd_beats_sent_total", "counter", "Heartbeats sent to the peer.", "", FIELD(beats_sent), ULONG_VALUE},
+    {"wd_beats_received_total", "counter", "Heartbeats received from the peer.", "", FIELD(beats_received), ULONG_VALUE},
+    {"wd_peer_memory_bytes", "gauge", "Memory usage of the peer as sampled by the memory checks.", "", FIELD(memory_bytes), ULONG_VALUE},
+    {"wd_peer_memory_eta_seconds", "gauge", "Time until the memory trend reaches the limit, -1 if never.", "", FIELD(memory_eta), LONG_VALUE},
+    {"wd_planned_restarts_total", "counter", "Restarts planned by the progress, memory and latency checks.", "", FIELD(planned_restarts), ULONG_VALUE},
+    {"wd_request_latency_seconds", "gauge", "Request latency percentile of the peer over the SLO window.", "", FIELD(request_latency_ns), NSEC_VALUE},
+    {"wd_requests_in_window", "gauge", "Requests the peer reported over the SLO window.", "", FIELD(request_count), ULONG_VALUE},
+    {"wd_slo_violations_total", "counter", "Intervals the peer spent above its latency SLO.", "", FIELD(slo_violations), ULONG_VALUE},
+    {"wd_stop_phase_seconds", "gauge", "Time each phase of the last stop of an old peer took.", ",phase=\"drain\"", FIELD(stop_phase_us[0]), USEC_VALUE},
+    {NULL, NULL, NULL, ",phase=\"term\"", FIELD(stop_phase_us[1]), USEC_VALUE},
+    {NULL, NULL, NULL, ",phase=\"kill\"", FIELD(stop_phase_us[2]), USEC_VALUE},
+    {"wd_stops_total", "counter", "Old peers stopped before a restart, by the phase they exited in.", ",phase=\"drain\"", FIELD(stops_ended[0]), ULONG_VALUE},
+    {NULL, NULL, NULL, ",phase=\"term\"", FIELD(stops_ended[1]), ULONG_VALUE},
+    {NULL, NULL, NULL, ",phase=\"kill\"", FIELD(stops_ended[2]), ULONG_VALUE},
+    {"wd_beat_interval_seconds", "gauge", "Time between the heartbeats the side sends at its current rate.", "", FIELD(beat_interval), ULONG_VALUE}
+};
+
+static const char *g_side_names[] = {"app", "wd"};
+
+static snapshot_ty g_snapshots[MAX_PAIRS * 2];
+static size_t g_snapshots_cnt = 0;
+
+static void PrintHelp(const char *metric, const char *type, const char *help)
+{
+    printf("# HELP %s %s\n# TYPE %s %s\n", metric, help, metric, type);
+}
+
+static void PrintScalars(void)
+{
+    const char *metric = NULL;
+    const char *field = NULL;
+    size_t i = 0;
+    size_t j = 0;
+
+    for (i = 0; i < sizeof(g_scalars) / sizeof(g_scalars[0]); ++i)
+    {
+        /* a NULL name continues the family above it */
+        if (NULL != g_scalars[i].metric)
+        {
+            metric = g_scalars[i].metric;
+            PrintHelp(metric, g_scalars[i].type, g_scalars[i].help);
+        }
+
+        for (j = 0; j < g_snapshots_cnt; ++j)
+        {
+            field = (const char *)&g_snapshots[j].side + g_scalars[i].offset;
+
+            printf("%s{pair=\"%s\",side=\"%s\"%s} ", metric, g_snapshots[j].name,
+                   g_side_names[g_snapshots[j].side_id], g_scalars[i].extra_label);
+
+            switch (g_scalars[i].kind)
+            {
+                case ULONG_VALUE:
+                    printf("%lu\n", *(const unsigned long *)field);
+                    break;
+                case LONG_VALUE:
+                    printf("%ld\n", *(const long *)field);
+                    break;
+                case USEC_VALUE:
+                    printf("%g\n", *(const unsigned long *)field / 1e6);
+                    break;
+                case NSEC_VALUE:
+                    printf("%g\n", *(const unsigned long *)field / 1e9);
+                    break;
+            }
+        }
+    }
+}
+
+static void PrintMisses(void)
+{
+    size_t i = 0;
+    size_t j = 0;
+
+    PrintHelp("wd_miss_checks_total", "counter",
+              "Liveness checks by the number of beats missed in a row.");
+
+    for (j = 0; j < g_snapshots_cnt; ++j)
+    {
+        for (i = 0; i < STATS_MISS_BUCKETS; ++i)
+        {
+            printf("wd_miss_checks_total{pair=\"%s\",side=\"%s\",misses=\"%lu%s\"} %lu\n",
+                   g_snapshots[j].name, g_side_names[g_snapshots[j].side_id],
+                   (unsigned long)i, (STATS_MISS_BUCKETS - 1 == i) ? "+" : "",
+                   g_snapshots[j].side.miss_hist[i]);
+        }
+    }
+}
+
+static void PrintLatency(void)
+{
+    static const size_t pcts[] = {50, 90, 99};
+    const stats_side_ty *side = NULL;
+    const char *name = NULL;
+    const char *side_name = NULL;
+    unsigned long cumulative = 0;
+    size_t i = 0;
+    size_t j = 0;
+
+    PrintHelp("wd_heartbeat_latency_seconds", "histogram",
+              "Delay from sending a heartbeat to handling it.");
+
+    for (j = 0; j < g_snapshots_cnt; ++j)
+    {
+        side = &g_snapshots[j].side;
+        name = g_snapshots[j].name;
+        side_name = g_side_names[g_snapshots[j].side_id];
+        cumulative = 0;
+
+        for (i = 0; i < STATS_LATENCY_BUCKETS - 1; ++i)
+        {
+            cumulative += side->latency_hist[i];
+            printf("wd_heartbeat_latency_seconds_bucket{pair=\"%s\",side=\"%s\",le=\"%g\"} %lu\n",
+                   name, side_name, (1UL << i) / 1e6, cumulative);
+        }
+        cumulative += side->latency_hist[i];
+        printf("wd_heartbeat_latency_seconds_bucket{pair=\"%s\",side=\"%s\",le=\"+Inf\"} %lu\n",
+               name, side_name, cumulative);
+        printf("wd_heartbeat_latency_seconds_sum{pair=\"%s\",side=\"%s\"} %g\n",
+               name, side_name, side->latency_us_sum / 1e6);
+        printf("wd_heartbeat_latency_seconds_count{pair=\"%s\",side=\"%s\"} %lu\n",
+               name, side_name, cumulative);
+    }
+
+    PrintHelp("wd_heartbeat_latency_percentile_seconds", "gauge",
+              "Heartbeat latency percentiles, upper bound of their bucket.");
+
+    for (j = 0; j < g_snapshots_cnt; ++j)
+    {
+        for (i = 0; i < sizeof(pcts) / sizeof(pcts[0]); ++i)
+        {
+            printf("wd_heartbeat_latency_percentile_seconds{pair=\"%s\",side=\"%s\",percentile=\"%lu\"} %g\n",
+                   g_snapshots[j].name, g_side_names[g_snapshots[j].side_id],
+                   (unsigned long)pcts[i],
+                   StatsLatencyPercentile(&g_snapshots[j].side, pcts[i]) / 1e6);
+        }
+    }
+}
+
+static int ReadPair(const char *name)
+{
+    stats_page_ty *page = StatsOpen(name, 0);
+    size_t i = 0;
+
+    if (NULL == page)
+    {
+        fprintf(stderr, "no stats page for %s\n", name);
+        return 1;
+    }
+
+    for (i = 0; i < 2 && MAX_PAIRS * 2 > g_snapshots_cnt; ++i)
+    {
+        snprintf(g_snapshots[g_snapshots_cnt].name, PAIR_NAME_SIZE, "%s", name);
+        g_snapshots[g_snapshots_cnt].side_id = i;
+        StatsRead(&page->side[i], &g_snapshots[g_snapshots_cnt].side);
+        ++g_snapshots_cnt;
+    }
+
+    StatsClose(page);
+
+    return 0;
+}
+
+/* who the pair is now and how long ago each side beat, -1 if it never did */
+static void PrintRegistry(void)
+{
+    static const registry_side_ty sides[] = {REGISTRY_APP_SIDE, REGISTRY_WD_SIDE};
+    registry_record_ty records[MAX_PAIRS];
+    const char *names[MAX_PAIRS];
+    registry_ty *registry = RegistryOpen(REGISTRY_SHM, 0);
+    unsigned long age_ns = 0;
+    size_t cnt = 0;
+    long slot = -1;
+    size_t i = 0;
+    size_t j = 0;
+
+    if (NULL == registry)
+    {
+        return;
+    }
+
+    for (j = 0; j < g_snapshots_cnt && MAX_PAIRS > cnt; ++j)
+    {
+        slot = (0 == g_snapshots[j].side_id) ?
+                        RegistryFind(registry, g_snapshots[j].name) : -1;
+        if (-1 != slot && 0 == RegistryRead(registry, (size_t)slot, &records[cnt]))
+        {
+            names[cnt] = g_snapshots[j].name;
+            ++cnt;
+        }
+    }
+    RegistryClose(registry);
+
+    PrintHelp("wd_registry_generation", "counter",
+              "Watchdogs that took the record of the pair.");
+    for (j = 0; j < cnt; ++j)
+    {
+        printf("wd_registry_generation{pair=\"%s\"} %lu\n", names[j],
+               records[j].generation);
+    }
+
+    PrintHelp("wd_registry_pid", "gauge",
+              "Pid of the side as the registry knows it, 0 if none.");
+    for (j = 0; j < cnt; ++j)
+    {
+        printf("wd_registry_pid{pair=\"%s\",side=\"app\"} %lu\n", names[j],
+               records[j].app_pid);
+        printf("wd_registry_pid{pair=\"%s\",side=\"wd\"} %lu\n", names[j],
+               records[j].wd_pid);
+    }
+
+    PrintHelp("wd_registry_beat_age_seconds", "gauge",
+              "Time since the side last beat, -1 if it never did.");
+    for (j = 0; j < cnt; ++j)
+    {
+        for (i = 0; i < sizeof(sides) / sizeof(sides[0]); ++i)
+        {
+            age_ns = RegistryBeatAge(&records[j], sides[i]);
+            printf("wd_registry_beat_age_seconds{pair=\"%s\",side=\"%s\"} %g\n",
+                   names[j], g_side_names[i],
+                   (ULONG_MAX == age_ns) ? -1.0 : age_ns / 1e9);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *prefix = STATS_PREFIX + 1;
+    struct dirent *entry = NULL;
+    DIR *dir = NULL;
+    int status = 0;
+
+    if (argc > 1)
+    {
+        status = ReadPair(argv[1]);
+    }
+    else
+    {
+        dir = opendir(SHM_DIR);
+        if (NULL == dir)
+        {
+            perror(SHM_DIR);
+            return 1;
+        }
+
+        while (NULL != (entry = readdir(dir)))
+        {
+            if (0 == strncmp(entry->d_name, prefix, strlen(prefix)))
+            {
+                status |= ReadPair(entry->d_name + strlen(prefix));
+            }
+        }
+
+        closedir(dir);
+    }
+
+    PrintScalars();
+    PrintMisses();
+    PrintLatency();
+    PrintRegistry();
+
+    return status;
+}
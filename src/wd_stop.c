@@ -0,0 +1,226 @@
+/*******************************************************************************
+ * Project:     Watchdog - bounded stop sequence of an old instance
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#define _GNU_SOURCE  /* setenv, syscall */
+
+#include <stdio.h>      /* sprintf, sscanf  */
+#include <stdlib.h>     /* setenv, getenv   */
+#include <string.h>     /* memset           */
+#include <errno.h>      /* errno            */
+#include <unistd.h>     /* syscall, close   */
+#include <signal.h>     /* kill             */
+#include <poll.h>       /* poll             */
+#include <time.h>       /* clock_gettime    */
+#include <assert.h>     /* assert           */
+#include <sys/wait.h>   /* waitid           */
+#include <sys/syscall.h>/* SYS_pidfd_open, SYS_pidfd_send_signal */
+
+#include "wd_stop.h"
+#include "wd_channel.h"
+
+enum {POLICY_STR_SIZE = 64, POLICY_FIELDS = 2, POLL_FALLBACK_MS = 10};
+
+static int WaitExit(pid_t pid, int pidfd, size_t timeout_ms);
+static void SendSignal(pid_t pid, int pidfd, int sig);
+static int HasExited(pid_t pid);
+static unsigned long NowUsec(void);
+
+int StopPolicyExport(const wd_stop_policy_ty *policy)
+{
+    char value[POLICY_STR_SIZE];
+
+    assert(NULL != policy);
+
+    sprintf(value, "%lu,%lu", (unsigned long)policy->drain_ms,
+            (unsigned long)policy->term_ms);
+
+    return (0 != setenv(STOP_POLICY_ENV, value, 1));
+}
+
+void StopPolicyImport(wd_stop_policy_ty *policy)
+{
+    unsigned long fields[POLICY_FIELDS] = {0, STOP_DEFAULT_TERM_MS};
+    const char *value = getenv(STOP_POLICY_ENV);
+
+    assert(NULL != policy);
+
+    if (NULL == value || POLICY_FIELDS != sscanf(value, "%lu,%lu",
+                                                 &fields[0], &fields[1]))
+    {
+        fields[0] = 0;
+        fields[1] = STOP_DEFAULT_TERM_MS;
+    }
+
+    policy->drain_ms = fields[0];
+    policy->term_ms = fields[1];
+}
+
+int StopProcess(pid_t pid, const wd_stop_policy_ty *policy, int channel,
+                stop_report_ty *report)
+{
+    static const int signals[STOP_PHASES] = {0, SIGTERM, SIGKILL};
+    size_t timeouts[STOP_PHASES];
+    channel_msg_ty msg;
+    unsigned long start = 0;
+    int exited = 0;
+    int pidfd = -1;
+    size_t phase = 0;
+
+    assert(NULL != policy);
+    assert(NULL != report);
+
+    memset(report, 0, sizeof(*report));
+
+    timeouts[STOP_DRAIN] = (-1 == channel) ? 0 : policy->drain_ms;
+    timeouts[STOP_TERM] = policy->term_ms;
+    timeouts[STOP_KILL] = STOP_KILL_WAIT_MS;
+
+    /* pinned from now on, a recycled pid can't be mistaken for it */
+    pidfd = (int)syscall(SYS_pidfd_open, pid, 0);
+    if (-1 == pidfd && ESRCH == errno)
+    {
+        return 0;
+    }
+    if (HasExited(pid))
+    {
+        if (-1 != pidfd)
+        {
+            close(pidfd);
+        }
+        return 0;
+    }
+
+    for (phase = 0; phase < STOP_PHASES && !exited; ++phase)
+    {
+        if (STOP_DRAIN == phase)
+        {
+            if (0 == timeouts[STOP_DRAIN])
+            {
+                continue;
+            }
+
+            memset(&msg, 0, sizeof(msg));
+            msg.type = CHANNEL_DRAIN;
+            msg.arg = (long)timeouts[STOP_DRAIN];
+            if (0 != ChannelSend(channel, &msg, -1))
+            {
+                continue;
+            }
+        }
+        else
+        {
+            SendSignal(pid, pidfd, signals[phase]);
+        }
+
+        start = NowUsec();
+        exited = WaitExit(pid, pidfd, timeouts[phase]);
+        report->phase_us[phase] = NowUsec() - start;
+        report->phases = phase + 1;
+    }
+
+    if (-1 != pidfd)
+    {
+        close(pidfd);
+    }
+
+    return !exited;
+}
+
+int StopWaitOrKill(pid_t pid, size_t timeout_ms)
+{
+    int pidfd = (int)syscall(SYS_pidfd_open, pid, 0);
+    int exited = 0;
+
+    if (-1 == pidfd && ESRCH == errno)
+    {
+        return 0;
+    }
+
+    exited = WaitExit(pid, pidfd, timeout_ms);
+    if (!exited)
+    {
+        SendSignal(pid, pidfd, SIGKILL);
+        exited = WaitExit(pid, pidfd, STOP_KILL_WAIT_MS);
+    }
+
+    if (-1 != pidfd)
+    {
+        close(pidfd);
+    }
+
+    return !exited;
+}
+
+/* returns 1 once "pid" exited, 0 if it is still there after "timeout_ms" */
+static int WaitExit(pid_t pid, int pidfd, size_t timeout_ms)
+{
+    unsigned long deadline = NowUsec() + timeout_ms * 1000;
+    unsigned long now = 0;
+    struct pollfd pfd;
+    int wait_ms = 0;
+
+    pfd.fd = pidfd;
+    pfd.events = POLLIN;
+
+    while (!HasExited(pid))
+    {
+        now = NowUsec();
+        if (now >= deadline)
+        {
+            return 0;
+        }
+
+        /* heartbeats interrupt it, the deadline stays */
+        wait_ms = (int)((deadline - now + 999) / 1000);
+        if (-1 == pidfd)
+        {
+            wait_ms = (POLL_FALLBACK_MS < wait_ms) ? POLL_FALLBACK_MS : wait_ms;
+        }
+        if (0 < poll((-1 == pidfd) ? NULL : &pfd, (-1 == pidfd) ? 0 : 1,
+                     wait_ms))
+        {
+            return 1;
+        }
+    }
+
+    return 1;
+}
+
+/* through the pidfd it can't reach a process that reused the pid, kill()
+   only if the pidfd could not be opened                                   */
+static void SendSignal(pid_t pid, int pidfd, int sig)
+{
+    if (-1 == pidfd)
+    {
+        kill(pid, sig);
+    }
+    else
+    {
+        syscall(SYS_pidfd_send_signal, pidfd, sig, NULL, 0);
+    }
+}
+
+/* a child is a zombie until reaped, it counts as gone without reaping it */
+static int HasExited(pid_t pid)
+{
+    siginfo_t info;
+
+    info.si_pid = 0;
+    if (0 == waitid(P_PID, (id_t)pid, &info, WEXITED | WNOHANG | WNOWAIT))
+    {
+        return (pid == info.si_pid);
+    }
+
+    return (0 != kill(pid, 0) && ESRCH == errno);
+}
+
+static unsigned long NowUsec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (unsigned long)ts.tv_sec * 1000000 + (unsigned long)ts.tv_nsec / 1000;
+}
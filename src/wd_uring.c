@@ -0,0 +1,289 @@
+/*******************************************************************************
+ * Project:     Watchdog - io_uring event loop backend
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+*******************************************************************************/
+#define _GNU_SOURCE  /* syscall */
+
+#include <stdlib.h>         /* calloc, free             */
+#include <string.h>         /* memset                   */
+#include <errno.h>          /* errno, ETIME, EINTR      */
+#include <assert.h>         /* assert                   */
+#include <poll.h>           /* POLLIN                   */
+#include <signal.h>         /* _NSIG                    */
+#include <unistd.h>         /* syscall, close           */
+#include <sys/mman.h>       /* mmap, munmap             */
+#include <sys/syscall.h>    /* SYS_io_uring_setup       */
+#include <linux/io_uring.h> /* struct io_uring_sqe      */
+
+#include "wd_uring.h"
+
+struct uring
+{
+    int fd;
+    void *rings;
+    size_t rings_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+
+    /* the submission queue, shared with the kernel */
+    unsigned int *sq_head;
+    unsigned int *sq_tail;
+    unsigned int *sq_array;
+    unsigned int sq_mask;
+    unsigned int sq_entries;
+    unsigned int to_submit;
+
+    /* the completion queue, shared with the kernel */
+    unsigned int *cq_head;
+    unsigned int *cq_tail;
+    struct io_uring_cqe *cqes;
+    unsigned int cq_mask;
+
+    size_t syscalls;
+};
+
+static void *Field(void *rings, unsigned int offset)
+{
+    return (char *)rings + offset;
+}
+
+uring_ty *UringCreate(unsigned int entries)
+{
+    struct io_uring_params params;
+    uring_ty *ring = NULL;
+    size_t sq_size = 0;
+    size_t cq_size = 0;
+
+    ring = (uring_ty *)calloc(1, sizeof(uring_ty));
+    if (NULL == ring)
+    {
+        return NULL;
+    }
+
+    memset(&params, 0, sizeof(params));
+    ring->fd = (int)syscall(SYS_io_uring_setup, entries, &params);
+    if (-1 == ring->fd)
+    {
+        free(ring);
+        return NULL;
+    }
+    ring->syscalls = 1;
+
+    /* both queues in one mapping, the timeout of a wait passed along */
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) ||
+        !(params.features & IORING_FEAT_EXT_ARG))
+    {
+        close(ring->fd);
+        free(ring);
+        return NULL;
+    }
+
+    sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    cq_size = params.cq_off.cqes +
+                            params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->rings_size = (sq_size > cq_size) ? sq_size : cq_size;
+    ring->rings = mmap(NULL, ring->rings_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = (struct io_uring_sqe *)mmap(NULL, ring->sqes_size,
+                                PROT_READ | PROT_WRITE,
+                                MAP_SHARED | MAP_POPULATE, ring->fd,
+                                IORING_OFF_SQES);
+
+    if (MAP_FAILED == ring->rings || MAP_FAILED == (void *)ring->sqes)
+    {
+        if (MAP_FAILED != ring->rings)
+        {
+            munmap(ring->rings, ring->rings_size);
+        }
+        if (MAP_FAILED != (void *)ring->sqes)
+        {
+            munmap(ring->sqes, ring->sqes_size);
+        }
+        close(ring->fd);
+        free(ring);
+        return NULL;
+    }
+
+    ring->sq_head = (unsigned int *)Field(ring->rings, params.sq_off.head);
+    ring->sq_tail = (unsigned int *)Field(ring->rings, params.sq_off.tail);
+    ring->sq_array = (unsigned int *)Field(ring->rings, params.sq_off.array);
+    ring->sq_mask = *(unsigned int *)Field(ring->rings,
+                                                    params.sq_off.ring_mask);
+    ring->sq_entries = params.sq_entries;
+
+    ring->cq_head = (unsigned int *)Field(ring->rings, params.cq_off.head);
+    ring->cq_tail = (unsigned int *)Field(ring->rings, params.cq_off.tail);
+    ring->cqes = (struct io_uring_cqe *)Field(ring->rings,
+                                                        params.cq_off.cqes);
+    ring->cq_mask = *(unsigned int *)Field(ring->rings,
+                                                    params.cq_off.ring_mask);
+
+    return ring;
+}
+
+void UringDestroy(uring_ty *ring)
+{
+    assert(NULL != ring);
+
+    munmap(ring->sqes, ring->sqes_size);
+    munmap(ring->rings, ring->rings_size);
+    close(ring->fd);
+    free(ring);
+}
+
+/* the next free entry of the submission queue, NULL if it is full */
+static struct io_uring_sqe *NextEntry(uring_ty *ring, unsigned long tag)
+{
+    unsigned int tail = *ring->sq_tail;
+    struct io_uring_sqe *sqe = NULL;
+
+    if (tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >=
+                                                            ring->sq_entries)
+    {
+        return NULL;
+    }
+
+    sqe = &ring->sqes[tail & ring->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->user_data = tag;
+
+    return sqe;
+}
+
+/* hands the filled entry over to the kernel, with the next wait */
+static void Publish(uring_ty *ring)
+{
+    unsigned int tail = *ring->sq_tail;
+
+    ring->sq_array[tail & ring->sq_mask] = tail & ring->sq_mask;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ++ring->to_submit;
+}
+
+int UringQueueRead(uring_ty *ring, int fd, void *buf, size_t len,
+                   unsigned long tag)
+{
+    struct io_uring_sqe *sqe = NULL;
+
+    assert(NULL != ring);
+    assert(NULL != buf);
+
+    sqe = NextEntry(ring, tag);
+    if (NULL == sqe)
+    {
+        return 1;
+    }
+
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (unsigned long)buf;
+    sqe->len = (unsigned int)len;
+    /* a stream has no offset, -1 reads at the current position */
+    sqe->off = (unsigned long)-1;
+    Publish(ring);
+
+    return 0;
+}
+
+int UringQueuePoll(uring_ty *ring, int fd, unsigned long tag)
+{
+    struct io_uring_sqe *sqe = NULL;
+
+    assert(NULL != ring);
+
+    sqe = NextEntry(ring, tag);
+    if (NULL == sqe)
+    {
+        return 1;
+    }
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = POLLIN;
+    Publish(ring);
+
+    return 0;
+}
+
+int UringQueueCancel(uring_ty *ring, unsigned long target, unsigned long tag)
+{
+    struct io_uring_sqe *sqe = NULL;
+
+    assert(NULL != ring);
+
+    sqe = NextEntry(ring, tag);
+    if (NULL == sqe)
+    {
+        return 1;
+    }
+
+    /* matched by the user data of the operation, not by its descriptor */
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = target;
+    Publish(ring);
+
+    return 0;
+}
+
+int UringWait(uring_ty *ring, long timeout_ms, uring_done_ty on_done,
+              void *param)
+{
+    struct io_uring_getevents_arg arg;
+    struct __kernel_timespec timeout;
+    struct io_uring_cqe *cqe = NULL;
+    unsigned int head = 0;
+    unsigned int tail = 0;
+    int done = 0;
+    long status = 0;
+
+    assert(NULL != ring);
+    assert(NULL != on_done);
+
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (timeout_ms % 1000) * 1000000;
+
+    memset(&arg, 0, sizeof(arg));
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = (0 > timeout_ms) ? 0 : (unsigned long)&timeout;
+
+    /* nothing to wait for if a completion is there already */
+    head = *ring->cq_head;
+    tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    if (head == tail || 0 != ring->to_submit)
+    {
+        status = syscall(SYS_io_uring_enter, ring->fd, ring->to_submit,
+                        (head == tail) ? 1 : 0,
+                        IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                        &arg, sizeof(arg));
+        ++ring->syscalls;
+
+        /* the submission comes first, also when the wait failed */
+        ring->to_submit = *ring->sq_tail -
+                            __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+        if (0 > status && ETIME != errno)
+        {
+            return -1;
+        }
+    }
+
+    tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head, ++done)
+    {
+        cqe = &ring->cqes[head & ring->cq_mask];
+        on_done(param, (unsigned long)cqe->user_data, cqe->res);
+    }
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+    return done;
+}
+
+size_t UringSyscalls(const uring_ty *ring)
+{
+    assert(NULL != ring);
+
+    return ring->syscalls;
+}
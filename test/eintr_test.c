@@ -0,0 +1,177 @@
+/*******************************************************************************
+ * Project:     Watchdog - EINTR test
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * proves that the watchdog traffic never interrupts a syscall of the app:
+ * worker threads and the main thread sleep, poll and read in a loop, while
+ * a flooder process adds SIGUSR1 at a high rate on top of the heartbeats
+ * every syscall that fails with EINTR is counted, the test passes with 0
+ * it also checks that the caller gets its signal mask back
+ * usage: ./eintr_test.out [seconds] [signal mode]
+*******************************************************************************/
+#define _GNU_SOURCE  /* nanosleep, pthread_sigmask, usleep */
+
+#include <stdio.h>      /* printf           */
+#include <stdlib.h>     /* atoi             */
+#include <errno.h>      /* errno, EINTR     */
+#include <unistd.h>     /* fork, pipe       */
+#include <fcntl.h>      /* O_NONBLOCK       */
+#include <signal.h>     /* sigqueue         */
+#include <poll.h>       /* poll             */
+#include <pthread.h>    /* pthread_create   */
+#include <time.h>       /* nanosleep        */
+#include <sys/wait.h>   /* waitpid          */
+
+#include "watchdog.h"
+
+enum {WORKERS = 4, FLOOD_PAUSE_US = 100, DEFAULT_SECONDS = 10};
+
+static time_t g_deadline = 0;
+static unsigned long g_eintr[WORKERS + 1];
+static unsigned long g_calls[WORKERS + 1];
+static int g_pipe[2];
+
+static void InterruptibleCalls(size_t id)
+{
+    struct timespec nap = {0, 1000000};
+    struct pollfd pfd;
+    char byte = 0;
+
+    pfd.fd = g_pipe[0];
+    pfd.events = POLLIN;
+
+    while (time(NULL) < g_deadline)
+    {
+        if (-1 == nanosleep(&nap, NULL) && EINTR == errno)
+        {
+            ++g_eintr[id];
+        }
+
+        if (-1 == poll(&pfd, 1, 1) && EINTR == errno)
+        {
+            ++g_eintr[id];
+        }
+
+        /* nothing is ever written, the pipe is non blocking */
+        if (-1 == read(g_pipe[0], &byte, 1) && EINTR == errno)
+        {
+            ++g_eintr[id];
+        }
+
+        g_calls[id] += 3;
+    }
+}
+
+static void *Worker(void *arg)
+{
+    InterruptibleCalls((size_t)arg);
+
+    return NULL;
+}
+
+static pid_t StartFlooder(pid_t target)
+{
+    union sigval value;
+    pid_t pid = fork();
+
+    if (0 == pid)
+    {
+        value.sival_ptr = NULL;
+        while (0 == sigqueue(target, SIGUSR1, value))
+        {
+            usleep(FLOOD_PAUSE_US);
+        }
+        _exit(0);
+    }
+
+    return pid;
+}
+
+static int CheckMask(const sigset_t *before)
+{
+    sigset_t after;
+    int mask_ok = 1;
+    int sig = 0;
+
+    pthread_sigmask(SIG_BLOCK, NULL, &after);
+
+    for (sig = 1; sig < SIGRTMIN; ++sig)
+    {
+        if (SIGUSR1 != sig && SIGUSR2 != sig &&
+            sigismember(before, sig) != sigismember(&after, sig))
+        {
+            printf("signal %d changed in the mask of the caller\n", sig);
+            mask_ok = 0;
+        }
+    }
+
+    return mask_ok;
+}
+
+int main(int argc, char *argv[])
+{
+    pthread_t workers[WORKERS];
+    sigset_t before;
+    unsigned long eintr = 0;
+    unsigned long calls = 0;
+    pid_t flooder = 0;
+    int seconds = (argc > 1) ? atoi(argv[1]) : DEFAULT_SECONDS;
+    int mask_ok = 0;
+    size_t i = 0;
+
+    if (argc > 2)
+    {
+        WDSetSignalMode((wd_signal_mode_ty)atoi(argv[2]));
+    }
+
+    if (0 != pipe(g_pipe) || -1 == fcntl(g_pipe[0], F_SETFL, O_NONBLOCK))
+    {
+        perror("pipe");
+        return 1;
+    }
+
+    pthread_sigmask(SIG_BLOCK, NULL, &before);
+
+    if (0 != MakeMeImmortal(argc, argv, 1, 5))
+    {
+        puts("MakeMeImmortal failed");
+        return 1;
+    }
+
+    mask_ok = CheckMask(&before);
+
+    g_deadline = time(NULL) + seconds;
+
+    for (i = 0; i < WORKERS; ++i)
+    {
+        pthread_create(&workers[i], NULL, Worker, (void *)(i + 1));
+    }
+
+    flooder = StartFlooder(getpid());
+
+    InterruptibleCalls(0);
+
+    for (i = 0; i < WORKERS; ++i)
+    {
+        pthread_join(workers[i], NULL);
+    }
+
+    kill(flooder, SIGKILL);
+    waitpid(flooder, NULL, 0);
+
+    DoNotResuscitate();
+
+    for (i = 0; i <= WORKERS; ++i)
+    {
+        eintr += g_eintr[i];
+        calls += g_calls[i];
+    }
+
+    printf("%lu syscalls in %d seconds, %lu EINTR, caller mask %s\n",
+           calls, seconds, eintr, mask_ok ? "restored" : "CHANGED");
+
+    puts((0 == eintr && mask_ok) ? "PASS" : "FAIL");
+
+    return !(0 == eintr && mask_ok);
+}
@@ -0,0 +1,243 @@
+/*******************************************************************************
+ * Project:     Watchdog - cross-host heartbeats benchmark
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * runs clusters of a growing number of nodes on 127.0.0.1 in one process,
+ * and reports for each of them the rounds until every node knows every
+ * other, the messages and bytes a node sends per second, the time from
+ * stopping a node until the first and the last of the others report it,
+ * and the nodes reported by mistake
+ * usage: ./gossip_bench.out [nodes] [interval_ms] [fanout] [fail_ms]
+ *        ./gossip_bench.out 8,32,128 50 2 3000
+*******************************************************************************/
+#define _POSIX_C_SOURCE 200112L  /* clock_nanosleep */
+
+#include <stdio.h>      /* printf           */
+#include <stdlib.h>     /* strtoul, calloc  */
+#include <time.h>       /* clock_nanosleep  */
+
+#include "wd_gossip.h"
+
+enum {MEASURE_MS = 2000, STOPPED_ID = 1};
+
+typedef struct cluster
+{
+    wd_gossip_ty **nodes;
+    size_t size;
+    size_t interval_ms;
+    unsigned long stopped_ms;
+    unsigned long first_ms;
+    unsigned long last_ms;
+    size_t reports;
+    size_t wrong_reports;
+    struct timespec next;
+}cluster_ty;
+
+static void OnFailed(void *param, unsigned int node_id, const char *addr)
+{
+    cluster_ty *cluster = (cluster_ty *)param;
+    unsigned long now_ms = GossipNow();
+
+    (void)addr;
+
+    if (STOPPED_ID != node_id || 0 == cluster->stopped_ms)
+    {
+        ++cluster->wrong_reports;
+        return;
+    }
+
+    cluster->first_ms = (0 == cluster->reports) ? now_ms : cluster->first_ms;
+    cluster->last_ms = now_ms;
+    ++cluster->reports;
+}
+
+/* a round of every running node, the digests arrive by the next one */
+static void Round(cluster_ty *cluster)
+{
+    unsigned long now_ms = 0;
+    size_t i = 0;
+
+    for (i = 0; i < cluster->size; ++i)
+    {
+        if (NULL != cluster->nodes[i])
+        {
+            GossipRound(cluster->nodes[i]);
+        }
+    }
+
+    cluster->next.tv_nsec += (long)cluster->interval_ms * 1000000;
+    cluster->next.tv_sec += cluster->next.tv_nsec / 1000000000;
+    cluster->next.tv_nsec %= 1000000000;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &cluster->next, NULL);
+
+    now_ms = GossipNow();
+    for (i = 0; i < cluster->size; ++i)
+    {
+        if (NULL != cluster->nodes[i])
+        {
+            GossipReceive(cluster->nodes[i], now_ms);
+            GossipCheck(cluster->nodes[i], now_ms);
+        }
+    }
+}
+
+static int AllKnow(const cluster_ty *cluster)
+{
+    size_t i = 0;
+
+    for (i = 0; i < cluster->size; ++i)
+    {
+        if (cluster->size - 1 != GossipAlive(cluster->nodes[i]))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static unsigned long Sent(const cluster_ty *cluster, unsigned long *bytes)
+{
+    gossip_stats_ty stats;
+    unsigned long messages = 0;
+    size_t i = 0;
+
+    *bytes = 0;
+    for (i = 0; i < cluster->size; ++i)
+    {
+        if (NULL != cluster->nodes[i])
+        {
+            GossipGetStats(cluster->nodes[i], &stats);
+            messages += stats.messages_sent;
+            *bytes += stats.bytes_sent;
+        }
+    }
+
+    return messages;
+}
+
+static int Start(cluster_ty *cluster, wd_gossip_config_ty *config)
+{
+    char seed[GOSSIP_ADDR_SIZE];
+    size_t i = 0;
+
+    config->param = cluster;
+    for (i = 0; i < cluster->size; ++i)
+    {
+        config->node_id = (unsigned int)i + 1;
+        cluster->nodes[i] = GossipCreate(config);
+        if (NULL == cluster->nodes[i])
+        {
+            return 1;
+        }
+
+        /* everybody joins through the node that stops later */
+        GossipAddr(cluster->nodes[0], seed);
+        config->seeds = seed;
+    }
+    config->seeds = NULL;
+
+    return 0;
+}
+
+static void Run(size_t size, wd_gossip_config_ty *config)
+{
+    cluster_ty cluster = {0};
+    unsigned long messages = 0;
+    unsigned long bytes = 0;
+    unsigned long bytes_before = 0;
+    size_t max_rounds = 0;
+    size_t round = 0;
+    size_t i = 0;
+
+    cluster.size = size;
+    cluster.interval_ms = config->interval_ms;
+    cluster.nodes = (wd_gossip_ty **)calloc(size, sizeof(wd_gossip_ty *));
+    if (NULL == cluster.nodes || 0 != Start(&cluster, config))
+    {
+        printf("%6lu  cannot start the nodes\n", (unsigned long)size);
+        size = (NULL == cluster.nodes) ? 0 : size;
+    }
+    else
+    {
+        clock_gettime(CLOCK_MONOTONIC, &cluster.next);
+
+        max_rounds = config->fail_ms * 10 / config->interval_ms;
+        for (round = 0; round < max_rounds && !AllKnow(&cluster); ++round)
+        {
+            Round(&cluster);
+        }
+
+        messages = Sent(&cluster, &bytes_before);
+        for (i = 0; i < MEASURE_MS / config->interval_ms; ++i)
+        {
+            Round(&cluster);
+        }
+        messages = Sent(&cluster, &bytes) - messages;
+        bytes -= bytes_before;
+
+        /* the seed stops, as a host that went down */
+        GossipDestroy(cluster.nodes[STOPPED_ID - 1]);
+        cluster.nodes[STOPPED_ID - 1] = NULL;
+        cluster.stopped_ms = GossipNow();
+
+        for (i = 0; i < max_rounds && cluster.reports < size - 1; ++i)
+        {
+            Round(&cluster);
+        }
+
+        printf("%6lu %8lu %10.1f %10.0f %10lu %10lu %8lu %6lu\n",
+               (unsigned long)size, (unsigned long)round,
+               messages * 1000.0 / MEASURE_MS / size,
+               bytes * 1000.0 / MEASURE_MS / size,
+               cluster.first_ms - cluster.stopped_ms,
+               cluster.last_ms - cluster.stopped_ms,
+               (unsigned long)cluster.reports,
+               (unsigned long)cluster.wrong_reports);
+    }
+
+    for (i = 0; i < size; ++i)
+    {
+        GossipDestroy(cluster.nodes[i]);
+    }
+    free(cluster.nodes);
+}
+
+int main(int argc, char *argv[])
+{
+    wd_gossip_config_ty config = {0};
+    const char *sizes = (1 < argc) ? argv[1] : "8,16,32,64,128,256";
+    char *end = NULL;
+    size_t size = 0;
+
+    config.bind = "127.0.0.1:0";
+    config.interval_ms = (2 < argc) ? strtoul(argv[2], NULL, 10) : 50;
+    config.fanout = (3 < argc) ? strtoul(argv[3], NULL, 10) : 2;
+    config.fail_ms = (4 < argc) ? strtoul(argv[4], NULL, 10) : 3000;
+    config.on_failed = OnFailed;
+
+    printf("interval %lu ms, fanout %lu, fail after %lu ms, "
+           "%d members a digest\n\n", (unsigned long)config.interval_ms,
+           (unsigned long)config.fanout, (unsigned long)config.fail_ms,
+           GOSSIP_MAX_DIGEST);
+    printf("%6s %8s %10s %10s %10s %10s %8s %6s\n", "nodes", "rounds",
+           "msgs/s", "bytes/s", "first [ms]", "last [ms]", "reports",
+           "wrong");
+
+    while ('\0' != *sizes)
+    {
+        size = strtoul(sizes, &end, 10);
+        if (2 <= size && GOSSIP_MAX_NODES >= size)
+        {
+            Run(size, &config);
+        }
+        sizes = (',' == *end) ? end + 1 : end;
+        if (end == sizes && '\0' != *sizes)
+        {
+            break;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,254 @@
+/*******************************************************************************
+ * Project:     Watchdog - cross-host heartbeats test
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * runs a cluster of nodes on 127.0.0.1 in one process, all of them seeded
+ * with the first one, and checks that they learn each other, that every
+ * node reports a stopped one once and nobody else, that a restarted node
+ * is alive again, and a pair of nodes in threads of their own
+ * usage: ./gossip_test.out
+*******************************************************************************/
+#define _POSIX_C_SOURCE 200112L  /* nanosleep */
+
+#include <stdio.h>      /* printf, puts */
+#include <time.h>       /* nanosleep    */
+
+#include "wd_gossip.h"
+
+#include "wd_expect.h"
+
+enum {NODES = 8, STOPPED = 3, INTERVAL_MS = 20, FAIL_MS = 300,
+      MAX_ROUNDS = 100};
+
+static wd_gossip_ty *g_nodes[NODES];
+static size_t g_reports[NODES];
+static size_t g_wrong_reports = 0;
+static char g_seed[GOSSIP_ADDR_SIZE];
+static size_t g_ids[NODES] = {0, 1, 2, 3, 4, 5, 6, 7};
+
+static void OnFailed(void *param, unsigned int node_id, const char *addr)
+{
+    (void)addr;
+
+    if (STOPPED + 1 == node_id)
+    {
+        ++g_reports[*(size_t *)param];
+    }
+    else
+    {
+        ++g_wrong_reports;
+    }
+}
+
+static wd_gossip_ty *Start(size_t i)
+{
+    wd_gossip_config_ty config = {0};
+
+    config.node_id = (unsigned int)i + 1;
+    config.bind = "127.0.0.1:0";
+    config.seeds = (0 == i) ? NULL : g_seed;
+    config.interval_ms = INTERVAL_MS;
+    config.fanout = 2;
+    config.fail_ms = FAIL_MS;
+    config.on_failed = OnFailed;
+    config.param = &g_ids[i];
+
+    return GossipCreate(&config);
+}
+
+/* a round of every running node, then the digests, one interval later */
+static void Round(void)
+{
+    struct timespec interval = {0, INTERVAL_MS * 1000000L};
+    unsigned long now_ms = 0;
+    size_t i = 0;
+
+    for (i = 0; i < NODES; ++i)
+    {
+        if (NULL != g_nodes[i])
+        {
+            GossipRound(g_nodes[i]);
+        }
+    }
+
+    nanosleep(&interval, NULL);
+
+    now_ms = GossipNow();
+    for (i = 0; i < NODES; ++i)
+    {
+        if (NULL != g_nodes[i])
+        {
+            GossipReceive(g_nodes[i], now_ms);
+            GossipCheck(g_nodes[i], now_ms);
+        }
+    }
+}
+
+static int AllKnow(size_t alive)
+{
+    size_t i = 0;
+
+    for (i = 0; i < NODES; ++i)
+    {
+        if (NULL != g_nodes[i] && alive != GossipAlive(g_nodes[i]))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static int AllReported(void)
+{
+    size_t i = 0;
+
+    for (i = 0; i < NODES; ++i)
+    {
+        if (STOPPED != i && 0 == g_reports[i])
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void CheckCluster(void)
+{
+    gossip_stats_ty stats;
+    size_t round = 0;
+    size_t i = 0;
+
+    for (i = 0; i < NODES; ++i)
+    {
+        g_nodes[i] = Start(i);
+        Expect(NULL != g_nodes[i], "create");
+        if (NULL == g_nodes[i])
+        {
+            return;
+        }
+        GossipAddr(g_nodes[0], g_seed);
+    }
+
+    for (round = 0; round < MAX_ROUNDS && !AllKnow(NODES - 1); ++round)
+    {
+        Round();
+    }
+    Expect(AllKnow(NODES - 1), "everybody knows everybody");
+
+    /* the node stops gossiping, as a host that went down */
+    GossipDestroy(g_nodes[STOPPED]);
+    g_nodes[STOPPED] = NULL;
+
+    for (round = 0; round < MAX_ROUNDS && !AllReported(); ++round)
+    {
+        Round();
+    }
+    Expect(AllReported(), "every node reports the stopped one");
+    Expect(round * INTERVAL_MS < FAIL_MS * 2, "reported in time");
+
+    /* the forgotten node is not revived by a late digest */
+    for (round = 0; round < FAIL_MS * 3 / INTERVAL_MS; ++round)
+    {
+        Round();
+    }
+    for (i = 0; i < NODES; ++i)
+    {
+        Expect(STOPPED == i || 1 == g_reports[i], "reported once");
+    }
+    Expect(0 == g_wrong_reports, "nobody else reported");
+    Expect(AllKnow(NODES - 2), "the others still alive");
+
+    /* a new instance of the node joins again */
+    g_nodes[STOPPED] = Start(STOPPED);
+    Expect(NULL != g_nodes[STOPPED], "restart");
+    for (round = 0; round < MAX_ROUNDS && !AllKnow(NODES - 1); ++round)
+    {
+        Round();
+    }
+    Expect(AllKnow(NODES - 1), "the restarted node is alive");
+    Expect(GossipIsAlive(g_nodes[0], STOPPED + 1), "alive at the seed");
+
+    GossipGetStats(g_nodes[0], &stats);
+    Expect(0 < stats.messages_sent && 0 < stats.messages_received &&
+           0 == stats.dropped, "stats");
+
+    for (i = 0; i < NODES; ++i)
+    {
+        GossipDestroy(g_nodes[i]);
+    }
+}
+
+static void OnThreadFailed(void *param, unsigned int node_id,
+                           const char *addr)
+{
+    (void)addr;
+
+    __atomic_store_n((unsigned int *)param, node_id, __ATOMIC_RELEASE);
+}
+
+static void CheckThreads(void)
+{
+    struct timespec tick = {0, 10000000};
+    wd_gossip_config_ty config = {0};
+    wd_gossip_ty *first = NULL;
+    wd_gossip_ty *second = NULL;
+    unsigned int failed_id = 0;
+    size_t i = 0;
+
+    config.bind = "127.0.0.1:0";
+    config.interval_ms = INTERVAL_MS;
+    config.fanout = 1;
+    config.fail_ms = FAIL_MS;
+    config.on_failed = OnThreadFailed;
+    config.param = &failed_id;
+
+    config.node_id = 100;
+    config.seeds = "127.0.0.1";
+    Expect(NULL == WDGossipStart(&config), "malformed seeds");
+    config.seeds = NULL;
+
+    first = WDGossipStart(&config);
+    Expect(NULL != first, "start first");
+    if (NULL == first)
+    {
+        return;
+    }
+
+    GossipAddr(first, g_seed);
+    config.node_id = 200;
+    config.seeds = g_seed;
+    second = WDGossipStart(&config);
+    Expect(NULL != second, "start second");
+
+    /* longer than "fail_ms", with the second up */
+    for (i = 0; i < FAIL_MS * 2 / 10; ++i)
+    {
+        nanosleep(&tick, NULL);
+    }
+    Expect(0 == __atomic_load_n(&failed_id, __ATOMIC_ACQUIRE),
+                                                    "no failure while up");
+
+    Expect(0 == WDGossipStop(second), "stop second");
+    for (i = 0; i < 100 &&
+                0 == __atomic_load_n(&failed_id, __ATOMIC_ACQUIRE); ++i)
+    {
+        nanosleep(&tick, NULL);
+    }
+    Expect(200 == __atomic_load_n(&failed_id, __ATOMIC_ACQUIRE),
+                                                    "the first reports it");
+
+    Expect(0 == WDGossipStop(first), "stop first");
+}
+
+int main(void)
+{
+    CheckCluster();
+    CheckThreads();
+
+    puts(0 == g_failed ? "PASS" : "FAIL");
+
+    return (0 != g_failed);
+}
@@ -0,0 +1,300 @@
+/*******************************************************************************
+ * Project:     Watchdog - supervision groups test
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * plays the wd_app of every member of a tree in one process:
+ *
+ *   <stack>          rest for one: db (rank 0), cache (1), proxy (3)
+ *   <stack>.logs     one for one, 2 restarts a minute: shipper, rotator (2)
+ *
+ * and checks the members a failure restarts, the dependency order of the
+ * restart, and the escalation of a group that restarted too often
+ * usage: ./group_test.out
+*******************************************************************************/
+#define _GNU_SOURCE  /* pid_t */
+
+#include <stdio.h>      /* printf, sprintf  */
+#include <string.h>     /* strcmp           */
+#include <unistd.h>     /* getpid           */
+#include <sys/mman.h>   /* shm_open         */
+#include <fcntl.h>      /* O_RDWR           */
+
+#include "wd_group.h"
+
+#include "wd_expect.h"
+
+enum {DB = 0, CACHE, PROXY, SHIPPER, ROTATOR, MEMBERS};
+
+typedef struct member
+{
+    const char *name;
+    int in_logs;
+    size_t rank;
+    group_ty *group;
+    unsigned long last_beat_us;
+}member_ty;
+
+static member_ty g_members[MEMBERS] =
+{
+    {"db", 0, 0, NULL, 0},
+    {"cache", 0, 1, NULL, 0},
+    {"proxy", 0, 3, NULL, 0},
+    {"shipper", 1, 2, NULL, 0},
+    {"rotator", 1, 2, NULL, 0}
+};
+
+static char g_stack[GROUP_NAME_SIZE / 2];
+static char g_logs[GROUP_NAME_SIZE];
+static unsigned long g_now_us = 1000;
+static group_ty *Join(size_t i)
+{
+    wd_group_policy_ty policy;
+    char member[GROUP_MEMBER_SIZE];
+
+    policy.name = g_members[i].in_logs ? g_logs : g_stack;
+    policy.strategy = g_members[i].in_logs ? WD_ONE_FOR_ONE : WD_REST_FOR_ONE;
+    policy.rank = g_members[i].rank;
+    policy.max_restarts = g_members[i].in_logs ? 2 : 0;
+    policy.window = 60;
+
+    sprintf(member, "%s.%d", g_members[i].name, (int)getpid());
+
+    return GroupJoin(&policy, member, getpid());
+}
+
+static group_action_ty Next(size_t i)
+{
+    return GroupNext(g_members[i].group, g_members[i].last_beat_us);
+}
+
+/* a bitmap of the members the last failure named */
+static unsigned int Named(void)
+{
+    unsigned int named = 0;
+    size_t i = 0;
+
+    for (i = 0; i < MEMBERS; ++i)
+    {
+        if (GROUP_STOP == Next(i))
+        {
+            named |= 1U << i;
+        }
+    }
+
+    return named;
+}
+
+static void Do(size_t i, group_action_ty action)
+{
+    GroupDone(g_members[i].group, action, ++g_now_us);
+}
+
+static void Beat(size_t i)
+{
+    g_members[i].last_beat_us = ++g_now_us;
+}
+
+/* the wd_apps run their steps until nobody is down, in rank order */
+static void Settle(void)
+{
+    size_t round = 0;
+    size_t i = 0;
+
+    for (round = 0; round < MEMBERS * 2; ++round)
+    {
+        for (i = 0; i < MEMBERS; ++i)
+        {
+            switch (Next(i))
+            {
+                case GROUP_STOP:
+                    Do(i, GROUP_STOP);
+                    break;
+                case GROUP_START:
+                    Do(i, GROUP_START);
+                    break;
+                case GROUP_STARTED:
+                    Beat(i);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+static void CheckStrategies(void)
+{
+    /* rest for one: the highest rank restarts alone */
+    Expect(0 == GroupFailed(g_members[PROXY].group, 100), "proxy depth");
+    Expect((1U << PROXY) == Named(), "proxy restarts alone");
+    Expect(0 == strcmp(g_stack, GroupActiveName(g_members[PROXY].group)),
+                                                            "proxy group");
+    Settle();
+
+    /* one for one in the subgroup */
+    Expect(0 == GroupFailed(g_members[ROTATOR].group, 101), "rotator depth");
+    Expect((1U << ROTATOR) == Named(), "rotator restarts alone");
+    Expect(0 == strcmp(g_logs, GroupActiveName(g_members[ROTATOR].group)),
+                                                            "rotator group");
+    Settle();
+}
+
+static void CheckOrder(void)
+{
+    size_t i = 0;
+
+    /* the cache takes the log shippers and the proxy, not the db */
+    Expect(0 == GroupFailed(g_members[CACHE].group, 102), "cache depth");
+    Expect(((1U << CACHE) | (1U << PROXY) | (1U << SHIPPER) |
+            (1U << ROTATOR)) == Named(), "cache restarts the rest");
+
+    /* every member named stops at once */
+    for (i = CACHE; i < MEMBERS; ++i)
+    {
+        Do(i, GROUP_STOP);
+    }
+
+    Expect(GROUP_START == Next(CACHE), "cache starts first");
+    Expect(GROUP_WAIT == Next(SHIPPER), "shipper waits for the cache");
+    Expect(GROUP_WAIT == Next(PROXY), "proxy waits for the cache");
+
+    Do(CACHE, GROUP_START);
+    Expect(GROUP_STARTED == Next(CACHE), "cache started");
+    Expect(GROUP_WAIT == Next(SHIPPER), "shipper waits for a beat");
+
+    Beat(CACHE);
+    Expect(GROUP_IDLE == Next(CACHE), "cache up");
+
+    /* the same rank in parallel */
+    Expect(GROUP_START == Next(SHIPPER), "shipper starts next");
+    Expect(GROUP_START == Next(ROTATOR), "rotator starts along");
+    Expect(GROUP_WAIT == Next(PROXY), "proxy waits for the shippers");
+
+    Do(SHIPPER, GROUP_START);
+    Do(ROTATOR, GROUP_START);
+    Beat(SHIPPER);
+    Expect(GROUP_WAIT == Next(PROXY), "proxy waits for the rotator");
+    Beat(ROTATOR);
+    Expect(GROUP_IDLE == Next(SHIPPER) && GROUP_IDLE == Next(ROTATOR),
+                                                            "shippers up");
+    Expect(GROUP_START == Next(PROXY), "proxy starts last");
+    Settle();
+
+    for (i = 0; i < MEMBERS; ++i)
+    {
+        Expect(GROUP_IDLE == Next(i), "all up");
+    }
+}
+
+static void CheckEscalation(void)
+{
+    /* the 2nd restart of the minute opens the breaker of the subgroup */
+    Expect(0 == GroupFailed(g_members[SHIPPER].group, 110), "1st shipper");
+    Expect((1U << SHIPPER) == Named(), "1st shipper restarts alone");
+    Settle();
+
+    /* the next one restarts the whole subgroup and the rest of the group
+       above, which decides it                                              */
+    Expect(1 == GroupFailed(g_members[SHIPPER].group, 111), "escalated");
+    Expect(((1U << SHIPPER) | (1U << ROTATOR) | (1U << PROXY)) == Named(),
+                                            "escalation restarts the group");
+    Expect(0 == strcmp(g_stack, GroupActiveName(g_members[SHIPPER].group)),
+                                                        "escalation group");
+    Settle();
+
+    /* and the subgroup starts afresh */
+    Expect(0 == GroupFailed(g_members[ROTATOR].group, 112), "afresh");
+    Settle();
+}
+
+static void CheckTopLimit(void)
+{
+    wd_group_policy_ty policy;
+    group_ty *group = NULL;
+    char name[GROUP_NAME_SIZE];
+
+    sprintf(name, "group_test_solo_%d", (int)getpid());
+    policy.name = name;
+    policy.strategy = WD_ONE_FOR_ONE;
+    policy.rank = 0;
+    policy.max_restarts = 1;
+    policy.window = 60;
+
+    group = GroupJoin(&policy, "solo", getpid());
+    Expect(NULL != group, "solo join");
+    if (NULL == group)
+    {
+        return;
+    }
+
+    Expect(0 == GroupFailed(group, 200), "solo 1st");
+    Expect(-1 == GroupFailed(group, 201), "solo postponed");
+    Expect(0 == GroupFailed(group, 261), "solo after the window");
+
+    GroupLeave(group);
+}
+
+static int PageExists(const char *name)
+{
+    char shm_name[GROUP_NAME_SIZE + sizeof(GROUP_PREFIX)];
+    int fd = -1;
+
+    sprintf(shm_name, "%s%s", GROUP_PREFIX, name);
+    fd = shm_open(shm_name, O_RDONLY, 0);
+    if (-1 != fd)
+    {
+        close(fd);
+    }
+
+    return (-1 != fd);
+}
+
+int main(void)
+{
+    wd_group_policy_ty policy;
+    char name[GROUP_NAME_SIZE];
+    size_t i = 0;
+
+    sprintf(g_stack, "group_test_%d", (int)getpid());
+    sprintf(g_logs, "%s.logs", g_stack);
+
+    /* a subgroup member first, the page of the stack gets its strategy later */
+    for (i = MEMBERS; i > 0; --i)
+    {
+        g_members[i - 1].group = Join(i - 1);
+        Expect(NULL != g_members[i - 1].group, "join");
+        if (NULL == g_members[i - 1].group)
+        {
+            return 1;
+        }
+    }
+
+    policy.name = "a.b.c.d.e";
+    Expect(0 != GroupPolicyExport(&policy), "too deep");
+    policy.name = g_logs;
+    policy.strategy = WD_REST_FOR_ONE;
+    policy.rank = 7;
+    policy.max_restarts = 3;
+    policy.window = 9;
+    Expect(0 == GroupPolicyExport(&policy) &&
+           0 == GroupPolicyImport(&policy, name) &&
+           0 == strcmp(g_logs, name) && WD_REST_FOR_ONE == policy.strategy &&
+           7 == policy.rank && 3 == policy.max_restarts && 9 == policy.window,
+                                                        "policy round trip");
+
+    CheckStrategies();
+    CheckOrder();
+    CheckEscalation();
+    CheckTopLimit();
+
+    for (i = 0; i < MEMBERS; ++i)
+    {
+        GroupLeave(g_members[i].group);
+    }
+    Expect(!PageExists(g_stack) && !PageExists(g_logs), "pages removed");
+
+    puts(0 == g_failed ? "PASS" : "FAIL");
+
+    return (0 != g_failed);
+}
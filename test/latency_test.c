@@ -0,0 +1,232 @@
+/*******************************************************************************
+ * Project:     Watchdog - request latency SLO test
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * checks the log-linear buckets of the histograms and their upper bounds,
+ * the percentile of a window taken from the cumulative snapshots, and that
+ * the threads beyond the owned slots count in the shared one while a
+ * thread that exits leaves its slot, and its counts, to the next one
+ * usage: ./latency_test.out
+*******************************************************************************/
+#define _GNU_SOURCE  /* pthread_barrier_t */
+
+#include <stdio.h>      /* printf, puts             */
+#include <limits.h>     /* ULONG_MAX                */
+#include <unistd.h>     /* getpid                   */
+#include <pthread.h>    /* pthread_create           */
+
+#include "wd_latency.h"
+
+#include "wd_expect.h"
+
+#define NAME "latency_test"
+#define FAST_NS 1000UL
+#define SLOW_NS 1000000UL
+
+enum {REQUESTS = 100, THREADS = 80, THREAD_REQUESTS = 1000, LATE = 10};
+
+static pthread_barrier_t g_barrier;
+
+static void CheckBuckets(void)
+{
+    unsigned long ns = 0;
+    unsigned long upper = 0;
+    size_t bucket = 0;
+    int is_good = 1;
+
+    for (ns = 0; ns < 4; ++ns)
+    {
+        is_good &= (ns == LatencyBucket(ns) &&
+                    ns == LatencyBucketUpperBound((size_t)ns));
+    }
+    Expect(is_good, "0 - 3 ns exact");
+
+    /* every bucket is used, and ends right where the next one starts */
+    is_good = 1;
+    for (bucket = 0; bucket < LATENCY_BUCKETS - 1; ++bucket)
+    {
+        upper = LatencyBucketUpperBound(bucket);
+        is_good &= (bucket == LatencyBucket(upper) &&
+                    bucket + 1 == LatencyBucket(upper + 1) &&
+                    upper < LatencyBucketUpperBound(bucket + 1));
+    }
+    Expect(is_good, "buckets adjacent");
+
+    /* the bound overstates a latency by less than a quarter of it */
+    is_good = 1;
+    for (ns = 4; ns < (1UL << 41); ns = ns * 3 / 2 + 1)
+    {
+        upper = LatencyBucketUpperBound(LatencyBucket(ns));
+        is_good &= (ns <= upper && 4 * (upper - ns) < ns);
+    }
+    Expect(is_good, "precision 25%");
+
+    Expect(LATENCY_BUCKETS - 1 == LatencyBucket(7UL << 38) &&
+           LATENCY_BUCKETS - 2 == LatencyBucket((7UL << 38) - 1),
+           "last bucket starts at 7 * 2^38");
+    Expect(LATENCY_BUCKETS - 1 == LatencyBucket(1UL << 41) &&
+           LATENCY_BUCKETS - 1 == LatencyBucket(ULONG_MAX), "overflow");
+}
+
+static void Record(unsigned long ns, size_t cnt)
+{
+    size_t i = 0;
+
+    for (i = 0; i < cnt; ++i)
+    {
+        WDRecordLatency(ns);
+    }
+}
+
+static void CheckWindow(latency_ty *latency)
+{
+    wd_latency_policy_ty policy = {10 * FAST_NS, 75, 0, 2 * REQUESTS};
+    unsigned long fast = LatencyBucketUpperBound(LatencyBucket(FAST_NS));
+    unsigned long slow = LatencyBucketUpperBound(LatencyBucket(SLOW_NS));
+
+    Expect(0 == LatencyEvaluate(latency, &policy, 2) &&
+           0 == latency->last_count && 0 == latency->last_pct_ns, "empty");
+
+    /* a window of 2 goes back 2 snapshots */
+    Record(FAST_NS, REQUESTS);
+    Expect(0 == LatencyEvaluate(latency, &policy, 2) &&
+           REQUESTS == latency->last_count && fast == latency->last_pct_ns,
+           "fast requests");
+
+    Record(SLOW_NS, REQUESTS);
+    policy.min_count = 2 * REQUESTS + 1;
+    Expect(0 == LatencyEvaluate(latency, &policy, 2) &&
+           2 * REQUESTS == latency->last_count &&
+           slow == latency->last_pct_ns, "too few to judge");
+
+    Record(FAST_NS, REQUESTS);
+    policy.min_count = 2 * REQUESTS;
+    Expect(1 == LatencyEvaluate(latency, &policy, 2) &&
+           2 * REQUESTS == latency->last_count &&
+           slow == latency->last_pct_ns, "violated");
+
+    /* the slow requests left the window */
+    Expect(0 == LatencyEvaluate(latency, &policy, 2) &&
+           REQUESTS == latency->last_count && fast == latency->last_pct_ns,
+           "slow ones forgotten");
+
+    policy.percentile = 50;
+    Record(SLOW_NS, REQUESTS);
+    Record(FAST_NS, REQUESTS);
+    Expect(0 == LatencyEvaluate(latency, &policy, 1) &&
+           fast == latency->last_pct_ns, "median");
+}
+
+static void *RecordThread(void *arg)
+{
+    (void)arg;
+
+    WDRecordLatency(FAST_NS);
+    pthread_barrier_wait(&g_barrier);
+    Record(FAST_NS, THREAD_REQUESTS - 1);
+    pthread_barrier_wait(&g_barrier);
+
+    return NULL;
+}
+
+static void *LateThread(void *arg)
+{
+    (void)arg;
+
+    Record(SLOW_NS, THREAD_REQUESTS);
+
+    return NULL;
+}
+
+static unsigned long SlotCount(const latency_slot_ty *slot)
+{
+    unsigned long cnt = 0;
+    size_t i = 0;
+
+    for (i = 0; i < LATENCY_BUCKETS; ++i)
+    {
+        cnt += slot->hist[i];
+    }
+
+    return cnt;
+}
+
+static size_t FreeSlots(const latency_page_ty *page)
+{
+    size_t cnt = 0;
+    size_t i = 0;
+
+    for (i = 0; i < LATENCY_SLOTS - 1; ++i)
+    {
+        cnt += (0 == page->slots[i].owner);
+    }
+
+    return cnt;
+}
+
+static void CheckSlots(latency_ty *latency)
+{
+    wd_latency_policy_ty policy = {10 * FAST_NS, 50, 0, 1};
+    const latency_slot_ty *shared = latency->page->slots + LATENCY_SLOTS - 1;
+    pthread_t threads[THREADS];
+    unsigned long shared_cnt = 0;
+    size_t i = 0;
+
+    /* the main thread owns a slot already, THREADS alive at once */
+    pthread_barrier_init(&g_barrier, NULL, THREADS);
+    for (i = 0; i < THREADS; ++i)
+    {
+        pthread_create(threads + i, NULL, RecordThread, NULL);
+    }
+    for (i = 0; i < THREADS; ++i)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_barrier_destroy(&g_barrier);
+
+    shared_cnt = SlotCount(shared);
+    LatencyEvaluate(latency, &policy, 1);
+    Expect(THREADS * THREAD_REQUESTS == latency->last_count,
+           "no record lost");
+    Expect(0 != shared->owner && (THREADS - (LATENCY_SLOTS - 2)) *
+           THREAD_REQUESTS == shared_cnt, "the rest share the last slot");
+    Expect(LATENCY_SLOTS - 2 == FreeSlots(latency->page),
+           "slots freed on exit");
+
+    /* the next threads take the freed slots and go on counting */
+    for (i = 0; i < LATE; ++i)
+    {
+        pthread_create(threads + i, NULL, LateThread, NULL);
+        pthread_join(threads[i], NULL);
+    }
+    Expect(1 == LatencyEvaluate(latency, &policy, 1) &&
+           LATE * THREAD_REQUESTS == latency->last_count,
+           "freed slots keep their counts");
+    Expect(shared_cnt == SlotCount(shared), "freed slots reused");
+}
+
+int main(void)
+{
+    latency_ty latency;
+
+    CheckBuckets();
+
+    LatencyInit(&latency);
+    if (0 != LatencyCreate(NAME) ||
+        0 != LatencyAttach(&latency, NAME, getpid()))
+    {
+        puts("FAIL");
+        return 1;
+    }
+
+    CheckWindow(&latency);
+    CheckSlots(&latency);
+
+    LatencyDetach(&latency);
+    LatencyUnlink(NAME, getpid());
+
+    puts(0 == g_failed ? "PASS" : "FAIL");
+
+    return (0 != g_failed);
+}
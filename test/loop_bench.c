@@ -0,0 +1,243 @@
+/*******************************************************************************
+ * Project:     Watchdog - event loop benchmark
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * runs idle pairs with every event loop of wd_app and every signal mode,
+ * traces the wd_app of each pair for a while and reports the system calls
+ * it makes per second, all of them and those that wait
+ * usage: ./loop_bench.out [pairs] [seconds]
+ * note: run from the directory of wd_app, the tracing needs ptrace rights
+ *       over the own processes (kernel.yama.ptrace_scope 0, or root)
+*******************************************************************************/
+#define _GNU_SOURCE  /* PTRACE_GET_SYSCALL_INFO */
+
+#include <stdio.h>          /* printf, fopen            */
+#include <stdlib.h>         /* atoi                     */
+#include <string.h>         /* strcmp                   */
+#include <signal.h>         /* kill, SIGINT             */
+#include <unistd.h>         /* fork, execl, pause       */
+#include <time.h>           /* time                     */
+#include <dirent.h>         /* opendir, readdir         */
+#include <sys/ptrace.h>     /* ptrace                   */
+#include <sys/syscall.h>    /* SYS_io_uring_enter       */
+#include <sys/wait.h>       /* waitpid                  */
+
+#include "watchdog.h"
+
+enum {DEFAULT_PAIRS = 2, MAX_PAIRS = 16, DEFAULT_SECONDS = 5,
+      SETTLE_SECONDS = 3, INTERVAL = 1, MAX_MISSES = 3};
+
+typedef struct counts
+{
+    size_t all;
+    size_t waits;
+}counts_ty;
+
+static volatile sig_atomic_t g_quit = 0;
+
+static void OnInterrupt(int sig)
+{
+    (void)sig;
+    g_quit = 1;
+}
+
+/* argv: app <event loop> <signal mode>, a revival gets the same */
+static int App(int argc, char *argv[])
+{
+    struct sigaction sa;
+
+    sa.sa_handler = OnInterrupt;
+    sa.sa_flags = 0;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+
+    WDSetEventLoop((wd_event_loop_ty)atoi(argv[2]));
+    WDSetSignalMode((wd_signal_mode_ty)atoi(argv[3]));
+
+    if (0 != MakeMeImmortal(argc, argv, INTERVAL, MAX_MISSES))
+    {
+        return 1;
+    }
+
+    while (!g_quit)
+    {
+        pause();
+    }
+
+    DoNotResuscitate();
+
+    return 0;
+}
+
+/* wd_app is the only child of the app, of one of its threads */
+static pid_t FindWdApp(pid_t app)
+{
+    char path[64];
+    struct dirent *task = NULL;
+    DIR *tasks = NULL;
+    FILE *file = NULL;
+    int pid = 0;
+
+    sprintf(path, "/proc/%d/task", (int)app);
+    tasks = opendir(path);
+    while (NULL != tasks && 0 == pid && NULL != (task = readdir(tasks)))
+    {
+        sprintf(path, "/proc/%d/task/%.16s/children", (int)app, task->d_name);
+        file = fopen(path, "r");
+        if (NULL != file)
+        {
+            if (1 != fscanf(file, "%d", &pid))
+            {
+                pid = 0;
+            }
+            fclose(file);
+        }
+    }
+    if (NULL != tasks)
+    {
+        closedir(tasks);
+    }
+
+    return (pid_t)pid;
+}
+
+static int IsWait(unsigned long nr)
+{
+    return (SYS_io_uring_enter == nr || SYS_ppoll == nr ||
+#ifdef SYS_poll
+            SYS_poll == nr ||
+#endif
+            SYS_clock_nanosleep == nr || SYS_nanosleep == nr);
+}
+
+/* the system calls "pid" enters within "seconds", 1 if it can't be traced */
+static int Trace(pid_t pid, size_t seconds, counts_ty *counts)
+{
+    struct __ptrace_syscall_info info;
+    time_t end = time(NULL) + (time_t)seconds;
+    int status = 0;
+    int sig = 0;
+
+    counts->all = 0;
+    counts->waits = 0;
+
+    if (0 != ptrace(PTRACE_SEIZE, pid, 0, PTRACE_O_TRACESYSGOOD))
+    {
+        return 1;
+    }
+    ptrace(PTRACE_INTERRUPT, pid, 0, 0);
+
+    /* a wait of wd_app ends in a second, when the time is checked again */
+    while (time(NULL) < end && pid == waitpid(pid, &status, __WALL))
+    {
+        if (!WIFSTOPPED(status))
+        {
+            return 1;
+        }
+
+        sig = WSTOPSIG(status);
+        if ((SIGTRAP | 0x80) == sig)
+        {
+            sig = 0;
+            if (0 < ptrace(PTRACE_GET_SYSCALL_INFO, pid, sizeof(info), &info) &&
+                PTRACE_SYSCALL_INFO_ENTRY == info.op)
+            {
+                ++counts->all;
+                counts->waits += IsWait(info.entry.nr);
+            }
+        }
+        else if (PTRACE_EVENT_STOP == (status >> 16))
+        {
+            sig = 0;
+        }
+        ptrace(PTRACE_SYSCALL, pid, 0, sig);
+    }
+
+    ptrace(PTRACE_INTERRUPT, pid, 0, 0);
+    waitpid(pid, &status, __WALL);
+    ptrace(PTRACE_DETACH, pid, 0, 0);
+
+    return 0;
+}
+
+static void Run(const char *self, wd_event_loop_ty loop, wd_signal_mode_ty mode,
+                size_t pairs, size_t seconds)
+{
+    static const char *loops[] = {"auto", "poll"};
+    static const char *modes[] = {"handlers", "signalfd"};
+    pid_t apps[MAX_PAIRS];
+    char loop_arg[4];
+    char mode_arg[4];
+    counts_ty counts;
+    counts_ty sum = {0, 0};
+    size_t traced = 0;
+    size_t i = 0;
+
+    sprintf(loop_arg, "%d", (int)loop);
+    sprintf(mode_arg, "%d", (int)mode);
+
+    for (i = 0; i < pairs; ++i)
+    {
+        apps[i] = fork();
+        if (0 == apps[i])
+        {
+            execl(self, self, "app", loop_arg, mode_arg, (char *)NULL);
+            _exit(1);
+        }
+    }
+    sleep(SETTLE_SECONDS);
+
+    for (i = 0; i < pairs; ++i)
+    {
+        if (0 == Trace(FindWdApp(apps[i]), seconds, &counts))
+        {
+            sum.all += counts.all;
+            sum.waits += counts.waits;
+            ++traced;
+        }
+    }
+
+    if (0 == traced)
+    {
+        printf("%-6s %-10s could not trace wd_app\n", loops[loop], modes[mode]);
+    }
+    else
+    {
+        printf("%-6s %-10s %12.2f %12.2f\n", loops[loop], modes[mode],
+                            (double)sum.all / (double)(traced * seconds),
+                            (double)sum.waits / (double)(traced * seconds));
+    }
+
+    for (i = 0; i < pairs; ++i)
+    {
+        kill(apps[i], SIGINT);
+        waitpid(apps[i], NULL, 0);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t pairs = (1 < argc) ? (size_t)atoi(argv[1]) : DEFAULT_PAIRS;
+    size_t seconds = (2 < argc) ? (size_t)atoi(argv[2]) : DEFAULT_SECONDS;
+
+    if (1 < argc && 0 == strcmp("app", argv[1]))
+    {
+        return App(argc, argv);
+    }
+
+    pairs = (0 == pairs || MAX_PAIRS < pairs) ? DEFAULT_PAIRS : pairs;
+    seconds = (0 == seconds) ? DEFAULT_SECONDS : seconds;
+
+    printf("%lu idle pairs, interval %d s, per wd_app:\n",
+                                        (unsigned long)pairs, INTERVAL);
+    printf("%-6s %-10s %12s %12s\n", "loop", "signals", "syscalls/s",
+                                                                "waits/s");
+
+    Run(argv[0], WD_LOOP_AUTO, WD_SIGNAL_HANDLERS, pairs, seconds);
+    Run(argv[0], WD_LOOP_POLL, WD_SIGNAL_HANDLERS, pairs, seconds);
+    Run(argv[0], WD_LOOP_AUTO, WD_SIGNAL_FD, pairs, seconds);
+    Run(argv[0], WD_LOOP_POLL, WD_SIGNAL_FD, pairs, seconds);
+
+    return 0;
+}
@@ -0,0 +1,206 @@
+/*******************************************************************************
+ * Project:     Watchdog - memory growth checks test
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * feeds the checks the usage of a file standing in for memory.current and
+ * checks the least squares trend and the time it leaves until the limit:
+ * exact on a steady growth, close on a noisy one, none on a flat or a
+ * shrinking usage, the samples that leave the window, the limit itself,
+ * and an attach that fails
+ * usage: ./memory_test.out
+*******************************************************************************/
+#include <stdio.h>      /* printf, puts, tmpfile    */
+#include <string.h>     /* strlen                   */
+#include <unistd.h>     /* pwrite, ftruncate        */
+
+#include "wd_memory.h"
+
+#include "wd_expect.h"
+
+#define MB (1024UL * 1024UL)
+
+enum {LIMIT_MB = 100, START_MB = 50};
+
+static FILE *g_file = NULL;
+
+/* a fresh usage of "mb", as memory.current shows it */
+static void SetUsage(double mb)
+{
+    char text[32];
+
+    sprintf(text, "%lu\n", (unsigned long)(mb * MB));
+    if (0 != ftruncate(fileno(g_file), 0) ||
+        (ssize_t)strlen(text) != pwrite(fileno(g_file), text, strlen(text), 0))
+    {
+        Expect(0, "write usage");
+    }
+}
+
+static void Reset(memory_ty *memory, wd_memory_policy_ty *policy,
+                  size_t horizon, size_t window)
+{
+    policy->limit_mb = LIMIT_MB;
+    policy->horizon = horizon;
+    policy->window = window;
+    policy->use_pss = 0;
+    policy->use_cgroup = 1;
+
+    MemoryInit(memory);
+    memory->pid = getpid();
+    memory->fd = fileno(g_file);
+    memory->limit = LIMIT_MB * MB;
+}
+
+static memory_verdict_ty Sample(memory_ty *memory,
+                                const wd_memory_policy_ty *policy,
+                                double mb, time_t now)
+{
+    SetUsage(mb);
+
+    return MemorySample(memory, policy, now);
+}
+
+static void CheckSteady(void)
+{
+    wd_memory_policy_ty policy;
+    memory_ty memory;
+    time_t t = 0;
+    int is_good = 1;
+
+    /* 1 MB/s: at 54 MB the limit is 46 s away */
+    Reset(&memory, &policy, 45, 0);
+    for (t = 0; t < MEMORY_MIN_SAMPLES - 1; ++t)
+    {
+        is_good &= (MEMORY_OK == Sample(&memory, &policy, START_MB + t, t) &&
+                    -1 == memory.eta);
+    }
+    Expect(is_good, "no trend before MEMORY_MIN_SAMPLES");
+
+    Expect(MEMORY_OK == Sample(&memory, &policy, START_MB + t, t) &&
+           46 == memory.eta, "eta beyond the horizon");
+    ++t;
+    Expect(MEMORY_TREND == Sample(&memory, &policy, START_MB + t, t) &&
+           45 == memory.eta, "eta within the horizon");
+    Expect((unsigned long)(START_MB + t) * MB == memory.last_bytes,
+           "last usage");
+}
+
+static void CheckNoisy(void)
+{
+    wd_memory_policy_ty policy;
+    memory_ty memory;
+    double mb = 0;
+    long eta = 0;
+    time_t t = 0;
+
+    /* 2 MB/s, 1 MB above and below the line in turn */
+    Reset(&memory, &policy, 10, 0);
+    for (t = 0; t < 10; ++t)
+    {
+        mb = START_MB + 2.0 * t + ((t % 2) ? 1 : -1);
+        Sample(&memory, &policy, mb, t);
+    }
+
+    eta = (long)((LIMIT_MB - mb) / 2);
+    Expect(eta * 9 / 10 <= memory.eta && memory.eta <= eta * 11 / 10,
+           "noisy growth");
+}
+
+static void CheckNoGrowth(void)
+{
+    wd_memory_policy_ty policy;
+    memory_ty memory;
+    time_t t = 0;
+    int is_good = 1;
+
+    Reset(&memory, &policy, 1000, 0);
+    for (t = 0; t < 10; ++t)
+    {
+        is_good &= (MEMORY_OK == Sample(&memory, &policy, START_MB, t));
+    }
+    Expect(is_good && -1 == memory.eta, "flat");
+
+    is_good = 1;
+    Reset(&memory, &policy, 1000, 0);
+    for (t = 0; t < 10; ++t)
+    {
+        is_good &= (MEMORY_OK == Sample(&memory, &policy, START_MB - t, t));
+    }
+    Expect(is_good && -1 == memory.eta, "shrinking");
+}
+
+static void CheckWindow(void)
+{
+    wd_memory_policy_ty policy;
+    memory_ty memory;
+    time_t t = 0;
+
+    /* 5 MB/s, then flat: once the climb left the window there is no trend */
+    Reset(&memory, &policy, 10, 10);
+    for (t = 0; t < 4; ++t)
+    {
+        Sample(&memory, &policy, START_MB + 5 * t, t);
+    }
+    Expect(MEMORY_TREND == Sample(&memory, &policy, START_MB + 5 * t, t) &&
+           6 == memory.eta, "climb");
+
+    for (++t; t < 14; ++t)
+    {
+        Sample(&memory, &policy, START_MB + 20, t);
+    }
+    Expect(0 < memory.eta, "climb still in the window");
+
+    for (; t < 20; ++t)
+    {
+        Sample(&memory, &policy, START_MB + 20, t);
+    }
+    Expect(-1 == memory.eta && 11 == memory.cnt, "climb left the window");
+
+    Reset(&memory, &policy, 10, 0);
+    for (t = 0; t < 2 * MEMORY_SAMPLES; ++t)
+    {
+        Sample(&memory, &policy, START_MB, t);
+    }
+    Expect(MEMORY_SAMPLES == memory.cnt, "MEMORY_SAMPLES at most");
+}
+
+static void CheckLimit(void)
+{
+    wd_memory_policy_ty policy;
+    memory_ty memory;
+
+    Reset(&memory, &policy, 10, 0);
+    Expect(MEMORY_OVER_LIMIT == Sample(&memory, &policy, LIMIT_MB, 0) &&
+           0 == memory.eta, "over the limit");
+
+    /* no limit and no cgroup: nothing to check against */
+    policy.limit_mb = 0;
+    policy.use_cgroup = 0;
+    MemoryInit(&memory);
+    Expect(0 != MemoryAttach(&memory, getpid(), &policy) &&
+           -1 == memory.fd && 0 == memory.pid, "attach fails");
+    Expect(MEMORY_OK == MemorySample(&memory, &policy, 0), "detached");
+}
+
+int main(void)
+{
+    g_file = tmpfile();
+    if (NULL == g_file)
+    {
+        puts("FAIL");
+        return 1;
+    }
+
+    CheckSteady();
+    CheckNoisy();
+    CheckNoGrowth();
+    CheckWindow();
+    CheckLimit();
+
+    fclose(g_file);
+
+    puts(0 == g_failed ? "PASS" : "FAIL");
+
+    return (0 != g_failed);
+}
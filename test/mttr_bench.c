@@ -0,0 +1,513 @@
+/*******************************************************************************
+ * Project:     Watchdog - recovery time benchmark
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * injects faults into an immortal test app and measures, from the fault:
+ * - detect:  until the watchdog revives the peer (LOG_REVIVED in the ring)
+ * - respawn: from there until the new instance is ready
+ * - ready:   the whole recovery, the app left MakeMeImmortal() again or the
+ *            new wd_app sent its first beat
+ * faults: SIGKILL of the app, SIGKILL of wd_app, SIGSTOP of the app and an
+ * endless loop of the app (caught by the progress check)
+ * every pair of interval and max_misses also reports the CPU the watchdog
+ * costs an idle app, its thread and wd_app together
+ * usage: ./mttr_bench.out [trials] [intervals] [max_misses]
+ *        e.g. ./mttr_bench.out 5 1,2,5 2,3
+ * note: run from the directory of wd_app
+*******************************************************************************/
+#define _GNU_SOURCE  /* setenv, clock_getcpuclockid */
+
+#include <stdio.h>      /* printf           */
+#include <stdlib.h>     /* atoi, qsort      */
+#include <string.h>     /* strcmp, strtok   */
+#include <errno.h>      /* errno            */
+#include <signal.h>     /* kill, sigaction  */
+#include <unistd.h>     /* fork, execl      */
+#include <fcntl.h>      /* open             */
+#include <poll.h>       /* poll             */
+#include <time.h>       /* clock_gettime    */
+#include <sys/mman.h>   /* shm_open, mmap   */
+#include <sys/socket.h> /* socket           */
+#include <sys/un.h>     /* sockaddr_un      */
+#include <sys/wait.h>   /* waitpid          */
+
+#include "watchdog.h"
+#include "wd_log.h"
+
+enum {DEFAULT_TRIALS = 3, MAX_TRIALS = 100, MAX_SWEEP = 8, NAME_SIZE = 64,
+      IDLE_SECONDS = 5, SPIN_TIME = 2, SPIN_PCT = 80, IO_PERIOD_MS = 100,
+      SLACK_SECONDS = 15, NSEC_PER_MSEC = 1000000};
+
+typedef enum fault
+{
+    FAULT_APP_KILL,
+    FAULT_WD_KILL,
+    FAULT_APP_STOP,
+    FAULT_APP_LOOP,
+    FAULTS_CNT
+}fault_ty;
+
+static const char *g_fault_names[FAULTS_CNT] =
+{
+    "app SIGKILL", "wd_app SIGKILL", "app SIGSTOP", "app loop"
+};
+
+/* what a ready app tells the benchmark */
+typedef struct report
+{
+    pid_t pid;
+    unsigned long time_ns;
+}report_ty;
+
+typedef struct pair
+{
+    char name[NAME_SIZE];
+    const log_ring_ty *ring;
+    int sock;
+    pid_t app;
+    pid_t wd_app;
+}pair_ty;
+
+static volatile sig_atomic_t g_quit = 0;
+static volatile sig_atomic_t g_spin = 0;
+
+static unsigned long NowNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (unsigned long)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int Compare(const void *a, const void *b)
+{
+    double diff = *(const double *)a - *(const double *)b;
+
+    return (diff > 0) - (diff < 0);
+}
+
+/******************************* the test app *********************************/
+
+static void OnInterrupt(int sig)
+{
+    (void)sig;
+    g_quit = 1;
+}
+
+static void OnAlarm(int sig)
+{
+    (void)sig;
+    g_spin = 1;
+}
+
+/* argv: app <socket path> <interval> <max_misses>, a revival gets the same */
+static int App(int argc, char *argv[])
+{
+    wd_restart_policy_ty restart = {0, 0, 0, 0, 60, 1};
+    wd_progress_policy_ty progress = {0, SPIN_TIME, SPIN_PCT};
+    struct timespec nap = {0, IO_PERIOD_MS * NSEC_PER_MSEC};
+    struct sigaction sa;
+    struct sockaddr_un addr;
+    report_ty report;
+    int sock = -1;
+    int devnull = -1;
+
+    /* SIGTERM is left alone, the watchdog uses it to stop a hung instance */
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = OnInterrupt;
+    sigaction(SIGINT, &sa, NULL);
+    sa.sa_handler = OnAlarm;
+    sigaction(SIGALRM, &sa, NULL);
+
+    /* every fault is restarted at once, the breaker stays out of the way */
+    WDSetRestartPolicy(&restart);
+    WDSetProgressPolicy(&progress);
+
+    if (0 != MakeMeImmortal(argc, argv, (size_t)atoi(argv[3]),
+                                        (size_t)atoi(argv[4])))
+    {
+        return 1;
+    }
+
+    report.pid = getpid();
+    report.time_ns = NowNs();
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, argv[2], sizeof(addr.sun_path) - 1);
+
+    sock = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    sendto(sock, &report, sizeof(report), 0, (struct sockaddr *)&addr,
+                                                            sizeof(addr));
+    close(sock);
+
+    /* a little I/O now and then is the progress of a healthy app */
+    devnull = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    while (!g_quit)
+    {
+        if (g_spin)
+        {
+            continue;
+        }
+        if (1 != write(devnull, "", 1))
+        {
+            break;
+        }
+        nanosleep(&nap, NULL);
+    }
+    close(devnull);
+
+    DoNotResuscitate();
+
+    return 0;
+}
+
+/***************************** the benchmark **********************************/
+
+static void Reap(void)
+{
+    while (0 < waitpid(-1, NULL, WNOHANG))
+    {
+    }
+}
+
+/* the next app that reports ready, other than "old", until "deadline_ns" */
+static int WaitReady(pair_ty *pair, pid_t old, unsigned long deadline_ns,
+                     report_ty *report)
+{
+    struct pollfd pfd;
+    unsigned long now = 0;
+
+    pfd.fd = pair->sock;
+    pfd.events = POLLIN;
+
+    while ((now = NowNs()) < deadline_ns)
+    {
+        Reap();
+        if (0 < poll(&pfd, 1, 10) &&
+            sizeof(*report) == recv(pair->sock, report, sizeof(*report), 0) &&
+            old != report->pid)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* the time of the latest "event" since "since_ns", not logged by "not_pid"
+   and with "arg1" unless it is 0, the time is 0 if there is none          */
+static unsigned long FindEvent(const pair_ty *pair, log_event_ty event,
+                               unsigned long since_ns, pid_t not_pid,
+                               pid_t arg1, log_record_ty *found)
+{
+    unsigned long head = __atomic_load_n(&pair->ring->head, __ATOMIC_ACQUIRE);
+    unsigned long index = (head > LOG_RECORDS) ? head - LOG_RECORDS : 0;
+    log_record_ty record;
+    unsigned long time_ns = 0;
+
+    for (; index < head; ++index)
+    {
+        if (0 == LogReadRecord(pair->ring, index, &record) &&
+            event == record.event && since_ns <= record.time_ns &&
+            not_pid != (pid_t)record.pid &&
+            (0 == arg1 || arg1 == (pid_t)record.arg1))
+        {
+            time_ns = record.time_ns;
+            *found = record;
+        }
+    }
+
+    return time_ns;
+}
+
+static pid_t FindWdApp(const pair_ty *pair)
+{
+    log_record_ty record;
+
+    if (0 == FindEvent(pair, LOG_WD_APP_STARTED, 0, 0, pair->app, &record))
+    {
+        return 0;
+    }
+
+    return (pid_t)record.arg0;
+}
+
+static int OpenRing(pair_ty *pair)
+{
+    char shm_name[NAME_SIZE + sizeof(LOG_PREFIX)];
+    void *ring = NULL;
+    int fd = -1;
+
+    sprintf(shm_name, "%s%s", LOG_PREFIX, pair->name);
+    fd = shm_open(shm_name, O_RDONLY, 0);
+    if (-1 == fd)
+    {
+        return 1;
+    }
+
+    ring = mmap(NULL, sizeof(log_ring_ty), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == ring)
+    {
+        return 1;
+    }
+    pair->ring = (const log_ring_ty *)ring;
+
+    return 0;
+}
+
+static int StartPair(pair_ty *pair, char *argv0, const char *sock_path,
+                     size_t interval, size_t max_misses)
+{
+    char interval_str[16];
+    char misses_str[16];
+    report_ty report;
+    pid_t pid = 0;
+
+    sprintf(pair->name, "mttr_bench.%d.%lux%lu", (int)getpid(),
+            (unsigned long)interval, (unsigned long)max_misses);
+    sprintf(interval_str, "%lu", (unsigned long)interval);
+    sprintf(misses_str, "%lu", (unsigned long)max_misses);
+
+    setenv("WD_NAME", pair->name, 1);
+
+    pid = fork();
+    if (0 == pid)
+    {
+        execl(argv0, argv0, "app", sock_path, interval_str, misses_str,
+                                                            (char *)NULL);
+        _exit(1);
+    }
+    if (-1 == pid ||
+        0 != WaitReady(pair, 0, NowNs() + SLACK_SECONDS * 1000000000UL,
+                                                                    &report))
+    {
+        return 1;
+    }
+
+    pair->app = report.pid;
+    if (0 != OpenRing(pair))
+    {
+        return 1;
+    }
+    pair->wd_app = FindWdApp(pair);
+
+    return (0 == pair->wd_app);
+}
+
+static void StopPair(pair_ty *pair)
+{
+    size_t i = 0;
+
+    kill(pair->app, SIGINT);
+    for (i = 0; i < 500 && (0 == kill(pair->app, 0) ||
+                            0 == kill(pair->wd_app, 0)); ++i)
+    {
+        Reap();
+        usleep(10000);
+    }
+
+    munmap((void *)pair->ring, sizeof(log_ring_ty));
+    LogUnlink(pair->name);
+}
+
+/* CPU of the app and wd_app together, the app itself is idle */
+static unsigned long CpuNs(const pair_ty *pair)
+{
+    clockid_t clock = 0;
+    struct timespec ts;
+    unsigned long total = 0;
+
+    if (0 == clock_getcpuclockid(pair->app, &clock) &&
+        0 == clock_gettime(clock, &ts))
+    {
+        total += (unsigned long)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    }
+    if (0 == clock_getcpuclockid(pair->wd_app, &clock) &&
+        0 == clock_gettime(clock, &ts))
+    {
+        total += (unsigned long)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    }
+
+    return total;
+}
+
+/* injects "fault", fills the times in ms, returns 0 once recovered */
+static int Trial(pair_ty *pair, fault_ty fault, unsigned long budget_ns,
+                 double *detect, double *ready)
+{
+    static const int signals[FAULTS_CNT] = {SIGKILL, SIGKILL, SIGSTOP, SIGALRM};
+    log_record_ty record;
+    report_ty report;
+    unsigned long fault_ns = NowNs();
+    unsigned long deadline_ns = fault_ns + budget_ns;
+    unsigned long ready_ns = 0;
+    unsigned long detect_ns = 0;
+    pid_t old_wd_app = pair->wd_app;
+
+    kill((FAULT_WD_KILL == fault) ? pair->wd_app : pair->app, signals[fault]);
+
+    if (FAULT_WD_KILL == fault)
+    {
+        /* wd_app is ready once it beats the app */
+        while ((0 == (ready_ns = FindEvent(pair, LOG_BEAT_SENT, fault_ns,
+                                                    pair->app, 0, &record)) ||
+                old_wd_app == (pid_t)record.pid) && NowNs() < deadline_ns)
+        {
+            ready_ns = 0;
+            Reap();
+            usleep(1000);
+        }
+        if (0 == ready_ns)
+        {
+            return 1;
+        }
+        pair->wd_app = (pid_t)record.pid;
+    }
+    else
+    {
+        if (0 != WaitReady(pair, pair->app, deadline_ns, &report))
+        {
+            return 1;
+        }
+        ready_ns = report.time_ns;
+        pair->app = report.pid;
+    }
+
+    detect_ns = FindEvent(pair, LOG_REVIVED, fault_ns, 0, 0, &record);
+
+    *detect = (double)(detect_ns - fault_ns) / NSEC_PER_MSEC;
+    *ready = (double)(ready_ns - fault_ns) / NSEC_PER_MSEC;
+
+    return (0 == detect_ns);
+}
+
+static void PrintDist(double *samples, size_t cnt)
+{
+    qsort(samples, cnt, sizeof(samples[0]), Compare);
+    printf(" %8.1f %8.1f", samples[cnt / 2], samples[cnt - 1]);
+}
+
+static size_t ParseList(char *str, size_t *list)
+{
+    size_t cnt = 0;
+    char *token = strtok(str, ",");
+
+    for (; NULL != token && MAX_SWEEP > cnt; token = strtok(NULL, ","))
+    {
+        if (0 < atoi(token))
+        {
+            list[cnt++] = (size_t)atoi(token);
+        }
+    }
+
+    return cnt;
+}
+
+int main(int argc, char *argv[])
+{
+    static double detect[MAX_TRIALS];
+    static double respawn[MAX_TRIALS];
+    static double ready[MAX_TRIALS];
+    char default_intervals[] = "1";
+    char default_misses[] = "2,3";
+    size_t intervals[MAX_SWEEP];
+    size_t misses[MAX_SWEEP];
+    size_t trials = (argc > 1) ? (size_t)atoi(argv[1]) : DEFAULT_TRIALS;
+    size_t intervals_cnt = ParseList((argc > 2) ? argv[2] : default_intervals,
+                                                                    intervals);
+    size_t misses_cnt = ParseList((argc > 3) ? argv[3] : default_misses, misses);
+    struct sockaddr_un addr;
+    unsigned long cpu_ns = 0;
+    unsigned long budget_ns = 0;
+    double cpu_pct = 0;
+    pair_ty pair;
+    size_t i = 0;
+    size_t m = 0;
+    size_t t = 0;
+    int f = 0;
+
+    if (argc > 4 && 0 == strcmp(argv[1], "app"))
+    {
+        return App(argc, argv);
+    }
+
+    trials = (MAX_TRIALS < trials) ? MAX_TRIALS : trials;
+    trials = (0 == trials) ? 1 : trials;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    sprintf(addr.sun_path, "/tmp/mttr_bench.%d.sock", (int)getpid());
+
+    memset(&pair, 0, sizeof(pair));
+    pair.sock = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (-1 == pair.sock ||
+        0 != bind(pair.sock, (struct sockaddr *)&addr, sizeof(addr)))
+    {
+        perror("socket");
+        return 1;
+    }
+
+    printf("%8s %6s %-15s %6s %17s %17s %17s %8s\n", "interval", "misses",
+           "fault", "trials", "detect p50/max", "respawn p50/max",
+           "ready p50/max", "cpu[%]");
+
+    for (i = 0; i < intervals_cnt; ++i)
+    {
+        for (m = 0; m < misses_cnt; ++m)
+        {
+            if (0 != StartPair(&pair, argv[0], addr.sun_path, intervals[i],
+                                                                misses[m]))
+            {
+                fprintf(stderr, "the test app did not start\n");
+                unlink(addr.sun_path);
+                return 1;
+            }
+
+            cpu_ns = CpuNs(&pair);
+            sleep(IDLE_SECONDS);
+            cpu_pct = (double)(CpuNs(&pair) - cpu_ns) / 1e7 / IDLE_SECONDS;
+
+            budget_ns = (intervals[i] * (misses[m] + 1) + SPIN_TIME +
+                                        SLACK_SECONDS) * 1000000000UL;
+
+            for (f = 0; f < FAULTS_CNT; ++f)
+            {
+                for (t = 0; t < trials; ++t)
+                {
+                    if (0 != Trial(&pair, (fault_ty)f, budget_ns, &detect[t],
+                                                                    &ready[t]))
+                    {
+                        fprintf(stderr, "%s: no recovery\n", g_fault_names[f]);
+                        StopPair(&pair);
+                        unlink(addr.sun_path);
+                        return 1;
+                    }
+                    respawn[t] = ready[t] - detect[t];
+
+                    /* the new peer settles before the next fault */
+                    sleep((unsigned int)intervals[i] + 1);
+                }
+
+                printf("%8lu %6lu %-15s %6lu", (unsigned long)intervals[i],
+                       (unsigned long)misses[m], g_fault_names[f],
+                       (unsigned long)trials);
+                PrintDist(detect, trials);
+                PrintDist(respawn, trials);
+                PrintDist(ready, trials);
+                printf(" %8.3f\n", cpu_pct);
+                fflush(stdout);
+            }
+
+            StopPair(&pair);
+        }
+    }
+
+    close(pair.sock);
+    unlink(addr.sun_path);
+
+    return 0;
+}
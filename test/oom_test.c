@@ -0,0 +1,357 @@
+/*******************************************************************************
+ * Project:     Watchdog - out of memory revive test
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * proves that a revive allocates nothing:
+ * - the app caps its heap (RLIMIT_DATA) at the size it has and takes all
+ *   that is left, then wd_app is killed: its watchdog thread, which has no
+ *   heap either, has to spawn a new one
+ * - wd_app gets the same cap, then the app is killed: wd_app has to
+ *   revive it, which then connects to it
+ * usage: ./oom_test.out
+ * note: run from the directory of wd_app
+*******************************************************************************/
+#define _GNU_SOURCE  /* prlimit, setenv */
+
+#include <stdio.h>          /* printf, fopen            */
+#include <stdlib.h>         /* malloc, atoi, setenv     */
+#include <string.h>         /* strcmp, strncmp          */
+#include <signal.h>         /* kill, sigsuspend         */
+#include <unistd.h>         /* fork, execl, pipe        */
+#include <fcntl.h>          /* O_RDONLY                 */
+#include <poll.h>           /* poll                     */
+#include <time.h>           /* time                     */
+#include <sys/mman.h>       /* shm_open, mmap           */
+#include <sys/resource.h>   /* setrlimit, prlimit       */
+#include <sys/wait.h>       /* waitpid                  */
+
+#include "watchdog.h"
+#include "wd_log.h"
+#include "wd_stats.h"
+
+#include "wd_expect.h"
+#include "wd_fixture.h"
+
+enum {INTERVAL = 1, MAX_MISSES = 3, TIMEOUT_S = 15};
+
+/* what the app tells the test, once it is up and whenever it starved */
+typedef struct report
+{
+    pid_t pid;
+    int is_starved;
+}report_ty;
+
+static volatile sig_atomic_t g_starve = 0;
+
+static void OnHangup(int sig)
+{
+    (void)sig;
+    g_starve = !g_starve;
+}
+
+/* the private writable memory of "pid" in bytes, what RLIMIT_DATA caps */
+static unsigned long DataSize(pid_t pid)
+{
+    char path[64];
+    char line[128];
+    unsigned long kb = 0;
+    FILE *file = NULL;
+
+    sprintf(path, "/proc/%d/status", (int)pid);
+    file = fopen(path, "r");
+    while (NULL != file && NULL != fgets(line, sizeof(line), file))
+    {
+        if (1 == sscanf(line, "VmData: %lu", &kb))
+        {
+            break;
+        }
+    }
+    if (NULL != file)
+    {
+        fclose(file);
+    }
+
+    return kb * 1024;
+}
+
+static void SetDataLimit(pid_t pid, rlim_t cur)
+{
+    struct rlimit limit;
+
+    prlimit(pid, RLIMIT_DATA, NULL, &limit);
+    limit.rlim_cur = (RLIM_INFINITY == cur) ? limit.rlim_max : cur;
+    prlimit(pid, RLIMIT_DATA, &limit, NULL);
+}
+
+/* caps the heap at its size and takes every block it still has */
+static void **Starve(void)
+{
+    static const size_t sizes[] = {1 << 20, 1 << 16, 1 << 12, 1 << 8, 16};
+    void **hoard = NULL;
+    void **block = NULL;
+    size_t i = 0;
+
+    SetDataLimit(0, DataSize(getpid()));
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+        while (NULL != (block = (void **)malloc(sizes[i])))
+        {
+            *block = hoard;
+            hoard = block;
+        }
+    }
+
+    return hoard;
+}
+
+static void Feed(void **hoard)
+{
+    void **next = NULL;
+
+    SetDataLimit(0, RLIM_INFINITY);
+
+    for (; NULL != hoard; hoard = next)
+    {
+        next = (void **)*hoard;
+        free(hoard);
+    }
+}
+
+/* argv: app <report fd>, a revival gets the same */
+static int App(int argc, char *argv[])
+{
+    wd_restart_policy_ty restart = {0, 0, 0, 0, 60, 1};
+    struct sigaction sa;
+    sigset_t mask;
+    sigset_t wait_mask;
+    report_ty report;
+    void **hoard = NULL;
+    int fd = atoi(argv[2]);
+
+    /* a revival inherits the cap of the wd_app that spawned it */
+    SetDataLimit(0, RLIM_INFINITY);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = OnInterrupt;
+    sigaction(SIGINT, &sa, NULL);
+    sa.sa_handler = OnHangup;
+    sigaction(SIGHUP, &sa, NULL);
+
+    WDSetRestartPolicy(&restart);
+
+    if (0 != MakeMeImmortal(argc, argv, INTERVAL, MAX_MISSES))
+    {
+        return 1;
+    }
+
+    /* taken only while waiting, a request never comes in before the wait */
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGHUP);
+    sigprocmask(SIG_BLOCK, &mask, &wait_mask);
+    sigdelset(&wait_mask, SIGINT);
+    sigdelset(&wait_mask, SIGHUP);
+
+    report.pid = getpid();
+    report.is_starved = 0;
+    if (sizeof(report) != write(fd, &report, sizeof(report)))
+    {
+        return 1;
+    }
+
+    while (!g_quit)
+    {
+        sigsuspend(&wait_mask);
+        if (g_starve == (NULL != hoard))
+        {
+            continue;
+        }
+
+        if (g_starve)
+        {
+            hoard = Starve();
+            report.is_starved = (NULL != hoard && NULL == malloc(16));
+        }
+        else
+        {
+            Feed(hoard);
+            hoard = NULL;
+            report.is_starved = 0;
+        }
+        if (sizeof(report) != write(fd, &report, sizeof(report)))
+        {
+            break;
+        }
+    }
+
+    Feed(hoard);
+    DoNotResuscitate();
+
+    return 0;
+}
+
+/***************************** the test ***************************************/
+
+static int ReadReport(int fd, report_ty *report)
+{
+    struct pollfd pfd;
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+
+    return !(1 == poll(&pfd, 1, TIMEOUT_S * 1000) &&
+             sizeof(*report) == read(fd, report, sizeof(*report)));
+}
+
+/* the latest wd_app started for "app" other than "old", 0 if none */
+static pid_t FindWdApp(const log_ring_ty *ring, pid_t app, pid_t old)
+{
+    unsigned long head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    unsigned long index = (head > LOG_RECORDS) ? head - LOG_RECORDS : 0;
+    log_record_ty record;
+    pid_t found = 0;
+
+    for (; index < head; ++index)
+    {
+        if (0 == LogReadRecord(ring, index, &record) &&
+            LOG_WD_APP_STARTED == record.event && app == record.arg1 &&
+            old != record.arg0)
+        {
+            found = (pid_t)record.arg0;
+        }
+    }
+
+    return found;
+}
+
+static pid_t WaitWdApp(const log_ring_ty *ring, pid_t app, pid_t old)
+{
+    time_t deadline = time(NULL) + TIMEOUT_S;
+    pid_t found = 0;
+
+    while (0 == (found = FindWdApp(ring, app, old)) && time(NULL) < deadline)
+    {
+        usleep(10000);
+    }
+
+    return found;
+}
+
+/* the app starves, wd_app is killed - its watchdog thread spawns another */
+static pid_t CheckStarvedApp(const log_ring_ty *ring, int fd, pid_t app,
+                             pid_t wd_app)
+{
+    report_ty report;
+    pid_t new_wd_app = 0;
+
+    kill(app, SIGHUP);
+    Expect(0 == ReadReport(fd, &report) && report.is_starved, "app starved");
+
+    kill(wd_app, SIGKILL);
+    new_wd_app = WaitWdApp(ring, app, wd_app);
+    Expect(0 != new_wd_app, "wd_app spawned by a starved app");
+
+    /* it is up and the starved app took it, it beats */
+    sleep(INTERVAL * MAX_MISSES);
+    Expect(IsAlive(app) && IsAlive(new_wd_app), "pair alive");
+
+    kill(app, SIGHUP);
+    Expect(0 == ReadReport(fd, &report) && !report.is_starved, "app fed");
+
+    return new_wd_app;
+}
+
+/* wd_app is capped, the app is killed - wd_app revives it */
+static pid_t CheckStarvedWdApp(int fd, pid_t app, pid_t wd_app)
+{
+    report_ty report;
+
+    report.pid = 0;
+    SetDataLimit(wd_app, DataSize(wd_app));
+
+    kill(app, SIGKILL);
+    waitpid(app, NULL, 0);
+    Expect(0 == ReadReport(fd, &report) && app != report.pid &&
+           IsAlive(wd_app), "app revived by a starved wd_app");
+
+    return report.pid;
+}
+
+static void Stop(pid_t app, pid_t wd_app)
+{
+    size_t i = 0;
+
+    Signal(app, SIGINT);
+    for (i = 0; i < 500 && (IsAlive(app) || IsAlive(wd_app)); ++i)
+    {
+        while (0 < waitpid(-1, NULL, WNOHANG))
+        {
+        }
+        usleep(10000);
+    }
+    Signal(app, SIGKILL);
+    Signal(wd_app, SIGKILL);
+}
+
+int main(int argc, char *argv[])
+{
+    char name[NAME_SIZE];
+    char fd_arg[16];
+    const log_ring_ty *ring = NULL;
+    report_ty report;
+    pid_t app = 0;
+    pid_t wd_app = 0;
+    int fds[2];
+
+    if (1 < argc && 0 == strcmp("app", argv[1]))
+    {
+        return App(argc, argv);
+    }
+
+    /* the write end is inherited by every app of the pair */
+    sprintf(name, "oom_test.%d", (int)getpid());
+    setenv("WD_NAME", name, 1);
+    if (0 != pipe(fds))
+    {
+        puts("FAIL");
+        return 1;
+    }
+    sprintf(fd_arg, "%d", fds[1]);
+
+    app = fork();
+    if (0 == app)
+    {
+        execl(argv[0], argv[0], "app", fd_arg, (char *)NULL);
+        _exit(1);
+    }
+
+    Expect(0 == ReadReport(fds[0], &report) && app == report.pid, "app up");
+    ring = OpenRing(name);
+    Expect(NULL != ring, "log ring");
+    wd_app = (NULL == ring) ? 0 : WaitWdApp(ring, app, 0);
+    Expect(0 != wd_app, "wd_app up");
+
+    if (0 == g_failed)
+    {
+        wd_app = CheckStarvedApp(ring, fds[0], app, wd_app);
+    }
+    if (0 == g_failed)
+    {
+        app = CheckStarvedWdApp(fds[0], app, wd_app);
+    }
+
+    Stop(app, wd_app);
+    waitpid(-1, NULL, WNOHANG);
+    if (NULL != ring)
+    {
+        munmap((void *)ring, sizeof(log_ring_ty));
+    }
+    LogUnlink(name);
+    StatsUnlink(name);
+
+    puts(0 == g_failed ? "PASS" : "FAIL");
+
+    return (0 != g_failed);
+}
@@ -0,0 +1,172 @@
+/*******************************************************************************
+ * Project:     Watchdog - phi accrual detector test
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * feeds the detector beats of a punctual and of a jittery peer and checks
+ * that phi grows with the silence, that a punctual peer is suspected soon
+ * after a missing beat while a jittery one is not for its usual delays,
+ * that the window forgets the old beats, and the queue of the handler
+ * usage: ./phi_test.out
+*******************************************************************************/
+#include <stdio.h>      /* printf, puts     */
+#include <stdlib.h>     /* rand, srand      */
+#include <string.h>     /* memset           */
+
+#include "wd_phi.h"
+
+#include "wd_expect.h"
+
+#define SEC_US 1000000UL
+#define THRESHOLD 8.0
+
+enum {BEATS = 500};
+
+/* "BEATS" beats a second apart, +- "jitter_us" at random, from "start" */
+static unsigned long Feed(phi_ty *phi, unsigned long start,
+                          unsigned long jitter_us)
+{
+    unsigned long now = start;
+    size_t i = 0;
+
+    for (i = 0; i < BEATS; ++i)
+    {
+        now += SEC_US - jitter_us + (unsigned long)rand() % (2 * jitter_us + 1);
+        PhiBeat(phi, now);
+        PhiValue(phi, now);
+    }
+
+    return now;
+}
+
+static void CheckPunctual(void)
+{
+    wd_phi_policy_ty policy = {THRESHOLD, 100, 0, 0};
+    phi_ty phi;
+    unsigned long last = 0;
+    unsigned long t = 0;
+    double prev = 0;
+    double value = 0;
+
+    PhiInit(&phi, &policy, SEC_US, 0);
+    last = Feed(&phi, 0, 1000);
+
+    Expect(THRESHOLD > PhiValue(&phi, last + SEC_US), "on time");
+    Expect(THRESHOLD <= PhiValue(&phi, last + SEC_US * 3 / 2),
+                                                    "punctual suspected");
+
+    for (t = 0; t < 2 * SEC_US; t += SEC_US / 100)
+    {
+        value = PhiValue(&phi, last + t);
+        Expect(value >= prev, "phi grows with the silence");
+        prev = value;
+    }
+
+    /* the floor of the deviation tolerates a beat a little late */
+    policy.min_std_ms = 200;
+    PhiInit(&phi, &policy, SEC_US, 0);
+    last = Feed(&phi, 0, 1000);
+    Expect(THRESHOLD > PhiValue(&phi, last + SEC_US * 3 / 2), "min_std");
+    Expect(THRESHOLD <= PhiValue(&phi, last + SEC_US * 3), "min_std dead");
+
+    /* and the pause is accepted on top of the mean */
+    policy.min_std_ms = 0;
+    policy.pause_ms = 2000;
+    PhiInit(&phi, &policy, SEC_US, 0);
+    last = Feed(&phi, 0, 1000);
+    Expect(THRESHOLD > PhiValue(&phi, last + SEC_US * 3), "pause");
+    Expect(THRESHOLD <= PhiValue(&phi, last + SEC_US * 4), "pause dead");
+}
+
+static void CheckJittery(void)
+{
+    wd_phi_policy_ty policy = {THRESHOLD, 100, 0, 0};
+    phi_ty phi;
+    unsigned long last = 0;
+
+    PhiInit(&phi, &policy, SEC_US, 0);
+    last = Feed(&phi, 0, SEC_US / 2);
+
+    /* as late as it used to be is not suspicious */
+    Expect(THRESHOLD > PhiValue(&phi, last + SEC_US * 3 / 2), "usual delay");
+    Expect(THRESHOLD <= PhiValue(&phi, last + SEC_US * 4), "jittery dead");
+}
+
+static void CheckWindow(void)
+{
+    wd_phi_policy_ty policy = {THRESHOLD, 10, 0, 0};
+    phi_ty phi;
+    unsigned long now = 0;
+    size_t i = 0;
+
+    PhiInit(&phi, &policy, SEC_US, 0);
+    now = Feed(&phi, 0, 1000);
+
+    /* the peer slows down to a beat every 3 seconds */
+    for (i = 0; i < policy.window; ++i)
+    {
+        now += 3 * SEC_US;
+        PhiBeat(&phi, now);
+        PhiValue(&phi, now);
+    }
+    Expect(THRESHOLD > PhiValue(&phi, now + 3 * SEC_US), "window forgets");
+    Expect(phi.cnt == policy.window, "window size");
+}
+
+static void CheckQueue(void)
+{
+    wd_phi_policy_ty policy = {THRESHOLD, 100, 0, 0};
+    phi_ty phi;
+    size_t i = 0;
+
+    PhiInit(&phi, &policy, SEC_US, 0);
+
+    /* beats the check did not drain yet, more than the queue holds */
+    for (i = 1; i <= PHI_QUEUE + 4; ++i)
+    {
+        PhiBeat(&phi, i * SEC_US);
+    }
+    Expect(THRESHOLD > PhiValue(&phi, (PHI_QUEUE + 4) * SEC_US + SEC_US / 2),
+                                            "a full queue ends the silence");
+    Expect(2 + PHI_QUEUE == phi.cnt, "queued beats learned");
+
+    /* the beats of an old peer are dropped by a restart */
+    PhiBeat(&phi, 100 * SEC_US);
+    PhiRestart(&phi, 90 * SEC_US);
+    Expect(2 + PHI_QUEUE == (PhiValue(&phi, 91 * SEC_US), phi.cnt),
+                                                        "restart drops");
+    Expect(THRESHOLD <= PhiValue(&phi, 95 * SEC_US), "silence from restart");
+}
+
+static void CheckPolicy(void)
+{
+    wd_phi_policy_ty policy = {8.5, 50, 100, 300};
+    wd_phi_policy_ty copy;
+
+    memset(&copy, 0, sizeof(copy));
+    Expect(0 == PhiPolicyExport(&policy), "export");
+    PhiPolicyImport(&copy);
+    Expect(8.5 == copy.threshold && 50 == copy.window &&
+           100 == copy.min_std_ms && 300 == copy.pause_ms, "round trip");
+
+    policy.window = PHI_MAX_WINDOW + 1;
+    Expect(0 != PhiPolicyExport(&policy), "window too large");
+    policy.window = 50;
+    policy.threshold = -1;
+    Expect(0 != PhiPolicyExport(&policy), "negative threshold");
+}
+
+int main(void)
+{
+    srand(1);
+
+    CheckPunctual();
+    CheckJittery();
+    CheckWindow();
+    CheckQueue();
+    CheckPolicy();
+
+    puts(0 == g_failed ? "PASS" : "FAIL");
+
+    return (0 != g_failed);
+}
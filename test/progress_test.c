@@ -0,0 +1,156 @@
+/*******************************************************************************
+ * Project:     Watchdog - progress based liveness test
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * attaches to its own process, leaving out its sampling thread, and checks
+ * that the rescans find the threads that start and drop the ones that end,
+ * keeping the history of the others, all through the task directory opened
+ * once - and that a detach closes every descriptor
+ * usage: ./progress_test.out
+*******************************************************************************/
+#define _GNU_SOURCE  /* syscall */
+
+#include <stdio.h>          /* printf, puts     */
+#include <string.h>         /* memset           */
+#include <dirent.h>         /* opendir          */
+#include <unistd.h>         /* pipe, read       */
+#include <pthread.h>        /* pthread_create   */
+#include <sys/syscall.h>    /* SYS_gettid       */
+
+#include "wd_progress.h"
+
+#include "wd_expect.h"
+
+enum {THREADS = 3, LATE = 2};
+
+static int g_pipe[2] = {-1, -1};
+
+/* blocks until the main thread writes a byte for it */
+static void *Worker(void *arg)
+{
+    char byte = 0;
+
+    (void)arg;
+
+    read(g_pipe[0], &byte, 1);
+
+    return NULL;
+}
+
+static size_t OpenFds(void)
+{
+    struct dirent *entry = NULL;
+    DIR *dir = opendir("/proc/self/fd");
+    size_t cnt = 0;
+
+    while (NULL != dir && NULL != (entry = readdir(dir)))
+    {
+        cnt += ('.' != entry->d_name[0]);
+    }
+    if (NULL != dir)
+    {
+        closedir(dir);
+    }
+
+    return cnt;
+}
+
+/* up to the next rescan */
+static void Rescan(progress_ty *progress, const wd_progress_policy_ty *policy)
+{
+    size_t i = 0;
+
+    for (i = 0; i < PROGRESS_RESCAN; ++i)
+    {
+        ProgressSample(progress, policy, 0);
+    }
+}
+
+static int IsKnown(const progress_ty *progress, pid_t tid)
+{
+    size_t i = 0;
+
+    for (i = 0; i < progress->threads_cnt; ++i)
+    {
+        if (tid == progress->threads[i].tid)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void Release(size_t cnt)
+{
+    char bytes[THREADS + LATE];
+
+    memset(bytes, 0, sizeof(bytes));
+    if ((ssize_t)cnt != write(g_pipe[1], bytes, cnt))
+    {
+        Expect(0, "release workers");
+    }
+}
+
+int main(void)
+{
+    wd_progress_policy_ty policy = {0, 0, 0};
+    pthread_t threads[THREADS + LATE];
+    pid_t self = (pid_t)syscall(SYS_gettid);
+    progress_ty progress;
+    size_t fds = 0;
+    size_t i = 0;
+    int task_fd = -1;
+
+    if (0 != pipe(g_pipe))
+    {
+        puts("FAIL");
+        return 1;
+    }
+
+    fds = OpenFds();
+    ProgressInit(&progress);
+    Expect(0 == ProgressAttach(&progress, getpid(), self, 0), "attach");
+    Expect(-1 != progress.task_fd, "task directory open");
+    Expect(0 == progress.threads_cnt, "the sampling thread left out");
+    task_fd = progress.task_fd;
+
+    for (i = 0; i < THREADS; ++i)
+    {
+        pthread_create(threads + i, NULL, Worker, NULL);
+    }
+    Rescan(&progress, &policy);
+    Expect(THREADS == progress.threads_cnt && !IsKnown(&progress, self),
+           "new threads found");
+
+    /* the known threads keep their history, the new ones join */
+    progress.threads[0].run_ns_at_io = 1;
+    for (i = THREADS; i < THREADS + LATE; ++i)
+    {
+        pthread_create(threads + i, NULL, Worker, NULL);
+    }
+    Rescan(&progress, &policy);
+    Expect(THREADS + LATE == progress.threads_cnt, "late threads found");
+    Expect(1 == progress.threads[0].run_ns_at_io, "history kept");
+
+    Release(THREADS + LATE);
+    for (i = 0; i < THREADS + LATE; ++i)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    Rescan(&progress, &policy);
+    Expect(0 == progress.threads_cnt, "ended threads dropped");
+    Expect(task_fd == progress.task_fd, "task directory kept open");
+    Expect(fds + 4 == OpenFds(), "no descriptor but the counters");
+
+    ProgressDetach(&progress);
+    Expect(fds == OpenFds() && -1 == progress.task_fd, "detach closes all");
+
+    close(g_pipe[0]);
+    close(g_pipe[1]);
+
+    puts(0 == g_failed ? "PASS" : "FAIL");
+
+    return (0 != g_failed);
+}
@@ -0,0 +1,137 @@
+/*******************************************************************************
+ * Project:     Watchdog - adaptive heartbeat rate test
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * plays the checks and the beats of both sides of a pair and checks that a
+ * healthy pair slows down to the slowest rate step by step, that a side
+ * announces a slower rate before it takes it, that trouble on either side
+ * brings both back to the fastest rate, and the policy round trip
+ * usage: ./rate_test.out
+*******************************************************************************/
+#include <stdio.h>      /* printf, puts     */
+#include <string.h>     /* memset           */
+
+#include "wd_rate.h"
+
+#include "wd_expect.h"
+
+enum {BASE = 1, MAX = 16, STABLE = 3, TICKS = 200};
+
+/* a tick of both sides: each beats the other, then checks it */
+static void Tick(rate_ty *a, rate_ty *b, int a_regular, int b_regular)
+{
+    RateUnpack(b, RatePack(a, 0));
+    RateUnpack(a, RatePack(b, 0));
+    RateUpdate(a, a_regular);
+    RateUpdate(b, b_regular);
+}
+
+static void CheckBackOff(void)
+{
+    wd_rate_policy_ty policy = {MAX, STABLE};
+    rate_ty a;
+    rate_ty b;
+    size_t i = 0;
+
+    RateInit(&a, &policy, BASE);
+    RateInit(&b, &policy, BASE);
+    Expect(BASE == a.current && MAX == RatePeerInterval(&a), "init");
+
+    for (i = 0; i < TICKS && MAX != a.current; ++i)
+    {
+        Tick(&a, &b, 1, 1);
+
+        /* the peer never waits longer than the last beat announced */
+        Expect(a.current <= RatePeerInterval(&b), "announced first");
+        Expect(b.current <= RatePeerInterval(&a), "announced first");
+    }
+    Expect(MAX == a.current && MAX == b.current, "slowest rate");
+    Expect(i > 4 * STABLE && i < 6 * STABLE, "steps");
+
+    /* one side in trouble, both beat fast by the next check */
+    Tick(&a, &b, 0, 1);
+    Expect(BASE == a.current, "fast at once");
+    Tick(&a, &b, 1, 1);
+    Expect(BASE == b.current && BASE == RatePeerInterval(&b), "peer follows");
+
+    /* and a new peer starts fast, unknown yet */
+    for (i = 0; i < TICKS; ++i)
+    {
+        Tick(&a, &b, 1, 1);
+    }
+    RateRestart(&a);
+    Expect(BASE == a.current && MAX == RatePeerInterval(&a), "restart");
+}
+
+static void CheckAnnounce(void)
+{
+    wd_rate_policy_ty policy = {MAX, 1};
+    rate_ty a;
+
+    RateInit(&a, &policy, BASE);
+
+    /* the peer wishes slower too, but nothing was sent since */
+    RateUnpack(&a, 8UL << 48);
+    Expect(BASE == RateUpdate(&a, 1) && 2 == a.announced, "not yet");
+    Expect(BASE == RateUpdate(&a, 1), "still not told");
+    RatePack(&a, 0);
+    Expect(4 == RateUpdate(&a, 1), "told, then slower");
+
+    /* faster needs no announcement */
+    RateUnpack(&a, 1UL << 48);
+    Expect(BASE == RateUpdate(&a, 1), "faster at once");
+}
+
+static void CheckPack(void)
+{
+    wd_rate_policy_ty policy = {MAX, STABLE};
+    unsigned long now = 0x123456789abcUL;
+    rate_ty a;
+
+    RateInit(&a, &policy, BASE);
+
+    Expect(now == RateUnpack(&a, RatePack(&a, now)), "send time");
+    Expect(((~0UL << 40) & RATE_TIME_MASK) == RateUnpack(&a, RatePack(&a,
+                                            ~0UL << 40)), "time masked");
+    Expect(BASE == RatePeerInterval(&a), "own interval");
+
+    /* a beat without the rate stands for the fastest one */
+    RateUnpack(&a, now);
+    Expect(BASE == RatePeerInterval(&a) && BASE == a.peer_wish, "no rate");
+
+    /* a disabled rate stays put */
+    policy.max_interval = 0;
+    RateInit(&a, &policy, 2);
+    RateUnpack(&a, 16UL << 48);
+    Expect(2 == RateUpdate(&a, 1) && 2 == RateUpdate(&a, 1), "disabled");
+}
+
+static void CheckPolicy(void)
+{
+    wd_rate_policy_ty policy = {30, 5};
+    wd_rate_policy_ty copy;
+
+    memset(&copy, 0, sizeof(copy));
+    Expect(0 == RatePolicyExport(&policy), "export");
+    RatePolicyImport(&copy);
+    Expect(30 == copy.max_interval && 5 == copy.stable_beats, "round trip");
+
+    policy.max_interval = RATE_MAX_INTERVAL + 1;
+    Expect(0 != RatePolicyExport(&policy), "interval too large");
+    policy.max_interval = 30;
+    policy.stable_beats = 0;
+    Expect(0 != RatePolicyExport(&policy), "no stable beats");
+}
+
+int main(void)
+{
+    CheckBackOff();
+    CheckAnnounce();
+    CheckPack();
+    CheckPolicy();
+
+    puts(0 == g_failed ? "PASS" : "FAIL");
+
+    return (0 != g_failed);
+}
@@ -0,0 +1,403 @@
+/*******************************************************************************
+ * Project:     Watchdog - registry test
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * checks the registry on a table of its own: records by name, a full table,
+ * a record freed by a pair that is gone, snapshots under a writer and the
+ * lock of a writer that died
+ * then restarts an app of a live pair: wd_app is stopped, the app killed and
+ * started again by the test - not by wd_app - and has to find wd_app in the
+ * registry, and wd_app has to take it over instead of a second wd_app
+ * usage: ./registry_test.out
+ * note: run from the directory of wd_app
+*******************************************************************************/
+#define _GNU_SOURCE  /* setenv */
+
+#include <stdio.h>          /* printf, sprintf          */
+#include <stdlib.h>         /* atoi, setenv             */
+#include <string.h>         /* strcmp                   */
+#include <signal.h>         /* kill, sigaction          */
+#include <unistd.h>         /* fork, execl, pipe        */
+#include <fcntl.h>          /* O_RDONLY                 */
+#include <poll.h>           /* poll                     */
+#include <time.h>           /* time                     */
+#include <sys/mman.h>       /* shm_open, mmap           */
+#include <sys/wait.h>       /* waitpid                  */
+
+#include "watchdog.h"
+#include "wd_log.h"
+#include "wd_stats.h"
+#include "wd_registry.h"
+
+#include "wd_expect.h"
+#include "wd_fixture.h"
+
+enum {INTERVAL = 1, MAX_MISSES = 3, TIMEOUT_S = 15, WRITES = 100000};
+
+/* argv: app <report fd> */
+static int App(int argc, char *argv[])
+{
+    struct sigaction sa;
+    pid_t pid = getpid();
+    int fd = atoi(argv[2]);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = OnInterrupt;
+    sigaction(SIGINT, &sa, NULL);
+
+    if (0 != MakeMeImmortal(argc, argv, INTERVAL, MAX_MISSES))
+    {
+        return 1;
+    }
+
+    if (sizeof(pid) != write(fd, &pid, sizeof(pid)))
+    {
+        return 1;
+    }
+
+    while (!g_quit)
+    {
+        pause();
+    }
+
+    DoNotResuscitate();
+
+    return 0;
+}
+
+/***************************** the table **************************************/
+
+static void CheckNames(registry_ty *registry)
+{
+    registry_record_ty record;
+    long slot = RegistryAttach(registry, "pair.a", REGISTRY_APP_SIDE);
+
+    Expect(-1 != slot, "attach");
+    Expect(slot == RegistryFind(registry, "pair.a"), "find");
+    Expect(slot == RegistryAttach(registry, "pair.a", REGISTRY_WD_SIDE),
+                                                            "attach again");
+    Expect(-1 == RegistryFind(registry, "pair.b"), "find unknown");
+    Expect(slot != RegistryAttach(registry, "pair.b", REGISTRY_WD_SIDE),
+                                                            "attach other");
+
+    Expect(0 == RegistryRead(registry, (size_t)slot, &record) &&
+           (unsigned long)getpid() == record.app_pid && 0 == record.wd_pid &&
+           0 == strcmp("pair.a", record.name), "claimed by the caller");
+}
+
+/* every record is of a live pair, then one of them is gone - "used" of
+   them were taken before                                                 */
+static void CheckFull(registry_ty *registry, size_t used)
+{
+    registry_record_ty *record = NULL;
+    char name[NAME_SIZE];
+    long slot = -1;
+    size_t i = 0;
+    int is_found = 1;
+
+    for (i = 0; i <= REGISTRY_RECORDS; ++i)
+    {
+        sprintf(name, "full.%lu", (unsigned long)i);
+        if (-1 == RegistryAttach(registry, name, REGISTRY_APP_SIDE))
+        {
+            break;
+        }
+    }
+    Expect(REGISTRY_RECORDS - used == i, "full table");
+
+    slot = RegistryFind(registry, "full.7");
+    record = RegistryWriteBegin(registry, (size_t)slot);
+    record->app_pid = 0;
+    RegistryWriteEnd(record);
+
+    Expect(slot == RegistryAttach(registry, "freed", REGISTRY_APP_SIDE),
+                                                            "freed record");
+    Expect(-1 == RegistryFind(registry, "full.7"), "old name gone");
+
+    /* a freed record breaks no chain of probes */
+    for (i = 0; i + used < REGISTRY_RECORDS; ++i)
+    {
+        sprintf(name, "full.%lu", (unsigned long)i);
+        is_found &= (7 == i || -1 != RegistryFind(registry, name));
+    }
+    Expect(is_found, "others found");
+}
+
+/* a snapshot never mixes two writes */
+static void CheckSnapshots(registry_ty *registry)
+{
+    registry_record_ty *record = NULL;
+    registry_record_ty copy;
+    long slot = RegistryAttach(registry, "snapshots", REGISTRY_APP_SIDE);
+    unsigned long last = 0;
+    int is_torn = 0;
+    pid_t writer = 0;
+    size_t i = 0;
+
+    writer = fork();
+    if (0 == writer)
+    {
+        for (i = 1; i <= WRITES; ++i)
+        {
+            record = RegistryWriteBegin(registry, (size_t)slot);
+            record->generation = i;
+            record->app_tid = i;
+            RegistryWriteEnd(record);
+        }
+        _exit(0);
+    }
+
+    while (last < WRITES && !is_torn)
+    {
+        if (0 == RegistryRead(registry, (size_t)slot, &copy))
+        {
+            is_torn = (copy.generation != copy.app_tid ||
+                       copy.generation < last);
+            last = copy.generation;
+        }
+        if (0 < waitpid(writer, NULL, WNOHANG))
+        {
+            writer = 0;
+            RegistryRead(registry, (size_t)slot, &copy);
+            last = copy.generation;
+        }
+    }
+    Expect(!is_torn && WRITES == last, "consistent snapshots");
+
+    if (0 != writer)
+    {
+        waitpid(writer, NULL, 0);
+    }
+}
+
+/* a writer that died holding the lock */
+static void CheckDeadWriter(registry_ty *registry)
+{
+    registry_record_ty *record = NULL;
+    registry_record_ty copy;
+    long slot = RegistryAttach(registry, "dead.writer", REGISTRY_APP_SIDE);
+
+    record = RegistryWriteBegin(registry, (size_t)slot);
+    Expect(0 != RegistryRead(registry, (size_t)slot, &copy), "locked");
+
+    record = RegistryWriteBegin(registry, (size_t)slot);
+    record->generation = 42;
+    RegistryWriteEnd(record);
+    Expect(0 == RegistryRead(registry, (size_t)slot, &copy) &&
+           42 == copy.generation, "lock broken");
+}
+
+static void CheckTable(void)
+{
+    char shm_name[NAME_SIZE];
+    registry_ty *registry = NULL;
+
+    sprintf(shm_name, "/wd_registry_test.%d", (int)getpid());
+    registry = RegistryOpen(shm_name, 1);
+    Expect(NULL != registry, "open");
+    if (NULL == registry)
+    {
+        return;
+    }
+
+    CheckNames(registry);
+    CheckSnapshots(registry);
+    CheckDeadWriter(registry);
+    CheckFull(registry, 4);
+
+    RegistryClose(registry);
+    RegistryUnlink(shm_name);
+}
+
+/***************************** the pair ***************************************/
+
+static int ReadPid(int fd, pid_t *pid)
+{
+    struct pollfd pfd;
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+
+    return !(1 == poll(&pfd, 1, TIMEOUT_S * 1000) &&
+             sizeof(*pid) == read(fd, pid, sizeof(*pid)));
+}
+
+static pid_t StartApp(const char *self, const char *fd_arg)
+{
+    pid_t app = fork();
+
+    if (0 == app)
+    {
+        execl(self, self, "app", fd_arg, (char *)NULL);
+        _exit(1);
+    }
+
+    return app;
+}
+
+static int ReadRecord(const char *name, registry_record_ty *record)
+{
+    registry_ty *registry = RegistryOpen(REGISTRY_SHM, 0);
+    long slot = (NULL == registry) ? -1 : RegistryFind(registry, name);
+    int status = (-1 == slot || 0 != RegistryRead(registry, (size_t)slot, record));
+
+    if (NULL != registry)
+    {
+        RegistryClose(registry);
+    }
+
+    return status;
+}
+
+/* the record once wd_app took it over for "app", wd_pid 0 if it did not */
+static void WaitRecord(const char *name, pid_t app, registry_record_ty *record)
+{
+    time_t deadline = time(NULL) + TIMEOUT_S;
+
+    while (time(NULL) < deadline &&
+           (0 != ReadRecord(name, record) || (pid_t)record->app_pid != app ||
+            0 == record->wd_pid || 0 == record->app_tid))
+    {
+        usleep(10000);
+    }
+    if ((pid_t)record->app_pid != app)
+    {
+        record->wd_pid = 0;
+    }
+}
+
+/* the record once neither side holds it, "app_pid" not 0 if it is gone or
+   still held at the deadline                                             */
+static void WaitReleased(const char *name, registry_record_ty *record)
+{
+    time_t deadline = time(NULL) + TIMEOUT_S;
+    int status = 1;
+
+    while (time(NULL) < deadline &&
+           (0 != (status = ReadRecord(name, record)) ||
+            0 != record->app_pid || 0 != record->wd_pid))
+    {
+        usleep(10000);
+    }
+    if (0 != status)
+    {
+        record->app_pid = 1;
+    }
+}
+
+/* records of "event" logged by "pid" with "arg0", 0 for any of either */
+static size_t CountEvents(const char *name, log_event_ty event, pid_t pid,
+                          long arg0)
+{
+    const log_ring_ty *ring = OpenRing(name);
+    unsigned long head = 0;
+    unsigned long index = 0;
+    log_record_ty record;
+    size_t cnt = 0;
+
+    if (NULL == ring)
+    {
+        return 0;
+    }
+
+    head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    for (index = (head > LOG_RECORDS) ? head - LOG_RECORDS : 0; index < head;
+                                                                    ++index)
+    {
+        if (0 != LogReadRecord(ring, index, &record))
+        {
+            continue;
+        }
+        cnt += (event == record.event &&
+                (0 == pid || pid == (pid_t)record.pid) &&
+                (0 == arg0 || arg0 == record.arg0));
+    }
+    munmap((void *)ring, sizeof(log_ring_ty));
+
+    return cnt;
+}
+
+static void CheckRestartedApp(const char *self, const char *name, int fd,
+                              const char *fd_arg)
+{
+    registry_record_ty record;
+    pid_t app = StartApp(self, fd_arg);
+    pid_t new_app = 0;
+    pid_t wd_app = 0;
+
+    Expect(0 == ReadPid(fd, &new_app) && app == new_app, "app up");
+    WaitRecord(name, app, &record);
+    wd_app = (pid_t)record.wd_pid;
+    Expect(0 != wd_app && 1 == record.generation, "pair in the registry");
+    if (0 != g_failed)
+    {
+        Signal(app, SIGKILL);
+        Signal(wd_app, SIGKILL);
+        return;
+    }
+
+    /* wd_app can't revive it meanwhile, a new one takes its place */
+    kill(wd_app, SIGSTOP);
+    kill(app, SIGKILL);
+    waitpid(app, NULL, 0);
+
+    new_app = StartApp(self, fd_arg);
+    Expect(0 == ReadPid(fd, &app) && app == new_app, "restarted app up");
+    kill(wd_app, SIGCONT);
+
+    WaitRecord(name, new_app, &record);
+    Expect(wd_app == (pid_t)record.wd_pid, "wd_app kept its record");
+
+    /* beaten by wd_app long enough to have missed it otherwise */
+    sleep(INTERVAL * (MAX_MISSES + 2));
+    Expect(1 == CountEvents(name, LOG_WD_EXISTS, new_app, wd_app),
+                                                        "wd_app found");
+    Expect(1 == CountEvents(name, LOG_APP_ADOPTED, wd_app, new_app),
+                                                        "app adopted");
+    Expect(0 == CountEvents(name, LOG_REVIVED, wd_app, 0) &&
+           1 == CountEvents(name, LOG_WD_APP_STARTED, 0, 0),
+                                        "no revival, no second wd_app");
+    Expect(IsAlive(new_app) && IsAlive(wd_app), "pair alive");
+
+    /* the pair stops for good, its record names nobody - wd_app may still
+       be on its way out                                                  */
+    kill(new_app, SIGINT);
+    waitpid(new_app, NULL, 0);
+    WaitReleased(name, &record);
+    Expect(0 == record.app_pid && 0 == record.wd_pid, "record released");
+    Signal(wd_app, SIGKILL);
+}
+
+int main(int argc, char *argv[])
+{
+    char name[NAME_SIZE];
+    char fd_arg[16];
+    int fds[2];
+
+    if (1 < argc && 0 == strcmp("app", argv[1]))
+    {
+        return App(argc, argv);
+    }
+
+    CheckTable();
+
+    /* a pair name that survives the app - a restart reuses it */
+    sprintf(name, "registry_test.%d", (int)getpid());
+    setenv("WD_NAME", name, 1);
+    if (0 != pipe(fds))
+    {
+        puts("FAIL");
+        return 1;
+    }
+    sprintf(fd_arg, "%d", fds[1]);
+
+    CheckRestartedApp(argv[0], name, fds[0], fd_arg);
+
+    LogUnlink(name);
+    StatsUnlink(name);
+
+    puts(0 == g_failed ? "PASS" : "FAIL");
+
+    return (0 != g_failed);
+}
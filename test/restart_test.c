@@ -0,0 +1,151 @@
+/*******************************************************************************
+ * Project:     Watchdog - restart policy test
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * records restarts on a clock of its own and checks the exponential backoff
+ * and its cap, that the jitter stays within its percent of the delay, that
+ * the circuit breaker opens inside the window and half-opens after it, and
+ * that a peer healthy for long enough resets the backoff
+ * usage: ./restart_test.out
+*******************************************************************************/
+#include <stdio.h>      /* printf, puts     */
+
+#include "wd_restart.h"
+
+#include "wd_expect.h"
+
+#define START ((time_t)1000000)
+
+enum {JITTER_RUNS = 200};
+
+static void CheckBackoff(void)
+{
+    wd_restart_policy_ty policy = {1, 16, 0, 0, 60, 30};
+    time_t expected[] = {1, 2, 4, 8, 16, 16, 16};
+    restart_state_ty state;
+    time_t now = START;
+    size_t i = 0;
+    int is_good = 1;
+
+    RestartStateInit(&state);
+    Expect(RestartIsAllowed(&policy, &state, now), "first restart allowed");
+
+    for (i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i)
+    {
+        RestartRecord(&policy, &state, now);
+        is_good &= (expected[i] == state.counters.next_allowed - now);
+        is_good &= !RestartIsAllowed(&policy, &state,
+                                     state.counters.next_allowed - 1);
+        is_good &= RestartIsAllowed(&policy, &state,
+                                    state.counters.next_allowed);
+        now = state.counters.next_allowed;
+    }
+    Expect(is_good, "delays double up to max_delay");
+    Expect(7 == state.counters.total_restarts &&
+           7 == state.counters.consecutive, "counters");
+    Expect(!state.counters.breaker_open, "no breaker without max_restarts");
+}
+
+static void CheckJitter(void)
+{
+    wd_restart_policy_ty policy = {10, 1000, 20, 0, 60, 30};
+    restart_state_ty state;
+    time_t nominal = 0;
+    time_t delay = 0;
+    time_t prev = 0;
+    time_t now = START;
+    size_t i = 0;
+    int is_good = 1;
+    int is_varied = 0;
+
+    RestartStateInit(&state);
+    for (i = 0; i < JITTER_RUNS; ++i)
+    {
+        nominal = (i < 7) ? (time_t)10 << i : 1000;
+        RestartRecord(&policy, &state, now);
+        delay = state.counters.next_allowed - now;
+        is_good &= (nominal * 80 / 100 <= delay &&
+                    delay <= nominal * 120 / 100);
+        if (7 < i)
+        {
+            is_varied |= (0 != prev && delay != prev);
+            prev = delay;
+        }
+        now += delay;
+    }
+    Expect(is_good, "jitter within 20 percent");
+    Expect(is_varied, "jitter varies");
+}
+
+static void CheckBreaker(void)
+{
+    wd_restart_policy_ty policy = {1, 60, 0, 3, 60, 30};
+    restart_state_ty state;
+
+    RestartStateInit(&state);
+    RestartRecord(&policy, &state, START);
+    RestartRecord(&policy, &state, START + 1);
+    Expect(!state.counters.breaker_open, "closed below max_restarts");
+    RestartRecord(&policy, &state, START + 3);
+    Expect(state.counters.breaker_open && 1 == state.counters.breaker_trips,
+           "opens at max_restarts");
+    Expect(!RestartIsAllowed(&policy, &state, START + 30), "open in window");
+    Expect(!RestartIsAllowed(&policy, &state, START + 59), "open to its end");
+
+    Expect(RestartIsAllowed(&policy, &state, START + 60), "half-open after");
+    Expect(!state.counters.breaker_open &&
+           0 == state.counters.restarts_in_window &&
+           START + 60 == state.counters.window_start, "fresh window");
+    RestartRecord(&policy, &state, START + 60);
+    Expect(!state.counters.breaker_open &&
+           1 == state.counters.restarts_in_window, "one restart through");
+
+    /* restarts spread wider than the window never open it */
+    RestartStateInit(&state);
+    RestartRecord(&policy, &state, START);
+    RestartRecord(&policy, &state, START + 40);
+    RestartRecord(&policy, &state, START + 80);
+    Expect(!state.counters.breaker_open &&
+           1 == state.counters.restarts_in_window, "window slides");
+}
+
+static void CheckHealthy(void)
+{
+    wd_restart_policy_ty policy = {1, 60, 0, 3, 60, 30};
+    restart_state_ty state;
+    time_t last = START + 3;
+
+    RestartStateInit(&state);
+    RestartRecord(&policy, &state, START);
+    RestartRecord(&policy, &state, START + 1);
+    RestartRecord(&policy, &state, last);
+
+    RestartReportHealthy(&policy, &state, last + 29);
+    Expect(3 == state.counters.consecutive && state.counters.breaker_open,
+           "not healthy too soon");
+
+    RestartReportHealthy(&policy, &state, last + 30);
+    Expect(0 == state.counters.consecutive &&
+           0 == state.counters.restarts_in_window &&
+           0 == state.counters.next_allowed &&
+           !state.counters.breaker_open, "reset after healthy_time");
+    Expect(3 == state.counters.total_restarts &&
+           1 == state.counters.breaker_trips, "history kept");
+    Expect(RestartIsAllowed(&policy, &state, last + 30), "allowed again");
+
+    RestartRecord(&policy, &state, last + 30);
+    Expect(1 == state.counters.next_allowed - (last + 30), "backoff restarts");
+}
+
+int main(void)
+{
+    CheckBackoff();
+    CheckJitter();
+    CheckBreaker();
+    CheckHealthy();
+
+    puts(0 == g_failed ? "PASS" : "FAIL");
+
+    return (0 != g_failed);
+}
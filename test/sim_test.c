@@ -0,0 +1,516 @@
+/*******************************************************************************
+ * Project:     Watchdog - simulation test
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * runs the wd_app side of a pair on a virtual clock against a simulated
+ * app: the spawn is mocked, the beats of the app are played in by the clock
+ * every scenario covers hours of heartbeats in milliseconds, over a sweep of
+ * interval and max_misses, and checks the restart decisions:
+ * - a healthy app is never restarted
+ * - a dead or hung app is restarted within max_misses intervals, and the
+ *   old instance is gone before the new one starts
+ * - a crash loop trips the restart breaker
+ * a short pause of the app shows the price of a tight detection
+ * the same with the phi accrual detector on, which learns that the beats
+ * are punctual and declares a crash long before max_misses
+ * and with the adaptive rate on, against an app that follows the rate the
+ * watchdog asks for: the beats a healthy pair sends, and the detection
+ * usage: ./sim_test.out [hours]
+*******************************************************************************/
+#define _GNU_SOURCE  /* pid_t */
+
+#include <stdio.h>      /* printf           */
+#include <stdlib.h>     /* atoi, free       */
+#include <string.h>     /* memset           */
+#include <signal.h>     /* SIGKILL          */
+#include <time.h>       /* clock_gettime    */
+
+#include "wd_internal.h"
+#include "vclock.h"
+
+enum {DEFAULT_HOURS = 24, HOUR = 3600, SIM_START = 1000000,
+      FIRST_FAIL = HOUR, LOOP_LIFETIME = 5, PAUSE = 4};
+
+/* far above any pid_max, a stray kill() of one finds nobody */
+enum {FAKE_PID_BASE = 0x7fff0000};
+
+enum {HANGS = -1};
+
+enum {PHI_THRESHOLD = 8};
+
+enum {RATE_MAX = 16, RATE_STABLE = 4, RATE_MISSES = 3};
+
+typedef struct scenario
+{
+    const char *name;
+    time_t quiet;       /* how a failing app goes silent: 0 dies, HANGS,
+                           or pauses that many seconds                      */
+    time_t lifetime;    /* how long a revived app lives, 0 for ever         */
+}scenario_ty;
+
+/* the app the watchdog sees, one instance per spawn */
+typedef struct peer
+{
+    pid_t pid;
+    time_t born;
+    time_t fails;       /* 0 never                                          */
+    time_t quiet;
+    int killed;
+}peer_ty;
+
+typedef struct sim
+{
+    wd_params_ty *params;
+    vclock_ty vclock;
+    wd_ops_ty ops;
+    const scenario_ty *scenario;
+    time_t end;
+    peer_ty peer;
+    rate_ty peer_rate;  /* the app beats at the rate the pair agreed on     */
+    time_t next_beat;
+    size_t beats;       /* of the app and of the watchdog                   */
+    size_t spawns;
+    size_t kills;
+    size_t overlaps;
+    time_t last_beat;
+    time_t detect_max;
+}sim_ty;
+
+static const scenario_ty g_scenarios[] =
+{
+    {"healthy", 0, 0},
+    {"crash", 0, 0},
+    {"hang", HANGS, 0},
+    {"crash loop", 0, LOOP_LIFETIME},
+    {"pause", PAUSE, 0}
+};
+
+enum {SCENARIOS = sizeof(g_scenarios) / sizeof(g_scenarios[0])};
+
+static const size_t g_intervals[] = {1, 2, 3, 5};
+static const size_t g_misses[] = {2, 3, 5, 8};
+
+enum {INTERVALS = sizeof(g_intervals) / sizeof(g_intervals[0]),
+      MISSES = sizeof(g_misses) / sizeof(g_misses[0])};
+
+static double NowMsec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static int PeerBeatsAt(const peer_ty *peer, time_t when)
+{
+    if (peer->killed || 0 == peer->pid)
+    {
+        return 0;
+    }
+
+    return (0 == peer->fails || when < peer->fails ||
+            (0 < peer->quiet && when >= peer->fails + peer->quiet));
+}
+
+/* a process that still runs, silent or not */
+static int PeerRunsAt(const peer_ty *peer, time_t when)
+{
+    if (peer->killed || 0 == peer->pid)
+    {
+        return 0;
+    }
+
+    return (0 == peer->fails || when < peer->fails || 0 != peer->quiet);
+}
+
+/* the beats of the app between two wakes of the watchdog, the last one
+   tells the rate                                                           */
+static void OnAdvance(void *param, time_t from, time_t to)
+{
+    sim_ty *sim = (sim_ty *)param;
+    unsigned long value = 0;
+    int is_beat = 0;
+
+    (void)from;
+
+    if (0 != sim->peer.pid)
+    {
+        for (; sim->next_beat <= to;
+                        sim->next_beat += (time_t)sim->peer_rate.current)
+        {
+            if (PeerBeatsAt(&sim->peer, sim->next_beat))
+            {
+                sim->last_beat = sim->next_beat;
+                value = RatePack(&sim->peer_rate, 0);
+                RateUpdate(&sim->peer_rate, 1);
+                ++sim->beats;
+                is_beat = 1;
+            }
+        }
+
+        if (is_beat)
+        {
+            WDReceiveBeat(sim->params, value);
+        }
+    }
+
+    if (to >= sim->end)
+    {
+        SchedulerStop(sim->params->scheduler);
+    }
+}
+
+static int Spawn(void *param, pid_t *pid, char *argv[])
+{
+    sim_ty *sim = (sim_ty *)param;
+    time_t now = VClockNow(&sim->vclock);
+    peer_ty *peer = &sim->peer;
+
+    (void)argv;
+
+    if (PeerRunsAt(peer, now))
+    {
+        ++sim->overlaps;
+    }
+
+    /* from the last beat of the failed app to its restart */
+    if (0 != peer->pid && now - sim->last_beat > sim->detect_max)
+    {
+        sim->detect_max = now - sim->last_beat;
+    }
+
+    peer->pid = FAKE_PID_BASE + (pid_t)sim->spawns;
+    peer->born = now;
+    sim->last_beat = now;
+    RateRestart(&sim->peer_rate);
+    sim->next_beat = now + (time_t)sim->peer_rate.current;
+    peer->killed = 0;
+    peer->quiet = sim->scenario->quiet;
+    if (0 == sim->spawns)
+    {
+        peer->fails = (sim->scenario != &g_scenarios[0]) ? now + FIRST_FAIL : 0;
+    }
+    else
+    {
+        peer->fails = (0 != sim->scenario->lifetime) ?
+                                        now + sim->scenario->lifetime : 0;
+    }
+
+    ++sim->spawns;
+    *pid = peer->pid;
+
+    return 0;
+}
+
+static int Kill(void *param, pid_t pid, int sig)
+{
+    sim_ty *sim = (sim_ty *)param;
+
+    if (SIGKILL == sig && pid == sim->peer.pid)
+    {
+        sim->peer.killed = 1;
+        ++sim->kills;
+    }
+
+    return 0;
+}
+
+/* a beat of the watchdog, the app takes the rate it asks for */
+static int Beat(void *param, pid_t pid, unsigned long value)
+{
+    sim_ty *sim = (sim_ty *)param;
+
+    if (pid == sim->peer.pid &&
+        PeerRunsAt(&sim->peer, VClockNow(&sim->vclock)))
+    {
+        RateUnpack(&sim->peer_rate, value);
+    }
+    ++sim->beats;
+
+    return 0;
+}
+
+static int Simulate(sim_ty *sim, const scenario_ty *scenario, size_t interval,
+                    size_t max_misses, time_t duration, char *argv[],
+                    const wd_phi_policy_ty *phi, const wd_rate_policy_ty *rate)
+{
+    wd_rate_policy_ty fixed = {0, 1};
+
+    memset(sim, 0, sizeof(*sim));
+
+    sim->params = CreateStruct(1, argv, interval, max_misses, 0, NULL);
+    if (NULL == sim->params)
+    {
+        return 1;
+    }
+
+    sim->scenario = scenario;
+    sim->end = SIM_START + duration;
+
+    VClockInit(&sim->vclock, SIM_START, OnAdvance, sim);
+    VClockAttach(&sim->vclock, &sim->ops.clock);
+    sim->ops.spawn = Spawn;
+    sim->ops.kill = Kill;
+    sim->ops.beat = Beat;
+    sim->ops.param = sim;
+
+    /* jitter off, so every run decides the same */
+    sim->params->restart_policy.jitter_pct = 0;
+    sim->params->restart_policy.window = 600;
+    sim->params->p_type = APP;
+    sim->params->ops = &sim->ops;
+    if (NULL != phi)
+    {
+        sim->params->phi_policy = *phi;
+    }
+    if (NULL != rate)
+    {
+        sim->params->rate_policy = *rate;
+    }
+    RateInit(&sim->peer_rate, (NULL != rate) ? rate : &fixed, interval);
+
+    WDFunc(sim->params, 0);
+
+    return 0;
+}
+
+static void DestroySim(sim_ty *sim)
+{
+    sem_destroy(&sim->params->dnr_return);
+    free(sim->params);
+    sim->params = NULL;
+}
+
+/* returns the number of failed checks */
+static int Check(const sim_ty *sim, const scenario_ty *scenario,
+                 size_t interval, size_t max_misses, time_t duration)
+{
+    const wd_restart_state_ty *restart = &sim->params->restart.counters;
+    size_t restarts = sim->spawns - 1;
+    size_t windows = (size_t)duration / sim->params->restart_policy.window + 1;
+    int failed = 0;
+
+    failed += (restarts != restart->total_restarts);
+    failed += (0 != sim->overlaps);
+
+    if (scenario == &g_scenarios[0])
+    {
+        failed += (0 != restarts);
+    }
+    else if (0 == scenario->lifetime && PAUSE != scenario->quiet)
+    {
+        failed += (1 != restarts);
+        failed += (sim->detect_max > (time_t)(max_misses * interval));
+        failed += (HANGS == scenario->quiet && 1 != sim->kills);
+    }
+    else if (0 != scenario->lifetime)
+    {
+        failed += (0 == restart->breaker_trips);
+        failed += (restarts > windows *
+                        (sim->params->restart_policy.max_restarts + 1));
+    }
+    else
+    {
+        failed += (1 < restarts);
+    }
+
+    if (failed)
+    {
+        printf("FAILED: %s interval %lu max_misses %lu: %lu restarts, "
+               "%lu overlaps, detect %lds\n", scenario->name,
+               (unsigned long)interval, (unsigned long)max_misses,
+               (unsigned long)restarts, (unsigned long)sim->overlaps,
+               (long)sim->detect_max);
+    }
+
+    return failed;
+}
+
+/* healthy, crash and hang with the detector on and a loose max_misses */
+static int SimulatePhi(time_t duration, char *argv[], size_t *runs)
+{
+    wd_phi_policy_ty phi = {PHI_THRESHOLD, 100, 0, 0};
+    size_t max_misses = g_misses[MISSES - 1];
+    size_t detect[INTERVALS];
+    size_t s = 0;
+    size_t i = 0;
+    int failed = 0;
+    sim_ty sim;
+
+    for (s = 0; s < 3; ++s)
+    {
+        for (i = 0; i < INTERVALS; ++i)
+        {
+            if (0 != Simulate(&sim, &g_scenarios[s], g_intervals[i],
+                              max_misses, duration, argv, &phi, NULL))
+            {
+                puts("CreateStruct failed");
+                return 1;
+            }
+
+            failed += Check(&sim, &g_scenarios[s], g_intervals[i],
+                            max_misses, duration);
+            if (0 != s && sim.detect_max > (time_t)(2 * g_intervals[i]))
+            {
+                printf("FAILED: phi %s interval %lu: detect %lds\n",
+                       g_scenarios[s].name, (unsigned long)g_intervals[i],
+                       (long)sim.detect_max);
+                ++failed;
+            }
+            detect[i] = (1 == s) ? (size_t)sim.detect_max : detect[i];
+
+            DestroySim(&sim);
+            ++*runs;
+        }
+    }
+
+    printf("phi accrual, threshold %d, max_misses %lu: crash detection [s]\n",
+           PHI_THRESHOLD, (unsigned long)max_misses);
+    for (i = 0; i < INTERVALS; ++i)
+    {
+        printf("%10lu  %4lu\n", (unsigned long)g_intervals[i],
+                                                (unsigned long)detect[i]);
+    }
+
+    return failed;
+}
+
+/* every scenario with the adaptive rate against the fixed one, from 1 s */
+static int SimulateRate(time_t duration, char *argv[], size_t *runs)
+{
+    wd_rate_policy_ty rate = {RATE_MAX, RATE_STABLE};
+    size_t beats[2];
+    time_t detect[2];
+    size_t s = 0;
+    size_t a = 0;
+    int failed = 0;
+    sim_ty sim;
+
+    printf("adaptive rate, 1 - %d s after %d regular checks, max_misses %d\n",
+           RATE_MAX, RATE_STABLE, RATE_MISSES);
+    printf("%12s  %14s  %14s\n", "", "beats/h fixed", "adaptive");
+
+    for (s = 0; s < SCENARIOS; ++s)
+    {
+        for (a = 0; a < 2; ++a)
+        {
+            if (0 != Simulate(&sim, &g_scenarios[s], 1, RATE_MISSES, duration,
+                              argv, NULL, (0 == a) ? NULL : &rate))
+            {
+                puts("CreateStruct failed");
+                return 1;
+            }
+
+            /* a slow pair detects within max_misses of its slowest beats */
+            failed += Check(&sim, &g_scenarios[s], (0 == a) ? 1 : RATE_MAX,
+                            RATE_MISSES, duration);
+            beats[a] = sim.beats * HOUR / (size_t)duration;
+            detect[a] = sim.detect_max;
+
+            DestroySim(&sim);
+            ++*runs;
+        }
+
+        /* a healthy pair pays for the slow rate only */
+        if (0 == s && beats[1] > beats[0] * 2 / RATE_MAX)
+        {
+            printf("FAILED: rate healthy %lu beats/h\n",
+                                                (unsigned long)beats[1]);
+            ++failed;
+        }
+
+        printf("%12s  %14lu  %14lu", g_scenarios[s].name,
+               (unsigned long)beats[0], (unsigned long)beats[1]);
+        if (1 == s || 2 == s)
+        {
+            printf("   detect %lds / %lds", (long)detect[0], (long)detect[1]);
+        }
+        printf("\n");
+    }
+
+    return failed;
+}
+
+int main(int argc, char *argv[])
+{
+    char *app_argv[2];
+    time_t duration = (argc > 1) ? atoi(argv[1]) * HOUR : DEFAULT_HOURS * HOUR;
+    size_t detect[INTERVALS][MISSES];
+    size_t pause_restarts[INTERVALS][MISSES];
+    size_t runs = 0;
+    size_t s = 0;
+    size_t i = 0;
+    size_t m = 0;
+    int failed = 0;
+    double start = NowMsec();
+    sim_ty sim;
+
+    duration = (duration < 2 * FIRST_FAIL) ? 2 * FIRST_FAIL : duration;
+
+    /* nothing of the simulation may reach a real pair */
+    unsetenv("WD_NAME");
+
+    app_argv[0] = argv[0];
+    app_argv[1] = NULL;
+
+    for (s = 0; s < SCENARIOS; ++s)
+    {
+        for (i = 0; i < INTERVALS; ++i)
+        {
+            for (m = 0; m < MISSES; ++m)
+            {
+                if (0 != Simulate(&sim, &g_scenarios[s], g_intervals[i],
+                                  g_misses[m], duration, app_argv, NULL, NULL))
+                {
+                    puts("CreateStruct failed");
+                    return 1;
+                }
+
+                failed += Check(&sim, &g_scenarios[s], g_intervals[i],
+                                g_misses[m], duration);
+
+                if (&g_scenarios[1] == &g_scenarios[s])
+                {
+                    detect[i][m] = (size_t)sim.detect_max;
+                }
+                else if (PAUSE == g_scenarios[s].quiet)
+                {
+                    pause_restarts[i][m] = sim.spawns - 1;
+                }
+
+                DestroySim(&sim);
+                ++runs;
+            }
+        }
+    }
+
+    printf("crash detection, last beat to restart [s] / restarted on a %ds pause\n", PAUSE);
+    printf("%10s", "interval");
+    for (m = 0; m < MISSES; ++m)
+    {
+        printf("  misses=%-4lu", (unsigned long)g_misses[m]);
+    }
+    printf("\n");
+    for (i = 0; i < INTERVALS; ++i)
+    {
+        printf("%10lu", (unsigned long)g_intervals[i]);
+        for (m = 0; m < MISSES; ++m)
+        {
+            printf("  %4lu / %-4s", (unsigned long)detect[i][m],
+                   pause_restarts[i][m] ? "yes" : "no");
+        }
+        printf("\n");
+    }
+
+    failed += SimulatePhi(duration, app_argv, &runs);
+    failed += SimulateRate(duration, app_argv, &runs);
+
+    printf("%lu runs of %ld virtual hours in %.1f ms\n", (unsigned long)runs,
+           (long)(duration / HOUR), NowMsec() - start);
+
+    puts(0 == failed ? "PASS" : "FAIL");
+
+    return (0 != failed);
+}
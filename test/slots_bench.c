@@ -0,0 +1,90 @@
+/*******************************************************************************
+ * Project:     Watchdog - heartbeat slots benchmark
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * measures one scan of a table of heartbeat slots for every kernel the CPU
+ * supports, and the share of a core it takes to scan every 5 ms
+ * usage: ./slots_bench.out [rounds]
+*******************************************************************************/
+#include <stdio.h>      /* printf           */
+#include <stdlib.h>     /* atoi, malloc     */
+
+#include "wd_slots.h"
+
+enum {DEFAULT_ROUNDS = 2000, PERIOD_NS = 5000000, TIMEOUT_NS = 1000000000};
+
+static const size_t g_sizes[] = {1024, 16384, 65536, 262144};
+static const slots_kernel_ty g_kernels[] = {SLOTS_SCALAR, SLOTS_SSE2, SLOTS_AVX2};
+
+int main(int argc, char *argv[])
+{
+    size_t rounds = (argc > 1) ? (size_t)atoi(argv[1]) : DEFAULT_ROUNDS;
+    wd_slots_ty *slots = NULL;
+    unsigned long *bitmap = NULL;
+    unsigned long start = 0;
+    unsigned long now = 0;
+    double scan_ns = 0;
+    size_t expired = 0;
+    size_t s = 0;
+    size_t k = 0;
+    size_t i = 0;
+
+    rounds = (0 == rounds) ? 1 : rounds;
+
+    printf("%10s %8s %12s %12s %12s\n", "slots", "kernel", "scan[us]",
+           "per slot[ns]", "core@5ms[%]");
+
+    for (s = 0; s < sizeof(g_sizes) / sizeof(g_sizes[0]); ++s)
+    {
+        slots = SlotsCreate(g_sizes[s]);
+        bitmap = (unsigned long *)malloc(g_sizes[s] / SLOTS_ALIGN *
+                                                        sizeof(long));
+        if (NULL == slots || NULL == bitmap)
+        {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+
+        /* every 16th slot is late */
+        for (i = 0; i < g_sizes[s]; ++i)
+        {
+            SlotsArm(slots, i, (0 == i % 16) ? 0 : TIMEOUT_NS);
+        }
+        now = SlotsNow() + 1000;
+
+        for (k = 0; k < sizeof(g_kernels) / sizeof(g_kernels[0]); ++k)
+        {
+            if (0 != SlotsSetKernel(slots, g_kernels[k]))
+            {
+                continue;
+            }
+
+            /* warm up the caches the way a periodic scan finds them */
+            expired = SlotsScan(slots, now, bitmap);
+
+            start = SlotsNow();
+            for (i = 0; i < rounds; ++i)
+            {
+                expired += SlotsScan(slots, now + i, bitmap);
+            }
+            scan_ns = (double)(SlotsNow() - start) / rounds;
+
+            printf("%10lu %8s %12.2f %12.3f %12.3f\n",
+                   (unsigned long)g_sizes[s], SlotsKernelName(slots),
+                   scan_ns / 1000, scan_ns / g_sizes[s],
+                   scan_ns * 100 / PERIOD_NS);
+        }
+
+        /* keeps the scans from being optimized away */
+        if (0 == expired)
+        {
+            printf("nothing expired\n");
+        }
+
+        SlotsDestroy(slots);
+        free(bitmap);
+    }
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+/*******************************************************************************
+ * Project:     Watchdog - heartbeat slots test
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * checks the scan of a table of heartbeat slots:
+ * - armed slots expire after their timeout, disarmed ones never do
+ * - every kernel the CPU supports finds exactly the slots the scalar one
+ *   does, for timeouts and ages on both sides of every 32 bit boundary
+ * usage: ./slots_test.out [rounds]
+*******************************************************************************/
+#include <stdio.h>      /* printf           */
+#include <stdlib.h>     /* rand, malloc     */
+#include <string.h>     /* memcmp           */
+
+#include "wd_slots.h"
+
+enum {SLOTS = 10000 + 37, DEFAULT_ROUNDS = 200};
+
+#define SEC_NS (1000000000UL)
+#define HOUR_NS (3600 * SEC_NS)
+
+static unsigned long Random64(void)
+{
+    return ((unsigned long)rand() << 33) ^ ((unsigned long)rand() << 11) ^
+                                                        (unsigned long)rand();
+}
+
+/* random magnitudes, so both halves of the 64 bit values get exercised */
+static unsigned long RandomSpan(void)
+{
+    return Random64() >> (rand() % 64);
+}
+
+static int CheckSemantics(void)
+{
+    wd_slots_ty *slots = SlotsCreate(3);
+    unsigned long bitmap[1];
+    unsigned long now = 0;
+    int failed = 0;
+
+    if (NULL == slots || SLOTS_ALIGN != SlotsCapacity(slots))
+    {
+        SlotsDestroy(slots);
+        return 1;
+    }
+
+    SlotsArm(slots, 0, SEC_NS);
+    SlotsArm(slots, 1, HOUR_NS);
+    SlotsArm(slots, 2, 0);
+    SlotsDisarm(slots, 2);
+    now = SlotsNow();
+
+    failed += (0 != SlotsScan(slots, now, bitmap) || 0 != bitmap[0]);
+    failed += (1 != SlotsScan(slots, now + 2 * SEC_NS, bitmap) ||
+               1 != bitmap[0]);
+    failed += (2 != SlotsScan(slots, now + 2 * HOUR_NS, bitmap) ||
+               3 != bitmap[0]);
+
+    /* a beat brings a slot back */
+    SlotsBeat(slots, 0);
+    failed += (0 != SlotsScan(slots, SlotsNow() + SEC_NS / 2, bitmap) ||
+               0 != bitmap[0]);
+
+    SlotsDestroy(slots);
+
+    return failed;
+}
+
+static int CheckKernels(size_t rounds)
+{
+    static const slots_kernel_ty kernels[] = {SLOTS_SSE2, SLOTS_AVX2};
+    wd_slots_ty *slots = SlotsCreate(SLOTS);
+    size_t words = SlotsCapacity(slots) / SLOTS_ALIGN;
+    unsigned long *expected = (unsigned long *)malloc(words * sizeof(long));
+    unsigned long *found = (unsigned long *)malloc(words * sizeof(long));
+    unsigned long now = 0;
+    size_t expected_cnt = 0;
+    size_t i = 0;
+    size_t k = 0;
+    size_t r = 0;
+    int failed = 0;
+
+    if (NULL == slots || NULL == expected || NULL == found)
+    {
+        failed = 1;
+        rounds = 0;
+    }
+
+    for (r = 0; r < rounds; ++r)
+    {
+        for (i = 0; i < SLOTS; ++i)
+        {
+            if (0 == rand() % 8)
+            {
+                SlotsDisarm(slots, i);
+            }
+            else
+            {
+                SlotsArm(slots, i, RandomSpan());
+            }
+        }
+
+        /* ages below 0 as well, a beat may land during the scan */
+        now = SlotsNow() + RandomSpan() - (0 == r % 4 ? 1000000 : 0);
+
+        SlotsSetKernel(slots, SLOTS_SCALAR);
+        expected_cnt = SlotsScan(slots, now, expected);
+
+        for (k = 0; k < sizeof(kernels) / sizeof(kernels[0]); ++k)
+        {
+            if (0 != SlotsSetKernel(slots, kernels[k]))
+            {
+                continue;
+            }
+            if (expected_cnt != SlotsScan(slots, now, found) ||
+                0 != memcmp(expected, found, words * sizeof(long)))
+            {
+                printf("%s differs from scalar in round %lu\n",
+                       SlotsKernelName(slots), (unsigned long)r);
+                ++failed;
+            }
+        }
+    }
+
+    SlotsDestroy(slots);
+    free(expected);
+    free(found);
+
+    return failed;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t rounds = (argc > 1) ? (size_t)atoi(argv[1]) : DEFAULT_ROUNDS;
+    wd_slots_ty *slots = SlotsCreate(1);
+    int failed = 0;
+
+    printf("best kernel: %s\n", (NULL != slots) ? SlotsKernelName(slots) : "-");
+    SlotsDestroy(slots);
+
+    failed += CheckSemantics();
+    failed += CheckKernels(rounds);
+
+    printf("%lu rounds of %d slots\n", (unsigned long)rounds, SLOTS);
+    puts(0 == failed ? "PASS" : "FAIL");
+
+    return (0 != failed);
+}
@@ -0,0 +1,114 @@
+/*******************************************************************************
+ * Project:     Watchdog - spawn latency benchmark
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * measures how long the spawning thread is stalled by fork()+execv() versus
+ * posix_spawn() as the resident size of the parent grows
+ * usage: ./spawn_bench.out [max_rss_mb] [rounds]
+*******************************************************************************/
+#define _GNU_SOURCE  /* environ */
+
+#include <stdio.h>      /* printf       */
+#include <stdlib.h>     /* malloc, atoi */
+#include <string.h>     /* memset       */
+#include <unistd.h>     /* fork, execv  */
+#include <spawn.h>      /* posix_spawn  */
+#include <time.h>       /* clock_gettime */
+#include <sys/wait.h>   /* waitpid      */
+
+#define CHILD_PATH "/bin/true"
+
+enum {DEFAULT_MAX_RSS_MB = 2048, DEFAULT_ROUNDS = 20, MB = 1024 * 1024};
+
+static double NowUsec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* returns the time the caller was blocked in fork() */
+static double ForkExec(void)
+{
+    char *argv[] = {CHILD_PATH, NULL};
+    double start = NowUsec();
+    double stalled = 0;
+    pid_t pid = fork();
+
+    if (0 == pid)
+    {
+        execv(CHILD_PATH, argv);
+        _exit(1);
+    }
+
+    stalled = NowUsec() - start;
+    waitpid(pid, NULL, 0);
+
+    return stalled;
+}
+
+/* returns the time the caller was blocked in posix_spawn() */
+static double Spawn(void)
+{
+    char *argv[] = {CHILD_PATH, NULL};
+    double start = NowUsec();
+    double stalled = 0;
+    pid_t pid = 0;
+
+    if (0 != posix_spawn(&pid, CHILD_PATH, NULL, NULL, argv, environ))
+    {
+        return -1;
+    }
+
+    stalled = NowUsec() - start;
+    waitpid(pid, NULL, 0);
+
+    return stalled;
+}
+
+static double Average(double (*spawner)(void), size_t rounds)
+{
+    double total = 0;
+    size_t i = 0;
+
+    for (i = 0; i < rounds; ++i)
+    {
+        total += spawner();
+    }
+
+    return total / rounds;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t max_rss_mb = (argc > 1) ? (size_t)atoi(argv[1]) : DEFAULT_MAX_RSS_MB;
+    size_t rounds = (argc > 2) ? (size_t)atoi(argv[2]) : DEFAULT_ROUNDS;
+    size_t rss_mb = 0;
+    size_t grown_mb = 0;
+    char *chunk = NULL;
+
+    printf("%10s %16s %16s\n", "rss[MB]", "fork+exec[us]", "posix_spawn[us]");
+
+    for (rss_mb = 0; rss_mb <= max_rss_mb; rss_mb = (0 == rss_mb) ? 64 : rss_mb * 2)
+    {
+        /* grow the resident set, every page touched - kept until exit */
+        for (; grown_mb < rss_mb; grown_mb += 64)
+        {
+            chunk = (char *)malloc(64 * MB);
+            if (NULL == chunk)
+            {
+                fprintf(stderr, "malloc failed at %lu MB\n", (unsigned long)grown_mb);
+                return 1;
+            }
+            memset(chunk, 1, 64 * MB);
+        }
+
+        printf("%10lu %16.1f %16.1f\n", (unsigned long)rss_mb,
+               Average(ForkExec, rounds), Average(Spawn, rounds));
+    }
+
+    return 0;
+}
@@ -0,0 +1,117 @@
+/*******************************************************************************
+ * Project:     Watchdog - startup latency benchmark
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * measures how long MakeMeImmortal() blocks a short-lived worker, from the
+ * call until its watchdog is up and running
+ * usage: LD_LIBRARY_PATH=. ./startup_bench.out [rounds]
+ * note: run from the directory of wd_app
+*******************************************************************************/
+#define _GNU_SOURCE  /* unsetenv */
+
+#include <stdio.h>      /* printf           */
+#include <stdlib.h>     /* atoi, qsort      */
+#include <unistd.h>     /* fork, pipe       */
+#include <time.h>       /* clock_gettime    */
+#include <sys/wait.h>   /* waitpid          */
+
+#include "watchdog.h"
+
+enum {DEFAULT_ROUNDS = 20, MAX_ROUNDS = 1000, INTERVAL = 1, MAX_MISSES = 3};
+
+static double NowUsec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int Compare(const void *a, const void *b)
+{
+    double diff = *(const double *)a - *(const double *)b;
+
+    return (diff > 0) - (diff < 0);
+}
+
+/* a worker that sets its watchdog, reports the time it took and leaves */
+static double Worker(char *argv0)
+{
+    char *argv[2];
+    double took = -1;
+    double start = 0;
+    int fds[2];
+    pid_t pid = 0;
+
+    argv[0] = argv0;
+    argv[1] = NULL;
+
+    if (0 != pipe(fds))
+    {
+        return -1;
+    }
+
+    pid = fork();
+    if (0 == pid)
+    {
+        close(fds[0]);
+
+        start = NowUsec();
+        if (0 == MakeMeImmortal(1, argv, INTERVAL, MAX_MISSES))
+        {
+            took = NowUsec() - start;
+        }
+        write(fds[1], &took, sizeof(took));
+
+        DoNotResuscitate();
+        _exit(0);
+    }
+
+    close(fds[1]);
+    if (-1 == pid || sizeof(took) != read(fds[0], &took, sizeof(took)))
+    {
+        took = -1;
+    }
+    close(fds[0]);
+    waitpid(pid, NULL, 0);
+
+    return took;
+}
+
+int main(int argc, char *argv[])
+{
+    static double took[MAX_ROUNDS];
+    size_t rounds = (argc > 1) ? (size_t)atoi(argv[1]) : DEFAULT_ROUNDS;
+    double total = 0;
+    size_t i = 0;
+
+    rounds = (MAX_ROUNDS < rounds) ? MAX_ROUNDS : rounds;
+    rounds = (0 == rounds) ? 1 : rounds;
+
+    /* every worker is a pair of its own */
+    unsetenv("WD_NAME");
+
+    for (i = 0; i < rounds; ++i)
+    {
+        took[i] = Worker(argv[0]);
+        if (0 > took[i])
+        {
+            fprintf(stderr, "MakeMeImmortal failed in round %lu\n",
+                    (unsigned long)i);
+            return 1;
+        }
+        total += took[i];
+    }
+
+    qsort(took, rounds, sizeof(took[0]), Compare);
+
+    printf("%10s %12s %12s %12s %12s\n", "rounds", "avg[us]", "p50[us]",
+           "p99[us]", "max[us]");
+    printf("%10lu %12.1f %12.1f %12.1f %12.1f\n", (unsigned long)rounds,
+           total / rounds, took[rounds / 2], took[rounds * 99 / 100],
+           took[rounds - 1]);
+
+    return 0;
+}
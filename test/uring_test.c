@@ -0,0 +1,221 @@
+/*******************************************************************************
+ * Project:     Watchdog - io_uring event loop backend test
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * checks that a wait without completions times out, that reads of a pipe
+ * and of a signalfd, a poll and the exit of a child seen through its pidfd
+ * complete together in one system call, that a poll in flight is cancelled
+ * by its tag, and that a full ring refuses more
+ * skipped, and passed, on a kernel without io_uring
+ * usage: ./uring_test.out
+*******************************************************************************/
+#define _GNU_SOURCE  /* syscall, pipe2 */
+
+#include <stdio.h>          /* printf, puts             */
+#include <string.h>         /* memset                   */
+#include <errno.h>          /* ECANCELED, ENOENT        */
+#include <time.h>           /* clock_gettime            */
+#include <poll.h>           /* POLLIN                   */
+#include <signal.h>         /* sigqueue, sigprocmask    */
+#include <unistd.h>         /* pipe, write, fork        */
+#include <sys/wait.h>       /* waitpid                  */
+#include <sys/signalfd.h>   /* signalfd                 */
+#include <sys/syscall.h>    /* SYS_pidfd_open           */
+
+#include "wd_uring.h"
+
+#include "wd_expect.h"
+
+enum {ENTRIES = 4, TIMEOUT_MS = 50, LONG_MS = 5000};
+
+enum {TAG_PIPE = 1, TAG_POLL = 2, TAG_SIGNAL = 3, TAG_CHILD = 4,
+      TAG_CANCEL = 5};
+
+typedef struct results
+{
+    int res[TAG_CANCEL + 1];
+    size_t cnt;
+}results_ty;
+
+static long NowMs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static void OnDone(void *param, unsigned long tag, int res)
+{
+    results_ty *results = (results_ty *)param;
+
+    if (TAG_CANCEL >= tag)
+    {
+        results->res[tag] = res;
+    }
+    ++results->cnt;
+}
+
+static void CheckTimeout(uring_ty *ring)
+{
+    results_ty results;
+    size_t syscalls = UringSyscalls(ring);
+    long start = NowMs();
+
+    memset(&results, 0, sizeof(results));
+
+    Expect(0 == UringWait(ring, TIMEOUT_MS, OnDone, &results), "timed out");
+    Expect(NowMs() - start >= TIMEOUT_MS - 1, "waited");
+    Expect(0 == results.cnt && syscalls + 1 == UringSyscalls(ring), "one call");
+}
+
+static void CheckBatch(uring_ty *ring)
+{
+    results_ty results;
+    struct signalfd_siginfo info;
+    union sigval value;
+    sigset_t mask;
+    char buf[8];
+    int read_fds[2];
+    int poll_fds[2];
+    int sig_fd = -1;
+    size_t syscalls = 0;
+
+    memset(&results, 0, sizeof(results));
+    Expect(0 == pipe(read_fds) && 0 == pipe(poll_fds), "pipes");
+
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+    sig_fd = signalfd(-1, &mask, SFD_CLOEXEC);
+    Expect(-1 != sig_fd, "signalfd");
+
+    Expect(0 == UringQueueRead(ring, read_fds[0], buf, sizeof(buf), TAG_PIPE),
+                                                                "queue read");
+    Expect(0 == UringQueuePoll(ring, poll_fds[0], TAG_POLL), "queue poll");
+    Expect(0 == UringQueueRead(ring, sig_fd, &info, sizeof(info), TAG_SIGNAL),
+                                                        "queue signal read");
+
+    /* nothing is ready yet, the operations wait in the kernel */
+    Expect(0 == UringWait(ring, TIMEOUT_MS, OnDone, &results), "pending");
+
+    value.sival_ptr = (void *)0x1234;
+    Expect(3 == write(read_fds[1], "abc", 3), "write");
+    Expect(1 == write(poll_fds[1], "", 1), "write");
+    Expect(0 == sigqueue(getpid(), SIGUSR1, value), "sigqueue");
+
+    /* the kernel completes them as they come, one wait reaps them all */
+    syscalls = UringSyscalls(ring);
+    while (3 > results.cnt && 0 <= UringWait(ring, LONG_MS, OnDone, &results))
+    {
+    }
+    Expect(3 == results.cnt, "all completed");
+    Expect(syscalls + 3 >= UringSyscalls(ring), "batched");
+    Expect(3 == results.res[TAG_PIPE] && 0 == memcmp(buf, "abc", 3), "read");
+    Expect(0 != (results.res[TAG_POLL] & POLLIN), "poll");
+    Expect((int)sizeof(info) == results.res[TAG_SIGNAL] &&
+           SIGUSR1 == info.ssi_signo && 0x1234 == info.ssi_ptr, "signal");
+
+    close(read_fds[0]);
+    close(read_fds[1]);
+    close(poll_fds[0]);
+    close(poll_fds[1]);
+    close(sig_fd);
+    sigprocmask(SIG_UNBLOCK, &mask, NULL);
+}
+
+static void CheckChild(uring_ty *ring)
+{
+    results_ty results;
+    pid_t child = 0;
+    int pidfd = -1;
+
+    memset(&results, 0, sizeof(results));
+
+    child = fork();
+    if (0 == child)
+    {
+        usleep(TIMEOUT_MS * 1000);
+        _exit(0);
+    }
+
+    pidfd = (int)syscall(SYS_pidfd_open, child, 0);
+    Expect(-1 != pidfd, "pidfd");
+    Expect(0 == UringQueuePoll(ring, pidfd, TAG_CHILD), "queue child");
+    Expect(1 == UringWait(ring, LONG_MS, OnDone, &results) &&
+           0 != (results.res[TAG_CHILD] & POLLIN), "child exited");
+
+    waitpid(child, NULL, 0);
+    close(pidfd);
+}
+
+static void CheckCancel(uring_ty *ring)
+{
+    results_ty results;
+    int fds[2];
+
+    memset(&results, 0, sizeof(results));
+    Expect(0 == pipe(fds), "pipe");
+
+    /* a poll of a pipe nobody writes to would wait forever */
+    Expect(0 == UringQueuePoll(ring, fds[0], TAG_POLL), "queue poll");
+    Expect(0 == UringWait(ring, TIMEOUT_MS, OnDone, &results), "in flight");
+
+    Expect(0 == UringQueueCancel(ring, TAG_POLL, TAG_CANCEL), "queue cancel");
+    while (2 > results.cnt && 0 <= UringWait(ring, LONG_MS, OnDone, &results))
+    {
+    }
+    Expect(2 == results.cnt && -ECANCELED == results.res[TAG_POLL] &&
+           0 == results.res[TAG_CANCEL], "cancelled");
+
+    Expect(0 == UringQueueCancel(ring, TAG_POLL, TAG_CANCEL) &&
+           1 == UringWait(ring, LONG_MS, OnDone, &results) &&
+           -ENOENT == results.res[TAG_CANCEL], "nothing left to cancel");
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+static void CheckFull(void)
+{
+    uring_ty *ring = UringCreate(2);
+    int fds[2];
+    size_t i = 0;
+
+    Expect(NULL != ring && 0 == pipe(fds), "small ring");
+    for (i = 0; i < 2; ++i)
+    {
+        Expect(0 == UringQueuePoll(ring, fds[0], TAG_POLL), "room");
+    }
+    Expect(0 != UringQueuePoll(ring, fds[0], TAG_POLL), "full");
+
+    UringDestroy(ring);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+int main(void)
+{
+    uring_ty *ring = UringCreate(ENTRIES);
+
+    if (NULL == ring)
+    {
+        puts("io_uring not supported, skipped");
+        puts("PASS");
+        return 0;
+    }
+
+    CheckTimeout(ring);
+    CheckBatch(ring);
+    CheckChild(ring);
+    CheckCancel(ring);
+    UringDestroy(ring);
+
+    CheckFull();
+
+    puts(0 == g_failed ? "PASS" : "FAIL");
+
+    return (0 != g_failed);
+}
@@ -0,0 +1,29 @@
+/*******************************************************************************
+ * Project:     Watchdog - checks shared by the tests
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * included by a test once, in its .c file: a failed check prints what it
+ * checked and counts in g_failed, which the test reports at its end
+*******************************************************************************/
+#ifndef __WD_EXPECT_H__
+#define __WD_EXPECT_H__
+
+#include <stdio.h>      /*  printf  */
+
+static int g_failed = 0;
+
+/*******************************************************************************
+ * Prints "what" and counts a failure if "is_good" is 0
+ * Time Complexity: O(1)
+*******************************************************************************/
+static void Expect(int is_good, const char *what)
+{
+    if (!is_good)
+    {
+        printf("FAILED: %s\n", what);
+        ++g_failed;
+    }
+}
+
+#endif  /*  __WD_EXPECT_H__  */
@@ -0,0 +1,80 @@
+/*******************************************************************************
+ * Project:     Watchdog - helpers shared by the tests that run a pair
+ * Author:      AvivJilin
+ * Version:     1.0 - 19/10/2026
+ *
+ * included by a test once, in its .c file: the app of the test stops on
+ * SIGINT through g_quit, the test signals and probes the pair by pid and
+ * reads the log ring of the pair by its name
+*******************************************************************************/
+#ifndef __WD_FIXTURE_H__
+#define __WD_FIXTURE_H__
+
+#include <stdio.h>          /*  sprintf             */
+#include <signal.h>         /*  kill, sig_atomic_t  */
+#include <unistd.h>         /*  close               */
+#include <fcntl.h>          /*  O_RDONLY            */
+#include <sys/mman.h>       /*  shm_open, mmap      */
+
+#include "wd_log.h"
+
+enum {NAME_SIZE = 64};
+
+static volatile sig_atomic_t g_quit = 0;
+
+/*******************************************************************************
+ * SIGINT handler of the app of a test, sets g_quit
+ * Time Complexity: O(1)
+*******************************************************************************/
+static void OnInterrupt(int sig)
+{
+    (void)sig;
+    g_quit = 1;
+}
+
+/*******************************************************************************
+ * Sends "sig" to "pid" - a pid of 0 is one that never showed up, not our
+ * process group
+ * Time Complexity: O(1)
+*******************************************************************************/
+static void Signal(pid_t pid, int sig)
+{
+    if (0 != pid)
+    {
+        kill(pid, sig);
+    }
+}
+
+/*******************************************************************************
+ * Returns 1 if "pid" is not 0 and runs, 0 otherwise
+ * Time Complexity: O(1)
+*******************************************************************************/
+static int IsAlive(pid_t pid)
+{
+    return (0 != pid && 0 == kill(pid, 0));
+}
+
+/*******************************************************************************
+ * Maps the log ring of the pair "name" read only, NULL if it has none
+ * Time Complexity: O(1)
+*******************************************************************************/
+static const log_ring_ty *OpenRing(const char *name)
+{
+    char shm_name[NAME_SIZE + sizeof(LOG_PREFIX)];
+    void *ring = NULL;
+    int fd = -1;
+
+    sprintf(shm_name, "%s%s", LOG_PREFIX, name);
+    fd = shm_open(shm_name, O_RDONLY, 0);
+    if (-1 == fd)
+    {
+        return NULL;
+    }
+
+    ring = mmap(NULL, sizeof(log_ring_ty), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    return (MAP_FAILED == ring) ? NULL : (const log_ring_ty *)ring;
+}
+
+#endif  /*  __WD_FIXTURE_H__  */